@@ -23,15 +23,37 @@
 #include "qtractorOptions.h"
 #include "qtractorMainForm.h"
 
+#include "qtractorSession.h"
+#include "qtractorSessionDocument.h"
+#include "qtractorAudioEngine.h"
+#include "qtractorMidiEngine.h"
+#include "qtractorAudioBuffer.h"
+#include "qtractorAudioCache.h"
+#include "qtractorAudioFile.h"
+#include "qtractorMidiClip.h"
+#include "qtractorMidiManager.h"
+#include "qtractorMidiControl.h"
+#include "qtractorMessageList.h"
+#include "qtractorPluginFactory.h"
+
+#ifdef CONFIG_LV2
+#include "qtractorLv2Plugin.h"
+#endif
+
 #include <QApplication>
 #include <QLibraryInfo>
 #include <QTranslator>
 #include <QLocale>
 
 #include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDomDocument>
 
 #include <QStyleFactory>
 
+#include <stdlib.h>
+
 
 #ifndef CONFIG_PREFIX
 #define CONFIG_PREFIX	"/usr/local"
@@ -561,6 +583,195 @@ static bool update_palette ( QPalette& pal, const QString& sCustomColorTheme )
 // main - The main program trunk.
 //
 
+//-------------------------------------------------------------------------
+// Headless (offline) session rendering -- qtractor-render.
+//
+// Loads the session file without any main form whatsoever and renders
+// the selected audio output buses straight into a file, driving the
+// engine process cycle by itself, that is without JACK nor ALSA.
+
+static int render_session ( qtractorOptions& options )
+{
+	QTextStream out(stderr);
+
+	// The (pseudo-)singletons the main form would have created...
+	qtractorSession session;
+	qtractorMessageList messageList;
+	qtractorAudioFileFactory audioFileFactory;
+	qtractorPluginFactory pluginFactory;
+	qtractorMidiControl midiControl;
+
+	// Same audio defaults as the main form would have set...
+	qtractorAudioFileFactory::setDefaultType(
+		options.sAudioCaptureExt,
+		options.iAudioCaptureType,
+		options.iAudioCaptureFormat,
+		options.iAudioCaptureQuality);
+	qtractorMidiClip::setDefaultFormat(
+		options.iMidiCaptureFormat);
+	qtractorMidiManager::setDefaultAudioOutputBus(
+		options.bAudioOutputBus);
+	qtractorMidiManager::setDefaultAudioOutputAutoConnect(false);
+	qtractorAudioBuffer::setDefaultResampleType(
+		options.iAudioResampleType);
+	qtractorAudioBuffer::setDefaultWsolaTimeStretch(
+		options.bAudioWsolaTimeStretch);
+	qtractorAudioBuffer::setDefaultWsolaQuickSeek(
+		options.bAudioWsolaQuickSeek);
+	qtractorAudioBuffer::setDefaultLandingBudget(
+		options.iAudioLandingBudget);
+
+	qtractorAudioEngine *pAudioEngine = session.audioEngine();
+	qtractorMidiEngine  *pMidiEngine  = session.midiEngine();
+
+	pAudioEngine->setMasterAutoConnect(false);
+	pAudioEngine->setRenderThreads(options.iAudioRenderThreads);
+	pAudioEngine->setBlockAutomation(options.iAudioBlockAutomation);
+	pAudioEngine->setSyncThreads(options.iAudioSyncThreads);
+
+	qtractorAudioCache *pAudioCache = session.audioCache();
+	if (pAudioCache)
+		pAudioCache->setBudget(options.iAudioCacheBudget);
+
+	// No JACK, no ALSA...
+	pAudioEngine->setOffline(true);
+	pMidiEngine->setOffline(true);
+
+	// Flag whether we're about to load a template or archive...
+	const QString& sFilename = options.sSessionFile;
+	const QFileInfo info(sFilename);
+	const QString& sSuffix = info.suffix();
+	int iFlags = qtractorDocument::Default;
+	if (sSuffix == qtractorDocument::templateExt())
+		iFlags |= qtractorDocument::Template;
+#ifdef CONFIG_LIBZ
+	if (sSuffix == qtractorDocument::archiveExt())
+		iFlags |= (qtractorDocument::Archive | qtractorDocument::Temporary);
+#endif
+
+#ifdef CONFIG_LV2
+	qtractorLv2PluginType::lv2_open();
+#endif
+
+	// Read the file.
+	QDomDocument doc("qtractorSession");
+	if (!qtractorSessionDocument(&doc, &session, NULL)
+			.load(sFilename, qtractorDocument::Flags(iFlags))) {
+		out << QObject::tr("Could not open \"%1\" session.")
+			.arg(sFilename) << endl;
+	#ifdef CONFIG_LV2
+		qtractorLv2PluginType::lv2_close();
+	#endif
+		return 1;
+	}
+
+	// Warm-up the session engines, at the session own sample-rate...
+	if (!session.init() || !session.open()) {
+		out << QObject::tr("Could not start the session engines.") << endl;
+		session.close();
+	#ifdef CONFIG_LV2
+		qtractorLv2PluginType::lv2_close();
+	#endif
+		return 1;
+	}
+
+	// Initial automation state...
+	qtractorSubject::resetQueue();
+	session.updateCurveIndex();
+	session.process_curve(0);
+
+	// Stems: one file per bus and/or track, all in one pass...
+	const bool bRenderStems
+		= (options.bRenderStems || !options.renderTracks.isEmpty());
+
+	// Audio output buses to render (default: master, or all for stems)...
+	bool bRenderError = false;
+	QList<qtractorAudioBus *> exportBuses;
+	QStringListIterator iter(options.renderBuses);
+	while (iter.hasNext()) {
+		const QString& sBusName = iter.next();
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (
+				pAudioEngine->findBus(sBusName));
+		if (pAudioBus == NULL || (pAudioBus->busMode() & qtractorBus::Output) == 0) {
+			out << QObject::tr("Unknown audio output bus \"%1\".")
+				.arg(sBusName) << endl;
+			bRenderError = true;
+			break;
+		}
+		exportBuses.append(pAudioBus);
+	}
+	if (options.renderBuses.isEmpty()) {
+		for (qtractorBus *pBus = pAudioEngine->buses().first();
+				pBus; pBus = pBus->next()) {
+			if ((pBus->busMode() & qtractorBus::Output) == 0)
+				continue;
+			if (bRenderStems && !options.bRenderStems)
+				break; // Track stems only.
+			exportBuses.append(static_cast<qtractorAudioBus *> (pBus));
+			if (!bRenderStems)
+				break; // Master only.
+		}
+	}
+
+	// Audio tracks to render as stems...
+	QList<qtractorTrack *> exportTracks;
+	QStringListIterator track_iter(options.renderTracks);
+	while (track_iter.hasNext() && !bRenderError) {
+		const QString& sTrackName = track_iter.next();
+		qtractorTrack *pTrack = session.findTrack(sTrackName);
+		if (pTrack == NULL || pTrack->trackType() != qtractorTrack::Audio) {
+			out << QObject::tr("Unknown audio track \"%1\".")
+				.arg(sTrackName) << endl;
+			bRenderError = true;
+			break;
+		}
+		exportTracks.append(pTrack);
+	}
+
+	// Default render file is named after the session one...
+	QString sRenderFile = options.sRenderFile;
+	if (sRenderFile.isEmpty()) {
+		sRenderFile = info.completeBaseName()
+			+ '.' + qtractorAudioFileFactory::defaultExt();
+	}
+
+	// Go for it...
+	int iResult = 1;
+	if (!bRenderError && (!exportBuses.isEmpty() || !exportTracks.isEmpty())) {
+		out << QObject::tr("Rendering \"%1\"...").arg(sRenderFile) << endl;
+		QStringList files;
+		bool bResult = false;
+		if (bRenderStems) {
+			bResult = pAudioEngine->fileExportStems(
+				sRenderFile, exportBuses, exportTracks, 0, 0, &files);
+		} else {
+			bResult = pAudioEngine->fileExport(
+				sRenderFile, exportBuses, 0, 0);
+			files.append(sRenderFile);
+		}
+		if (bResult) {
+			QStringListIterator file_iter(files);
+			while (file_iter.hasNext())
+				out << QObject::tr("Rendered \"%1\".").arg(file_iter.next()) << endl;
+			out << QObject::tr("Done (%1x realtime).")
+				.arg(pAudioEngine->exportSpeed(), 0, 'f', 1) << endl;
+			iResult = 0;
+		}
+		else out << QObject::tr("Could not render \"%1\".").arg(sRenderFile) << endl;
+	}
+
+	// Shut-off...
+	session.close();
+
+#ifdef CONFIG_LV2
+	qtractorLv2PluginType::lv2_close();
+#endif
+
+	return iResult;
+}
+
+
 int main ( int argc, char **argv )
 {
 	Q_INIT_RESOURCE(qtractor);
@@ -572,6 +783,21 @@ int main ( int argc, char **argv )
 	signal(SIGABRT, stacktrace);
 	signal(SIGBUS,  stacktrace);
 #endif
+#endif
+#if QT_VERSION >= 0x050000
+	// Headless rendering has no need for a display whatsoever...
+	// (same options that imply render mode in qtractorOptions::parse_args)
+	for (int i = 0; i < argc; ++i) {
+		const QString sArg = QString::fromLocal8Bit(argv[i]).section('=', 0, 0);
+		if ((i == 0 && QFileInfo(sArg).fileName() == QTRACTOR_TITLE "-render")
+			|| sArg == "-R" || sArg == "--render"
+			|| sArg == "-S" || sArg == "--render-stems"
+			|| sArg == "-T" || sArg == "--render-track") {
+			if (::getenv("QT_QPA_PLATFORM") == NULL)
+				::setenv("QT_QPA_PLATFORM", "offscreen", 0);
+			break;
+		}
+	}
 #endif
 	qtractorApplication app(argc, argv);
 
@@ -582,6 +808,13 @@ int main ( int argc, char **argv )
 		return 1;
 	}
 
+	// Headless (offline) session rendering?
+	if (options.bRender) {
+		const int iResult = render_session(options);
+		app.quit();
+		return iResult;
+	}
+
 	// Have another instance running?
 	if (app.setup()) {
 		app.quit();
@@ -28,6 +28,8 @@
 #include "qtractorSession.h"
 #include "qtractorAudioEngine.h"
 
+#include "qtractorAudioRamp.h"
+
 #include <math.h>
 
 
@@ -36,79 +38,201 @@
 
 
 //----------------------------------------------------------------------
-// class qtractorAudioBufferThread -- Ring-cache manager thread.
+// class qtractorAudioBufferThread -- Ring-cache I/O worker thread.
 //
 
 // Constructor.
 qtractorAudioBufferThread::qtractorAudioBufferThread (
-	unsigned int iSyncSize ) : QThread()
+	qtractorAudioBufferPool *pSyncPool, unsigned int iSlot ) : QThread()
 {
-	m_iSyncSize = (4 << 1);
-	while (m_iSyncSize < iSyncSize)
-		m_iSyncSize <<= 1;
-	m_iSyncMask = (m_iSyncSize - 1);
-	m_ppSyncItems = new qtractorAudioBuffer * [m_iSyncSize];
-	m_iSyncRead   = 0;
-	m_iSyncWrite  = 0;
+	m_pSyncPool = pSyncPool;
+	m_iSlot = iSlot;
+}
 
-	m_bRunState = false;
+
+// Thread run executive.
+void qtractorAudioBufferThread::run (void)
+{
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioBufferThread[%p]::run(%u): started.", this, m_iSlot);
+#endif
+
+	m_pSyncPool->run(m_iSlot);
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioBufferThread[%p]::run(%u): stopped.", this, m_iSlot);
+#endif
 }
 
+
+//----------------------------------------------------------------------
+// class qtractorAudioBufferPool -- Ring-cache I/O worker pool.
+//
+
+// Atomic load helpers (acquire semantics).
+static inline int qtractorAudioBufferPool_load ( const qtractorAtomic *pVal )
+{
+#if QT_VERSION >= 0x050000
+	return pVal->loadAcquire();
+#else
+	return ATOMIC_GET(pVal);
+#endif
+}
+
+template <typename T>
+static inline T *qtractorAudioBufferPool_load ( const QAtomicPointer<T>& ptr )
+{
+#if QT_VERSION >= 0x050000
+	return ptr.loadAcquire();
+#else
+	return ptr;
+#endif
+}
+
+
+// Request ring constructor.
+qtractorAudioBufferPool::SyncRing::SyncRing ( unsigned int iSyncSize )
+{
+	size = (4 << 1);
+	while (size < iSyncSize)
+		size <<= 1;
+	mask  = (size - 1);
+	items = new QAtomicPointer<qtractorAudioBuffer> [size];
+	read  = 0;
+
+	ATOMIC_SET(&write, 0);
+	ATOMIC_SET(&users, 0);
+}
+
+// Request ring destructor.
+qtractorAudioBufferPool::SyncRing::~SyncRing (void)
+{
+	delete [] items;
+}
+
+
+// Constructor.
+qtractorAudioBufferPool::qtractorAudioBufferPool (
+	unsigned int iThreads, unsigned int iSyncSize )
+{
+	m_syncRing.fetchAndStoreOrdered(new SyncRing(iSyncSize));
+
+	m_iBuffers = 0;
+
+	m_iQueueDepth    = 0;
+	m_iQueueDepthMax = 0;
+	m_iSyncCount     = 0;
+
+	ATOMIC_SET(&m_missed, 0);
+
+	m_bRunState = true;
+
+	m_iThreads  = 0;
+	m_ppThreads = NULL;
+
+	setThreads(iThreads);
+}
+
+
 // Destructor.
-qtractorAudioBufferThread::~qtractorAudioBufferThread (void)
+qtractorAudioBufferPool::~qtractorAudioBufferPool (void)
 {
-	if (isRunning()) do {
-		setRunState(false);
-	//	terminate();
-		sync();
-	} while (!wait(100));
+#ifdef CONFIG_DEBUG
+	qDebug("qtractorAudioBufferPool[%p]: threads=%u syncs=%lu missed=%lu"
+		" queue-depth-max=%u", this, m_iThreads, syncCount(),
+		missedCount(), queueDepthMax());
+#endif
 
-	delete [] m_ppSyncItems;
+	m_mutex.lock();
+	m_bRunState = false;
+	m_cond.wakeAll();
+	m_mutex.unlock();
+
+	for (unsigned int i = 0; i < m_iThreads; ++i) {
+		qtractorAudioBufferThread *pThread = m_ppThreads[i];
+		pThread->wait();
+		delete pThread;
+	}
+
+	delete [] m_ppThreads;
+
+	qDeleteAll(m_retired);
+	m_retired.clear();
+
+	delete m_syncRing.fetchAndStoreOrdered(NULL);
 }
 
-// Run state accessor.
-void qtractorAudioBufferThread::setRunState ( bool bRunState )
+
+// Number of I/O worker threads (non RT-safe).
+void qtractorAudioBufferPool::setThreads ( unsigned int iThreads )
 {
+	if (iThreads < 1)
+		iThreads = 1;
+
 	QMutexLocker locker(&m_mutex);
 
-	m_bRunState = bRunState;
+	if (iThreads > m_iThreads) {
+		qtractorAudioBufferThread **ppOldThreads = m_ppThreads;
+		m_ppThreads = new qtractorAudioBufferThread * [iThreads];
+		unsigned int i = 0;
+		for ( ; i < m_iThreads; ++i)
+			m_ppThreads[i] = ppOldThreads[i];
+		for ( ; i < iThreads; ++i) {
+			m_ppThreads[i] = new qtractorAudioBufferThread(this, i);
+			m_ppThreads[i]->start(QThread::HighPriority);
+		}
+		m_iThreads = iThreads;
+		if (ppOldThreads)
+			delete [] ppOldThreads;
+	}
+	else
+	if (iThreads < m_iThreads) {
+		// Surplus workers bail out on their own...
+		const unsigned int iOldThreads = m_iThreads;
+		m_iThreads = iThreads;
+		m_cond.wakeAll();
+		locker.unlock();
+		for (unsigned int i = iThreads; i < iOldThreads; ++i) {
+			qtractorAudioBufferThread *pThread = m_ppThreads[i];
+			pThread->wait();
+			delete pThread;
+			m_ppThreads[i] = NULL;
+		}
+	}
 }
 
-bool qtractorAudioBufferThread::runState (void) const
+unsigned int qtractorAudioBufferPool::threads (void) const
 {
-	return m_bRunState;
+	return m_iThreads;
 }
 
 
 // Wake from executive wait condition (RT-safe).
-void qtractorAudioBufferThread::sync ( qtractorAudioBuffer *pAudioBuffer )
-{
-	if (pAudioBuffer == NULL) {
-		unsigned int r = m_iSyncRead;
-		unsigned int w = m_iSyncWrite;
-		while (r != w) {
-			m_ppSyncItems[r]->setSyncFlag(qtractorAudioBuffer::WaitSync, false);
-			++r &= m_iSyncMask;
-			w = m_iSyncWrite;
-		}
-		m_iSyncRead = r;
-	} else {
-		// !pAudioBuffer->isSyncFlag(qtractorAudioBuffer::WaitSync)
-		unsigned int n;
-		unsigned int r = m_iSyncRead;
-		unsigned int w = m_iSyncWrite;
-		if (w > r) {
-			n = ((r - w + m_iSyncSize) & m_iSyncMask) - 1;
-		} else if (r > w) {
-			n = (r - w) - 1;
-		} else {
-			n = m_iSyncSize - 1;
+void qtractorAudioBufferPool::sync ( qtractorAudioBuffer *pAudioBuffer )
+{
+	if (pAudioBuffer) {
+		// Pin the current ring, so that a concurrent resize
+		// waits for us before draining it for the last time...
+		SyncRing *pSyncRing;
+		for (;;) {
+			pSyncRing = qtractorAudioBufferPool_load(m_syncRing);
+			ATOMIC_INC(&pSyncRing->users);
+			if (qtractorAudioBufferPool_load(m_syncRing) == pSyncRing)
+				break;
+			ATOMIC_DEC(&pSyncRing->users);
 		}
-		if (n > 0) {
+		// Reserve a request slot (there may be concurrent producers)...
+		unsigned int w;
+		do {
+			w = ATOMIC_GET(&pSyncRing->write);
+			if (w - pSyncRing->read >= pSyncRing->mask)
+				break;
+		} while (!ATOMIC_CAS(&pSyncRing->write, w, w + 1));
+		if (w - pSyncRing->read < pSyncRing->mask) {
 			pAudioBuffer->setSyncFlag(qtractorAudioBuffer::WaitSync);
-			m_ppSyncItems[w] = pAudioBuffer;
-			m_iSyncWrite = (w + 1) & m_iSyncMask;
+			pSyncRing->items[w & pSyncRing->mask].fetchAndStoreOrdered(pAudioBuffer);
 		}
+		ATOMIC_DEC(&pSyncRing->users);
 	}
 
 	if (m_mutex.tryLock()) {
@@ -116,80 +240,210 @@ void qtractorAudioBufferThread::sync ( qtractorAudioBuffer *pAudioBuffer )
 		m_mutex.unlock();
 	}
 #ifdef CONFIG_DEBUG_0
-	else qDebug("qtractorAudioBufferThread[%p]::sync(): tryLock() failed.", this);
+	else qDebug("qtractorAudioBufferPool[%p]::sync(): tryLock() failed.", this);
 #endif
 }
 
 
 // Bypass executive wait condition (non RT-safe).
-void qtractorAudioBufferThread::syncExport (void)
+void qtractorAudioBufferPool::syncExport (void)
 {
 	QMutexLocker locker(&m_mutex);
 
-	process();
+	// Have all workers take care of everything pending...
+	drain();
+
+	while (!m_pending.isEmpty() || !m_active.isEmpty()) {
+		m_cond.wakeAll();
+		m_idle.wait(&m_mutex);
+		drain();
+	}
 }
 
 
-// Thread run executive.
-void qtractorAudioBufferThread::run (void)
+// Withdraw all requests of a closing buffer (non RT-safe).
+void qtractorAudioBufferPool::cancel ( qtractorAudioBuffer *pAudioBuffer )
 {
-#ifdef CONFIG_DEBUG_0
-	qDebug("qtractorAudioBufferThread[%p]::run(): started.", this);
-#endif
+	QMutexLocker locker(&m_mutex);
 
-	m_mutex.lock();
+	drain();
 
-	m_bRunState = true;
+	m_pending.removeAll(pAudioBuffer);
+	m_iQueueDepth = m_pending.count();
+
+	while (m_active.contains(pAudioBuffer))
+		m_idle.wait(&m_mutex);
+}
+
+
+// Buffer (de)registration; grows the request ring (non RT-safe).
+void qtractorAudioBufferPool::attach (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	checkSyncSize(++m_iBuffers);
+}
+
+void qtractorAudioBufferPool::detach (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	if (m_iBuffers > 0)
+		--m_iBuffers;
+}
+
+
+// Conditional resize check (non RT-safe);
+// must be called with the mutex locked.
+void qtractorAudioBufferPool::checkSyncSize ( unsigned int iSyncSize )
+{
+	SyncRing *pOldSyncRing = qtractorAudioBufferPool_load(m_syncRing);
+	if (iSyncSize <= (pOldSyncRing->size - 4))
+		return;
+
+	unsigned int iNewSyncSize = (pOldSyncRing->size << 1);
+	while (iNewSyncSize < iSyncSize)
+		iNewSyncSize <<= 1;
 
-	while (m_bRunState) {
-		// Do whatever we must, then wait for more...
-		process();
+	// Hand-off: new producers go straight to the new ring...
+	m_syncRing.fetchAndStoreOrdered(new SyncRing(iNewSyncSize));
+
+	// Wait for late producers still posting into the old ring...
+	while (qtractorAudioBufferPool_load(&pOldSyncRing->users) > 0)
+		QThread::yieldCurrentThread();
+
+	// Nothing gets lost: all reserved slots are published by now...
+	drain(pOldSyncRing);
+
+	// Keep it around, for producers still backing off from it.
+	m_retired.append(pOldSyncRing);
+}
+
+
+// Worker thread executive.
+void qtractorAudioBufferPool::run ( unsigned int iSlot )
+{
+	m_mutex.lock();
+
+	while (m_bRunState && iSlot < m_iThreads) {
+		// Do whatever is most urgent...
+		drain();
+		qtractorAudioBuffer *pAudioBuffer = claim();
+		if (pAudioBuffer) {
+			m_active.append(pAudioBuffer);
+			m_mutex.unlock();
+			pAudioBuffer->sync();
+			m_mutex.lock();
+			m_active.removeOne(pAudioBuffer);
+			++m_iSyncCount;
+			m_idle.wakeAll();
+			continue;
+		}
 		// Wait for sync...
 		m_cond.wait(&m_mutex);
 	}
 
 	m_mutex.unlock();
-
-#ifdef CONFIG_DEBUG_0
-	qDebug("qtractorAudioBufferThread[%p]::run(): stopped.", this);
-#endif
 }
 
 
-// Thread run executive.
-void qtractorAudioBufferThread::process (void)
+// Move all posted requests into the pending list;
+// must be called with the mutex locked.
+void qtractorAudioBufferPool::drain (void)
 {
-	unsigned int r = m_iSyncRead;
-	unsigned int w = m_iSyncWrite;
+	drain(qtractorAudioBufferPool_load(m_syncRing));
+}
+
+void qtractorAudioBufferPool::drain ( SyncRing *pSyncRing )
+{
+	unsigned int r = pSyncRing->read;
+	const unsigned int w = ATOMIC_GET(&pSyncRing->write);
 
 	while (r != w) {
-		m_ppSyncItems[r]->sync();
-		++r &= m_iSyncMask;
-		w = m_iSyncWrite;
+		// Slot reserved but not yet published?
+		qtractorAudioBuffer *pAudioBuffer
+			= pSyncRing->items[r & pSyncRing->mask].fetchAndStoreOrdered(NULL);
+		if (pAudioBuffer == NULL)
+			break;
+		if (!m_pending.contains(pAudioBuffer))
+			m_pending.append(pAudioBuffer);
+		++r;
 	}
 
-	m_iSyncRead = r;
+	pSyncRing->read = r;
+
+	m_iQueueDepth = m_pending.count();
+	if (m_iQueueDepthMax < m_iQueueDepth)
+		m_iQueueDepthMax = m_iQueueDepth;
 }
 
 
-// Conditional resize check.
-void qtractorAudioBufferThread::checkSyncSize ( unsigned int iSyncSize )
+// Pick the most urgent pending request (earliest deadline)
+// not already in-flight; must be called with the mutex locked.
+qtractorAudioBuffer *qtractorAudioBufferPool::claim (void)
 {
-	if (iSyncSize > (m_iSyncSize - 4)) {
-		QMutexLocker locker(&m_mutex);
-		unsigned int iNewSyncSize = (m_iSyncSize << 1);
-		while (iNewSyncSize < iSyncSize)
-			iNewSyncSize <<= 1;
-		qtractorAudioBuffer **ppNewSyncItems
-			= new qtractorAudioBuffer * [iNewSyncSize];
-		qtractorAudioBuffer **ppOldSyncItems = m_ppSyncItems;
-		::memcpy(ppNewSyncItems, ppOldSyncItems,
-			m_iSyncSize * sizeof(qtractorAudioBuffer *));
-		m_iSyncSize = iNewSyncSize;
-		m_iSyncMask = (iNewSyncSize - 1);
-		m_ppSyncItems = ppNewSyncItems;
-		delete [] ppOldSyncItems;
+	int iClaim = -1;
+	unsigned int iDeadline = 0;
+
+	const int iPending = m_pending.count();
+	for (int i = 0; i < iPending; ++i) {
+		qtractorAudioBuffer *pAudioBuffer = m_pending.at(i);
+		if (m_active.contains(pAudioBuffer))
+			continue;
+		const unsigned int iSyncDeadline = pAudioBuffer->syncDeadline();
+		if (iClaim < 0 || iDeadline > iSyncDeadline) {
+			iClaim = i;
+			iDeadline = iSyncDeadline;
+			if (iDeadline == 0)
+				break;
+		}
 	}
+
+	if (iClaim < 0)
+		return NULL;
+
+	m_iQueueDepth = iPending - 1;
+
+	return m_pending.takeAt(iClaim);
+}
+
+
+// Missed deadline (ring-buffer underrun) tally (RT-safe).
+void qtractorAudioBufferPool::missDeadline (void)
+{
+	ATOMIC_INC(&m_missed);
+}
+
+
+// Sync request statistics.
+unsigned int qtractorAudioBufferPool::queueDepth (void) const
+{
+	return m_iQueueDepth;
+}
+
+unsigned int qtractorAudioBufferPool::queueDepthMax (void) const
+{
+	return m_iQueueDepthMax;
+}
+
+unsigned long qtractorAudioBufferPool::syncCount (void) const
+{
+	return m_iSyncCount;
+}
+
+unsigned long qtractorAudioBufferPool::missedCount (void) const
+{
+	return (unsigned long) ATOMIC_GET(&m_missed);
+}
+
+void qtractorAudioBufferPool::resetStats (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_iQueueDepthMax = m_iQueueDepth;
+	m_iSyncCount = 0;
+
+	ATOMIC_SET(&m_missed, 0);
 }
 
 
@@ -199,9 +453,9 @@ void qtractorAudioBufferThread::checkSyncSize ( unsigned int iSyncSize )
 
 // Constructors.
 qtractorAudioBuffer::qtractorAudioBuffer (
-	qtractorAudioBufferThread *pSyncThread, unsigned short iChannels )
+	qtractorAudioBufferPool *pSyncPool, unsigned short iChannels )
 {
-	m_pSyncThread    = pSyncThread;
+	m_pSyncPool      = pSyncPool;
 
 	m_iChannels      = iChannels;
 
@@ -248,6 +502,28 @@ qtractorAudioBuffer::qtractorAudioBuffer (
 	m_fNextGain      = 0.0f;
 	m_iRampGain      = 1;
 
+#if defined(CONFIG_AVX2_MIX)
+	if (avx2_enabled()) {
+		m_pfnMixRamp  = avx2_mix_ramp;
+		m_pfnGainRamp = avx2_gain_ramp;
+	} else
+#endif
+#if defined(__SSE__)
+	if (sse_enabled()) {
+		m_pfnMixRamp  = sse_mix_ramp;
+		m_pfnGainRamp = sse_gain_ramp;
+	} else
+#endif
+#if defined(__ARM_NEON__)
+	m_pfnMixRamp  = neon_mix_ramp;
+	m_pfnGainRamp = neon_gain_ramp;
+	if (false)
+#endif
+	{
+		m_pfnMixRamp  = std_mix_ramp;
+		m_pfnGainRamp = std_gain_ramp;
+	}
+
 #ifdef CONFIG_LIBSAMPLERATE
 	m_bResample      = false;
 	m_fResampleRatio = 1.0f;
@@ -259,6 +535,20 @@ qtractorAudioBuffer::qtractorAudioBuffer (
 
 	m_pPeakFile      = NULL;
 
+	m_pCacheItem     = NULL;
+
+	for (unsigned int k = 0; k < LandingSlots; ++k) {
+		LandingSlot *pSlot = &m_landing[k];
+		ATOMIC_SET(&pSlot->state, LandingEmpty);
+		pSlot->offset = 0;
+		pSlot->frames = 0;
+		pSlot->buffer = NULL;
+	}
+
+	m_pLanding = NULL;
+
+	ATOMIC_SET(&m_landingPending, 0);
+
 	// Time-stretch mode local options.
 	m_bWsolaTimeStretch = g_bDefaultWsolaTimeStretch;
 	m_bWsolaQuickSeek   = g_bDefaultWsolaQuickSeek;
@@ -369,6 +659,24 @@ bool qtractorAudioBuffer::open ( const QString& sFilename, int iMode )
 			m_iOffset = 0;
 	}
 
+	// Shared decoded audio cache key (read-only mode)...
+	m_sCacheKey.clear();
+	if (iMode & qtractorAudioFile::Read) {
+		unsigned int iFlags = 0;
+		if (m_bWsolaTimeStretch)
+			iFlags |= 1;
+		if (m_bWsolaQuickSeek)
+			iFlags |= 2;
+	#ifdef CONFIG_LIBSAMPLERATE
+		if (m_bResample)
+			iFlags |= (g_iDefaultResampleType + 1) << 2;
+	#endif
+		m_sCacheKey = qtractorAudioCache::key(sFilename, iSampleRate,
+			m_iOffset, m_iLength,
+			(m_bTimeStretch ? m_fTimeStretch : 1.0f),
+			(m_bPitchShift  ? m_fPitchShift  : 1.0f), iFlags);
+	}
+
 	// Allocate ring-buffer now.
 	unsigned int iBufferSize = m_iLength;
 	if (iBufferSize == 0)
@@ -452,8 +760,10 @@ bool qtractorAudioBuffer::open ( const QString& sFilename, int iMode )
 		m_pfGains[i] = 1.0f;
 
 	// Make it sync-managed...
-	if (m_pSyncThread)
-		m_pSyncThread->sync(this);
+	if (m_pSyncPool) {
+		m_pSyncPool->attach();
+		m_pSyncPool->sync(this);
+	}
 	
 	return true;
 }
@@ -466,13 +776,19 @@ void qtractorAudioBuffer::close (void)
 		return;
 
 	// Wait for regular file close...
-	if (m_pSyncThread) {
+	if (m_pSyncPool) {
 		setSyncFlag(CloseSync);
-		m_pSyncThread->sync(this);
+		m_pSyncPool->sync(this);
 		do QThread::yieldCurrentThread();
 		while (isSyncFlag(CloseSync));
+		// Make sure no worker will ever get back to us...
+		m_pSyncPool->cancel(this);
+		m_pSyncPool->detach();
 	}
 
+	// Release any prefetched landing areas...
+	clearLanding();
+
 	// Delete old panning-gains holders...
 	if (m_pfGains) {
 		delete [] m_pfGains;
@@ -508,6 +824,14 @@ void qtractorAudioBuffer::close (void)
 		m_ppBuffer = NULL;
 	}
 
+	// Release shared decoded audio, if any...
+	if (m_pCacheItem) {
+		qtractorSession *pSession = qtractorSession::getInstance();
+		if (pSession)
+			pSession->audioCache()->release(m_pCacheItem);
+		m_pCacheItem = NULL;
+	}
+
 	if (m_pRingBuffer) {
 		deleteIOBuffers();
 		delete m_pRingBuffer;
@@ -614,8 +938,8 @@ int qtractorAudioBuffer::read ( float **ppFrames, unsigned int iFrames,
 
 	// Time to sync()?
 	if (!m_bIntegral &&
-		m_pSyncThread && m_pRingBuffer->writable() > m_iThreshold)
-		m_pSyncThread->sync(this);
+		m_pSyncPool && m_pRingBuffer->writable() > m_iThreshold)
+		m_pSyncPool->sync(this);
 
 	return nread;
 }
@@ -689,8 +1013,8 @@ int qtractorAudioBuffer::write ( float **ppFrames, unsigned int iFrames,
 	m_iWriteOffset += nwrite;
 
 	// Time to sync()?
-	if (m_pSyncThread && m_pRingBuffer->readable() > m_iThreshold)
-		m_pSyncThread->sync(this);
+	if (m_pSyncPool && m_pRingBuffer->readable() > m_iThreshold)
+		m_pSyncPool->sync(this);
 
 	return nwrite;
 }
@@ -703,6 +1027,10 @@ int qtractorAudioBuffer::readMix ( float **ppFrames, unsigned int iFrames,
 	if (m_pRingBuffer == NULL)
 		return -1;
 
+	// Still playing out of a landing area?
+	if (m_pLanding)
+		return readMixLanding(ppFrames, iFrames, iChannels, iOffset, fGain);
+
 	int nread = iFrames;
 
 	unsigned long ro = m_iReadOffset;
@@ -771,11 +1099,81 @@ int qtractorAudioBuffer::readMix ( float **ppFrames, unsigned int iFrames,
 		// Force out-of-sync...
 		setSyncFlag(ReadSync, false);
 	}
+	else
+	if (nread < int(iFrames) && m_iReadOffset < m_iFileLength
+		&& m_pSyncPool && !ATOMIC_GET(&m_seekPending)) {
+		// Ring-buffer ran dry: the sync request came in too late...
+		m_pSyncPool->missDeadline();
+	}
 
 	// Time to sync()?
 	if (!m_bIntegral &&
-		m_pSyncThread && m_pRingBuffer->writable() > m_iThreshold)
-		m_pSyncThread->sync(this);
+		m_pSyncPool && m_pRingBuffer->writable() > m_iThreshold)
+		m_pSyncPool->sync(this);
+
+	return nread;
+}
+
+
+// Landing cache play-out (RT-safe).
+int qtractorAudioBuffer::readMixLanding ( float **ppFrames,
+	unsigned int iFrames, unsigned short iChannels, unsigned int iOffset,
+	float fGain )
+{
+	LandingSlot *pLanding = m_pLanding;
+
+	const unsigned long ls = m_iOffset + pLanding->offset;
+	const unsigned long le = ls + pLanding->frames;
+	const unsigned long re = m_iOffset + m_iLength;
+	const unsigned long ro = m_iReadOffset;
+
+	int nread = 0;
+
+	if (ro >= ls && ro < le) {
+		nread = le - ro;
+		if (nread > int(iFrames))
+			nread = iFrames;
+		// Take care of end-of-stream...
+		if (ro + iFrames >= re)
+			m_iRampGain = -1;
+		const unsigned int r = ro - ls;
+		const unsigned short iBuffers = m_pRingBuffer->channels();
+		for (unsigned short i = 0; i < iBuffers; ++i) {
+			::memcpy(m_ppBuffer[i], pLanding->buffer[i] + r,
+				nread * sizeof(float));
+		}
+		nread = mixFrames(ppFrames, nread, iChannels, iOffset, fGain);
+		m_iReadOffset = ro + nread;
+	}
+
+	if (m_iReadOffset >= re) {
+		// Force out-of-sync...
+		setSyncFlag(ReadSync, false);
+	}
+	else
+	if (m_iReadOffset >= le || m_iReadOffset < ls) {
+		// Landing area is over, get back to the ring-buffer...
+		releaseLanding();
+		if (ATOMIC_GET(&m_landingPending) == 0) {
+			if (nread < int(iFrames)) {
+				const int nmore = readMix(ppFrames,
+					iFrames - nread, iChannels, iOffset + nread, fGain);
+				if (nmore > 0)
+					nread += nmore;
+			}
+		} else {
+			// Too late: force (late) out-of-sync...
+			ATOMIC_SET(&m_landingPending, 0);
+			m_iReadOffset = m_iOffset + m_iLength + 1;
+			setSyncFlag(ReadSync, false);
+			if (m_pSyncPool)
+				m_pSyncPool->missDeadline();
+		}
+	}
+
+	// Time to sync()?
+	if (m_pSyncPool && m_pRingBuffer->writable() > m_iThreshold)
+		m_pSyncPool->sync(this);
 
 	return nread;
 }
@@ -823,18 +1221,63 @@ bool qtractorAudioBuffer::seek ( unsigned long iFrame )
 	iFrame += m_iOffset;
 
 	// Check if target is already cached...
-	const unsigned int  rs = m_pRingBuffer->readable();
-	const unsigned int  ri = m_pRingBuffer->readIndex();
-	const unsigned long ro = m_iReadOffset;
-	if (iFrame >= ro && iFrame < ro + rs) {
-		m_pRingBuffer->setReadIndex(ri + iFrame - ro);
-	//	m_iWriteOffset += iFrame - ro;
-		m_iReadOffset   = iFrame;
-		// Maybe (late) in-sync...
-		//setSyncFlag(ReadSync);
+	// (not while playing out of a landing area)
+	if (m_pLanding == NULL) {
+		const unsigned int  rs = m_pRingBuffer->readable();
+		const unsigned int  ri = m_pRingBuffer->readIndex();
+		const unsigned long ro = m_iReadOffset;
+		if (iFrame >= ro && iFrame < ro + rs) {
+			m_pRingBuffer->setReadIndex(ri + iFrame - ro);
+		//	m_iWriteOffset += iFrame - ro;
+			m_iReadOffset   = iFrame;
+			// Maybe (late) in-sync...
+			//setSyncFlag(ReadSync);
+			return true;
+		}
+	}
+
+	// Check if target has been prefetched (landing)...
+	const unsigned long iLanding = iFrame - m_iOffset;
+	LandingSlot *pLanding = m_pLanding;
+	if (pLanding == NULL
+		|| iLanding <  pLanding->offset
+		|| iLanding >= pLanding->offset + pLanding->frames) {
+		pLanding = NULL;
+		for (unsigned int k = 0; k < LandingSlots; ++k) {
+			LandingSlot *pSlot = &m_landing[k];
+			if (ATOMIC_GET(&pSlot->state) != LandingReady)
+				continue;
+			if (!ATOMIC_CAS(&pSlot->state, LandingReady, LandingActive))
+				continue;
+			if (iLanding >= pSlot->offset
+				&& iLanding <  pSlot->offset + pSlot->frames) {
+				pLanding = pSlot;
+				break;
+			}
+			ATOMIC_CAS(&pSlot->state, LandingActive, LandingReady);
+		}
+		if (pLanding) {
+			releaseLanding();
+			m_pLanding = pLanding;
+		}
+	}
+
+	if (pLanding) {
+		// Play out from RAM right away, while the
+		// ring-buffer gets refilled past the landing area...
+		m_iReadOffset = iFrame;
+		m_iSeekOffset = m_iOffset + pLanding->offset + pLanding->frames;
+		ATOMIC_INC(&m_landingPending);
+		ATOMIC_INC(&m_seekPending);
+		if (m_pSyncPool)
+			m_pSyncPool->sync(this);
 		return true;
 	}
 
+	// Not from a landing area anymore...
+	releaseLanding();
+	ATOMIC_SET(&m_landingPending, 0);
+
 #ifdef CONFIG_DEBUG_0
 	qDebug("qtractorAudioBuffer[%p]::seek(%lu) pending(%d, %lu) wo=%lu ro=%lu",
 		this, iFrame, ATOMIC_GET(&m_seekPending), m_iSeekOffset,
@@ -851,8 +1294,8 @@ bool qtractorAudioBuffer::seek ( unsigned long iFrame )
 	ATOMIC_INC(&m_seekPending);
 
 	// readSync();
-	if (m_pSyncThread)
-		m_pSyncThread->sync(this);
+	if (m_pSyncPool)
+		m_pSyncPool->sync(this);
 
 	return true;
 }
@@ -906,6 +1349,34 @@ void qtractorAudioBuffer::initSync (void)
 	m_fNextGain = 0.0f;
 	m_iRampGain = 1;
 
+	// Maybe it has been decoded integrally already...
+	qtractorSession *pSession = qtractorSession::getInstance();
+	qtractorAudioCache *pAudioCache
+		= (pSession && !m_sCacheKey.isEmpty() ? pSession->audioCache() : NULL);
+	if (pAudioCache) {
+		qtractorAudioCache::Item *pItem = pAudioCache->acquire(m_sCacheKey);
+		if (pItem && (pItem->channels() != m_pRingBuffer->channels()
+			|| pItem->bufferSize() != m_pRingBuffer->bufferSize())) {
+			pAudioCache->release(pItem);
+			pItem = NULL;
+		}
+		if (pItem) {
+			// Share it, read-only...
+			m_pCacheItem = pItem;
+			m_pRingBuffer->setBuffer(pItem->frames());
+			m_pRingBuffer->setReadIndex(0);
+			m_pRingBuffer->setWriteIndex(pItem->length());
+			m_iFileLength  = m_iOffset + pItem->length();
+			m_iWriteOffset = m_iFileLength;
+			m_iReadOffset  = m_iOffset;
+			m_bIntegral = true;
+			deleteIOBuffers();
+			setSyncFlag(InitSync);
+			setSyncFlag(CloseSync, false);
+			return;
+		}
+	}
+
 	// Set to initial offset...
 	m_iSeekOffset = m_iOffset;
 
@@ -922,6 +1393,14 @@ void qtractorAudioBuffer::initSync (void)
 	if (m_iFileLength < m_iOffset + m_pRingBuffer->bufferSize() - 1) {
 		m_bIntegral = true;
 		deleteIOBuffers();
+		// Have it shared from now on...
+		if (pAudioCache) {
+			m_pCacheItem = pAudioCache->insert(m_sCacheKey,
+				m_pRingBuffer->buffer(), m_pRingBuffer->channels(),
+				m_pRingBuffer->bufferSize(), m_iFileLength - m_iOffset);
+			if (m_pCacheItem)
+				m_pRingBuffer->detachBuffer();
+		}
 	}
 	else // Re-sync if loop falls short in initial area... 
 	if (m_iLoopStart < m_iLoopEnd
@@ -955,8 +1434,10 @@ void qtractorAudioBuffer::sync (void)
 	} else {
 		setSyncFlag(WaitSync, false);
 		const int mode = m_pFile->mode();
-		if (mode & qtractorAudioFile::Read)
+		if (mode & qtractorAudioFile::Read) {
 			readSync();
+			landingSync();
+		}
 		else
 		if (mode & qtractorAudioFile::Write)
 			writeSync();
@@ -968,6 +1449,26 @@ void qtractorAudioBuffer::sync (void)
 }
 
 
+// Sync request deadline, in frames left to ring-buffer
+// over/underrun; zero means as soon as possible.
+unsigned int qtractorAudioBuffer::syncDeadline (void) const
+{
+	if (m_pFile == NULL || m_pRingBuffer == NULL)
+		return 0;
+
+	if (!isSyncFlag(InitSync) || isSyncFlag(CloseSync))
+		return 0;
+
+	if (ATOMIC_GET(&m_seekPending) > 0)
+		return 0;
+
+	if (m_pFile->mode() & qtractorAudioFile::Write)
+		return m_pRingBuffer->writable();
+	else
+		return m_pRingBuffer->readable();
+}
+
+
 // Audio frame process synchronization predicate method.
 bool qtractorAudioBuffer::inSync (
 	unsigned long iFrameStart, unsigned long iFrameEnd )
@@ -997,7 +1498,7 @@ bool qtractorAudioBuffer::inSync (
 // Export-mode sync executive.
 void qtractorAudioBuffer::syncExport (void)
 {
-	if (m_pSyncThread) m_pSyncThread->syncExport();
+	if (m_pSyncPool) m_pSyncPool->syncExport();
 }
 
 
@@ -1010,8 +1511,12 @@ void qtractorAudioBuffer::readSync (void)
 	if (isSyncFlag(CloseSync))
 		return;
 
+	// Whether we're refilling past some landing area...
+	int iLanding = 0;
+
 	// Check whether we have some hard-seek pending...
 	if (ATOMIC_TAZ(&m_seekPending)) {
+		iLanding = ATOMIC_GET(&m_landingPending);
 		// Do it...
 		if (!seekSync(m_iSeekOffset))
 			return;
@@ -1019,12 +1524,18 @@ void qtractorAudioBuffer::readSync (void)
 		m_pRingBuffer->reset();
 		// Override with new intended offset...
 		m_iWriteOffset = m_iSeekOffset;
-		m_iReadOffset  = m_iSeekOffset;
+		// (read offset is still the landing area's)
+		if (iLanding == 0)
+			m_iReadOffset = m_iSeekOffset;
 	}
 
 	const unsigned int ws = m_pRingBuffer->writable();
-	if (ws == 0)
+	if (ws == 0) {
+		// Nothing to refill, but still hand over the landing area...
+		if (iLanding > 0)
+			ATOMIC_CAS(&m_landingPending, iLanding, 0);
 		return;
+	}
 
 	unsigned int nahead = ws;
 	unsigned int ntotal = 0;
@@ -1076,6 +1587,10 @@ void qtractorAudioBuffer::readSync (void)
 			}
 		}
 	}
+
+	// Ring-buffer is now ready to take over the landing area...
+	if (iLanding > 0)
+		ATOMIC_CAS(&m_landingPending, iLanding, 0);
 }
 
 
@@ -1116,6 +1631,127 @@ void qtractorAudioBuffer::writeSync (void)
 }
 
 
+// Landing cache sync executive (prefetch).
+void qtractorAudioBuffer::landingSync (void)
+{
+	if (m_pRingBuffer == NULL || m_bIntegral)
+		return;
+
+	if (isSyncFlag(CloseSync))
+		return;
+
+	// Only plain streams may be prefetched at random...
+	if (m_bTimeStretch || m_bPitchShift)
+		return;
+#ifdef CONFIG_LIBSAMPLERATE
+	if (m_bResample)
+		return;
+#endif
+
+	m_landingMutex.lock();
+	const QList<unsigned long> targets = m_landingTargets;
+	m_landingMutex.unlock();
+
+	unsigned int k;
+
+	// Retire the ones that are not wanted anymore...
+	for (k = 0; k < LandingSlots; ++k) {
+		LandingSlot *pSlot = &m_landing[k];
+		if (ATOMIC_GET(&pSlot->state) == LandingReady
+			&& !targets.contains(pSlot->offset))
+			ATOMIC_CAS(&pSlot->state, LandingReady, LandingEmpty);
+	}
+
+	const unsigned short iBuffers = m_pRingBuffer->channels();
+	const int iLandingSize = (iBuffers * m_iThreshold * sizeof(float)) >> 10;
+	const int iLandingBudget = (g_iDefaultLandingBudget << 10);
+
+	bool bSeekSync = false;
+
+	// Prefetch the ones still missing...
+	QListIterator<unsigned long> iter(targets);
+	while (iter.hasNext() && !ATOMIC_GET(&m_seekPending)) {
+		const unsigned long iOffset = iter.next();
+		if (iOffset >= m_iLength)
+			continue;
+		LandingSlot *pFree = NULL;
+		for (k = 0; k < LandingSlots; ++k) {
+			LandingSlot *pSlot = &m_landing[k];
+			if (ATOMIC_GET(&pSlot->state) == LandingEmpty) {
+				if (pFree == NULL || pFree->buffer == NULL)
+					pFree = pSlot;
+			}
+			else
+			if (pSlot->offset == iOffset) {
+				pFree = NULL;
+				break;
+			}
+		}
+		if (pFree == NULL)
+			continue;
+		// Stop short of the loop-end point, if any...
+		unsigned int nframes = m_iThreshold;
+		if (iOffset + nframes > m_iLength)
+			nframes = m_iLength - iOffset;
+		if (m_iLoopStart < m_iLoopEnd && iOffset < m_iLoopEnd
+			&& iOffset + nframes >= m_iLoopEnd)
+			nframes = m_iLoopEnd - iOffset - 1;
+		if (nframes < m_iBufferSize)
+			continue;
+		// Within memory budget?
+		if (pFree->buffer == NULL) {
+			// Reserve against the shared budget (concurrent buffers)...
+			int iLandingUsed;
+			do {
+				iLandingUsed = ATOMIC_GET(&g_landingUsed);
+				if (iLandingUsed + iLandingSize > iLandingBudget)
+					break;
+			} while (!ATOMIC_CAS(&g_landingUsed,
+				iLandingUsed, iLandingUsed + iLandingSize));
+			if (iLandingUsed + iLandingSize > iLandingBudget)
+				break;
+			pFree->buffer = new float * [iBuffers];
+			for (unsigned short i = 0; i < iBuffers; ++i)
+				pFree->buffer[i] = new float [m_iThreshold];
+		}
+		if (!ATOMIC_CAS(&pFree->state, LandingEmpty, LandingBusy))
+			continue;
+		// Read it in...
+		unsigned int nread = 0;
+		if (m_pFile->seek(m_iOffset + iOffset)) {
+			bSeekSync = true;
+			while (nread < nframes) {
+				unsigned int nahead = nframes - nread;
+				if (nahead > m_iBufferSize)
+					nahead = m_iBufferSize;
+				const int n = m_pFile->read(m_ppFrames, nahead);
+				if (n < 1)
+					break;
+				for (unsigned short i = 0; i < iBuffers; ++i) {
+					::memcpy(pFree->buffer[i] + nread, m_ppFrames[i],
+						n * sizeof(float));
+				}
+				nread += n;
+			}
+		}
+		pFree->offset = iOffset;
+		pFree->frames = nread;
+		if (nread > 0) {
+			const unsigned long iFileLength = m_iOffset + iOffset + nread;
+			if (m_iFileLength < iFileLength)
+				m_iFileLength = iFileLength;
+			ATOMIC_CAS(&pFree->state, LandingBusy, LandingReady);
+		} else {
+			ATOMIC_SET(&pFree->state, LandingEmpty);
+		}
+	}
+
+	// Resume streaming where it was left...
+	if (bSeekSync && !ATOMIC_GET(&m_seekPending))
+		m_pFile->seek(m_iWriteOffset);
+}
+
+
 // Internal-seek sync executive.
 bool qtractorAudioBuffer::seekSync ( unsigned long iFrame )
 {
@@ -1314,25 +1950,33 @@ int qtractorAudioBuffer::readMixFrames (
 	if (nread == 0)
 		return 0;
 
+	return mixFrames(ppFrames, nread, iChannels, iOffset, fGain);
+}
+
+
+// Channel-mix buffer helper (off the internal read-mix buffer).
+int qtractorAudioBuffer::mixFrames (
+	float **ppFrames, unsigned int iFrames, unsigned short iChannels,
+	unsigned int iOffset, float fGain )
+{
+	const int nread = iFrames;
+	if (nread == 0)
+		return 0;
+
 	const unsigned short iBuffers = m_pRingBuffer->channels();
 
-	unsigned short i, j; int n;
-	float fGainIter, fGainStep1, fGainStep2;
-	float *pFrames, *pBuffer;
+	unsigned short i, j;
+	float fGainStep1;
 
 	// HACK: Case of clip ramp in/out-set in this run...
 	if (m_iRampGain) {
 		const unsigned int nramp
 			= (nread < QTRACTOR_RAMP_LENGTH ? nread : QTRACTOR_RAMP_LENGTH);
-		const int n0 = (m_iRampGain < 0 ? nread - nramp : nramp);
-		const int n1 = (m_iRampGain < 0 ? n0 : 0);
-		const int n2 = (m_iRampGain < 0 ? nread : n0);
+		const int n1 = (m_iRampGain < 0 ? nread - nramp : 0);
 		fGainStep1 = float(m_iRampGain) / float(nramp);
 		for (i = 0; i < iBuffers; ++i) {
-			fGainIter = (m_iRampGain < 0 ? 1.0f : 0.0f);
-			pBuffer = m_ppBuffer[i] + n1;
-			for (n = n1; n < n2; ++n, fGainIter += fGainStep1)
-				*pBuffer++ *= fGainIter;
+			(*m_pfnGainRamp)(m_ppBuffer[i] + n1, nramp,
+				(m_iRampGain < 0 ? 1.0f : 0.0f), fGainStep1);
 		}
 		m_iRampGain = (m_iRampGain < 0 ? 1 : 0);
 	//	fPrevGain = fGain;
@@ -1346,23 +1990,15 @@ int qtractorAudioBuffer::readMixFrames (
 
 	if (iChannels == iBuffers) {
 		for (i = 0; i < iBuffers; ++i) {
-			pFrames = ppFrames[i] + iOffset;
-			pBuffer = m_ppBuffer[i];
-			fGainIter = fPrevGain * m_pfGains[i];
-			fGainStep2 = fGainStep1 * m_pfGains[i];
-			for (n = 0; n < nread; ++n, fGainIter += fGainStep2)
-				*pFrames++ += fGainIter * *pBuffer++;
+			(*m_pfnMixRamp)(ppFrames[i] + iOffset, m_ppBuffer[i], nread,
+				fPrevGain * m_pfGains[i], fGainStep1 * m_pfGains[i]);
 		}
 	}
 	else if (iChannels > iBuffers) {
 		j = 0;
 		for (i = 0; i < iChannels; ++i) {
-			pFrames = ppFrames[i] + iOffset;
-			pBuffer = m_ppBuffer[j];
-			fGainIter = fPrevGain * m_pfGains[j];
-			fGainStep2 = fGainStep1 * m_pfGains[j];
-			for (n = 0; n < nread; ++n, fGainIter += fGainStep2)
-				*pFrames++ += fGainIter * *pBuffer++;
+			(*m_pfnMixRamp)(ppFrames[i] + iOffset, m_ppBuffer[j], nread,
+				fPrevGain * m_pfGains[j], fGainStep1 * m_pfGains[j]);
 			if (++j >= iBuffers)
 				j = 0;
 		}
@@ -1370,12 +2006,8 @@ int qtractorAudioBuffer::readMixFrames (
 	else { // (iChannels < iBuffers)
 		i = 0;
 		for (j = 0; j < iBuffers; ++j) {
-			pFrames = ppFrames[i] + iOffset;
-			pBuffer = m_ppBuffer[j];
-			fGainIter = fPrevGain * m_pfGains[j];
-			fGainStep2 = fGainStep1 * m_pfGains[j];
-			for (n = 0; n < nread; ++n, fGainIter += fGainStep2)
-				*pFrames++ += fGainIter * *pBuffer++;
+			(*m_pfnMixRamp)(ppFrames[i] + iOffset, m_ppBuffer[j], nread,
+				fPrevGain * m_pfGains[j], fGainStep1 * m_pfGains[j]);
 			if (++i >= iChannels)
 				i = 0;
 		}
@@ -1653,6 +2285,89 @@ bool qtractorAudioBuffer::isWsolaQuickSeek (void) const
 }
 
 
+// Predictive seek prefetch (landing) targets,
+// in frames from the logical start (non RT-safe).
+void qtractorAudioBuffer::setLandingTargets (
+	const QList<unsigned long>& targets )
+{
+	if (m_pFile == NULL || m_bIntegral)
+		return;
+
+	if (m_pFile->mode() & qtractorAudioFile::Write)
+		return;
+
+	QMutexLocker locker(&m_landingMutex);
+
+	if (m_landingTargets == targets)
+		return;
+
+	m_landingTargets = targets;
+	while (m_landingTargets.count() > LandingSlots)
+		m_landingTargets.removeLast();
+
+	// Get the sync workers at it...
+	if (m_pSyncPool)
+		m_pSyncPool->sync(this);
+}
+
+
+// Landing cache slot release (RT-safe).
+void qtractorAudioBuffer::releaseLanding (void)
+{
+	LandingSlot *pLanding = m_pLanding;
+	if (pLanding) {
+		m_pLanding = NULL;
+		ATOMIC_CAS(&pLanding->state, LandingActive, LandingReady);
+	}
+}
+
+
+// Landing cache clean-up (non RT-safe).
+void qtractorAudioBuffer::clearLanding (void)
+{
+	const unsigned short iBuffers
+		= (m_pRingBuffer ? m_pRingBuffer->channels() : 0);
+	const int iLandingSize = (iBuffers * m_iThreshold * sizeof(float)) >> 10;
+
+	for (unsigned int k = 0; k < LandingSlots; ++k) {
+		LandingSlot *pSlot = &m_landing[k];
+		if (pSlot->buffer) {
+			for (unsigned short i = 0; i < iBuffers; ++i)
+				delete [] pSlot->buffer[i];
+			delete [] pSlot->buffer;
+			pSlot->buffer = NULL;
+			ATOMIC_ADD(&g_landingUsed, -iLandingSize);
+		}
+		ATOMIC_SET(&pSlot->state, LandingEmpty);
+		pSlot->offset = 0;
+		pSlot->frames = 0;
+	}
+
+	m_pLanding = NULL;
+
+	ATOMIC_SET(&m_landingPending, 0);
+
+	m_landingMutex.lock();
+	m_landingTargets.clear();
+	m_landingMutex.unlock();
+}
+
+
+// Landing cache memory budget, in MB (global option).
+unsigned int   qtractorAudioBuffer::g_iDefaultLandingBudget = 64;
+qtractorAtomic qtractorAudioBuffer::g_landingUsed;
+
+void qtractorAudioBuffer::setDefaultLandingBudget ( unsigned int iLandingBudget )
+{
+	g_iDefaultLandingBudget = iLandingBudget;
+}
+
+unsigned int qtractorAudioBuffer::defaultLandingBudget (void)
+{
+	return g_iDefaultLandingBudget;
+}
+
+
 // Sample-rate converter type (global option).
 int qtractorAudioBuffer::g_iDefaultResampleType = 2;	// SRC_SINC_FASTEST;
 
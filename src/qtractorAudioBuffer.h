@@ -25,6 +25,7 @@
 #include "qtractorList.h"
 #include "qtractorAudioFile.h"
 #include "qtractorRingBuffer.h"
+#include "qtractorAudioCache.h"
 
 #ifdef CONFIG_LIBSAMPLERATE
 // libsamplerate API
@@ -32,18 +33,21 @@
 #endif
 
 #include <QThread>
+#include <QAtomicPointer>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QList>
 
 
 // Forward declarations.
 class qtractorAudioPeakFile;
 class qtractorAudioBuffer;
+class qtractorAudioBufferPool;
 class qtractorTimeStretcher;
 
 
 //----------------------------------------------------------------------
-// class qtractorAudioBufferThread -- Ring-cache manager thread.
+// class qtractorAudioBufferThread -- Ring-cache I/O worker thread.
 //
 
 class qtractorAudioBufferThread : public QThread
@@ -51,14 +55,40 @@ class qtractorAudioBufferThread : public QThread
 public:
 
 	// Constructor.
-	qtractorAudioBufferThread(unsigned int iSyncSize = 8);
+	qtractorAudioBufferThread(
+		qtractorAudioBufferPool *pSyncPool, unsigned int iSlot);
+
+protected:
+
+	// The main thread executive.
+	void run();
+
+private:
+
+	// Instance variables.
+	qtractorAudioBufferPool *m_pSyncPool;
+	unsigned int m_iSlot;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioBufferPool -- Ring-cache I/O worker pool.
+//
+
+class qtractorAudioBufferPool
+{
+public:
+
+	// Constructor.
+	qtractorAudioBufferPool(unsigned int iThreads = 1,
+		unsigned int iSyncSize = 8);
 
 	// Destructor.
-	~qtractorAudioBufferThread();
+	~qtractorAudioBufferPool();
 
-	// Thread run state accessors.
-	void setRunState(bool bRunState);
-	bool runState() const;
+	// Number of I/O worker threads (non RT-safe).
+	void setThreads(unsigned int iThreads);
+	unsigned int threads() const;
 
 	// Wake from executive wait condition (RT-safe).
 	void sync(qtractorAudioBuffer *pAudioBuffer = NULL);
@@ -66,31 +96,93 @@ public:
 	// Bypass executive wait condition (non RT-safe).
 	void syncExport();
 
-	// Conditional resize check.
-	void checkSyncSize(unsigned int iSyncSize);
+	// Withdraw all requests of a closing buffer (non RT-safe).
+	void cancel(qtractorAudioBuffer *pAudioBuffer);
+
+	// Buffer (de)registration; grows the request ring (non RT-safe).
+	void attach();
+	void detach();
+
+	// Worker thread executive.
+	void run(unsigned int iSlot);
+
+	// Missed deadline (ring-buffer underrun) tally (RT-safe).
+	void missDeadline();
+
+	// Sync request statistics.
+	unsigned int queueDepth() const;
+	unsigned int queueDepthMax() const;
+
+	unsigned long syncCount() const;
+	unsigned long missedCount() const;
+
+	void resetStats();
 
 protected:
 
-	// The main thread executives.
-	void run();
-	void process();
+	// Move all posted requests into the pending list.
+	void drain();
+
+	// Conditional resize check (non RT-safe).
+	void checkSyncSize(unsigned int iSyncSize);
+
+	// Pick the most urgent pending request (earliest deadline).
+	qtractorAudioBuffer *claim();
 
 private:
 
 	// Instance variables.
-	unsigned int          m_iSyncSize;
-	unsigned int          m_iSyncMask;
-	qtractorAudioBuffer **m_ppSyncItems;
+	unsigned int m_iThreads;
+	qtractorAudioBufferThread **m_ppThreads;
+
+	// Multi-producer request ring (free-running counters).
+	struct SyncRing
+	{
+		// Constructor.
+		SyncRing(unsigned int iSyncSize);
+		// Destructor.
+		~SyncRing();
+
+		unsigned int    size;
+		unsigned int    mask;
+		QAtomicPointer<qtractorAudioBuffer> *items;
+
+		qtractorAtomic  write;
+		volatile unsigned int read;
+
+		// Producers currently posting into this ring.
+		qtractorAtomic  users;
+	};
+
+	// Move all posted requests of a ring into the pending list.
+	void drain(SyncRing *pSyncRing);
+
+	// Current request ring (handed off on resize).
+	QAtomicPointer<SyncRing> m_syncRing;
 
-	volatile unsigned int m_iSyncRead;
-	volatile unsigned int m_iSyncWrite;
+	// Retired request rings (for safe late producers).
+	QList<SyncRing *> m_retired;
 
-	// Whether the thread is logically running.
+	// Number of attached (open) buffers.
+	unsigned int m_iBuffers;
+
+	// Pending and currently in-flight requests.
+	QList<qtractorAudioBuffer *> m_pending;
+	QList<qtractorAudioBuffer *> m_active;
+
+	// Statistics.
+	volatile unsigned int m_iQueueDepth;
+	unsigned int  m_iQueueDepthMax;
+	unsigned long m_iSyncCount;
+	qtractorAtomic m_missed;
+
+	// Whether the pool is logically running.
 	volatile bool m_bRunState;
 
 	// Thread synchronization objects.
 	QMutex m_mutex;
 	QWaitCondition m_cond;
+	QWaitCondition m_idle;
 };
 
 
@@ -104,7 +196,7 @@ public:
 
 	// Constructor.
 	qtractorAudioBuffer(
-		qtractorAudioBufferThread *pSyncThread,	unsigned short iChannels);
+		qtractorAudioBufferPool *pSyncPool, unsigned short iChannels);
 
 	// Default destructor.
 	~qtractorAudioBuffer();
@@ -190,6 +282,10 @@ public:
 	// Base sync method.
 	void sync();
 
+	// Sync request deadline, in frames left to ring-buffer
+	// over/underrun; zero means as soon as possible.
+	unsigned int syncDeadline() const;
+
 	// Audio frame process synchronization predicate method.
 	bool inSync(unsigned long iFrameStart, unsigned long iFrameEnd);
 
@@ -218,6 +314,14 @@ public:
 	static void setDefaultResampleType(int iResampleType);
 	static int defaultResampleType();
 
+	// Predictive seek prefetch (landing) targets,
+	// in frames from the logical start (non RT-safe).
+	void setLandingTargets(const QList<unsigned long>& targets);
+
+	// Landing cache memory budget, in MB (global option).
+	static void setDefaultLandingBudget(unsigned int iLandingBudget);
+	static unsigned int defaultLandingBudget();
+
 protected:
 
 	// Read-sync mode methods (playback).
@@ -226,6 +330,19 @@ protected:
 	// Write-sync mode method (recording).
 	void writeSync();
 
+	// Landing cache sync executive (prefetch).
+	void landingSync();
+
+	// Landing cache play-out (RT-safe).
+	int readMixLanding(float **ppFrames, unsigned int iFrames,
+		unsigned short iChannels, unsigned int iOffset, float fGain);
+
+	// Landing cache slot release (RT-safe).
+	void releaseLanding();
+
+	// Landing cache clean-up (non RT-safe).
+	void clearLanding();
+
 	// Internal-seek sync executive.
 	bool seekSync(unsigned long iFrame);
 
@@ -240,6 +357,8 @@ protected:
 	// Special kind of super-read/channel-mix buffer helper.
 	int readMixFrames(float **ppFrames, unsigned int iFrames,
 		unsigned short iChannels, unsigned int iOffset, float fGain);
+	int mixFrames(float **ppFrames, unsigned int iFrames,
+		unsigned short iChannels, unsigned int iOffset, float fGain);
 
 	// I/O buffer release.
 	void deleteIOBuffers();
@@ -251,7 +370,7 @@ protected:
 private:
 
 	// Audio buffer instance variables.
-	qtractorAudioBufferThread *m_pSyncThread;
+	qtractorAudioBufferPool *m_pSyncPool;
 
 	unsigned short m_iChannels;
 
@@ -298,6 +417,10 @@ private:
 	float          m_fNextGain;
 	int            m_iRampGain;
 
+	// Gain-ramped mix-down and clip ramp in/out kernels.
+	void (*m_pfnMixRamp)(float *, const float *, unsigned int, float, float);
+	void (*m_pfnGainRamp)(float *, unsigned int, float, float);
+
 #ifdef CONFIG_LIBSAMPLERATE
 	bool           m_bResample;
 	float          m_fResampleRatio;
@@ -309,6 +432,31 @@ private:
 
 	qtractorAudioPeakFile *m_pPeakFile;
 
+	// Shared decoded audio cache key and item (integral only).
+	QString        m_sCacheKey;
+	qtractorAudioCache::Item *m_pCacheItem;
+
+	// Landing cache (predictive seek prefetch) slots.
+	enum { LandingSlots = 8 };
+
+	enum LandingState {
+		LandingEmpty = 0, LandingBusy, LandingReady, LandingActive };
+
+	struct LandingSlot
+	{
+		qtractorAtomic  state;
+		unsigned long   offset;
+		unsigned int    frames;
+		float         **buffer;
+	};
+
+	LandingSlot    m_landing[LandingSlots];
+	LandingSlot   *m_pLanding;
+	qtractorAtomic m_landingPending;
+
+	QMutex         m_landingMutex;
+	QList<unsigned long> m_landingTargets;
+
 	// Time-stretch mode local options.
 	bool           m_bWsolaTimeStretch;
 	bool           m_bWsolaQuickSeek;
@@ -319,6 +467,10 @@ private:
 
 	// Sample-rate converter type global option.
 	static int     g_iDefaultResampleType;
+
+	// Landing cache memory budget (MB) and usage (KB).
+	static unsigned int   g_iDefaultLandingBudget;
+	static qtractorAtomic g_landingUsed;
 };
 
 
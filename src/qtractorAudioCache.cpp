@@ -0,0 +1,250 @@
+// qtractorAudioCache.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioCache.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioCache::Item -- Cache item (decoded region).
+//
+
+// Constructor.
+qtractorAudioCache::Item::Item ( const QString& sKey, float **ppFrames,
+	unsigned short iChannels, unsigned int iBufferSize,
+	unsigned long iFrames ) : m_sKey(sKey), m_ppFrames(ppFrames),
+		m_iChannels(iChannels), m_iBufferSize(iBufferSize),
+		m_iFrames(iFrames), m_iRefCount(0), m_iStamp(0)
+{
+}
+
+
+// Destructor.
+qtractorAudioCache::Item::~Item (void)
+{
+	if (m_ppFrames) {
+		for (unsigned short i = 0; i < m_iChannels; ++i)
+			delete [] m_ppFrames[i];
+		delete [] m_ppFrames;
+	}
+}
+
+
+// Memory footprint (in bytes).
+unsigned long qtractorAudioCache::Item::size (void) const
+{
+	return (unsigned long) m_iChannels * m_iBufferSize * sizeof(float);
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioCache -- Shared decoded audio region cache.
+//
+
+// Constructor.
+qtractorAudioCache::qtractorAudioCache (void)
+{
+	m_iBudget = 256;
+	m_iUsed   = 0;
+	m_iStamp  = 0;
+	m_iHits   = 0;
+	m_iMisses = 0;
+}
+
+
+// Destructor.
+qtractorAudioCache::~qtractorAudioCache (void)
+{
+#ifdef CONFIG_DEBUG
+	qDebug("qtractorAudioCache[%p]: items=%u used=%lu hits=%lu misses=%lu",
+		this, count(), used(), hits(), misses());
+#endif
+
+	qDeleteAll(m_items);
+	m_items.clear();
+}
+
+
+// Cache item key factory.
+QString qtractorAudioCache::key ( const QString& sFilename,
+	unsigned int iSampleRate, unsigned long iOffset, unsigned long iLength,
+	float fTimeStretch, float fPitchShift, unsigned int iFlags )
+{
+	// File size and modification time stamp (changed on disk)...
+	const QFileInfo fi(sFilename);
+	return QString("%1:%2:%3:%4:%5:%6:%7:%8:%9").arg(fi.absoluteFilePath())
+		.arg(fi.size()).arg(fi.lastModified().toMSecsSinceEpoch())
+		.arg(iSampleRate).arg(iOffset).arg(iLength)
+		.arg(fTimeStretch).arg(fPitchShift).arg(iFlags);
+}
+
+
+// Look up and reference an existing item (or null).
+qtractorAudioCache::Item *qtractorAudioCache::acquire ( const QString& sKey )
+{
+	QMutexLocker locker(&m_mutex);
+
+	Item *pItem = m_items.value(sKey, NULL);
+	if (pItem) {
+		++pItem->m_iRefCount;
+		pItem->m_iStamp = ++m_iStamp;
+		++m_iHits;
+	} else {
+		++m_iMisses;
+	}
+
+	return pItem;
+}
+
+
+// Adopt and reference a new item; the cache takes ownership
+// of the frame buffers whenever accepted (or null otherwise).
+qtractorAudioCache::Item *qtractorAudioCache::insert ( const QString& sKey,
+	float **ppFrames, unsigned short iChannels, unsigned int iBufferSize,
+	unsigned long iFrames )
+{
+	QMutexLocker locker(&m_mutex);
+
+	// Someone else got there first?
+	if (m_items.contains(sKey))
+		return NULL;
+
+	Item *pItem = new Item(sKey, ppFrames, iChannels, iBufferSize, iFrames);
+	if (!evict(pItem->size())) {
+		pItem->m_ppFrames = NULL;
+		delete pItem;
+		return NULL;
+	}
+
+	pItem->m_iRefCount = 1;
+	pItem->m_iStamp = ++m_iStamp;
+
+	m_items.insert(sKey, pItem);
+	m_iUsed += pItem->size();
+
+	return pItem;
+}
+
+
+// Dereference an item (eligible for eviction if last).
+void qtractorAudioCache::release ( Item *pItem )
+{
+	QMutexLocker locker(&m_mutex);
+
+	if (pItem->m_iRefCount > 0)
+		--pItem->m_iRefCount;
+
+	// Over budget already?
+	if (pItem->m_iRefCount == 0)
+		evict(0);
+}
+
+
+// Evict least-recently-used items, till it fits;
+// must be called with the mutex locked.
+bool qtractorAudioCache::evict ( unsigned long iSize )
+{
+	const unsigned long iBudget = (unsigned long) m_iBudget << 20;
+	if (iSize > iBudget)
+		return false;
+
+	while (m_iUsed + iSize > iBudget) {
+		Item *pLruItem = NULL;
+		QHash<QString, Item *>::ConstIterator iter = m_items.constBegin();
+		const QHash<QString, Item *>::ConstIterator& iter_end = m_items.constEnd();
+		for ( ; iter != iter_end; ++iter) {
+			Item *pItem = iter.value();
+			if (pItem->m_iRefCount > 0)
+				continue;
+			if (pLruItem == NULL || pLruItem->m_iStamp > pItem->m_iStamp)
+				pLruItem = pItem;
+		}
+		// Everything's in use?
+		if (pLruItem == NULL)
+			return false;
+		m_items.remove(pLruItem->key());
+		m_iUsed -= pLruItem->size();
+		delete pLruItem;
+	}
+
+	return true;
+}
+
+
+// Memory budget (in MB; 0=disabled).
+void qtractorAudioCache::setBudget ( unsigned int iBudget )
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_iBudget = iBudget;
+
+	evict(0);
+}
+
+unsigned int qtractorAudioCache::budget (void) const
+{
+	return m_iBudget;
+}
+
+
+// Cache statistics.
+unsigned long qtractorAudioCache::used (void) const
+{
+	return m_iUsed;
+}
+
+unsigned int qtractorAudioCache::count (void) const
+{
+	return m_items.count();
+}
+
+unsigned long qtractorAudioCache::hits (void) const
+{
+	return m_iHits;
+}
+
+unsigned long qtractorAudioCache::misses (void) const
+{
+	return m_iMisses;
+}
+
+
+// Free all unreferenced items.
+void qtractorAudioCache::cleanup (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	QMutableHashIterator<QString, Item *> iter(m_items);
+	while (iter.hasNext()) {
+		Item *pItem = iter.next().value();
+		if (pItem->m_iRefCount == 0) {
+			m_iUsed -= pItem->size();
+			iter.remove();
+			delete pItem;
+		}
+	}
+}
+
+
+// end of qtractorAudioCache.cpp
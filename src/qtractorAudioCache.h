@@ -0,0 +1,150 @@
+// qtractorAudioCache.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioCache_h
+#define __qtractorAudioCache_h
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioCache -- Shared decoded audio region cache.
+//
+// Integrally decoded (and resampled/stretched) file regions are kept
+// here, reference-counted, so that any audio buffer of the very same
+// key may share them instead of decoding its own; unreferenced items
+// are evicted in least-recently-used order, under a memory budget.
+//
+
+class qtractorAudioCache
+{
+public:
+
+	// Constructor.
+	qtractorAudioCache();
+
+	// Destructor.
+	~qtractorAudioCache();
+
+	// Cache item (decoded region).
+	class Item
+	{
+	public:
+
+		// Constructor.
+		Item(const QString& sKey, float **ppFrames,
+			unsigned short iChannels, unsigned int iBufferSize,
+			unsigned long iFrames);
+
+		// Destructor.
+		~Item();
+
+		// Item properties.
+		const QString& key() const
+			{ return m_sKey; }
+		float **frames() const
+			{ return m_ppFrames; }
+		unsigned short channels() const
+			{ return m_iChannels; }
+		unsigned int bufferSize() const
+			{ return m_iBufferSize; }
+		unsigned long length() const
+			{ return m_iFrames; }
+
+		// Memory footprint (in bytes).
+		unsigned long size() const;
+
+	private:
+
+		friend class qtractorAudioCache;
+
+		// Item variables.
+		QString        m_sKey;
+		float        **m_ppFrames;
+		unsigned short m_iChannels;
+		unsigned int   m_iBufferSize;
+		unsigned long  m_iFrames;
+
+		// Reference count and LRU stamp.
+		unsigned int   m_iRefCount;
+		unsigned long  m_iStamp;
+	};
+
+	// Cache item key factory.
+	static QString key(const QString& sFilename,
+		unsigned int iSampleRate, unsigned long iOffset,
+		unsigned long iLength, float fTimeStretch, float fPitchShift,
+		unsigned int iFlags = 0);
+
+	// Look up and reference an existing item (or null).
+	Item *acquire(const QString& sKey);
+
+	// Adopt and reference a new item; the cache takes ownership
+	// of the frame buffers whenever accepted (or null otherwise).
+	Item *insert(const QString& sKey, float **ppFrames,
+		unsigned short iChannels, unsigned int iBufferSize,
+		unsigned long iFrames);
+
+	// Dereference an item (eligible for eviction if last).
+	void release(Item *pItem);
+
+	// Memory budget (in MB; 0=disabled).
+	void setBudget(unsigned int iBudget);
+	unsigned int budget() const;
+
+	// Cache statistics.
+	unsigned long used() const;
+	unsigned int count() const;
+
+	unsigned long hits() const;
+	unsigned long misses() const;
+
+	// Free all unreferenced items.
+	void cleanup();
+
+protected:
+
+	// Evict least-recently-used items, till it fits.
+	bool evict(unsigned long iSize);
+
+private:
+
+	// Instance variables.
+	QHash<QString, Item *> m_items;
+
+	unsigned int  m_iBudget;
+	unsigned long m_iUsed;
+
+	unsigned long m_iStamp;
+
+	unsigned long m_iHits;
+	unsigned long m_iMisses;
+
+	QMutex m_mutex;
+};
+
+
+#endif  // __qtractorAudioCache_h
+
+
+// end of qtractorAudioCache.h
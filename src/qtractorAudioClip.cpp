@@ -602,11 +602,17 @@ void qtractorAudioClip::process (
 	if (pBuff == NULL)
 		return;
 
+	qtractorTrack *pTrack = track();
 	qtractorAudioBus *pAudioBus
-		= static_cast<qtractorAudioBus *> (track()->outputBus());
+		= static_cast<qtractorAudioBus *> (pTrack->outputBus());
 	if (pAudioBus == NULL)
 		return;
 
+	// Current track process buffer (shared or private)...
+	float **ppBuffer = pTrack->audioBuffer();
+	if (ppBuffer == NULL)
+		return;
+
 	// Get the next bunch from the clip...
 	const unsigned long iClipStart = clipStart();
 	if (iClipStart > iFrameEnd)
@@ -622,7 +628,7 @@ void qtractorAudioClip::process (
 	if (iClipStart > iFrameStart) {
 		if (pBuff->inSync(0, iOffset)) {
 			pBuff->readMix(
-				pAudioBus->buffer(),
+				ppBuffer,
 				iOffset,
 				pAudioBus->channels(),
 				iClipStart - iFrameStart,
@@ -631,7 +637,7 @@ void qtractorAudioClip::process (
 	} else {
 		if (pBuff->inSync(iFrameStart - iClipStart, iOffset)) {
 			pBuff->readMix(
-				pAudioBus->buffer(),
+				ppBuffer,
 				(iFrameEnd < iClipEnd ? iFrameEnd : iClipEnd) - iFrameStart,
 				pAudioBus->channels(),
 				0,
@@ -847,7 +853,7 @@ bool qtractorAudioClip::clipExport ( ClipExport pfnClipExport, void *pvArg,
 		iLength = clipLength();
 
 	qtractorAudioBuffer *pBuff
-		= new qtractorAudioBuffer(pTrack->syncThread(), iChannels);
+		= new qtractorAudioBuffer(pTrack->syncPool(), iChannels);
 
 	pBuff->setOffset(iOffset);
 	pBuff->setLength(iLength);
@@ -130,7 +130,7 @@ public:
 		// Constructor.
 		Data(qtractorTrack *pTrack, unsigned short iChannels)
 			: m_pBuff(new qtractorAudioBuffer(
-				pTrack->syncThread(), iChannels)) {}
+				pTrack->syncPool(), iChannels)) {}
 
 		// Destructor.
 		~Data() { clear(); delete m_pBuff; }
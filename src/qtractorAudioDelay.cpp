@@ -0,0 +1,145 @@
+// qtractorAudioDelay.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioDelay.h"
+
+#include <string.h>
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioDelay -- Multi-channel audio delay-line.
+//
+
+// Constructor.
+qtractorAudioDelay::qtractorAudioDelay (void)
+{
+	m_iChannels   = 0;
+	m_iDelay      = 0;
+
+	m_iBufferSize = 0;
+	m_iBufferMask = 0;
+	m_iWriteIndex = 0;
+
+	m_ppBuffer    = NULL;
+
+	ATOMIC_SET(&m_resetPending, 0);
+}
+
+
+// Destructor.
+qtractorAudioDelay::~qtractorAudioDelay (void)
+{
+	setDelay(0, 0);
+}
+
+
+// Delay-line (re)setup (non RT-safe).
+void qtractorAudioDelay::setDelay (
+	unsigned short iChannels, unsigned long iDelay )
+{
+	if (iChannels == m_iChannels && iDelay == m_iDelay)
+		return;
+
+	// Ring-buffer must hold the whole delay plus one...
+	unsigned int iBufferSize = 0;
+	if (iChannels > 0 && iDelay > 0) {
+		iBufferSize = 4;
+		while (iBufferSize <= iDelay)
+			iBufferSize <<= 1;
+	}
+
+	// Reallocate only if really needed...
+	if (iChannels != m_iChannels || iBufferSize != m_iBufferSize) {
+		if (m_ppBuffer) {
+			for (unsigned short i = 0; i < m_iChannels; ++i)
+				delete [] m_ppBuffer[i];
+			delete [] m_ppBuffer;
+			m_ppBuffer = NULL;
+		}
+		m_iBufferSize = 0;
+		m_iBufferMask = 0;
+		if (iBufferSize > 0) {
+			m_ppBuffer = new float * [iChannels];
+			for (unsigned short i = 0; i < iChannels; ++i)
+				m_ppBuffer[i] = new float [iBufferSize];
+			m_iBufferSize = iBufferSize;
+			m_iBufferMask = iBufferSize - 1;
+		}
+	}
+
+	m_iChannels = iChannels;
+	m_iDelay = (m_iBufferSize > 0 ? iDelay : 0);
+
+	clear();
+}
+
+
+// Clear delay-line contents, on next cycle (RT-safe).
+void qtractorAudioDelay::reset (void)
+{
+	ATOMIC_SET(&m_resetPending, 1);
+}
+
+
+// Clear delay-line contents, right away.
+void qtractorAudioDelay::clear (void)
+{
+	ATOMIC_SET(&m_resetPending, 0);
+
+	m_iWriteIndex = 0;
+
+	if (m_ppBuffer) {
+		for (unsigned short i = 0; i < m_iChannels; ++i)
+			::memset(m_ppBuffer[i], 0, m_iBufferSize * sizeof(float));
+	}
+}
+
+
+// In-place delay processing (RT-safe).
+void qtractorAudioDelay::process ( float **ppBuffer, unsigned int nframes )
+{
+	if (m_ppBuffer == NULL || m_iDelay < 1)
+		return;
+
+	// Any pending reset goes first...
+	if (ATOMIC_TAZ(&m_resetPending))
+		clear();
+
+	const unsigned int iDelay = m_iDelay;
+	const unsigned int iMask  = m_iBufferMask;
+
+	for (unsigned short i = 0; i < m_iChannels; ++i) {
+		float *pFrames = ppBuffer[i];
+		float *pBuffer = m_ppBuffer[i];
+		unsigned int w = m_iWriteIndex;
+		for (unsigned int n = 0; n < nframes; ++n) {
+			pBuffer[w & iMask] = pFrames[n];
+			pFrames[n] = pBuffer[(w - iDelay) & iMask];
+			++w;
+		}
+	}
+
+	m_iWriteIndex = (m_iWriteIndex + nframes) & iMask;
+}
+
+
+// end of qtractorAudioDelay.cpp
@@ -0,0 +1,89 @@
+// qtractorAudioDelay.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioDelay_h
+#define __qtractorAudioDelay_h
+
+#include "qtractorAtomic.h"
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioDelay -- Multi-channel audio delay-line.
+//
+// Used for plugin delay compensation (PDC): (re)allocation only
+// happens on setDelay(), which is not RT-safe and must be called
+// while the session is locked; process() is RT-safe. A reset() may
+// be requested from any thread, as it's only posted and then carried
+// out on the very next process() cycle.
+//
+
+class qtractorAudioDelay
+{
+public:
+
+	// Constructor.
+	qtractorAudioDelay();
+
+	// Destructor.
+	~qtractorAudioDelay();
+
+	// Delay-line (re)setup (non RT-safe).
+	void setDelay(unsigned short iChannels, unsigned long iDelay);
+
+	// Delay-line accessors.
+	unsigned short channels() const
+		{ return m_iChannels; }
+	unsigned long delay() const
+		{ return m_iDelay; }
+
+	// Clear delay-line contents, on next cycle (RT-safe).
+	void reset();
+
+	// In-place delay processing (RT-safe).
+	void process(float **ppBuffer, unsigned int nframes);
+
+protected:
+
+	// Clear delay-line contents, right away.
+	void clear();
+
+private:
+
+	// Instance variables.
+	unsigned short m_iChannels;
+	unsigned long  m_iDelay;
+
+	// Ring-buffers (power of two sized).
+	unsigned int   m_iBufferSize;
+	unsigned int   m_iBufferMask;
+	unsigned int   m_iWriteIndex;
+
+	float        **m_ppBuffer;
+
+	// Pending reset flag.
+	qtractorAtomic m_resetPending;
+};
+
+
+#endif  // __qtractorAudioDelay_h
+
+
+// end of qtractorAudioDelay.h
@@ -24,6 +24,9 @@
 #include "qtractorAudioMonitor.h"
 #include "qtractorAudioBuffer.h"
 #include "qtractorAudioClip.h"
+#include "qtractorAudioRender.h"
+#include "qtractorAudioGraph.h"
+#include "qtractorAudioExport.h"
 
 #include "qtractorSession.h"
 
@@ -50,6 +53,10 @@
 #include <jack/session.h>
 #endif
 
+
+// Offline (headless) rendering period size (in frames).
+#define QTRACTOR_OFFLINE_BUFFER_SIZE	1024
+
 #ifdef CONFIG_JACK_METADATA
 #include <jack/metadata.h>
 #endif
@@ -57,6 +64,8 @@
 #include <QApplication>
 #include <QProgressBar>
 #include <QDomDocument>
+#include <QElapsedTimer>
+#include <QThread>
 
 #if defined(__SSE__)
 
@@ -494,18 +503,37 @@ qtractorAudioEngine::qtractorAudioEngine ( qtractorSession *pSession )
 	// Audio-export freewheeling (internal) state.
 	m_bFreewheel = false;
 
-	// Common audio buffer sync thread.
-	m_pSyncThread = NULL;
+	// Common audio buffer I/O worker pool.
+	m_iSyncThreads = 4;
+	m_pSyncPool = NULL;
+
+	// Parallel track rendering pool.
+	m_iRenderThreads = 0;
+	m_pRenderPool = NULL;
+
+	m_pTimeReader = NULL;
+
+	// Block automation sub-block size.
+	m_iBlockAutomation = 0;
+
+	// Audio routing graph (none yet).
+	ATOMIC_SET(&m_graphSerial, 1);
+	ATOMIC_SET(&m_graphPending, 0);
+	m_iGraphSerial = 0;
+	m_pGraph = NULL;
 
 	// Audio-export (in)active state.
 	m_bExporting   = false;
 	m_pExportFile  = NULL;
 	m_pExportBuses = NULL;
 	m_pExportBuffer = NULL;
+	m_pExportPool  = NULL;
 	m_iExportStart = 0;
 	m_iExportEnd   = 0;
 	m_bExportDone  = true;
 
+	m_fExportSpeed = 0.0f;
+
 	// Audio metronome stuff.
 	m_bMetronome        = false;
 	m_bMetroBus         = false;
@@ -541,6 +569,18 @@ qtractorAudioEngine::qtractorAudioEngine ( qtractorSession *pSession )
 }
 
 
+// Destructor.
+qtractorAudioEngine::~qtractorAudioEngine (void)
+{
+	// Terminate common audio buffer I/O pool,
+	// which might have outlived any engine (re)start...
+	if (m_pSyncPool) {
+		delete m_pSyncPool;
+		m_pSyncPool = NULL;
+	}
+}
+
+
 // Special event notifier proxy object.
 const qtractorAudioEngineProxy *qtractorAudioEngine::proxy (void) const
 {
@@ -632,6 +672,21 @@ bool qtractorAudioEngine::init (void)
 	if (pSession == NULL)
 		return false;
 
+	// Offline (headless) rendering goes without any JACK client;
+	// sample rate is the (already loaded) session one...
+	if (isOffline()) {
+		m_iSampleRate = pSession->sampleRate();
+		m_iBufferSize = QTRACTOR_OFFLINE_BUFFER_SIZE;
+		// Our optional parallel track rendering pool...
+		if (m_iRenderThreads > 0) {
+			m_pRenderPool = new qtractorAudioRenderPool(pSession,
+				m_iRenderThreads, pSession->tracks().count());
+		}
+		// Our own tempo-map reader...
+		m_pTimeReader = new qtractorTimeScale::Reader(pSession->timeScale());
+		return true;
+	}
+
 	// Try open a new client...
 	const QByteArray aClientName = pSession->clientName().toUtf8();
 	int opts = JackNullOption;
@@ -669,9 +724,14 @@ bool qtractorAudioEngine::init (void)
 	// ATTN: Third is setting session sample rate.
 	pSession->setSampleRate(m_iSampleRate);
 
-	// Our dedicated audio buffer thread...
-	m_pSyncThread = new qtractorAudioBufferThread();
-	m_pSyncThread->start(QThread::HighPriority);
+	// Our optional parallel track rendering pool...
+	if (m_iRenderThreads > 0) {
+		m_pRenderPool = new qtractorAudioRenderPool(pSession,
+			m_iRenderThreads, pSession->tracks().count());
+	}
+
+	// Our own tempo-map reader...
+	m_pTimeReader = new qtractorTimeScale::Reader(pSession->timeScale());
 
 	return true;
 }
@@ -699,6 +759,13 @@ bool qtractorAudioEngine::activate (void)
 		pMidiManager = pMidiManager->next();
 	}
 
+	// Offline (headless) rendering has no callbacks whatsoever...
+	if (m_pJackClient == NULL) {
+		resetAllMonitors();
+		resetGraph();
+		return isOffline();
+	}
+
 	// Ensure (not) freewheeling state...
 	jack_set_freewheel(m_pJackClient, 0);
 
@@ -756,6 +823,9 @@ bool qtractorAudioEngine::activate (void)
 	// Reset all dependable monitoring...
 	resetAllMonitors();
 
+	// Audio routing graph must be (re)compiled...
+	resetGraph();
+
 	// Time to activate ourselves...
 	jack_activate(m_pJackClient);
 
@@ -801,7 +871,7 @@ bool qtractorAudioEngine::start (void)
 	resetMetro();
 
 	// Start transport rolling...
-	if (m_transportMode & qtractorBus::Output)
+	if (m_pJackClient && (m_transportMode & qtractorBus::Output))
 		jack_transport_start(m_pJackClient);
 
 	// We're now ready and running...
@@ -815,7 +885,7 @@ void qtractorAudioEngine::stop (void)
 	if (!isActivated())
 		return;
 
-	if (m_transportMode & qtractorBus::Output) {
+	if (m_pJackClient && (m_transportMode & qtractorBus::Output)) {
 		jack_transport_stop(m_pJackClient);
 		jack_transport_locate(m_pJackClient, sessionCursor()->frame());
 	}
@@ -854,15 +924,19 @@ void qtractorAudioEngine::clean (void)
 	deletePlayerBus();
 	deleteMetroBus();
 
-	// Terminate common player/metro sync thread...
-	if (m_pSyncThread) {
-		if (m_pSyncThread->isRunning()) do {
-			m_pSyncThread->setRunState(false);
-		//	m_pSyncThread->terminate();
-			m_pSyncThread->sync();
-		} while (!m_pSyncThread->wait(100));
-		delete m_pSyncThread;
-		m_pSyncThread = NULL;
+	// Terminate audio routing graph...
+	cleanGraph();
+
+	// Terminate parallel track rendering pool...
+	if (m_pRenderPool) {
+		delete m_pRenderPool;
+		m_pRenderPool = NULL;
+	}
+
+	// Terminate tempo-map reader...
+	if (m_pTimeReader) {
+		delete m_pTimeReader;
+		m_pTimeReader = NULL;
 	}
 
 	// Audio-export stilll around? weird...
@@ -881,6 +955,11 @@ void qtractorAudioEngine::clean (void)
 		m_pExportFile = NULL;
 	}
 
+	if (m_pExportPool) {
+		delete m_pExportPool;
+		m_pExportPool = NULL;
+	}
+
 	// Close the JACK client, finally.
 	if (m_pJackClient) {
 		jack_client_close(m_pJackClient);
@@ -977,6 +1056,11 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 #endif
 #endif
 
+	// MIDI track plugins get their events straight from clips...
+	qtractorMidiEngine *pMidiEngine = pSession->midiEngine();
+	if (pMidiEngine && isPlaying())
+		pMidiEngine->process_direct(pAudioCursor, nframes);
+
 	// MIDI plugin manager processing...
 	qtractorMidiManager *pMidiManager
 		= pSession->midiManagers().first();
@@ -991,6 +1075,10 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 		}
 	}
 
+	// JACK MIDI output buses processing...
+	if (pMidiEngine && pMidiEngine->isJackOutput())
+		pMidiEngine->process_jack(pAudioCursor->frameTime(), nframes);
+
 	// Don't go any further, if not playing.
 	if (!isPlaying()) {
 		// Do the idle processing...
@@ -1047,9 +1135,10 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 	unsigned long iFrameEnd   = iFrameStart + nframes;
 
 	// Metronome stuff...
-	if (m_bMetronome && m_pMetroBus && iFrameEnd > m_iMetroBeatStart) {
-		qtractorTimeScale::Cursor& cursor = pSession->timeScale()->cursor();
-		qtractorTimeScale::Node *pNode = cursor.seekFrame(iFrameStart);
+	if (m_bMetronome && m_pMetroBus && m_pTimeReader
+		&& iFrameEnd > m_iMetroBeatStart) {
+		const qtractorTimeScale::Node *pNode
+			= m_pTimeReader->seekFrame(iFrameStart);
 		qtractorAudioBuffer *pMetroBuff = NULL;
 		if (pNode->beatIsBar(m_iMetroBeat))
 			pMetroBuff = m_pMetroBarBuff;
@@ -1091,14 +1180,20 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 	}
 
 	// Regular range playback...
-	pSession->process(pAudioCursor, iFrameStart, iFrameEnd);
-	m_iBufferOffset += (iFrameEnd - iFrameStart);
-
-	// Commit current audio buses...
-	for (pBus = buses().first(); pBus; pBus = pBus->next()) {
-		pAudioBus = static_cast<qtractorAudioBus *> (pBus);
-		if (pAudioBus)
-			pAudioBus->process_commit(nframes);
+	qtractorAudioGraph *pGraph = (m_iBufferOffset > 0 ? NULL : graph());
+	if (pGraph) {
+		// Routing graph (parallel) schedule, bus commits included...
+		m_pRenderPool->process(pGraph, pAudioCursor, iFrameStart, iFrameEnd);
+		m_iBufferOffset += (iFrameEnd - iFrameStart);
+	} else {
+		pSession->process(pAudioCursor, iFrameStart, iFrameEnd);
+		m_iBufferOffset += (iFrameEnd - iFrameStart);
+		// Commit current audio buses...
+		for (pBus = buses().first(); pBus; pBus = pBus->next()) {
+			pAudioBus = static_cast<qtractorAudioBus *> (pBus);
+			if (pAudioBus)
+				pAudioBus->process_commit(nframes);
+		}
 	}
 
 	// Regular range recording (if and when applicable)...
@@ -1114,9 +1209,9 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 		if (m_transportMode & qtractorBus::Output)
 			jack_transport_locate(m_pJackClient, iFrameEnd);
 		// Take special care on metronome too...
-		if (m_bMetronome) {
-			m_iMetroBeat = pSession->beatFromFrame(iFrameEnd);
-			m_iMetroBeatStart = metro_offset(pSession->frameFromBeat(m_iMetroBeat));
+		if (m_bMetronome && m_pTimeReader) {
+			m_iMetroBeat = m_pTimeReader->beatFromFrame(iFrameEnd);
+			m_iMetroBeatStart = metro_offset(m_pTimeReader->frameFromBeat(m_iMetroBeat));
 		}
 	}
 
@@ -1141,9 +1236,10 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 {
 	if (m_bExportDone)
 		return;
-	if (m_pExportBuses  == NULL ||
-		m_pExportFile   == NULL ||
-		m_pExportBuffer == NULL)
+	if (m_pExportBuses == NULL)
+		return;
+	if ((m_pExportFile == NULL || m_pExportBuffer == NULL)
+		&& m_pExportPool == NULL)
 		return;
 
 	qtractorSession *pSession = session();
@@ -1175,7 +1271,8 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 	// Write output bus buffers to export audio file...
 	if (iFrameStart < m_iExportEnd && iFrameEnd > m_iExportStart) {
 		// Prepare mix-down buffer...
-		m_pExportBuffer->process_prepare(nframes);
+		if (m_pExportBuffer)
+			m_pExportBuffer->process_prepare(nframes);
 		// Force/sync every audio clip approaching...
 	#ifdef CONFIG_LV2
 	#ifdef CONFIG_LV2_TIME
@@ -1207,10 +1304,16 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 		while (iter.hasNext()) {
 			qtractorAudioBus *pExportBus = iter.next();
 			pExportBus->process_commit(nframes);
-			m_pExportBuffer->process_add(pExportBus, nframes);
+			if (m_pExportPool)
+				m_pExportPool->process(pExportBus, nframes);
+			else
+				m_pExportBuffer->process_add(pExportBus, nframes);
 		}
-		// Write to export file...
-		m_pExportFile->write(m_pExportBuffer->buffer(), nframes);
+		// Write to export file (or hand over to stem writers)...
+		if (m_pExportPool)
+			m_pExportPool->sync();
+		else
+			m_pExportFile->write(m_pExportBuffer->buffer(), nframes);
 		// HACK! Freewheeling observers update (non RT safe!)...
 		qtractorSubject::flushQueue(false);
 	} else {
@@ -1257,9 +1360,14 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 // JACK timebase master callback.
 void qtractorAudioEngine::timebase ( jack_position_t *pPos, int iNewPos )
 {
-	qtractorSession *pSession = session();
-	qtractorTimeScale::Cursor& cursor = pSession->timeScale()->cursor();
-	qtractorTimeScale::Node *pNode = cursor.seekFrame(pPos->frame);
+	if (m_pTimeReader == NULL)
+		return;
+
+	const qtractorTimeScale::Node *pNode
+		= m_pTimeReader->seekFrame(pPos->frame);
+	if (pNode == NULL)
+		return;
+
 	unsigned short bars  = 0;
 	unsigned int   beats = 0;
 	unsigned long  ticks = pNode->tickFromFrame(pPos->frame) - pNode->tick;
@@ -1451,20 +1559,10 @@ bool qtractorAudioEngine::fileExport (
 	if (!isActivated() || isPlaying() || isExporting())
 		return false;
 
-	// Make sure we have an actual session cursor...
 	qtractorSession *pSession = session();
 	if (pSession == NULL)
 		return false;
 
-	// About to show some progress bar...
-	qtractorMainForm *pMainForm = qtractorMainForm::getInstance();
-	if (pMainForm == NULL)
-		return false;
-
-	QProgressBar *pProgressBar = pMainForm->progressBar();
-	if (pProgressBar == NULL)
-		return false;
-
 	// Cannot have exports longer than current session.
 	if (iExportStart >= iExportEnd)
 		iExportEnd = pSession->sessionEnd();
@@ -1477,6 +1575,10 @@ bool qtractorAudioEngine::fileExport (
 	if (pExportBus == NULL)
 		return false;
 
+	// Don't leave an empty file behind, if not going anywhere...
+	if (!fileExportCheck())
+		return false;
+
 	// Get proper file type class...
 	const unsigned int iChannels = pExportBus->channels();
 	qtractorAudioFile *pExportFile
@@ -1492,6 +1594,155 @@ bool qtractorAudioEngine::fileExport (
 		return false;
 	}
 
+	// Mix-down all buses into the one file...
+	m_pExportFile  = pExportFile;
+	m_pExportBuffer = new qtractorAudioExportBuffer(iChannels, bufferSize());
+
+	const bool bResult
+		= fileExportEx(exportBuses, iExportStart, iExportEnd);
+
+	// May close the file...
+	m_pExportFile->close();
+
+	// Free up things here.
+	delete m_pExportBuffer;
+	delete m_pExportFile;
+
+	m_pExportFile  = NULL;
+	m_pExportBuffer = NULL;
+
+	// Done whether successfully.
+	return bResult;
+}
+
+
+// Audio stem-export method (one file per bus and/or track).
+bool qtractorAudioEngine::fileExportStems (
+	const QString& sExportPath, const QList<qtractorAudioBus *>& exportBuses,
+	const QList<qtractorTrack *>& exportTracks,
+	unsigned long iExportStart, unsigned long iExportEnd,
+	QStringList *pStemFiles )
+{
+	// No simultaneous or foul exports...
+	if (!isActivated() || isPlaying() || isExporting())
+		return false;
+
+	qtractorSession *pSession = session();
+	if (pSession == NULL)
+		return false;
+
+	// Cannot have exports longer than current session.
+	if (iExportStart >= iExportEnd)
+		iExportEnd = pSession->sessionEnd();
+	if (iExportStart >= iExportEnd)
+		return false;
+
+	// Don't leave empty files behind, if not going anywhere...
+	if (!fileExportCheck())
+		return false;
+
+	qtractorAudioExportPool *pExportPool
+		= new qtractorAudioExportPool(bufferSize());
+
+	// All buses to process: bus stems and track stems output buses...
+	QList<qtractorAudioBus *> processBuses;
+
+	QListIterator<qtractorAudioBus *> bus_iter(exportBuses);
+	while (bus_iter.hasNext()) {
+		qtractorAudioBus *pAudioBus = bus_iter.next();
+		if (processBuses.contains(pAudioBus))
+			continue;
+		pExportPool->addBusStem(pAudioBus,
+			qtractorAudioExportPool::stemPath(
+				sExportPath, pAudioBus->busName()));
+		processBuses.append(pAudioBus);
+	}
+
+	QListIterator<qtractorTrack *> track_iter(exportTracks);
+	while (track_iter.hasNext()) {
+		qtractorTrack *pTrack = track_iter.next();
+		if (pExportPool->addTrackStem(pTrack,
+				qtractorAudioExportPool::stemPath(
+					sExportPath, pTrack->trackName())) == NULL)
+			continue;
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (pTrack->outputBus());
+		if (!processBuses.contains(pAudioBus))
+			processBuses.append(pAudioBus);
+	}
+
+	// Open all stem files and start the writer pool...
+	if (!pExportPool->open(sampleRate(), iExportEnd - iExportStart)) {
+		delete pExportPool;
+		return false;
+	}
+
+	m_pExportPool = pExportPool;
+
+	bool bResult = fileExportEx(processBuses, iExportStart, iExportEnd);
+
+	// Flush and close all stem files...
+	m_pExportPool->close();
+
+	if (pStemFiles) {
+		QListIterator<qtractorAudioExportStem *> iter(m_pExportPool->stems());
+		while (iter.hasNext())
+			pStemFiles->append(iter.next()->filename());
+	}
+
+	delete m_pExportPool;
+	m_pExportPool = NULL;
+
+	// Done whether successfully.
+	return bResult;
+}
+
+
+// Audio-export common pre-conditions (before any file gets opened).
+bool qtractorAudioEngine::fileExportCheck (void) const
+{
+	// Make sure we have an actual session cursor...
+	if (session() == NULL)
+		return false;
+
+	// Some progress bar must be there (not when headless)...
+	if (!isOffline()) {
+		qtractorMainForm *pMainForm = qtractorMainForm::getInstance();
+		if (pMainForm == NULL || pMainForm->progressBar() == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+
+// Audio-export common executive (freewheeling).
+bool qtractorAudioEngine::fileExportEx (
+	const QList<qtractorAudioBus *>& exportBuses,
+	unsigned long iExportStart, unsigned long iExportEnd )
+{
+	// Make sure we have an actual session cursor...
+	qtractorSession *pSession = session();
+	if (pSession == NULL)
+		return false;
+
+	// About to show some progress bar (not when headless)...
+	QProgressBar *pProgressBar = NULL;
+	if (!isOffline()) {
+		qtractorMainForm *pMainForm = qtractorMainForm::getInstance();
+		if (pMainForm == NULL)
+			return false;
+		pProgressBar = pMainForm->progressBar();
+		if (pProgressBar == NULL)
+			return false;
+	}
+
+	// Cannot have exports longer than current session.
+	if (iExportStart >= iExportEnd)
+		iExportEnd = pSession->sessionEnd();
+	if (iExportStart >= iExportEnd)
+		return false;
+
 	// We'll be busy...
 	pSession->lock();
 
@@ -1501,16 +1752,16 @@ bool qtractorAudioEngine::fileExport (
 	// Start with fixing the export range...
 	m_bExporting   = true;
 	m_pExportBuses = new QList<qtractorAudioBus *> (exportBuses);
-	m_pExportFile  = pExportFile;
-	m_pExportBuffer = new qtractorAudioExportBuffer(iChannels, bufferSize());
 	m_iExportStart = iExportStart;
 	m_iExportEnd   = iExportEnd;
 	m_bExportDone  = false;
 
 	// Prepare and show some progress...
-	pProgressBar->setRange(iExportStart, iExportEnd);
-	pProgressBar->reset();
-	pProgressBar->show();
+	if (pProgressBar) {
+		pProgressBar->setRange(iExportStart, iExportEnd);
+		pProgressBar->reset();
+		pProgressBar->show();
+	}
 
 	// We'll have to save some session parameters...
 	const unsigned long iPlayHead  = pSession->playHead();
@@ -1532,30 +1783,49 @@ bool qtractorAudioEngine::fileExport (
 	// Special initialization.
 	m_iBufferOffset = 0;
 
-	// Start export (freewheeling)...
-	jack_set_freewheel(m_pJackClient, 1);
-
-	// Wait for the export to end.
-	struct timespec ts;
-	ts.tv_sec  = 0;
-	ts.tv_nsec = 20000000L; // 20msec.
-
-	while (m_bExporting && !m_bExportDone) {
-		qtractorSession::stabilize(200);
-	#ifdef CONFIG_LV2
-	#ifdef CONFIG_LV2_TIME
-		qtractorLv2Plugin::updateTimePost();
-	#endif
-	#endif
-		::nanosleep(&ts, NULL); // Ain't that enough?
-		pProgressBar->setValue(pSession->playHead());
+	// Throughput accounting...
+	QElapsedTimer timer;
+	timer.start();
+
+	if (m_pJackClient == NULL) {
+		// Offline (headless) export: we're the one driving
+		// the process cycle, as fast as it can possibly go...
+		m_bFreewheel = true;
+		while (m_bExporting && !m_bExportDone) {
+			process_export(m_iBufferSize);
+		#ifdef CONFIG_LV2
+		#ifdef CONFIG_LV2_TIME
+			qtractorLv2Plugin::updateTimePost();
+		#endif
+		#endif
+		}
+		m_bFreewheel = false;
+	} else {
+		// Start export (freewheeling)...
+		jack_set_freewheel(m_pJackClient, 1);
+		// Wait for the export to end.
+		struct timespec ts;
+		ts.tv_sec  = 0;
+		ts.tv_nsec = 20000000L; // 20msec.
+		while (m_bExporting && !m_bExportDone) {
+			qtractorSession::stabilize(200);
+		#ifdef CONFIG_LV2
+		#ifdef CONFIG_LV2_TIME
+			qtractorLv2Plugin::updateTimePost();
+		#endif
+		#endif
+			::nanosleep(&ts, NULL); // Ain't that enough?
+			if (pProgressBar)
+				pProgressBar->setValue(pSession->playHead());
+		}
+		// Stop export (freewheeling)...
+		jack_set_freewheel(m_pJackClient, 0);
 	}
 
-	// Stop export (freewheeling)...
-	jack_set_freewheel(m_pJackClient, 0);
-
-	// May close the file...
-	m_pExportFile->close();
+	// Throughput, in realtime multiples...
+	const qint64 iElapsed = timer.elapsed();
+	const float fDuration = float(iExportEnd - iExportStart) / float(sampleRate());
+	m_fExportSpeed = (iElapsed > 0 ? 1000.0f * fDuration / float(iElapsed) : 0.0f);
 
 	// Restore session at ease...
 	pSession->setLoop(iLoopStart, iLoopEnd);
@@ -1571,17 +1841,14 @@ bool qtractorAudioEngine::fileExport (
 	const bool bResult = m_bExporting;
 
 	// Free up things here.
-	delete m_pExportBuffer;
 	delete m_pExportBuses;
-	delete m_pExportFile;
 
 	// Made some progress...
-	pProgressBar->hide();
+	if (pProgressBar)
+		pProgressBar->hide();
 
 	m_bExporting   = false;
 	m_pExportBuses = NULL;
-	m_pExportFile  = NULL;
-	m_pExportBuffer = NULL;
 	m_iExportStart = 0;
 	m_iExportEnd   = 0;
 	m_bExportDone  = true;
@@ -1594,6 +1861,13 @@ bool qtractorAudioEngine::fileExport (
 }
 
 
+// Last audio-export throughput (in realtime multiples).
+float qtractorAudioEngine::exportSpeed (void) const
+{
+	return m_fExportSpeed;
+}
+
+
 // Special track-immediate methods.
 void qtractorAudioEngine::trackMute ( qtractorTrack *pTrack, bool bMute )
 {
@@ -1801,11 +2075,11 @@ bool qtractorAudioEngine::openMetroBus (void)
 	}
 
 	// We got it...
-	m_pMetroBarBuff = new qtractorAudioBuffer(m_pSyncThread, iChannels);
+	m_pMetroBarBuff = new qtractorAudioBuffer(syncPool(), iChannels);
 	m_pMetroBarBuff->setGain(m_fMetroBarGain);
 	m_pMetroBarBuff->open(m_sMetroBarFilename);
 
-	m_pMetroBeatBuff = new qtractorAudioBuffer(m_pSyncThread, iChannels);
+	m_pMetroBeatBuff = new qtractorAudioBuffer(syncPool(), iChannels);
 	m_pMetroBeatBuff->setGain(m_fMetroBeatGain);
 	m_pMetroBeatBuff->open(m_sMetroBeatFilename);
 
@@ -1996,7 +2270,7 @@ bool qtractorAudioEngine::openPlayerBus (void)
 	}
 
 	// We got it...
-	m_pPlayerBuff = new qtractorAudioBuffer(m_pSyncThread, iChannels);
+	m_pPlayerBuff = new qtractorAudioBuffer(syncPool(), iChannels);
 
 	return true;
 }
@@ -2170,6 +2444,201 @@ unsigned long qtractorAudioEngine::jackFrameTime (void) const
 }
 
 
+// Parallel track rendering worker threads (0=serial): never as many
+// as there are cores, as the workers must not get to share the same
+// one with the audio thread (a yield won't give way to lower priority).
+void qtractorAudioEngine::setRenderThreads ( unsigned int iRenderThreads )
+{
+	const int iMaxThreads = QThread::idealThreadCount() - 1;
+	if (iMaxThreads < 1)
+		iRenderThreads = 0;
+	else
+	if (iRenderThreads > (unsigned int) iMaxThreads)
+		iRenderThreads = iMaxThreads;
+
+	if (m_iRenderThreads == iRenderThreads)
+		return;
+
+	m_iRenderThreads = iRenderThreads;
+
+	// Track private render buffers must follow suit,
+	// otherwise those just get rendered serially...
+	qtractorSession *pSession = session();
+	if (pSession == NULL)
+		return;
+
+	pSession->lock();
+
+	for (qtractorTrack *pTrack = pSession->tracks().first();
+			pTrack; pTrack = pTrack->next()) {
+		if (pTrack->trackType() == qtractorTrack::Audio)
+			pTrack->updateRenderBuffers();
+	}
+
+	pSession->unlock();
+}
+
+unsigned int qtractorAudioEngine::renderThreads (void) const
+{
+	return m_iRenderThreads;
+}
+
+
+// Parallel track rendering pool accessor.
+qtractorAudioRenderPool *qtractorAudioEngine::renderPool (void) const
+{
+	return m_pRenderPool;
+}
+
+
+// Tempo-map reader accessor (audio thread only).
+qtractorTimeScale::Reader *qtractorAudioEngine::timeReader (void) const
+{
+	return m_pTimeReader;
+}
+
+
+// Block automation sub-block size (in frames; 0=per-period).
+void qtractorAudioEngine::setBlockAutomation ( unsigned int iBlockFrames )
+{
+	m_iBlockAutomation = iBlockFrames;
+}
+
+unsigned int qtractorAudioEngine::blockAutomation (void) const
+{
+	return m_iBlockAutomation;
+}
+
+
+// Common audio buffer I/O worker threads.
+void qtractorAudioEngine::setSyncThreads ( unsigned int iSyncThreads )
+{
+	m_iSyncThreads = iSyncThreads;
+
+	if (m_pSyncPool)
+		m_pSyncPool->setThreads(m_iSyncThreads);
+}
+
+unsigned int qtractorAudioEngine::syncThreads (void) const
+{
+	return m_iSyncThreads;
+}
+
+
+// Common audio buffer I/O pool accessor (lazy created).
+qtractorAudioBufferPool *qtractorAudioEngine::syncPool (void)
+{
+	if (m_pSyncPool == NULL)
+		m_pSyncPool = new qtractorAudioBufferPool(m_iSyncThreads);
+
+	return m_pSyncPool;
+}
+
+
+// Audio routing graph invalidation (on any topology change).
+void qtractorAudioEngine::resetGraph (void)
+{
+	ATOMIC_INC(&m_graphSerial);
+
+	// Get it (re)compiled as soon as possible,
+	// instead of falling back to serial meanwhile...
+	if (m_pRenderPool && ATOMIC_TAS(&m_graphPending))
+		m_proxy.notifyGraphEvent();
+}
+
+
+// Audio routing graph (topology) change serial.
+int qtractorAudioEngine::graphSerial (void) const
+{
+	return ATOMIC_GET(&m_graphSerial);
+}
+
+
+// Audio routing graph (re)compilation, if invalid (non RT-safe).
+void qtractorAudioEngine::updateGraph (void)
+{
+	// Only useful for parallel processing...
+	if (m_pRenderPool == NULL || !isActivated())
+		return;
+
+	ATOMIC_SET(&m_graphPending, 0);
+
+	const int iGraphSerial = ATOMIC_GET(&m_graphSerial);
+	if (m_iGraphSerial == iGraphSerial)
+		return;
+
+	m_iGraphSerial = iGraphSerial;
+
+	// Dispose of the one retired by the RT thread...
+	qtractorAudioGraph *pGraph = m_graphDone.fetchAndStoreOrdered(NULL);
+	if (pGraph)
+		delete pGraph;
+
+	// Compile the current topology...
+	pGraph = new qtractorAudioGraph(session(), iGraphSerial);
+
+#ifdef CONFIG_DEBUG
+	qDebug("qtractorAudioEngine::updateGraph() serial=%d nodes=%u valid=%d",
+		iGraphSerial, pGraph->nodes(), int(pGraph->isValid()));
+#endif
+
+	if (!pGraph->isValid()) {
+		delete pGraph;
+		return;
+	}
+
+	// Post it; whatever was still pending never got used...
+	pGraph = m_graphNext.fetchAndStoreOrdered(pGraph);
+	if (pGraph)
+		delete pGraph;
+}
+
+
+// Current audio routing graph, if still valid (RT-safe).
+qtractorAudioGraph *qtractorAudioEngine::graph (void)
+{
+	if (m_pRenderPool == NULL)
+		return NULL;
+
+	// Take the newly posted graph, but only if
+	// the previous one can be retired safely...
+	if (m_graphDone.testAndSetOrdered(NULL, NULL)) {
+		qtractorAudioGraph *pGraph = m_graphNext.fetchAndStoreOrdered(NULL);
+		if (pGraph) {
+			if (m_pGraph)
+				m_graphDone.fetchAndStoreOrdered(m_pGraph);
+			m_pGraph = pGraph;
+		}
+	}
+
+	// Stale graphs are of no use...
+	if (m_pGraph && m_pGraph->serial() == ATOMIC_GET(&m_graphSerial))
+		return m_pGraph;
+	else
+		return NULL;
+}
+
+
+// Audio routing graph cleanup (non RT-safe).
+void qtractorAudioEngine::cleanGraph (void)
+{
+	qtractorAudioGraph *pGraph = m_graphNext.fetchAndStoreOrdered(NULL);
+	if (pGraph)
+		delete pGraph;
+
+	pGraph = m_graphDone.fetchAndStoreOrdered(NULL);
+	if (pGraph)
+		delete pGraph;
+
+	if (m_pGraph) {
+		delete m_pGraph;
+		m_pGraph = NULL;
+	}
+
+	m_iGraphSerial = 0;
+}
+
+
 // Reset all audio monitoring...
 void qtractorAudioEngine::resetAllMonitors (void)
 {
@@ -2245,6 +2714,8 @@ qtractorAudioBus::qtractorAudioBus (
 
 	m_bEnabled  = false;
 
+	m_iLatencyComp = 0;
+
 #if defined(__SSE__)
 	if (sse_enabled())
 		m_pfnBufferAdd = sse_buffer_add;
@@ -2327,7 +2798,7 @@ bool qtractorAudioBus::open (void)
 		return false;
 
 	jack_client_t *pJackClient = pAudioEngine->jackClient();
-	if (pJackClient == NULL)
+	if (pJackClient == NULL && !pAudioEngine->isOffline())
 		return false;
 
 	const qtractorBus::BusMode busMode
@@ -2338,33 +2809,47 @@ bool qtractorAudioBus::open (void)
 	unsigned short i;
 	unsigned short iDisabled = 0;
 
-	if (busMode & qtractorBus::Input) {
-		// Register and allocate input port buffers...
-		m_ppIPorts  = new jack_port_t * [m_iChannels];
-		m_ppIBuffer = new float * [m_iChannels];
-		const QString sIPortName(busName() + "/in_%1");
-		for (i = 0; i < m_iChannels; ++i) {
-			m_ppIPorts[i] = jack_port_register(pJackClient,
-				sIPortName.arg(i + 1).toUtf8().constData(),
-				JACK_DEFAULT_AUDIO_TYPE,
-				JackPortIsInput, 0);
-			m_ppIBuffer[i] = NULL;
-			if (m_ppIPorts[i] == NULL) ++iDisabled;
+	if (pJackClient == NULL) {
+		// Offline (headless): no ports, just owned I/O buffers...
+		if (busMode & qtractorBus::Input) {
+			m_ppIBuffer = new float * [m_iChannels];
+			for (i = 0; i < m_iChannels; ++i)
+				m_ppIBuffer[i] = new float [iBufferSize];
+		}
+		if (busMode & qtractorBus::Output) {
+			m_ppOBuffer = new float * [m_iChannels];
+			for (i = 0; i < m_iChannels; ++i)
+				m_ppOBuffer[i] = new float [iBufferSize];
+		}
+	} else {
+		if (busMode & qtractorBus::Input) {
+			// Register and allocate input port buffers...
+			m_ppIPorts  = new jack_port_t * [m_iChannels];
+			m_ppIBuffer = new float * [m_iChannels];
+			const QString sIPortName(busName() + "/in_%1");
+			for (i = 0; i < m_iChannels; ++i) {
+				m_ppIPorts[i] = jack_port_register(pJackClient,
+					sIPortName.arg(i + 1).toUtf8().constData(),
+					JACK_DEFAULT_AUDIO_TYPE,
+					JackPortIsInput, 0);
+				m_ppIBuffer[i] = NULL;
+				if (m_ppIPorts[i] == NULL) ++iDisabled;
+			}
 		}
-	}
 
-	if (busMode & qtractorBus::Output) {
-		// Register and allocate output port buffers...
-		m_ppOPorts  = new jack_port_t * [m_iChannels];
-		m_ppOBuffer = new float * [m_iChannels];
-		const QString sOPortName(busName() + "/out_%1");
-		for (i = 0; i < m_iChannels; ++i) {
-			m_ppOPorts[i] = jack_port_register(pJackClient,
-				sOPortName.arg(i + 1).toUtf8().constData(),
-				JACK_DEFAULT_AUDIO_TYPE,
-				JackPortIsOutput, 0);
-			m_ppOBuffer[i] = NULL;
-			if (m_ppOPorts[i] == NULL) ++iDisabled;
+		if (busMode & qtractorBus::Output) {
+			// Register and allocate output port buffers...
+			m_ppOPorts  = new jack_port_t * [m_iChannels];
+			m_ppOBuffer = new float * [m_iChannels];
+			const QString sOPortName(busName() + "/out_%1");
+			for (i = 0; i < m_iChannels; ++i) {
+				m_ppOPorts[i] = jack_port_register(pJackClient,
+					sOPortName.arg(i + 1).toUtf8().constData(),
+					JACK_DEFAULT_AUDIO_TYPE,
+					JackPortIsOutput, 0);
+				m_ppOBuffer[i] = NULL;
+				if (m_ppOPorts[i] == NULL) ++iDisabled;
+			}
 		}
 	}
 
@@ -2388,6 +2873,9 @@ bool qtractorAudioBus::open (void)
 	// Finally, open for biz...
 	m_bEnabled = (iDisabled == 0);
 
+	// Routing topology has changed...
+	pAudioEngine->resetGraph();
+
 	return true;
 }
 
@@ -2403,6 +2891,9 @@ void qtractorAudioBus::close (void)
 	if (pAudioEngine == NULL)
 		return;
 
+	// Routing topology has changed...
+	pAudioEngine->resetGraph();
+
 	jack_client_t *pJackClient = pAudioEngine->jackClient();
 
 	const qtractorBus::BusMode busMode
@@ -2421,14 +2912,19 @@ void qtractorAudioBus::close (void)
 				}
 			}
 		}
+		// Free input buffers (owned, when offline).
+		if (m_ppIBuffer) {
+			if (m_ppIPorts == NULL) {
+				for (i = 0; i < m_iChannels; ++i)
+					delete [] m_ppIBuffer[i];
+			}
+			delete [] m_ppIBuffer;
+		}
+		m_ppIBuffer = NULL;
 		// Free input ports.
 		if (m_ppIPorts)
 			delete [] m_ppIPorts;
 		m_ppIPorts = NULL;
-		// Free input buffers.
-		if (m_ppIBuffer)
-			delete [] m_ppIBuffer;
-		m_ppIBuffer = NULL;
 	}
 
 	if (busMode & qtractorBus::Output) {
@@ -2442,14 +2938,19 @@ void qtractorAudioBus::close (void)
 				}
 			}
 		}
+		// Free output buffers (owned, when offline).
+		if (m_ppOBuffer) {
+			if (m_ppOPorts == NULL) {
+				for (i = 0; i < m_iChannels; ++i)
+					delete [] m_ppOBuffer[i];
+			}
+			delete [] m_ppOBuffer;
+		}
+		m_ppOBuffer = NULL;
 		// Free output ports.
 		if (m_ppOPorts)
 			delete [] m_ppOPorts;
 		m_ppOPorts = NULL;
-		// Free output buffers.
-		if (m_ppOBuffer)
-			delete [] m_ppOBuffer;
-		m_ppOBuffer = NULL;
 	}
 
 	// Free internal buffers.
@@ -2604,6 +3105,11 @@ void qtractorAudioBus::process_prepare ( unsigned int nframes )
 
 	if (busMode & qtractorBus::Input) {
 		for (i = 0; i < m_iChannels; ++i) {
+			// Offline (headless) input is plain silence...
+			if (m_ppIPorts == NULL) {
+				::memset(m_ppIBuffer[i], 0, nframes * sizeof(float));
+				continue;
+			}
 			m_ppIBuffer[i] = static_cast<float *>
 				(jack_port_get_buffer(m_ppIPorts[i], nframes));
 		}
@@ -2611,8 +3117,10 @@ void qtractorAudioBus::process_prepare ( unsigned int nframes )
 
 	if (busMode & qtractorBus::Output) {
 		for (i = 0; i < m_iChannels; ++i) {
-			m_ppOBuffer[i] = static_cast<float *>
-				(jack_port_get_buffer(m_ppOPorts[i], nframes));
+			if (m_ppOPorts) {
+				m_ppOBuffer[i] = static_cast<float *>
+					(jack_port_get_buffer(m_ppOPorts[i], nframes));
+			}
 			// Zero-out output buffer...
 			::memset(m_ppOBuffer[i], 0, nframes * sizeof(float));
 		}
@@ -2658,6 +3166,20 @@ void qtractorAudioBus::process_commit ( unsigned int nframes )
 // Bus-buffering methods.
 void qtractorAudioBus::buffer_prepare (
 	unsigned int nframes, qtractorAudioBus *pInputBus )
+{
+	buffer_prepare(m_ppXBuffer, m_ppYBuffer, nframes, pInputBus);
+}
+
+void qtractorAudioBus::buffer_commit ( unsigned int nframes )
+{
+	buffer_commit(m_ppXBuffer, nframes);
+}
+
+
+// Bus-buffering methods (on external buffers).
+void qtractorAudioBus::buffer_prepare (
+	float **ppXBuffer, float **ppYBuffer,
+	unsigned int nframes, qtractorAudioBus *pInputBus )
 {
 	if (!m_bEnabled)
 		return;
@@ -2672,8 +3194,8 @@ void qtractorAudioBus::buffer_prepare (
 
 	if (pInputBus == NULL) {
 		for (unsigned short i = 0; i < m_iChannels; ++i) {
-			m_ppYBuffer[i] = m_ppXBuffer[i] + offset;
-			::memset(m_ppYBuffer[i], 0, nbytes);
+			ppYBuffer[i] = ppXBuffer[i] + offset;
+			::memset(ppYBuffer[i], 0, nbytes);
 		}
 		return;
 	}
@@ -2684,31 +3206,32 @@ void qtractorAudioBus::buffer_prepare (
 	if (m_iChannels == iBuffers) {
 		// Exact buffer copy...
 		for (unsigned short i = 0; i < iBuffers; ++i) {
-			m_ppYBuffer[i] = m_ppXBuffer[i] + offset;
-			::memcpy(m_ppYBuffer[i], ppBuffer[i] + offset, nbytes);
+			ppYBuffer[i] = ppXBuffer[i] + offset;
+			::memcpy(ppYBuffer[i], ppBuffer[i] + offset, nbytes);
 		}
 	} else {
 		// Buffer merge/multiplex...
 		unsigned short i;
 		for (i = 0; i < m_iChannels; ++i) {
-			m_ppYBuffer[i] = m_ppXBuffer[i] + offset;
-			::memset(m_ppYBuffer[i], 0, nbytes);
+			ppYBuffer[i] = ppXBuffer[i] + offset;
+			::memset(ppYBuffer[i], 0, nbytes);
 		}
 		if (m_iChannels > iBuffers) {
 			unsigned short j = 0;
 			for (i = 0; i < m_iChannels; ++i) {
-				::memcpy(m_ppYBuffer[i], ppBuffer[j] + offset, nbytes);
+				::memcpy(ppYBuffer[i], ppBuffer[j] + offset, nbytes);
 				if (++j >= iBuffers)
 					j = 0;
 			}
 		} else { // (m_iChannels < iBuffers)
-			(*m_pfnBufferAdd)(m_ppXBuffer, ppBuffer,
+			(*m_pfnBufferAdd)(ppXBuffer, ppBuffer,
 				nframes, m_iChannels, iBuffers, offset);
 		}
 	}
 }
 
-void qtractorAudioBus::buffer_commit ( unsigned int nframes )
+void qtractorAudioBus::buffer_commit (
+	float **ppXBuffer, unsigned int nframes )
 {
 	if (!m_bEnabled || (busMode() & qtractorBus::Output) == 0)
 		return;
@@ -2718,7 +3241,7 @@ void qtractorAudioBus::buffer_commit ( unsigned int nframes )
 	if (pAudioEngine == NULL)
 		return;
 
-	(*m_pfnBufferAdd)(m_ppOBuffer, m_ppXBuffer,
+	(*m_pfnBufferAdd)(m_ppOBuffer, ppXBuffer,
 		nframes, m_iChannels, m_iChannels, pAudioEngine->bufferOffset());
 }
 
@@ -24,18 +24,25 @@
 
 #include "qtractorAtomic.h"
 #include "qtractorEngine.h"
+#include "qtractorTimeScale.h"
 
 #include <jack/jack.h>
 
 #include <QObject>
+#include <QAtomicPointer>
+#include <QStringList>
 
 
 // Forward declarations.
 class qtractorAudioBus;
 class qtractorAudioBuffer;
+class qtractorAudioBufferPool;
 class qtractorAudioMonitor;
 class qtractorAudioFile;
 class qtractorAudioExportBuffer;
+class qtractorAudioExportPool;
+class qtractorAudioRenderPool;
+class qtractorAudioGraph;
 class qtractorPluginList;
 class qtractorCurveList;
 
@@ -69,6 +76,8 @@ public:
 		{ emit syncEvent(iPlayHead); }
 	void notifyPropEvent()
 		{ emit propEvent(); }
+	void notifyGraphEvent()
+		{ emit graphEvent(); }
 
 signals:
 	
@@ -80,6 +89,7 @@ signals:
 	void sessEvent(void *pvSessionArg);
 	void syncEvent(unsigned long iPlayHead);
 	void propEvent();
+	void graphEvent();
 };
 
 
@@ -94,6 +104,9 @@ public:
 	// Constructor.
 	qtractorAudioEngine(qtractorSession *pSession);
 
+	// Destructor.
+	~qtractorAudioEngine();
+
 	// Engine initialization.
 	bool init();
 
@@ -150,6 +163,17 @@ public:
 		const QList<qtractorAudioBus *>& exportBuses,
 		unsigned long iExportStart = 0, unsigned long iExportEnd = 0);
 
+	// Audio stem-export method: one file per bus and/or track,
+	// all in one single pass (file names derived from export path).
+	bool fileExportStems(const QString& sExportPath,
+		const QList<qtractorAudioBus *>& exportBuses,
+		const QList<qtractorTrack *>& exportTracks,
+		unsigned long iExportStart = 0, unsigned long iExportEnd = 0,
+		QStringList *pStemFiles = NULL);
+
+	// Last audio-export throughput (in realtime multiples).
+	float exportSpeed() const;
+
 	// Special track-immediate methods.
 	void trackMute(qtractorTrack *pTrack, bool bMute);
 
@@ -228,6 +252,36 @@ public:
 	// Absolute number of frames elapsed since engine start.
 	unsigned long jackFrameTime() const;
 
+	// Parallel track rendering worker threads (0=serial).
+	void setRenderThreads(unsigned int iRenderThreads);
+	unsigned int renderThreads() const;
+
+	// Parallel track rendering pool accessor.
+	qtractorAudioRenderPool *renderPool() const;
+
+	// Tempo-map reader accessor (audio thread only).
+	qtractorTimeScale::Reader *timeReader() const;
+
+	// Block automation sub-block size (in frames; 0=per-period).
+	void setBlockAutomation(unsigned int iBlockFrames);
+	unsigned int blockAutomation() const;
+
+	// Common audio buffer I/O worker threads.
+	void setSyncThreads(unsigned int iSyncThreads);
+	unsigned int syncThreads() const;
+
+	// Common audio buffer I/O pool accessor (lazy created).
+	qtractorAudioBufferPool *syncPool();
+
+	// Audio routing graph invalidation (on any topology change).
+	void resetGraph();
+
+	// Audio routing graph (topology) change serial.
+	int graphSerial() const;
+
+	// Audio routing graph (re)compilation, if invalid (non RT-safe).
+	void updateGraph();
+
 	// Reset all audio monitoring...
 	void resetAllMonitors();
 
@@ -255,9 +309,22 @@ protected:
 	// Freewheeling process cycle executive (needed for export).
 	void process_export(unsigned int nframes);
 
+	// Audio-export common pre-conditions (before any file gets opened).
+	bool fileExportCheck() const;
+
+	// Audio-export common executive (freewheeling).
+	bool fileExportEx(const QList<qtractorAudioBus *>& exportBuses,
+		unsigned long iExportStart, unsigned long iExportEnd);
+
 	// Metronome latency offset compensation.
 	unsigned long metro_offset(unsigned long iFrame) const;
 
+	// Current audio routing graph, if still valid (RT-safe).
+	qtractorAudioGraph *graph();
+
+	// Audio routing graph cleanup (non RT-safe).
+	void cleanGraph();
+
 private:
 
 	// Special event notifier proxy object.
@@ -283,8 +350,28 @@ private:
 	// Audio-export freewheeling (internal) state.
 	bool m_bFreewheel;
 
-	// Common audio buffer sync thread.
-	qtractorAudioBufferThread *m_pSyncThread;
+	// Common audio buffer I/O worker pool.
+	unsigned int m_iSyncThreads;
+	qtractorAudioBufferPool *m_pSyncPool;
+
+	// Parallel track rendering pool.
+	unsigned int m_iRenderThreads;
+	qtractorAudioRenderPool *m_pRenderPool;
+
+	// Tempo-map reader (audio thread).
+	qtractorTimeScale::Reader *m_pTimeReader;
+
+	// Block automation sub-block size.
+	unsigned int m_iBlockAutomation;
+
+	// Audio routing graph, current (RT), posted and retired.
+	qtractorAtomic m_graphSerial;
+	qtractorAtomic m_graphPending;
+	int m_iGraphSerial;
+
+	qtractorAudioGraph *m_pGraph;
+	QAtomicPointer<qtractorAudioGraph> m_graphNext;
+	QAtomicPointer<qtractorAudioGraph> m_graphDone;
 
 	// Audio-export (in)active state.
 	volatile bool        m_bExporting;
@@ -295,6 +382,9 @@ private:
 
 	QList<qtractorAudioBus *> *m_pExportBuses;
 	qtractorAudioExportBuffer *m_pExportBuffer;
+	qtractorAudioExportPool   *m_pExportPool;
+
+	float                m_fExportSpeed;
 
 	// Audio metronome stuff.
 	bool                 m_bMetronome;
@@ -374,6 +464,11 @@ public:
 		qtractorAudioBus *pInputBus = NULL);
 	void buffer_commit(unsigned int nframes);
 
+	// Bus-buffering methods (on external buffers).
+	void buffer_prepare(float **ppXBuffer, float **ppYBuffer,
+		unsigned int nframes, qtractorAudioBus *pInputBus = NULL);
+	void buffer_commit(float **ppXBuffer, unsigned int nframes);
+
 	// Up-and-running predicate.
 	bool isEnabled() const { return m_bEnabled; }
 
@@ -399,6 +494,13 @@ public:
 	unsigned int latency_in()  const;
 	unsigned int latency_out() const;
 
+	// Plugin delay compensation: aligned (maximum) latency
+	// of all tracks and aux-sends into this bus (in frames).
+	void setLatencyComp(unsigned long iLatencyComp)
+		{ m_iLatencyComp = iLatencyComp; }
+	unsigned long latencyComp() const
+		{ return m_iLatencyComp; }
+
 	// Retrieve/restore client:port connections;
 	// return the effective number of connection attempts...
 	int updateConnects(BusMode busMode,
@@ -451,6 +553,9 @@ private:
 	// (r/w access should be atomic)
 	volatile bool m_bEnabled;
 
+	// Plugin delay compensation (aligned) latency.
+	unsigned long m_iLatencyComp;
+
 	// Buffer mix-down processor.
 	void (*m_pfnBufferAdd)(float **, float **, unsigned int,
 		unsigned short, unsigned short, unsigned int);
@@ -0,0 +1,419 @@
+// qtractorAudioExport.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioExport.h"
+
+#include "qtractorAudioEngine.h"
+#include "qtractorAudioFile.h"
+
+#include "qtractorTrack.h"
+
+#include <QFileInfo>
+#include <QDir>
+#include <QRegExp>
+
+
+// Stem ring-buffer size, in number of process cycles.
+#define QTRACTOR_EXPORT_CYCLES	64
+
+// Writer chunk size, in frames.
+#define QTRACTOR_EXPORT_CHUNK	4096
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioExportStem -- Stem export file (one per bus/track).
+//
+
+// Constructor.
+qtractorAudioExportStem::qtractorAudioExportStem ( qtractorAudioExportPool *pPool,
+	const QString& sFilename, unsigned short iChannels )
+	: m_pPool(pPool), m_sFilename(sFilename), m_iChannels(iChannels), m_pFile(NULL)
+{
+	m_pRingBuffer = new qtractorRingBuffer<float> (m_iChannels,
+		m_pPool->bufferSize() * QTRACTOR_EXPORT_CYCLES);
+
+	m_iFrames  = QTRACTOR_EXPORT_CHUNK;
+	m_ppFrames = new float * [m_iChannels];
+	for (unsigned short i = 0; i < m_iChannels; ++i)
+		m_ppFrames[i] = new float [m_iFrames];
+
+	m_iRemain  = 0;
+	m_iWritten = 0;
+}
+
+
+// Destructor.
+qtractorAudioExportStem::~qtractorAudioExportStem (void)
+{
+	close();
+
+	for (unsigned short i = 0; i < m_iChannels; ++i)
+		delete [] m_ppFrames[i];
+	delete [] m_ppFrames;
+
+	delete m_pRingBuffer;
+}
+
+
+// Open the stem file, for writing of course.
+bool qtractorAudioExportStem::open (
+	unsigned int iSampleRate, unsigned long iFrames )
+{
+	close();
+
+	qtractorAudioFile *pFile
+		= qtractorAudioFileFactory::createAudioFile(
+			m_sFilename, m_iChannels, iSampleRate);
+	if (pFile == NULL)
+		return false;
+
+	if (!pFile->open(m_sFilename, qtractorAudioFile::Write)) {
+		delete pFile;
+		return false;
+	}
+
+	m_pRingBuffer->reset();
+
+	m_pFile    = pFile;
+	m_iRemain  = iFrames;
+	m_iWritten = 0;
+
+	return true;
+}
+
+
+// Flush and close the stem file.
+void qtractorAudioExportStem::close (void)
+{
+	if (m_pFile == NULL)
+		return;
+
+	flush();
+
+	m_pFile->close();
+	delete m_pFile;
+	m_pFile = NULL;
+}
+
+
+// Render side: push a block of frames.
+void qtractorAudioExportStem::write ( float **ppFrames, unsigned int nframes )
+{
+	if (m_pFile == NULL)
+		return;
+
+	// Never past the export range end...
+	if (nframes > m_iRemain)
+		nframes = m_iRemain;
+
+	unsigned int offset = 0;
+	while (nframes > 0) {
+		const int nwrite = m_pRingBuffer->write(ppFrames, nframes, offset);
+		if (nwrite > 0) {
+			offset  += nwrite;
+			nframes -= nwrite;
+			m_iRemain -= nwrite;
+		}
+		else m_pPool->waitWritable();
+	}
+}
+
+
+// Writer side: drain whatever's pending into file.
+unsigned int qtractorAudioExportStem::flush (void)
+{
+	if (m_pFile == NULL)
+		return 0;
+
+	unsigned int nflush = 0;
+
+	int nread = m_pRingBuffer->read(m_ppFrames, m_iFrames);
+	while (nread > 0) {
+		m_pFile->write(m_ppFrames, nread);
+		m_iWritten += nread;
+		nflush += nread;
+		nread = m_pRingBuffer->read(m_ppFrames, m_iFrames);
+	}
+
+	return nflush;
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioExportThread -- Stem export writer worker.
+//
+
+// Constructor.
+qtractorAudioExportThread::qtractorAudioExportThread (
+	qtractorAudioExportPool *pPool, unsigned int iSlot ) : QThread()
+{
+	m_pPool = pPool;
+	m_iSlot = iSlot;
+
+	m_bSyncPending = false;
+	m_bRunState = false;
+}
+
+
+// Run state accessor.
+void qtractorAudioExportThread::setRunState ( bool bRunState )
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_bRunState = bRunState;
+}
+
+bool qtractorAudioExportThread::runState (void) const
+{
+	return m_bRunState;
+}
+
+
+// Wake from executive wait condition.
+void qtractorAudioExportThread::sync (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_bSyncPending = true;
+	m_cond.wakeAll();
+}
+
+
+// Thread run executive.
+void qtractorAudioExportThread::run (void)
+{
+	m_mutex.lock();
+
+	m_bRunState = true;
+
+	while (m_bRunState) {
+		// Wait for sync, unless it's already pending...
+		if (!m_bSyncPending)
+			m_cond.wait(&m_mutex);
+		m_bSyncPending = false;
+		if (!m_bRunState)
+			break;
+		// Write whatever we've got...
+		m_mutex.unlock();
+		m_pPool->flush(m_iSlot);
+		m_mutex.lock();
+	}
+
+	m_mutex.unlock();
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioExportPool -- Stem export writer pool.
+//
+
+// Constructor.
+qtractorAudioExportPool::qtractorAudioExportPool ( unsigned int iBufferSize )
+	: m_iBufferSize(iBufferSize)
+{
+}
+
+
+// Destructor.
+qtractorAudioExportPool::~qtractorAudioExportPool (void)
+{
+	close();
+
+	// Tracks are not capturing anymore...
+	QListIterator<qtractorTrack *> track_iter(m_tracks);
+	while (track_iter.hasNext())
+		track_iter.next()->setExportStem(NULL);
+	m_tracks.clear();
+
+	qDeleteAll(m_stems);
+	m_stems.clear();
+}
+
+
+// Stem file name, as derived from the main export path:
+// eg. "/path/to/export.wav" + "Master" => "/path/to/export-Master.wav".
+QString qtractorAudioExportPool::stemPath (
+	const QString& sExportPath, const QString& sName )
+{
+	const QFileInfo info(sExportPath);
+
+	QString sSuffix = info.suffix();
+	if (sSuffix.isEmpty())
+		sSuffix = qtractorAudioFileFactory::defaultExt();
+
+	QString sStemName = sName.simplified();
+	sStemName.replace(QRegExp("[\\s\\/\\\\:]+"), "_");
+
+	return info.dir().filePath(
+		info.completeBaseName() + '-' + sStemName + '.' + sSuffix);
+}
+
+
+// Stem registry.
+qtractorAudioExportStem *qtractorAudioExportPool::addBusStem (
+	qtractorAudioBus *pAudioBus, const QString& sFilename )
+{
+	qtractorAudioExportStem *pStem = m_busStems.value(pAudioBus, NULL);
+	if (pStem)
+		return pStem;
+
+	pStem = new qtractorAudioExportStem(
+		this, sFilename, pAudioBus->channels());
+	m_stems.append(pStem);
+	m_busStems.insert(pAudioBus, pStem);
+
+	return pStem;
+}
+
+
+qtractorAudioExportStem *qtractorAudioExportPool::addTrackStem (
+	qtractorTrack *pTrack, const QString& sFilename )
+{
+	// Only audio tracks have audio of their own...
+	if (pTrack->trackType() != qtractorTrack::Audio)
+		return NULL;
+
+	qtractorAudioBus *pAudioBus
+		= static_cast<qtractorAudioBus *> (pTrack->outputBus());
+	if (pAudioBus == NULL)
+		return NULL;
+
+	qtractorAudioExportStem *pStem = pTrack->exportStem();
+	if (pStem)
+		return pStem;
+
+	pStem = new qtractorAudioExportStem(
+		this, sFilename, pAudioBus->channels());
+	m_stems.append(pStem);
+	m_tracks.append(pTrack);
+
+	pTrack->setExportStem(pStem);
+
+	return pStem;
+}
+
+
+// Open all stem files and start the writer threads.
+bool qtractorAudioExportPool::open ( unsigned int iSampleRate,
+	unsigned long iFrames, unsigned int iThreads )
+{
+	close();
+
+	if (m_stems.isEmpty())
+		return false;
+
+	QListIterator<qtractorAudioExportStem *> iter(m_stems);
+	while (iter.hasNext()) {
+		if (!iter.next()->open(iSampleRate, iFrames)) {
+			close();
+			return false;
+		}
+	}
+
+	// Default: as many writers as cores to spare, one per stem at most.
+	if (iThreads < 1) {
+		const int iIdealThreads = QThread::idealThreadCount() - 1;
+		iThreads = (iIdealThreads > 1 ? iIdealThreads : 1);
+	}
+	if (iThreads > (unsigned int) m_stems.count())
+		iThreads = m_stems.count();
+
+	for (unsigned int i = 0; i < iThreads; ++i)
+		m_threads.append(new qtractorAudioExportThread(this, i));
+
+	QListIterator<qtractorAudioExportThread *> thread_iter(m_threads);
+	while (thread_iter.hasNext())
+		thread_iter.next()->start();
+
+	return true;
+}
+
+
+// Stop writer threads, flush and close all stem files.
+void qtractorAudioExportPool::close (void)
+{
+	QListIterator<qtractorAudioExportThread *> thread_iter(m_threads);
+	while (thread_iter.hasNext()) {
+		qtractorAudioExportThread *pThread = thread_iter.next();
+		if (pThread->isRunning()) do {
+			pThread->setRunState(false);
+			pThread->sync();
+		} while (!pThread->wait(100));
+		delete pThread;
+	}
+	m_threads.clear();
+
+	// Remaining frames get flushed on close...
+	QListIterator<qtractorAudioExportStem *> iter(m_stems);
+	while (iter.hasNext())
+		iter.next()->close();
+}
+
+
+// Render side: bus stem capture (after commit).
+void qtractorAudioExportPool::process (
+	qtractorAudioBus *pAudioBus, unsigned int nframes )
+{
+	qtractorAudioExportStem *pStem = m_busStems.value(pAudioBus, NULL);
+	if (pStem)
+		pStem->write(pAudioBus->out(), nframes);
+}
+
+
+// Render side: wake up the writers (end of cycle).
+void qtractorAudioExportPool::sync (void)
+{
+	QListIterator<qtractorAudioExportThread *> iter(m_threads);
+	while (iter.hasNext())
+		iter.next()->sync();
+}
+
+
+// Render side: wait for room on some stem buffer.
+void qtractorAudioExportPool::waitWritable (void)
+{
+	sync();
+
+	QMutexLocker locker(&m_mutex);
+	m_cond.wait(&m_mutex, 10);
+}
+
+
+// Writer side: serve stems of some thread slot.
+void qtractorAudioExportPool::flush ( unsigned int iSlot )
+{
+	const unsigned int iThreads = m_threads.count();
+	const unsigned int iStems = m_stems.count();
+
+	unsigned int nflush = 0;
+	for (unsigned int i = iSlot; i < iStems; i += iThreads)
+		nflush += m_stems.at(i)->flush();
+
+	// Let the render side know there's room again...
+	if (nflush > 0) {
+		QMutexLocker locker(&m_mutex);
+		m_cond.wakeAll();
+	}
+}
+
+
+// end of qtractorAudioExport.cpp
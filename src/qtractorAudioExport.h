@@ -0,0 +1,212 @@
+// qtractorAudioExport.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioExport_h
+#define __qtractorAudioExport_h
+
+#include "qtractorRingBuffer.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <QString>
+#include <QList>
+#include <QHash>
+
+
+// Forward declarations.
+class qtractorAudioFile;
+class qtractorAudioBus;
+class qtractorTrack;
+class qtractorAudioExportPool;
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioExportStem -- Stem export file (one per bus/track).
+//
+
+class qtractorAudioExportStem
+{
+public:
+
+	// Constructor.
+	qtractorAudioExportStem(qtractorAudioExportPool *pPool,
+		const QString& sFilename, unsigned short iChannels);
+
+	// Destructor.
+	~qtractorAudioExportStem();
+
+	// Stem file accessors.
+	const QString& filename() const { return m_sFilename; }
+	unsigned short channels() const { return m_iChannels; }
+
+	// Open/close the stem file (writer side).
+	bool open(unsigned int iSampleRate, unsigned long iFrames);
+	void close();
+
+	bool isOpen() const { return (m_pFile != NULL); }
+
+	// Render side: push a block of frames, blocking
+	// only when the writer pool can't catch up (freewheel).
+	void write(float **ppFrames, unsigned int nframes);
+
+	// Writer side: drain whatever's pending into file.
+	unsigned int flush();
+
+	// Total frames actually written into file.
+	unsigned long written() const { return m_iWritten; }
+
+private:
+
+	// Instance variables.
+	qtractorAudioExportPool *m_pPool;
+
+	QString        m_sFilename;
+	unsigned short m_iChannels;
+
+	qtractorAudioFile *m_pFile;
+
+	qtractorRingBuffer<float> *m_pRingBuffer;
+
+	float **m_ppFrames;
+	unsigned int m_iFrames;
+
+	// Remaining frames to be taken (export range length).
+	unsigned long m_iRemain;
+	unsigned long m_iWritten;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioExportThread -- Stem export writer worker.
+//
+
+class qtractorAudioExportThread : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorAudioExportThread(
+		qtractorAudioExportPool *pPool, unsigned int iSlot);
+
+	// Thread run state accessors.
+	void setRunState(bool bRunState);
+	bool runState() const;
+
+	// Wake from executive wait condition.
+	void sync();
+
+protected:
+
+	// The main thread executive.
+	void run();
+
+private:
+
+	// Instance variables.
+	qtractorAudioExportPool *m_pPool;
+	unsigned int m_iSlot;
+
+	volatile bool m_bSyncPending;
+	volatile bool m_bRunState;
+
+	QMutex m_mutex;
+	QWaitCondition m_cond;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioExportPool -- Stem export writer pool.
+//
+// One pass over the timeline feeds every stem ring-buffer from the
+// render thread; encoding and disk writes are carried on by a small
+// pool of writer threads, each one serving its own share of stems.
+//
+
+class qtractorAudioExportPool
+{
+public:
+
+	// Constructor.
+	qtractorAudioExportPool(unsigned int iBufferSize);
+
+	// Destructor.
+	~qtractorAudioExportPool();
+
+	// Stem file name, as derived from the main export path.
+	static QString stemPath(const QString& sExportPath, const QString& sName);
+
+	// Stem registry.
+	qtractorAudioExportStem *addBusStem(
+		qtractorAudioBus *pAudioBus, const QString& sFilename);
+	qtractorAudioExportStem *addTrackStem(
+		qtractorTrack *pTrack, const QString& sFilename);
+
+	const QList<qtractorAudioExportStem *>& stems() const
+		{ return m_stems; }
+
+	// Open all stem files and start the writer threads.
+	bool open(unsigned int iSampleRate, unsigned long iFrames,
+		unsigned int iThreads = 0);
+
+	// Stop writer threads, flush and close all stem files.
+	void close();
+
+	// Render side: bus stem capture (after commit).
+	void process(qtractorAudioBus *pAudioBus, unsigned int nframes);
+
+	// Render side: wake up the writers (end of cycle).
+	void sync();
+
+	// Render side: wait for room on some stem buffer.
+	void waitWritable();
+
+	// Writer side: serve stems of some thread slot.
+	void flush(unsigned int iSlot);
+
+	// Number of writer threads.
+	unsigned int threads() const { return m_threads.count(); }
+
+	// Process cycle buffer size.
+	unsigned int bufferSize() const { return m_iBufferSize; }
+
+private:
+
+	// Instance variables.
+	unsigned int m_iBufferSize;
+
+	QList<qtractorAudioExportStem *> m_stems;
+	QHash<qtractorAudioBus *, qtractorAudioExportStem *> m_busStems;
+	QList<qtractorTrack *> m_tracks;
+
+	QList<qtractorAudioExportThread *> m_threads;
+
+	// Writer to render side back-pressure.
+	QMutex m_mutex;
+	QWaitCondition m_cond;
+};
+
+
+#endif  // __qtractorAudioExport_h
+
+
+// end of qtractorAudioExport.h
@@ -22,6 +22,7 @@
 #include "qtractorAbout.h"
 #include "qtractorAudioFile.h"
 #include "qtractorAudioSndFile.h"
+#include "qtractorAudioMmapFile.h"
 #include "qtractorAudioVorbisFile.h"
 #include "qtractorAudioMadFile.h"
 
@@ -180,7 +181,13 @@ qtractorAudioFile *qtractorAudioFileFactory::newAudioFile (
 	if (iter == m_types.constEnd())
 		return NULL;
 
-	return newAudioFile(iter.value()->type, iChannels, iSampleRate, iBufferSize);
+	// Plain WAV/CAF files may be read straight off mapped pages...
+	const FileFormat *pFormat = iter.value();
+	if (pFormat->type == SndFile
+		&& (pFormat->data == SF_FORMAT_WAV || pFormat->data == SF_FORMAT_CAF))
+		return new qtractorAudioMmapFile(iChannels, iSampleRate, iBufferSize);
+
+	return newAudioFile(pFormat->type, iChannels, iSampleRate, iBufferSize);
 }
 
 
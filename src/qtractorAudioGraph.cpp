@@ -0,0 +1,404 @@
+// qtractorAudioGraph.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioGraph.h"
+
+#include "qtractorSession.h"
+#include "qtractorSessionCursor.h"
+
+#include "qtractorAudioEngine.h"
+#include "qtractorInsertPlugin.h"
+
+#include <QHash>
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioGraph -- Audio routing dependency graph.
+//
+
+// Constructor.
+qtractorAudioGraph::qtractorAudioGraph (
+	qtractorSession *pSession, int iSerial )
+{
+	m_iSerial = iSerial;
+	m_bValid  = false;
+
+	m_pInputs = NULL;
+	m_pReady  = NULL;
+
+	ATOMIC_SET(&m_head, 0);
+	ATOMIC_SET(&m_tail, 0);
+	ATOMIC_SET(&m_done, 0);
+
+	m_pSessionCursor = NULL;
+
+	m_iFrameStart = 0;
+	m_iFrameEnd   = 0;
+
+	compile(pSession);
+
+	// Per-cycle state gets allocated here, once and for all...
+	const int iNodes = m_nodes.count();
+	if (m_bValid && iNodes > 0) {
+		m_pInputs = new qtractorAtomic [iNodes];
+		m_pReady  = new qtractorAtomic [iNodes];
+		for (int i = 0; i < iNodes; ++i) {
+			ATOMIC_SET(&m_pInputs[i], 0);
+			ATOMIC_SET(&m_pReady[i], 0);
+		}
+	}
+}
+
+
+// Destructor.
+qtractorAudioGraph::~qtractorAudioGraph (void)
+{
+	if (m_pReady)
+		delete [] m_pReady;
+	if (m_pInputs)
+		delete [] m_pInputs;
+}
+
+
+// Topology serial number (generation) accessor.
+int qtractorAudioGraph::serial (void) const
+{
+	return m_iSerial;
+}
+
+
+// Whether the topology compiled into a proper DAG.
+bool qtractorAudioGraph::isValid (void) const
+{
+	return m_bValid;
+}
+
+
+// Number of nodes.
+unsigned int qtractorAudioGraph::nodes (void) const
+{
+	return m_nodes.count();
+}
+
+
+// Node introspection.
+qtractorAudioGraph::NodeType qtractorAudioGraph::nodeType ( int iNode ) const
+{
+	return m_nodes.at(iNode).type;
+}
+
+const QVector<int>& qtractorAudioGraph::nodeOutputs ( int iNode ) const
+{
+	return m_nodes.at(iNode).outputs;
+}
+
+
+// Topologically sorted node order.
+const QVector<int>& qtractorAudioGraph::order (void) const
+{
+	return m_order;
+}
+
+
+// Aux-send targets, from a plugin chain.
+void qtractorAudioGraph::auxSends ( qtractorPluginList *pPluginList,
+	QVector<qtractorAudioAuxSendPlugin *>& sends ) const
+{
+	if (pPluginList == NULL || pPluginList->isMidi())
+		return;
+
+	for (qtractorPlugin *pPlugin = pPluginList->first();
+			pPlugin; pPlugin = pPlugin->next()) {
+		if ((pPlugin->type())->typeHint() == qtractorPluginType::AuxSend) {
+			qtractorAudioAuxSendPlugin *pAuxSendPlugin
+				= static_cast<qtractorAudioAuxSendPlugin *> (pPlugin);
+			if (pAuxSendPlugin && pAuxSendPlugin->audioBus())
+				sends.append(pAuxSendPlugin);
+		}
+	}
+}
+
+
+// Graph build: nodes and edges.
+void qtractorAudioGraph::compile ( qtractorSession *pSession )
+{
+	qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return;
+
+	// A mix-node and a bus-node for each bus, in bus order...
+	QHash<qtractorAudioBus *, int> buses;
+	QVector<qtractorAudioBus *> busList;
+	for (qtractorBus *pBus = pAudioEngine->buses().first();
+			pBus; pBus = pBus->next()) {
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (pBus);
+		if (pAudioBus == NULL)
+			continue;
+		Node mix;
+		mix.type   = MixNode;
+		mix.track  = NULL;
+		mix.index  = 0;
+		mix.bus    = pAudioBus;
+		mix.inputs = 0;
+		m_nodes.append(mix);
+		Node bus = mix;
+		bus.type = BusNode;
+		m_nodes.append(bus);
+		buses.insert(pAudioBus, busList.count());
+		busList.append(pAudioBus);
+	}
+
+	#define MIX_NODE(b)	(2 * (b))
+	#define BUS_NODE(b)	(2 * (b) + 1)
+
+	// A track-node for each audio track; mix-down items
+	// are appended in strict track order (sends first)...
+	unsigned int iTrack = 0;
+	for (qtractorTrack *pTrack = pSession->tracks().first();
+			pTrack; pTrack = pTrack->next(), ++iTrack) {
+		if (pTrack->trackType() != qtractorTrack::Audio)
+			continue;
+		qtractorAudioBus *pOutputBus
+			= static_cast<qtractorAudioBus *> (pTrack->outputBus());
+		// Can't do without a private render buffer...
+		if (pOutputBus && !pTrack->isRenderBuffer())
+			return;
+		const int iNode = m_nodes.count();
+		Node track;
+		track.type   = TrackNode;
+		track.track  = pTrack;
+		track.index  = iTrack;
+		track.bus    = NULL;
+		track.inputs = 0;
+		m_nodes.append(track);
+		MixItem item;
+		QVector<qtractorAudioAuxSendPlugin *> sends;
+		auxSends(pTrack->pluginList(), sends);
+		QVectorIterator<qtractorAudioAuxSendPlugin *> iter(sends);
+		while (iter.hasNext()) {
+			qtractorAudioAuxSendPlugin *pAuxSendPlugin = iter.next();
+			const int x = buses.value(pAuxSendPlugin->audioBus(), -1);
+			if (x < 0)
+				continue;
+			item.track   = NULL;
+			item.auxSend = pAuxSendPlugin;
+			m_nodes[MIX_NODE(x)].items.append(item);
+			m_nodes[iNode].sends.append(pAuxSendPlugin);
+			addEdge(iNode, MIX_NODE(x));
+		}
+		const int b = buses.value(pOutputBus, -1);
+		if (b >= 0) {
+			item.track   = pTrack;
+			item.auxSend = NULL;
+			m_nodes[MIX_NODE(b)].items.append(item);
+			addEdge(iNode, MIX_NODE(b));
+		}
+	}
+
+	// Bus output aux-sends: writers onto each bus output...
+	const int iBuses = busList.count();
+	QVector<QVector<int> > writers(iBuses);
+	for (int a = 0; a < iBuses; ++a) {
+		QVector<qtractorAudioAuxSendPlugin *> sends;
+		auxSends(busList.at(a)->pluginList_out(), sends);
+		QVectorIterator<qtractorAudioAuxSendPlugin *> iter(sends);
+		while (iter.hasNext()) {
+			const int x = buses.value(iter.next()->audioBus(), -1);
+			if (x >= 0 && x != a && !writers[x].contains(a))
+				writers[x].append(a);
+		}
+	}
+
+	// Chain all writers and the bus itself, in bus order,
+	// after all tracks have been mixed down onto it...
+	for (int x = 0; x < iBuses; ++x) {
+		QVector<int>& chain = writers[x];
+		int i = 0;
+		while (i < chain.count() && chain.at(i) < x)
+			++i;
+		chain.insert(i, x);
+		addEdge(MIX_NODE(x), BUS_NODE(chain.first()));
+		for (i = 1; i < chain.count(); ++i)
+			addEdge(BUS_NODE(chain.at(i - 1)), BUS_NODE(chain.at(i)));
+		addEdge(MIX_NODE(x), BUS_NODE(x));
+	}
+
+	#undef MIX_NODE
+	#undef BUS_NODE
+
+	m_bValid = sort();
+}
+
+
+// Graph build: add an unique edge.
+void qtractorAudioGraph::addEdge ( int iNode, int iNextNode )
+{
+	Node& node = m_nodes[iNode];
+	if (!node.outputs.contains(iNextNode)) {
+		node.outputs.append(iNextNode);
+		++m_nodes[iNextNode].inputs;
+	}
+}
+
+
+// Graph build: topological sort (Kahn); false on cycles.
+bool qtractorAudioGraph::sort (void)
+{
+	const int iNodes = m_nodes.count();
+
+	QVector<int> inputs(iNodes);
+	int i;
+	for (i = 0; i < iNodes; ++i) {
+		inputs[i] = m_nodes.at(i).inputs;
+		if (inputs[i] == 0) {
+			m_order.append(i);
+			m_sources.append(i);
+		}
+	}
+
+	for (i = 0; i < m_order.count(); ++i) {
+		const QVector<int>& outputs = m_nodes.at(m_order.at(i)).outputs;
+		QVectorIterator<int> iter(outputs);
+		while (iter.hasNext()) {
+			const int iNextNode = iter.next();
+			if (--inputs[iNextNode] == 0)
+				m_order.append(iNextNode);
+		}
+	}
+
+	return (m_order.count() == iNodes);
+}
+
+
+// Process cycle setup; queue all source nodes (RT-safe).
+void qtractorAudioGraph::reset ( qtractorSessionCursor *pSessionCursor,
+	unsigned long iFrameStart, unsigned long iFrameEnd )
+{
+	m_pSessionCursor = pSessionCursor;
+
+	m_iFrameStart = iFrameStart;
+	m_iFrameEnd   = iFrameEnd;
+
+	ATOMIC_SET(&m_done, 0);
+	ATOMIC_SET(&m_tail, 0);
+	ATOMIC_SET(&m_head, 0);
+
+	const int iNodes = m_nodes.count();
+	for (int i = 0; i < iNodes; ++i) {
+		ATOMIC_SET(&m_pInputs[i], m_nodes.at(i).inputs);
+		ATOMIC_SET(&m_pReady[i], 0);
+	}
+
+	const int iSources = m_sources.count();
+	for (int i = 0; i < iSources; ++i)
+		push(m_sources.at(i));
+}
+
+
+// Ready queue: each node gets pushed exactly once per cycle;
+// the tail reserves a slot, which is published by its value.
+void qtractorAudioGraph::push ( int iNode )
+{
+	const int iTail = ATOMIC_INC(&m_tail) - 1;
+	ATOMIC_SET(&m_pReady[iTail], iNode + 1);
+}
+
+
+// Claim next ready node, if any (RT-safe): the head never gets past
+// a reserved but not yet published slot; the pusher might be still
+// on its way (eg. preempted), so it's up to the caller to retry.
+int qtractorAudioGraph::claim (void)
+{
+	for (;;) {
+		const int iHead = ATOMIC_GET(&m_head);
+		if (iHead >= ATOMIC_GET(&m_tail))
+			break;
+		const int iValue = ATOMIC_GET(&m_pReady[iHead]);
+		if (iValue == 0)
+			break;
+		if (ATOMIC_CAS(&m_head, iHead, iHead + 1))
+			return iValue - 1;
+	}
+
+	return -1;
+}
+
+
+// Execute a claimed node, releasing its dependants (RT-safe).
+unsigned int qtractorAudioGraph::process ( int iNode )
+{
+	const Node& node = m_nodes.at(iNode);
+	const unsigned int nframes = m_iFrameEnd - m_iFrameStart;
+
+	switch (node.type) {
+	case TrackNode: {
+		// Hold track aux-sends for the ordered mix-down...
+		const int iSends = node.sends.count();
+		for (int i = 0; i < iSends; ++i)
+			node.sends.at(i)->setSendDeferred(true);
+		node.track->process(m_pSessionCursor->clip(node.index),
+			m_iFrameStart, m_iFrameEnd, true);
+		break;
+	}
+	case MixNode: {
+		// Strict track order mix-down...
+		const int iItems = node.items.count();
+		for (int i = 0; i < iItems; ++i) {
+			const MixItem& item = node.items.at(i);
+			if (item.track)
+				item.track->process_commit(nframes);
+			else
+				item.auxSend->process_commit(nframes);
+		}
+		break;
+	}
+	case BusNode:
+		node.bus->process_commit(nframes);
+		break;
+	}
+
+	// Release all dependants...
+	unsigned int iReady = 0;
+	const int iOutputs = node.outputs.count();
+	for (int i = 0; i < iOutputs; ++i) {
+		const int iNextNode = node.outputs.at(i);
+		if (ATOMIC_DEC(&m_pInputs[iNextNode]) == 0) {
+			push(iNextNode);
+			++iReady;
+		}
+	}
+
+	ATOMIC_INC(&m_done);
+
+	return iReady;
+}
+
+
+// Whether all nodes were processed in current cycle (RT-safe).
+bool qtractorAudioGraph::isDone (void) const
+{
+	return (ATOMIC_GET(&m_done) >= m_nodes.count());
+}
+
+
+// end of qtractorAudioGraph.cpp
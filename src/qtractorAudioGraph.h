@@ -0,0 +1,159 @@
+// qtractorAudioGraph.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioGraph_h
+#define __qtractorAudioGraph_h
+
+#include "qtractorAtomic.h"
+
+#include <QVector>
+
+
+// Forward declarations.
+class qtractorSession;
+class qtractorSessionCursor;
+class qtractorTrack;
+class qtractorAudioBus;
+class qtractorAudioAuxSendPlugin;
+class qtractorPluginList;
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioGraph -- Audio routing dependency graph.
+//
+// Compiled (non RT-safe) from the current session topology, with:
+//
+//   Track node: track render, on its own private buffer;
+//   Mix node:   ordered commit of all tracks and track aux-sends
+//               onto some bus output (in strict track order);
+//   Bus node:   bus output plugin chain and monitor commit.
+//
+// Bus output aux-sends are ordered as they would in the serial
+// (bus list) order, so results stay the same whatever the schedule.
+//
+
+class qtractorAudioGraph
+{
+public:
+
+	// Constructor.
+	qtractorAudioGraph(qtractorSession *pSession, int iSerial);
+
+	// Destructor.
+	~qtractorAudioGraph();
+
+	// Node types.
+	enum NodeType { TrackNode, MixNode, BusNode };
+
+	// Topology serial number (generation) accessor.
+	int serial() const;
+
+	// Whether the topology compiled into a proper DAG.
+	bool isValid() const;
+
+	// Number of nodes.
+	unsigned int nodes() const;
+
+	// Node introspection.
+	NodeType nodeType(int iNode) const;
+	const QVector<int>& nodeOutputs(int iNode) const;
+
+	// Topologically sorted node order.
+	const QVector<int>& order() const;
+
+	// Process cycle setup; queue all source nodes (RT-safe).
+	void reset(qtractorSessionCursor *pSessionCursor,
+		unsigned long iFrameStart, unsigned long iFrameEnd);
+
+	// Claim next ready node, if any (RT-safe).
+	int claim();
+
+	// Execute a claimed node, releasing its dependants;
+	// returns the number of nodes made ready (RT-safe).
+	unsigned int process(int iNode);
+
+	// Whether all nodes were processed in current cycle (RT-safe).
+	bool isDone() const;
+
+protected:
+
+	// Ordered mix-down item (either a track or an aux-send).
+	struct MixItem
+	{
+		qtractorTrack              *track;
+		qtractorAudioAuxSendPlugin *auxSend;
+	};
+
+	// Graph node.
+	struct Node
+	{
+		NodeType           type;
+		qtractorTrack     *track;
+		unsigned int       index;
+		qtractorAudioBus  *bus;
+		QVector<qtractorAudioAuxSendPlugin *> sends;
+		QVector<MixItem>   items;
+		QVector<int>       outputs;
+		int                inputs;
+	};
+
+	// Graph build helpers.
+	void compile(qtractorSession *pSession);
+	void addEdge(int iNode, int iNextNode);
+	bool sort();
+
+	// Ready queue.
+	void push(int iNode);
+
+	// Aux-send targets, from a plugin chain.
+	void auxSends(qtractorPluginList *pPluginList,
+		QVector<qtractorAudioAuxSendPlugin *>& sends) const;
+
+private:
+
+	// Instance variables.
+	int  m_iSerial;
+	bool m_bValid;
+
+	QVector<Node> m_nodes;
+	QVector<int>  m_order;
+	QVector<int>  m_sources;
+
+	// Per-cycle dependency counters and ready queue.
+	qtractorAtomic *m_pInputs;
+	qtractorAtomic *m_pReady;
+
+	qtractorAtomic m_head;
+	qtractorAtomic m_tail;
+	qtractorAtomic m_done;
+
+	// Current cycle state.
+	qtractorSessionCursor *m_pSessionCursor;
+
+	unsigned long m_iFrameStart;
+	unsigned long m_iFrameEnd;
+};
+
+
+#endif  // __qtractorAudioGraph_h
+
+
+// end of qtractorAudioGraph.h
@@ -0,0 +1,762 @@
+// qtractorAudioMmapFile.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioMmapFile.h"
+
+#include "qtractorSse.h"
+
+#include <QtEndian>
+
+#ifdef CONFIG_MMAP_FILE
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
+
+
+// Read-ahead window size (in bytes).
+static const unsigned long c_iAdviseBytes = (1 << 20);
+
+
+//----------------------------------------------------------------------
+// Raw sample readers (any host endianness).
+//
+
+struct sample_s16le
+{
+	enum { Size = 2 };
+	static inline float get ( const unsigned char *p )
+		{ return float(short(p[0] | (p[1] << 8))) * (1.0f / 32768.0f); }
+};
+
+struct sample_s16be
+{
+	enum { Size = 2 };
+	static inline float get ( const unsigned char *p )
+		{ return float(short(p[1] | (p[0] << 8))) * (1.0f / 32768.0f); }
+};
+
+struct sample_s24le
+{
+	enum { Size = 3 };
+	static inline float get ( const unsigned char *p )
+		{ return float(int(p[0] | (p[1] << 8) | (int((signed char) p[2]) << 16)))
+			* (1.0f / 8388608.0f); }
+};
+
+struct sample_s24be
+{
+	enum { Size = 3 };
+	static inline float get ( const unsigned char *p )
+		{ return float(int(p[2] | (p[1] << 8) | (int((signed char) p[0]) << 16)))
+			* (1.0f / 8388608.0f); }
+};
+
+struct sample_s32le
+{
+	enum { Size = 4 };
+	static inline float get ( const unsigned char *p )
+		{ return float(int(qFromLittleEndian<quint32>(p))) * (1.0f / 2147483648.0f); }
+};
+
+struct sample_s32be
+{
+	enum { Size = 4 };
+	static inline float get ( const unsigned char *p )
+		{ return float(int(qFromBigEndian<quint32>(p))) * (1.0f / 2147483648.0f); }
+};
+
+struct sample_f32le
+{
+	enum { Size = 4 };
+	static inline float get ( const unsigned char *p )
+	{
+		const quint32 u = qFromLittleEndian<quint32>(p);
+		float f; ::memcpy(&f, &u, sizeof(f));
+		return f;
+	}
+};
+
+struct sample_f32be
+{
+	enum { Size = 4 };
+	static inline float get ( const unsigned char *p )
+	{
+		const quint32 u = qFromBigEndian<quint32>(p);
+		float f; ::memcpy(&f, &u, sizeof(f));
+		return f;
+	}
+};
+
+
+// Generic (scalar) de-interleave/convert.
+template <typename Sample>
+static void std_decode ( float **ppFrames,
+	const unsigned char *pData, unsigned int iFrames, unsigned short iChannels )
+{
+	const unsigned int iStride = iChannels * Sample::Size;
+	for (unsigned short i = 0; i < iChannels; ++i) {
+		float *pFrames = ppFrames[i];
+		const unsigned char *p = pData + i * Sample::Size;
+		for (unsigned int n = 0; n < iFrames; ++n) {
+			pFrames[n] = Sample::get(p);
+			p += iStride;
+		}
+	}
+}
+
+
+// Native float mono is just a copy.
+static void std_decode_f32_mono ( float **ppFrames,
+	const unsigned char *pData, unsigned int iFrames, unsigned short /*iChannels*/ )
+{
+	::memcpy(ppFrames[0], pData, iFrames * sizeof(float));
+}
+
+
+#if defined(__SSE__)
+
+// SSE enabled native float stereo de-interleave.
+static void sse_decode_f32_stereo ( float **ppFrames,
+	const unsigned char *pData, unsigned int iFrames, unsigned short /*iChannels*/ )
+{
+	const float *pSrc = (const float *) pData;
+	float *pL = ppFrames[0];
+	float *pR = ppFrames[1];
+	unsigned int nframes = iFrames;
+	for (; nframes >= 4; nframes -= 4) {
+		const __m128 a = _mm_loadu_ps(pSrc);
+		const __m128 b = _mm_loadu_ps(pSrc + 4);
+		_mm_storeu_ps(pL, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(pR, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		pSrc += 8;
+		pL += 4;
+		pR += 4;
+	}
+	for (; nframes > 0; --nframes) {
+		*pL++ = *pSrc++;
+		*pR++ = *pSrc++;
+	}
+}
+
+#if defined(__SSE2__)
+
+// SSE2 enabled 16bit stereo convert and de-interleave.
+static void sse2_decode_s16_stereo ( float **ppFrames,
+	const unsigned char *pData, unsigned int iFrames, unsigned short /*iChannels*/ )
+{
+	const short *pSrc = (const short *) pData;
+	float *pL = ppFrames[0];
+	float *pR = ppFrames[1];
+	const __m128 vscale = _mm_set1_ps(1.0f / 32768.0f);
+	unsigned int nframes = iFrames;
+	for (; nframes >= 4; nframes -= 4) {
+		const __m128i x = _mm_loadu_si128((const __m128i *) pSrc);
+		const __m128 a = _mm_mul_ps(vscale, _mm_cvtepi32_ps(
+			_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)));
+		const __m128 b = _mm_mul_ps(vscale, _mm_cvtepi32_ps(
+			_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)));
+		_mm_storeu_ps(pL, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(pR, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		pSrc += 8;
+		pL += 4;
+		pR += 4;
+	}
+	for (; nframes > 0; --nframes) {
+		*pL++ = float(*pSrc++) * (1.0f / 32768.0f);
+		*pR++ = float(*pSrc++) * (1.0f / 32768.0f);
+	}
+}
+
+#endif // __SSE2__
+
+#endif // __SSE__
+
+
+#if defined(__ARM_NEON__)
+
+#include "arm_neon.h"
+
+// NEON enabled native float stereo de-interleave.
+static void neon_decode_f32_stereo ( float **ppFrames,
+	const unsigned char *pData, unsigned int iFrames, unsigned short /*iChannels*/ )
+{
+	const float *pSrc = (const float *) pData;
+	float *pL = ppFrames[0];
+	float *pR = ppFrames[1];
+	unsigned int nframes = iFrames;
+	for (; nframes >= 4; nframes -= 4) {
+		const float32x4x2_t v = vld2q_f32(pSrc);
+		vst1q_f32(pL, v.val[0]);
+		vst1q_f32(pR, v.val[1]);
+		pSrc += 8;
+		pL += 4;
+		pR += 4;
+	}
+	for (; nframes > 0; --nframes) {
+		*pL++ = *pSrc++;
+		*pR++ = *pSrc++;
+	}
+}
+
+
+// NEON enabled 16bit stereo convert and de-interleave.
+static void neon_decode_s16_stereo ( float **ppFrames,
+	const unsigned char *pData, unsigned int iFrames, unsigned short /*iChannels*/ )
+{
+	const short *pSrc = (const short *) pData;
+	float *pL = ppFrames[0];
+	float *pR = ppFrames[1];
+	unsigned int nframes = iFrames;
+	for (; nframes >= 4; nframes -= 4) {
+		const int16x4x2_t v = vld2_s16(pSrc);
+		vst1q_f32(pL, vmulq_n_f32(
+			vcvtq_f32_s32(vmovl_s16(v.val[0])), 1.0f / 32768.0f));
+		vst1q_f32(pR, vmulq_n_f32(
+			vcvtq_f32_s32(vmovl_s16(v.val[1])), 1.0f / 32768.0f));
+		pSrc += 8;
+		pL += 4;
+		pR += 4;
+	}
+	for (; nframes > 0; --nframes) {
+		*pL++ = float(*pSrc++) * (1.0f / 32768.0f);
+		*pR++ = float(*pSrc++) * (1.0f / 32768.0f);
+	}
+}
+
+#endif // __ARM_NEON__
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioMmapFile -- Memory-mapped audio file implementation.
+//
+
+// Constructor.
+qtractorAudioMmapFile::qtractorAudioMmapFile ( unsigned short iChannels,
+	unsigned int iSampleRate, unsigned int iBufferSize )
+	: qtractorAudioSndFile(iChannels, iSampleRate, iBufferSize)
+{
+	m_pMap         = NULL;
+	m_iMapSize     = 0;
+	m_iMapFd       = -1;
+
+	m_iDataOffset  = 0;
+	m_iFrames      = 0;
+	m_iChannels    = 0;
+	m_iSampleRate  = 0;
+	m_iFrameSize   = 0;
+	m_encoding     = Unknown;
+	m_bBigEndian   = false;
+
+	m_iOffset      = 0;
+	m_iDirection   = 0;
+
+	m_iAdviseStart = 0;
+	m_iAdviseEnd   = 0;
+
+	m_pfnDecode    = NULL;
+}
+
+// Destructor.
+qtractorAudioMmapFile::~qtractorAudioMmapFile (void)
+{
+	closeMap();
+}
+
+
+// Open method.
+bool qtractorAudioMmapFile::open ( const QString& sFilename, int iMode )
+{
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioMmapFile::open(\"%s\", %d)",
+		sFilename.toUtf8().constData(), iMode);
+#endif
+	close();
+
+	// Only plain read mode is ever mapped...
+	if (iMode == qtractorAudioMmapFile::Read && openMap(sFilename))
+		return true;
+
+	return qtractorAudioSndFile::open(sFilename, iMode);
+}
+
+
+// Read method.
+int qtractorAudioMmapFile::read ( float **ppFrames, unsigned int iFrames )
+{
+	if (m_pMap == NULL)
+		return qtractorAudioSndFile::read(ppFrames, iFrames);
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioMmapFile::read(%p, %d)", ppFrames, iFrames);
+#endif
+
+	if (m_iOffset >= m_iFrames)
+		return 0;
+
+	// Never touch pages past the actual end of file...
+	const unsigned long iMapFrames = mapFrames();
+	if (m_iOffset >= iMapFrames)
+		return 0;
+
+	if (iFrames > iMapFrames - m_iOffset)
+		iFrames = iMapFrames - m_iOffset;
+
+	advise(m_iOffset, iFrames);
+
+	(*m_pfnDecode)(ppFrames,
+		m_pMap + m_iDataOffset + m_iOffset * m_iFrameSize,
+		iFrames, m_iChannels);
+
+	m_iOffset += iFrames;
+
+	return iFrames;
+}
+
+
+// Seek method.
+bool qtractorAudioMmapFile::seek ( unsigned long iOffset )
+{
+	if (m_pMap == NULL)
+		return qtractorAudioSndFile::seek(iOffset);
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioMmapFile::seek(%lu)", iOffset);
+#endif
+
+	if (iOffset > m_iFrames)
+		return false;
+
+	// Jumping back makes for a backward trend,
+	// until reading runs off the advised window...
+	const int iDirection = (iOffset < m_iOffset ? -1 : +1);
+#ifdef CONFIG_MMAP_FILE
+	if (iDirection != m_iDirection) {
+		::posix_madvise(m_pMap, m_iMapSize, iDirection < 0
+			? POSIX_MADV_NORMAL : POSIX_MADV_SEQUENTIAL);
+	}
+#endif
+	m_iDirection = iDirection;
+	m_iOffset = iOffset;
+
+	advise(m_iOffset, 0);
+
+	return true;
+}
+
+
+// Close method.
+void qtractorAudioMmapFile::close (void)
+{
+	closeMap();
+
+	qtractorAudioSndFile::close();
+}
+
+
+// Open mode accessor.
+int qtractorAudioMmapFile::mode (void) const
+{
+	return (m_pMap ? int(qtractorAudioMmapFile::Read)
+		: qtractorAudioSndFile::mode());
+}
+
+
+// Open channel(s) accessor.
+unsigned short qtractorAudioMmapFile::channels (void) const
+{
+	return (m_pMap ? m_iChannels : qtractorAudioSndFile::channels());
+}
+
+
+// Total number of frames specialty.
+unsigned long qtractorAudioMmapFile::frames (void) const
+{
+	return (m_pMap ? m_iFrames : qtractorAudioSndFile::frames());
+}
+
+
+// Sample rate specialty.
+unsigned int qtractorAudioMmapFile::sampleRate (void) const
+{
+	return (m_pMap ? m_iSampleRate : qtractorAudioSndFile::sampleRate());
+}
+
+
+// RIFF/WAVE header parser.
+bool qtractorAudioMmapFile::parseWav (
+	const unsigned char *pHead, unsigned long iSize )
+{
+	if (iSize < 12
+		|| ::memcmp(pHead, "RIFF", 4)
+		|| ::memcmp(pHead + 8, "WAVE", 4))
+		return false;
+
+	bool bFormat = false;
+	unsigned long iPos = 12;
+
+	while (iPos + 8 <= iSize) {
+		const unsigned char *pChunk = pHead + iPos;
+		const unsigned long iChunkSize = qFromLittleEndian<quint32>(pChunk + 4);
+		const unsigned long iBody = iPos + 8;
+		if (::memcmp(pChunk, "fmt ", 4) == 0) {
+			if (iChunkSize < 16 || iBody + iChunkSize > iSize)
+				return false;
+			const unsigned char *p = pHead + iBody;
+			unsigned short iTag = qFromLittleEndian<quint16>(p);
+			m_iChannels   = qFromLittleEndian<quint16>(p + 2);
+			m_iSampleRate = qFromLittleEndian<quint32>(p + 4);
+			m_iFrameSize  = qFromLittleEndian<quint16>(p + 12);
+			const unsigned short iBits = qFromLittleEndian<quint16>(p + 14);
+			// WAVE_FORMAT_EXTENSIBLE: sub-format GUID leads with the tag.
+			if (iTag == 0xfffe && iChunkSize >= 40)
+				iTag = qFromLittleEndian<quint16>(p + 24);
+			if (iTag == 1) {
+				switch (iBits) {
+				case 16: m_encoding = Int16; break;
+				case 24: m_encoding = Int24; break;
+				case 32: m_encoding = Int32; break;
+				default: break;
+				}
+			}
+			else
+			if (iTag == 3 && iBits == 32)
+				m_encoding = Float32;
+			if (m_encoding == Unknown || m_iChannels < 1
+				|| m_iFrameSize != m_iChannels * (iBits >> 3))
+				return false;
+			m_bBigEndian = false;
+			bFormat = true;
+		}
+		else
+		if (::memcmp(pChunk, "data", 4) == 0) {
+			if (!bFormat)
+				return false;
+			// Unfinished recordings may carry a bogus size...
+			unsigned long iDataSize = iChunkSize;
+			if (iDataSize == 0 || iBody + iDataSize > iSize)
+				iDataSize = iSize - iBody;
+			m_iDataOffset = iBody;
+			m_iFrames = iDataSize / m_iFrameSize;
+			return true;
+		}
+		if (iChunkSize > iSize)
+			break;
+		iPos = iBody + iChunkSize + (iChunkSize & 1);
+	}
+
+	return false;
+}
+
+
+// Core Audio Format (CAF) header parser.
+bool qtractorAudioMmapFile::parseCaf (
+	const unsigned char *pHead, unsigned long iSize )
+{
+	if (iSize < 8
+		|| ::memcmp(pHead, "caff", 4)
+		|| qFromBigEndian<quint16>(pHead + 4) != 1)
+		return false;
+
+	bool bFormat = false;
+	unsigned long iPos = 8;
+
+	while (iPos + 12 <= iSize) {
+		const unsigned char *pChunk = pHead + iPos;
+		const qint64 iChunkSize = qFromBigEndian<qint64>(pChunk + 4);
+		const unsigned long iBody = iPos + 12;
+		if (::memcmp(pChunk, "desc", 4) == 0) {
+			if (iChunkSize < 32 || iBody + 32 > iSize)
+				return false;
+			const unsigned char *p = pHead + iBody;
+			const quint64 iRate = qFromBigEndian<quint64>(p);
+			double fRate; ::memcpy(&fRate, &iRate, sizeof(fRate));
+			if (::memcmp(p + 8, "lpcm", 4))
+				return false;
+			const unsigned int iFlags = qFromBigEndian<quint32>(p + 12);
+			const unsigned int iBytesPerPacket  = qFromBigEndian<quint32>(p + 16);
+			const unsigned int iFramesPerPacket = qFromBigEndian<quint32>(p + 20);
+			const unsigned int iChannels = qFromBigEndian<quint32>(p + 24);
+			const unsigned int iBits = qFromBigEndian<quint32>(p + 28);
+			if (iFlags & 1) { // kCAFLinearPCMFormatFlagIsFloat
+				if (iBits == 32)
+					m_encoding = Float32;
+			} else {
+				switch (iBits) {
+				case 16: m_encoding = Int16; break;
+				case 24: m_encoding = Int24; break;
+				case 32: m_encoding = Int32; break;
+				default: break;
+				}
+			}
+			if (m_encoding == Unknown || iFramesPerPacket != 1
+				|| iChannels < 1 || iChannels > 0xffff
+				|| iBytesPerPacket != iChannels * (iBits >> 3))
+				return false;
+			m_iChannels   = iChannels;
+			m_iSampleRate = (unsigned int) (fRate + 0.5);
+			m_iFrameSize  = iBytesPerPacket;
+			// kCAFLinearPCMFormatFlagIsLittleEndian
+			m_bBigEndian  = ((iFlags & 2) == 0);
+			bFormat = true;
+		}
+		else
+		if (::memcmp(pChunk, "data", 4) == 0) {
+			if (!bFormat || iBody + 4 > iSize)
+				return false;
+			// Skip the edit count; size of -1 means up to the end.
+			const unsigned long iData = iBody + 4;
+			unsigned long iDataSize = iSize - iData;
+			if (iChunkSize >= 4 && (unsigned long) (iChunkSize - 4) < iDataSize)
+				iDataSize = iChunkSize - 4;
+			m_iDataOffset = iData;
+			m_iFrames = iDataSize / m_iFrameSize;
+			return true;
+		}
+		if (iChunkSize < 0 || (quint64) iChunkSize > iSize)
+			break;
+		iPos = iBody + iChunkSize;
+	}
+
+	return false;
+}
+
+
+// Map the file read-only, on the parsed layout.
+bool qtractorAudioMmapFile::openMap ( const QString& sFilename )
+{
+#ifdef CONFIG_MMAP_FILE
+
+	const QByteArray aFilename = sFilename.toUtf8();
+	const int fd = ::open(aFilename.constData(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) < 0 || st.st_size < 12
+		|| (quint64) st.st_size != (quint64) (size_t) st.st_size) {
+		::close(fd);
+		return false;
+	}
+
+	// Private mapping, file descriptor kept open for size re-checks...
+	void *pMap = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (pMap == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+
+	m_pMap = (unsigned char *) pMap;
+	m_iMapSize = st.st_size;
+	m_iMapFd = fd;
+	m_encoding = Unknown;
+
+	if (!parseWav(m_pMap, m_iMapSize) && !parseCaf(m_pMap, m_iMapSize)) {
+		closeMap();
+		return false;
+	}
+
+	// Pick the decoder for the encoding at hand...
+	switch (m_encoding) {
+	case Int16:
+		m_pfnDecode = (m_bBigEndian
+			? std_decode<sample_s16be> : std_decode<sample_s16le>);
+		break;
+	case Int24:
+		m_pfnDecode = (m_bBigEndian
+			? std_decode<sample_s24be> : std_decode<sample_s24le>);
+		break;
+	case Int32:
+		m_pfnDecode = (m_bBigEndian
+			? std_decode<sample_s32be> : std_decode<sample_s32le>);
+		break;
+	case Float32:
+		m_pfnDecode = (m_bBigEndian
+			? std_decode<sample_f32be> : std_decode<sample_f32le>);
+		break;
+	default:
+		closeMap();
+		return false;
+	}
+
+	// Native layouts may go faster (element aligned data only)...
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	const bool bNative = (!m_bBigEndian && (m_iDataOffset & 3) == 0);
+	if (bNative && m_encoding == Float32 && m_iChannels == 1)
+		m_pfnDecode = std_decode_f32_mono;
+#if defined(__SSE__)
+	if (bNative && m_iChannels == 2 && sse_enabled()) {
+		if (m_encoding == Float32)
+			m_pfnDecode = sse_decode_f32_stereo;
+	#if defined(__SSE2__)
+		else
+		if (m_encoding == Int16 && sse2_enabled())
+			m_pfnDecode = sse2_decode_s16_stereo;
+	#endif
+	}
+#endif
+#if defined(__ARM_NEON__)
+	if (bNative && m_iChannels == 2) {
+		if (m_encoding == Float32)
+			m_pfnDecode = neon_decode_f32_stereo;
+		else
+		if (m_encoding == Int16)
+			m_pfnDecode = neon_decode_s16_stereo;
+	}
+#endif
+#endif
+
+	// Start off reading forward...
+	::posix_madvise(m_pMap, m_iMapSize, POSIX_MADV_SEQUENTIAL);
+
+	m_iOffset = 0;
+	m_iDirection = +1;
+	m_iAdviseStart = 0;
+	m_iAdviseEnd = 0;
+
+	advise(0, 0);
+
+	return true;
+
+#else
+
+	Q_UNUSED(sFilename);
+
+	return false;
+
+#endif
+}
+
+
+void qtractorAudioMmapFile::closeMap (void)
+{
+#ifdef CONFIG_MMAP_FILE
+	if (m_pMap)
+		::munmap(m_pMap, m_iMapSize);
+	if (m_iMapFd >= 0)
+		::close(m_iMapFd);
+#endif
+
+	m_pMap = NULL;
+	m_iMapSize = 0;
+	m_iMapFd = -1;
+
+	m_iDataOffset = 0;
+	m_iFrames = 0;
+	m_iChannels = 0;
+	m_iSampleRate = 0;
+	m_iFrameSize = 0;
+	m_encoding = Unknown;
+
+	m_iOffset = 0;
+	m_iDirection = 0;
+
+	m_pfnDecode = NULL;
+}
+
+
+// Frames still backed by the file (truncated underneath?),
+// as touching mapped pages past its end would raise SIGBUS.
+unsigned long qtractorAudioMmapFile::mapFrames (void) const
+{
+#ifdef CONFIG_MMAP_FILE
+
+	struct stat st;
+	if (::fstat(m_iMapFd, &st) < 0)
+		return 0;
+
+	unsigned long iMapSize = m_iMapSize;
+	if ((quint64) iMapSize > (quint64) st.st_size)
+		iMapSize = st.st_size;
+	if (iMapSize <= m_iDataOffset)
+		return 0;
+
+	const unsigned long iFrames = (iMapSize - m_iDataOffset) / m_iFrameSize;
+	return (iFrames < m_iFrames ? iFrames : m_iFrames);
+
+#else
+
+	return m_iFrames;
+
+#endif
+}
+
+
+// Page-cache read-ahead hints, following the playback direction.
+void qtractorAudioMmapFile::advise ( unsigned long iOffset, unsigned int iFrames )
+{
+#ifdef CONFIG_MMAP_FILE
+
+	const unsigned long iWindow = c_iAdviseBytes / m_iFrameSize + 1;
+
+	// Reading forward past the advised window ends any backward trend...
+	if (m_iDirection < 0 && iOffset + iFrames > m_iAdviseEnd) {
+		::posix_madvise(m_pMap, m_iMapSize, POSIX_MADV_SEQUENTIAL);
+		m_iDirection = +1;
+	}
+
+	// Already covered? (half a window of hysteresis ahead)
+	unsigned long iStart = iOffset;
+	unsigned long iEnd = iOffset + iFrames + (iWindow >> 1);
+	if (m_iDirection < 0)
+		iStart = (iOffset > (iWindow >> 1) ? iOffset - (iWindow >> 1) : 0);
+	if (iEnd > m_iFrames)
+		iEnd = m_iFrames;
+	if (iStart >= m_iAdviseStart && iEnd <= m_iAdviseEnd)
+		return;
+
+	// Forward: the window ahead; backward: both sides of it.
+	iStart = iOffset;
+	iEnd = iOffset + iFrames + iWindow;
+	if (m_iDirection < 0)
+		iStart = (iOffset > iWindow ? iOffset - iWindow : 0);
+	if (iEnd > m_iFrames)
+		iEnd = m_iFrames;
+	if (iStart >= iEnd)
+		return;
+
+	// Round out to page boundaries...
+	const unsigned long iPageMask = (unsigned long) ::sysconf(_SC_PAGESIZE) - 1;
+	const unsigned long iBegin
+		= (m_iDataOffset + iStart * m_iFrameSize) & ~iPageMask;
+	const unsigned long iFinal
+		= m_iDataOffset + iEnd * m_iFrameSize;
+
+	::posix_madvise(m_pMap + iBegin, iFinal - iBegin, POSIX_MADV_WILLNEED);
+
+	m_iAdviseStart = iStart;
+	m_iAdviseEnd = iEnd;
+
+#else
+
+	Q_UNUSED(iOffset);
+	Q_UNUSED(iFrames);
+
+#endif
+}
+
+
+// end of qtractorAudioMmapFile.cpp
@@ -0,0 +1,119 @@
+// qtractorAudioMmapFile.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioMmapFile_h
+#define __qtractorAudioMmapFile_h
+
+#include "qtractorAudioSndFile.h"
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioMmapFile -- Memory-mapped audio file declaration.
+//
+// Plain PCM/float WAV and CAF files are decoded straight off the mapped
+// pages on read; anything else (including write mode) falls back to the
+// libsndfile implementation this class derives from.
+//
+
+class qtractorAudioMmapFile : public qtractorAudioSndFile
+{
+public:
+
+	// Constructor.
+	qtractorAudioMmapFile(unsigned short iChannels = 0,
+		unsigned int iSampleRate = 0, unsigned int iBufferSize = 0);
+
+	// Destructor.
+	virtual ~qtractorAudioMmapFile();
+
+	// Virtual method mockups.
+	bool open  (const QString& sFilename, int iMode = Read);
+	int  read  (float **ppFrames, unsigned int iFrames);
+	bool seek  (unsigned long iOffset);
+	void close ();
+
+	// Virtual accessor mockups.
+	int mode() const;
+	unsigned short channels() const;
+	unsigned long  frames() const;
+
+	// Specialty methods.
+	unsigned int   sampleRate() const;
+
+	// Whether the current file is being read off the mapped pages.
+	bool isMapped() const { return (m_pMap != NULL); }
+
+	// Sample encodings eligible for the mapped read path.
+	enum Encoding { Unknown = 0, Int16, Int24, Int32, Float32 };
+
+	// De-interleave/convert function prototype.
+	typedef void (*DecodeFunc)(float **ppFrames,
+		const unsigned char *pData, unsigned int iFrames, unsigned short iChannels);
+
+protected:
+
+	// Header parsers (fill in the data chunk and format stuff).
+	bool parseWav(const unsigned char *pHead, unsigned long iSize);
+	bool parseCaf(const unsigned char *pHead, unsigned long iSize);
+
+	// Map the file read-only, on the parsed layout.
+	bool openMap(const QString& sFilename);
+	void closeMap();
+
+	// Frames still backed by the file (SIGBUS safe-guard).
+	unsigned long mapFrames() const;
+
+	// Page-cache read-ahead hints, following the playback direction.
+	void advise(unsigned long iOffset, unsigned int iFrames);
+
+private:
+
+	// Mapped file region.
+	unsigned char *m_pMap;
+	unsigned long  m_iMapSize;
+	int            m_iMapFd;
+
+	// Data chunk layout.
+	unsigned long  m_iDataOffset;
+	unsigned long  m_iFrames;
+	unsigned short m_iChannels;
+	unsigned int   m_iSampleRate;
+	unsigned int   m_iFrameSize;
+	Encoding       m_encoding;
+	bool           m_bBigEndian;
+
+	// Current read position and direction.
+	unsigned long  m_iOffset;
+	int            m_iDirection;
+
+	// Last advised read-ahead window (in frames).
+	unsigned long  m_iAdviseStart;
+	unsigned long  m_iAdviseEnd;
+
+	// Decoder for the current encoding.
+	DecodeFunc     m_pfnDecode;
+};
+
+
+#endif  // __qtractorAudioMmapFile_h
+
+
+// end of qtractorAudioMmapFile.h
@@ -0,0 +1,274 @@
+// qtractorAudioRamp.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioRamp_h
+#define __qtractorAudioRamp_h
+
+// Gain-ramped mix-down and clip ramp in/out kernels,
+// as picked at run-time by each audio buffer (cf. the
+// qtractor_ramp_bench program, for "make bench").
+
+#include "qtractorSse.h"
+
+
+#if defined(__SSE__)
+
+// SSE enabled gain-ramped mix-down version.
+static inline void sse_mix_ramp ( float *pFrames, const float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (; (long(pFrames) & 15) && (iFrames > 0); --iFrames) {
+		*pFrames++ += fGainIter * *pBuffer++;
+		fGainIter += fGainStep;
+	}
+
+	__m128 vGainIter = _mm_setr_ps(
+		fGainIter,
+		fGainIter + fGainStep,
+		fGainIter + 2.0f * fGainStep,
+		fGainIter + 3.0f * fGainStep);
+	const __m128 vGainStep = _mm_set1_ps(4.0f * fGainStep);
+
+	for (; iFrames >= 4; iFrames -= 4) {
+		_mm_store_ps(pFrames,
+			_mm_add_ps(
+				_mm_load_ps(pFrames),
+				_mm_mul_ps(vGainIter, _mm_loadu_ps(pBuffer))));
+		vGainIter = _mm_add_ps(vGainIter, vGainStep);
+		pFrames += 4;
+		pBuffer += 4;
+	}
+
+	fGainIter = _mm_cvtss_f32(vGainIter);
+	for (; iFrames > 0; --iFrames) {
+		*pFrames++ += fGainIter * *pBuffer++;
+		fGainIter += fGainStep;
+	}
+}
+
+
+// SSE enabled clip ramp in/out version.
+static inline void sse_gain_ramp ( float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (; (long(pBuffer) & 15) && (iFrames > 0); --iFrames) {
+		*pBuffer++ *= fGainIter;
+		fGainIter += fGainStep;
+	}
+
+	__m128 vGainIter = _mm_setr_ps(
+		fGainIter,
+		fGainIter + fGainStep,
+		fGainIter + 2.0f * fGainStep,
+		fGainIter + 3.0f * fGainStep);
+	const __m128 vGainStep = _mm_set1_ps(4.0f * fGainStep);
+
+	for (; iFrames >= 4; iFrames -= 4) {
+		_mm_store_ps(pBuffer, _mm_mul_ps(_mm_load_ps(pBuffer), vGainIter));
+		vGainIter = _mm_add_ps(vGainIter, vGainStep);
+		pBuffer += 4;
+	}
+
+	fGainIter = _mm_cvtss_f32(vGainIter);
+	for (; iFrames > 0; --iFrames) {
+		*pBuffer++ *= fGainIter;
+		fGainIter += fGainStep;
+	}
+}
+
+#endif // __SSE__
+
+
+// AVX2/FMA versions are built regardless of the baseline target flags,
+// thus only picked at run-time, when the host CPU says so.
+#if defined(__x86_64__) && (defined(__clang__) \
+	|| (defined(__GNUC__) && (__GNUC__ >= 5)))
+
+#define CONFIG_AVX2_MIX
+
+#include <immintrin.h>
+
+// AVX2/FMA detection.
+static inline bool avx2_enabled (void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+
+// AVX2/FMA enabled gain-ramped mix-down version.
+__attribute__ ((target ("avx2,fma")))
+static void avx2_mix_ramp ( float *pFrames, const float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (; (long(pFrames) & 31) && (iFrames > 0); --iFrames) {
+		*pFrames++ += fGainIter * *pBuffer++;
+		fGainIter += fGainStep;
+	}
+
+	__m256 vGainIter = _mm256_add_ps(_mm256_set1_ps(fGainIter),
+		_mm256_mul_ps(_mm256_set1_ps(fGainStep),
+			_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f)));
+	const __m256 vGainStep = _mm256_set1_ps(8.0f * fGainStep);
+
+	for (; iFrames >= 8; iFrames -= 8) {
+		_mm256_store_ps(pFrames,
+			_mm256_fmadd_ps(vGainIter,
+				_mm256_loadu_ps(pBuffer),
+				_mm256_load_ps(pFrames)));
+		vGainIter = _mm256_add_ps(vGainIter, vGainStep);
+		pFrames += 8;
+		pBuffer += 8;
+	}
+
+	fGainIter = _mm256_cvtss_f32(vGainIter);
+	for (; iFrames > 0; --iFrames) {
+		*pFrames++ += fGainIter * *pBuffer++;
+		fGainIter += fGainStep;
+	}
+}
+
+
+// AVX2 enabled clip ramp in/out version.
+__attribute__ ((target ("avx2,fma")))
+static void avx2_gain_ramp ( float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (; (long(pBuffer) & 31) && (iFrames > 0); --iFrames) {
+		*pBuffer++ *= fGainIter;
+		fGainIter += fGainStep;
+	}
+
+	__m256 vGainIter = _mm256_add_ps(_mm256_set1_ps(fGainIter),
+		_mm256_mul_ps(_mm256_set1_ps(fGainStep),
+			_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f)));
+	const __m256 vGainStep = _mm256_set1_ps(8.0f * fGainStep);
+
+	for (; iFrames >= 8; iFrames -= 8) {
+		_mm256_store_ps(pBuffer,
+			_mm256_mul_ps(_mm256_load_ps(pBuffer), vGainIter));
+		vGainIter = _mm256_add_ps(vGainIter, vGainStep);
+		pBuffer += 8;
+	}
+
+	fGainIter = _mm256_cvtss_f32(vGainIter);
+	for (; iFrames > 0; --iFrames) {
+		*pBuffer++ *= fGainIter;
+		fGainIter += fGainStep;
+	}
+}
+
+#endif // CONFIG_AVX2_MIX
+
+
+#if defined(__ARM_NEON__)
+
+#include "arm_neon.h"
+
+// NEON enabled gain-ramped mix-down version.
+static inline void neon_mix_ramp ( float *pFrames, const float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (; (long(pFrames) & 15) && (iFrames > 0); --iFrames) {
+		*pFrames++ += fGainIter * *pBuffer++;
+		fGainIter += fGainStep;
+	}
+
+	float __attribute__ ((aligned (16))) fInitGainIter[4] = {
+		fGainIter,
+		fGainIter + fGainStep,
+		fGainIter + 2.0f * fGainStep,
+		fGainIter + 3.0f * fGainStep };
+
+	float32x4_t vGainIter = vld1q_f32(fInitGainIter);
+	const float32x4_t vGainStep = vdupq_n_f32(4.0f * fGainStep);
+
+	for (; iFrames >= 4; iFrames -= 4) {
+		vst1q_f32(pFrames,
+			vmlaq_f32(vld1q_f32(pFrames), vGainIter, vld1q_f32(pBuffer)));
+		vGainIter = vaddq_f32(vGainIter, vGainStep);
+		pFrames += 4;
+		pBuffer += 4;
+	}
+
+	fGainIter = vgetq_lane_f32(vGainIter, 0);
+	for (; iFrames > 0; --iFrames) {
+		*pFrames++ += fGainIter * *pBuffer++;
+		fGainIter += fGainStep;
+	}
+}
+
+
+// NEON enabled clip ramp in/out version.
+static inline void neon_gain_ramp ( float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (; (long(pBuffer) & 15) && (iFrames > 0); --iFrames) {
+		*pBuffer++ *= fGainIter;
+		fGainIter += fGainStep;
+	}
+
+	float __attribute__ ((aligned (16))) fInitGainIter[4] = {
+		fGainIter,
+		fGainIter + fGainStep,
+		fGainIter + 2.0f * fGainStep,
+		fGainIter + 3.0f * fGainStep };
+
+	float32x4_t vGainIter = vld1q_f32(fInitGainIter);
+	const float32x4_t vGainStep = vdupq_n_f32(4.0f * fGainStep);
+
+	for (; iFrames >= 4; iFrames -= 4) {
+		vst1q_f32(pBuffer, vmulq_f32(vld1q_f32(pBuffer), vGainIter));
+		vGainIter = vaddq_f32(vGainIter, vGainStep);
+		pBuffer += 4;
+	}
+
+	fGainIter = vgetq_lane_f32(vGainIter, 0);
+	for (; iFrames > 0; --iFrames) {
+		*pBuffer++ *= fGainIter;
+		fGainIter += fGainStep;
+	}
+}
+
+#endif // __ARM_NEON__
+
+
+// Standard gain-ramped mix-down version.
+static inline void std_mix_ramp ( float *pFrames, const float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (unsigned int n = 0; n < iFrames; ++n, fGainIter += fGainStep)
+		pFrames[n] += fGainIter * pBuffer[n];
+}
+
+
+// Standard clip ramp in/out version.
+static inline void std_gain_ramp ( float *pBuffer,
+	unsigned int iFrames, float fGainIter, float fGainStep )
+{
+	for (unsigned int n = 0; n < iFrames; ++n, fGainIter += fGainStep)
+		pBuffer[n] *= fGainIter;
+}
+
+
+#endif  // __qtractorAudioRamp_h
+
+// end of qtractorAudioRamp.h
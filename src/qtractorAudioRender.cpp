@@ -0,0 +1,687 @@
+// qtractorAudioRender.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioRender.h"
+
+#include "qtractorSession.h"
+#include "qtractorSessionCursor.h"
+#include "qtractorAudioEngine.h"
+#include "qtractorAudioGraph.h"
+
+#include "qtractorPlugin.h"
+#include "qtractorCurve.h"
+
+#include <jack/thread.h>
+
+#include <pthread.h>
+
+
+// Work queue slot packing (head and tail item indexes).
+#define QTRACTOR_RENDER_SLOT(head, tail)	(int(((tail) << 16) | (head)))
+#define QTRACTOR_RENDER_HEAD(slot)			(int((slot) & 0xffff))
+#define QTRACTOR_RENDER_TAIL(slot)			(int(((slot) >> 16) & 0x7fff))
+
+// Maximum number of render items per cycle (must fit the packing).
+#define QTRACTOR_RENDER_MAX		0x7fff
+
+// Maximum busy-wait iterations, before yielding (RT thread).
+#define QTRACTOR_RENDER_SPIN	256
+
+// Maximum yield iterations, before revoking and parking (RT thread).
+#define QTRACTOR_RENDER_YIELD	64
+
+// Maximum parking time, before checking again (msecs).
+#define QTRACTOR_RENDER_PARK	1
+
+
+// Atomic (acquire) load helpers.
+static inline int qtractorAudioRender_load ( const qtractorAtomic *pVal )
+{
+#if QT_VERSION >= 0x050000
+	return pVal->loadAcquire();
+#else
+	return ATOMIC_GET(pVal);
+#endif
+}
+
+static inline qtractorAudioGraph *qtractorAudioRender_load (
+	const QAtomicPointer<qtractorAudioGraph>& graph )
+{
+#if QT_VERSION >= 0x050000
+	return graph.loadAcquire();
+#else
+	return graph;
+#endif
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioRenderThread -- Parallel track render worker.
+//
+
+// Constructor.
+qtractorAudioRenderThread::qtractorAudioRenderThread (
+	qtractorAudioRenderPool *pRenderPool, unsigned int iSlot,
+	int iRtPriority ) : QThread()
+{
+	m_pRenderPool = pRenderPool;
+	m_iSlot = iSlot;
+
+	m_iRtPriority = iRtPriority;
+
+	ATOMIC_SET(&m_syncPending, 0);
+
+	m_bRunState = false;
+}
+
+
+// Destructor.
+qtractorAudioRenderThread::~qtractorAudioRenderThread (void)
+{
+	if (isRunning()) do {
+		setRunState(false);
+	//	terminate();
+		sync();
+	} while (!wait(100));
+}
+
+
+// Run state accessor.
+void qtractorAudioRenderThread::setRunState ( bool bRunState )
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_bRunState = bRunState;
+}
+
+bool qtractorAudioRenderThread::runState (void) const
+{
+	return m_bRunState;
+}
+
+
+// Wake from executive wait condition (RT-safe).
+void qtractorAudioRenderThread::sync (void)
+{
+	ATOMIC_SET(&m_syncPending, 1);
+
+	if (m_mutex.tryLock()) {
+		m_cond.wakeAll();
+		m_mutex.unlock();
+	}
+#ifdef CONFIG_DEBUG_0
+	else qDebug("qtractorAudioRenderThread[%p]::sync(): tryLock() failed.", this);
+#endif
+}
+
+
+// Thread run executive.
+void qtractorAudioRenderThread::run (void)
+{
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioRenderThread[%p]::run(%u): started.", this, m_iSlot);
+#endif
+
+	// Run real-time, at the very same priority of the JACK process
+	// thread, so that it may yield to us while waiting (under SCHED_FIFO
+	// sched_yield() won't ever hand the CPU to a lower priority)...
+	if (m_iRtPriority > 0)
+		::jack_acquire_real_time_scheduling(pthread_self(), m_iRtPriority);
+
+	m_mutex.lock();
+
+	m_bRunState = true;
+
+	while (m_bRunState) {
+		// Wait for sync, unless it's already pending...
+		if (!ATOMIC_TAZ(&m_syncPending))
+			m_cond.wait(&m_mutex);
+		ATOMIC_SET(&m_syncPending, 0);
+		if (!m_bRunState)
+			break;
+		// Render whatever we can get hold of...
+		m_mutex.unlock();
+		m_pRenderPool->render(m_iSlot);
+		m_mutex.lock();
+	}
+
+	m_mutex.unlock();
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioRenderThread[%p]::run(%u): stopped.", this, m_iSlot);
+#endif
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioRenderPool -- Parallel track render scheduler.
+//
+
+// Constructor.
+qtractorAudioRenderPool::qtractorAudioRenderPool (
+	qtractorSession *pSession, unsigned int iThreads, unsigned int iRenderSize )
+{
+	m_pSession = pSession;
+
+	// Slot zero is always reserved to the caller (RT) thread.
+	m_iThreads = iThreads;
+	m_iSlots   = iThreads + 1;
+
+	m_pSlots = new qtractorAtomic [m_iSlots];
+	m_piSlotItems = new unsigned int [m_iSlots];
+	for (unsigned int iSlot = 0; iSlot < m_iSlots; ++iSlot) {
+		ATOMIC_SET(&m_pSlots[iSlot], 0);
+		m_piSlotItems[iSlot] = 0;
+	}
+
+	m_iRenderSize = 0;
+	m_ppTracks = NULL;
+	m_ppClips  = NULL;
+	m_pbRender = NULL;
+	m_piWork   = NULL;
+
+	m_iFrameStart = 0;
+	m_iFrameEnd   = 0;
+
+	m_graph = NULL;
+
+	ATOMIC_SET(&m_cycle,  0);
+	ATOMIC_SET(&m_done,   0);
+	ATOMIC_SET(&m_steals, 0);
+	ATOMIC_SET(&m_active, 0);
+
+	ATOMIC_SET(&m_revoke, 0);
+	ATOMIC_SET(&m_parked, 0);
+
+	resetStats();
+
+	checkRenderSize(iRenderSize);
+
+	// Workers get real-time scheduling, if JACK is so...
+	int iRtPriority = 0;
+	qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+	jack_client_t *pJackClient
+		= (pAudioEngine ? pAudioEngine->jackClient() : NULL);
+	if (pJackClient && ::jack_is_realtime(pJackClient))
+		iRtPriority = ::jack_client_real_time_priority(pJackClient);
+
+	// Start all workers...
+	m_ppThreads = new qtractorAudioRenderThread * [m_iThreads];
+	for (unsigned int i = 0; i < m_iThreads; ++i) {
+		m_ppThreads[i] = new qtractorAudioRenderThread(this, i + 1, iRtPriority);
+		m_ppThreads[i]->start(QThread::TimeCriticalPriority);
+	}
+}
+
+
+// Destructor.
+qtractorAudioRenderPool::~qtractorAudioRenderPool (void)
+{
+	for (unsigned int i = 0; i < m_iThreads; ++i)
+		delete m_ppThreads[i];
+
+	delete [] m_ppThreads;
+
+	if (m_piWork)
+		delete [] m_piWork;
+	if (m_pbRender)
+		delete [] m_pbRender;
+	if (m_ppClips)
+		delete [] m_ppClips;
+	if (m_ppTracks)
+		delete [] m_ppTracks;
+
+	delete [] m_piSlotItems;
+	delete [] m_pSlots;
+}
+
+
+// Number of worker threads (not counting the caller's).
+unsigned int qtractorAudioRenderPool::threads (void) const
+{
+	return m_iThreads;
+}
+
+
+// Whether render item tables are large enough.
+bool qtractorAudioRenderPool::isRenderSize ( unsigned int iRenderSize ) const
+{
+	if (iRenderSize > QTRACTOR_RENDER_MAX)
+		iRenderSize = QTRACTOR_RENDER_MAX;
+
+	return (iRenderSize <= m_iRenderSize && m_ppTracks);
+}
+
+
+// Conditional resize check (non RT-safe): the session must be locked,
+// so that the RT thread is out of business while tables get swapped.
+void qtractorAudioRenderPool::checkRenderSize ( unsigned int iRenderSize )
+{
+	if (isRenderSize(iRenderSize))
+		return;
+
+	if (iRenderSize > QTRACTOR_RENDER_MAX)
+		iRenderSize = QTRACTOR_RENDER_MAX;
+
+	unsigned int iNewRenderSize = (m_iRenderSize > 0 ? m_iRenderSize : 32);
+	while (iNewRenderSize < iRenderSize)
+		iNewRenderSize <<= 1;
+	if (iNewRenderSize > QTRACTOR_RENDER_MAX)
+		iNewRenderSize = QTRACTOR_RENDER_MAX;
+
+	qtractorTrack **ppOldTracks = m_ppTracks;
+	qtractorClip  **ppOldClips  = m_ppClips;
+	bool           *pbOldRender = m_pbRender;
+	unsigned int   *piOldWork   = m_piWork;
+
+	qtractorTrack **ppNewTracks = new qtractorTrack * [iNewRenderSize];
+	qtractorClip  **ppNewClips  = new qtractorClip  * [iNewRenderSize];
+	bool           *pbNewRender = new bool [iNewRenderSize];
+	unsigned int   *piNewWork   = new unsigned int [iNewRenderSize];
+
+	for (unsigned int i = 0; i < iNewRenderSize; ++i) {
+		ppNewTracks[i] = NULL;
+		ppNewClips[i]  = NULL;
+		pbNewRender[i] = false;
+		piNewWork[i]   = 0;
+	}
+
+	// Carry on whatever was there (never in the middle of a cycle)...
+	for (unsigned int i = 0; i < m_iRenderSize; ++i) {
+		ppNewTracks[i] = ppOldTracks[i];
+		ppNewClips[i]  = ppOldClips[i];
+		pbNewRender[i] = pbOldRender[i];
+		piNewWork[i]   = piOldWork[i];
+	}
+
+	m_ppTracks = ppNewTracks;
+	m_ppClips  = ppNewClips;
+	m_pbRender = pbNewRender;
+	m_piWork   = piNewWork;
+
+	m_iRenderSize = iNewRenderSize;
+
+	if (piOldWork)
+		delete [] piOldWork;
+	if (pbOldRender)
+		delete [] pbOldRender;
+	if (ppOldClips)
+		delete [] ppOldClips;
+	if (ppOldTracks)
+		delete [] ppOldTracks;
+}
+
+
+// Whether a track may be rendered out of (serial) order.
+bool qtractorAudioRenderPool::isRenderTrack ( qtractorTrack *pTrack ) const
+{
+	if (pTrack->trackType() != qtractorTrack::Audio)
+		return false;
+
+	if (!pTrack->isRenderBuffer())
+		return false;
+
+	// Aux-sends mix straight into some other bus output,
+	// which must be done in strict (serial) track order...
+	qtractorPluginList *pPluginList = pTrack->pluginList();
+	if (pPluginList == NULL)
+		return true;
+
+	for (qtractorPlugin *pPlugin = pPluginList->first();
+			pPlugin; pPlugin = pPlugin->next()) {
+		if ((pPlugin->type())->typeHint() == qtractorPluginType::AuxSend)
+			return false;
+	}
+
+	return true;
+}
+
+
+// Parallel track process cycle executive (RT-safe).
+void qtractorAudioRenderPool::process (
+	qtractorSessionCursor *pSessionCursor,
+	unsigned long iFrameStart, unsigned long iFrameEnd )
+{
+	// Track automation processing...
+	process_curve(iFrameStart);
+
+	// Render items setup...
+	unsigned int iWork  = 0;
+	unsigned int iTrack = 0;
+	qtractorTrack *pTrack = m_pSession->tracks().first();
+	while (pTrack) {
+		if (iTrack < m_iRenderSize) {
+			const bool bRender = isRenderTrack(pTrack);
+			m_ppTracks[iTrack] = pTrack;
+			m_ppClips[iTrack]  = pSessionCursor->clip(iTrack);
+			m_pbRender[iTrack] = bRender;
+			if (bRender)
+				m_piWork[iWork++] = iTrack;
+		}
+		pTrack = pTrack->next();
+		++iTrack;
+	}
+
+	// Render all independent items in parallel...
+	if (iWork > 0) {
+		m_iFrameStart = iFrameStart;
+		m_iFrameEnd   = iFrameEnd;
+		ATOMIC_SET(&m_done, 0);
+		ATOMIC_SET(&m_steals, 0);
+		unsigned int iSlot;
+		for (iSlot = 0; iSlot < m_iSlots; ++iSlot)
+			m_piSlotItems[iSlot] = 0;
+		ATOMIC_SET(&m_revoke, 0);
+		m_park.tryAcquire(m_park.available());
+		// Make sure all the above is visible before opening queues...
+		ATOMIC_INC(&m_cycle);
+		// Spread work items evenly across all slot queues...
+		for (iSlot = 0; iSlot < m_iSlots; ++iSlot) {
+			const unsigned int iHead = (iWork * iSlot) / m_iSlots;
+			const unsigned int iTail = (iWork * (iSlot + 1)) / m_iSlots;
+			ATOMIC_SET(&m_pSlots[iSlot], QTRACTOR_RENDER_SLOT(iHead, iTail));
+		}
+		// Wake up the workers, if worth it...
+		if (iWork > 1)
+			wakeup();
+		// Do our own share, then steal from the others,
+		// so that nothing's left unclaimed but what's in-flight...
+		render(0);
+		// Wait for whatever is still in-flight (bounded)...
+		unsigned int iSpin = 0;
+		while (qtractorAudioRender_load(&m_done) < int(iWork))
+			wait(iSpin);
+		// And for any worker still around, before
+		// the queues get reset on the next cycle...
+		iSpin = 0;
+		while (qtractorAudioRender_load(&m_active) > 0)
+			wait(iSpin);
+		// Update load-balance statistics...
+		unsigned int iMaxItems = 0;
+		for (iSlot = 0; iSlot < m_iSlots; ++iSlot) {
+			if (iMaxItems < m_piSlotItems[iSlot])
+				iMaxItems = m_piSlotItems[iSlot];
+		}
+		m_iRenderItems   = iWork;
+		m_iRenderSteals  = ATOMIC_GET(&m_steals);
+		m_fRenderBalance = (iMaxItems > 0
+			? float(iWork) / float(iMaxItems * m_iSlots) : 1.0f);
+		m_iRenderStealsTotal += m_iRenderSteals;
+		m_fRenderBalanceSum  += m_fRenderBalance;
+		++m_iRenderCycles;
+	}
+
+	// Deterministic (serial) track order commit,
+	// also processing all the left-over tracks...
+	const unsigned int nframes = iFrameEnd - iFrameStart;
+	iTrack = 0;
+	pTrack = m_pSession->tracks().first();
+	while (pTrack) {
+		if (pTrack->trackType() == qtractorTrack::Audio) {
+			if (iTrack < m_iRenderSize && m_pbRender[iTrack])
+				pTrack->process_commit(nframes);
+			else
+				pTrack->process(pSessionCursor->clip(iTrack),
+					iFrameStart, iFrameEnd);
+		}
+		pTrack = pTrack->next();
+		++iTrack;
+	}
+}
+
+
+// Parallel routing graph process cycle executive (RT-safe).
+void qtractorAudioRenderPool::process ( qtractorAudioGraph *pGraph,
+	qtractorSessionCursor *pSessionCursor,
+	unsigned long iFrameStart, unsigned long iFrameEnd )
+{
+	// Track automation processing...
+	process_curve(iFrameStart);
+
+	// Queue all source nodes...
+	pGraph->reset(pSessionCursor, iFrameStart, iFrameEnd);
+
+	ATOMIC_SET(&m_steals, 0);
+	unsigned int iSlot;
+	for (iSlot = 0; iSlot < m_iSlots; ++iSlot)
+		m_piSlotItems[iSlot] = 0;
+	ATOMIC_SET(&m_revoke, 0);
+	m_park.tryAcquire(m_park.available());
+
+	// Make sure all the above is visible before going...
+	m_graph.fetchAndStoreOrdered(pGraph);
+	ATOMIC_INC(&m_cycle);
+
+	// Wake up the workers, if worth it...
+	const unsigned int iNodes = pGraph->nodes();
+	if (iNodes > 1)
+		wakeup();
+
+	// Do our own share, until all is done: whatever node gets ready
+	// is claimed right away, so that when out of waiting budget (ie.
+	// workers revoked) the caller renders all the rest by itself...
+	unsigned int iSpin = 0;
+	while (!pGraph->isDone()) {
+		const int iNode = pGraph->claim();
+		if (iNode >= 0) {
+			if (pGraph->process(iNode) > 1)
+				wakeup();
+			++m_piSlotItems[0];
+			iSpin = 0;
+		}
+		else wait(iSpin);
+	}
+
+	// Retire the graph (full barrier) and
+	// wait for any worker still around...
+	m_graph.fetchAndStoreOrdered(NULL);
+	iSpin = 0;
+	while (qtractorAudioRender_load(&m_active) > 0)
+		wait(iSpin);
+
+	// Update load-balance statistics...
+	unsigned int iMaxItems = 0;
+	for (iSlot = 0; iSlot < m_iSlots; ++iSlot) {
+		if (iMaxItems < m_piSlotItems[iSlot])
+			iMaxItems = m_piSlotItems[iSlot];
+	}
+	m_iRenderItems   = iNodes;
+	m_iRenderSteals  = ATOMIC_GET(&m_steals);
+	m_fRenderBalance = (iMaxItems > 0
+		? float(iNodes) / float(iMaxItems * m_iSlots) : 1.0f);
+	m_iRenderStealsTotal += m_iRenderSteals;
+	m_fRenderBalanceSum  += m_fRenderBalance;
+	++m_iRenderCycles;
+}
+
+
+// Track automation processing (serial).
+void qtractorAudioRenderPool::process_curve ( unsigned long iFrameStart )
+{
+	for (qtractorTrack *pTrack = m_pSession->tracks().first();
+			pTrack; pTrack = pTrack->next()) {
+		qtractorCurveList *pCurveList = pTrack->curveList();
+		if (pCurveList && pCurveList->isProcess())
+			pCurveList->process(iFrameStart);
+	}
+}
+
+
+// Wake up all workers (RT-safe).
+void qtractorAudioRenderPool::wakeup (void)
+{
+	for (unsigned int i = 0; i < m_iThreads; ++i)
+		m_ppThreads[i]->sync();
+}
+
+
+// Bounded spin-wait, yield, then revoke and park (RT-safe): workers run
+// at the caller's own real-time priority, so that yielding may actually
+// hand them the CPU; still, a worker may be preempted by something else
+// or be sharing a core with the caller, while holding a claimed item.
+// When out of budget, workers are revoked from claiming any further
+// items, left for the caller to take back, and the caller parks for
+// a while, instead of spinning, until some in-flight item is done.
+void qtractorAudioRenderPool::wait ( unsigned int& iSpin )
+{
+	++iSpin;
+
+	if (iSpin <= QTRACTOR_RENDER_SPIN)
+		return;
+
+	if (iSpin <= QTRACTOR_RENDER_SPIN + QTRACTOR_RENDER_YIELD) {
+		QThread::yieldCurrentThread();
+		return;
+	}
+
+	ATOMIC_SET(&m_revoke, 1);
+
+	ATOMIC_SET(&m_parked, 1);
+	m_park.tryAcquire(1, QTRACTOR_RENDER_PARK);
+	ATOMIC_SET(&m_parked, 0);
+}
+
+
+// Wake up the caller, if parked (RT-safe).
+void qtractorAudioRenderPool::unpark (void)
+{
+	if (ATOMIC_GET(&m_parked))
+		m_park.release();
+}
+
+
+// Claim next render item, from own or someone else's queue.
+int qtractorAudioRenderPool::claim ( unsigned int iSlot )
+{
+	for (unsigned int i = 0; i < m_iSlots; ++i) {
+		qtractorAtomic *pSlot = &m_pSlots[(iSlot + i) % m_iSlots];
+		for (;;) {
+			const int iValue = ATOMIC_GET(pSlot);
+			const int iHead  = QTRACTOR_RENDER_HEAD(iValue);
+			if (iHead >= QTRACTOR_RENDER_TAIL(iValue))
+				break;
+			if (ATOMIC_CAS(pSlot, iValue, iValue + 1)) {
+				if (i > 0)
+					ATOMIC_INC(&m_steals);
+				return iHead;
+			}
+		}
+	}
+
+	return -1;
+}
+
+
+// Worker render executive (own queue first, then steal).
+void qtractorAudioRenderPool::render ( unsigned int iSlot )
+{
+	// Must be accounted for before anything else (full barrier)...
+	ATOMIC_INC(&m_active);
+
+	qtractorAudioGraph *pGraph = qtractorAudioRender_load(m_graph);
+	if (pGraph) {
+		// Whatever graph node is ready, unless revoked...
+		int iNode = (isRevoked(iSlot) ? -1 : pGraph->claim());
+		while (iNode >= 0) {
+			if (pGraph->process(iNode) > 1)
+				wakeup();
+			++m_piSlotItems[iSlot];
+			unpark();
+			iNode = (isRevoked(iSlot) ? -1 : pGraph->claim());
+		}
+	} else {
+		// Whatever track render item is left; workers stop claiming
+		// as soon as revoked, the caller (slot zero) never is though...
+		int iItem = (isRevoked(iSlot) ? -1 : claim(iSlot));
+		while (iItem >= 0) {
+			const unsigned int iTrack = m_piWork[iItem];
+			m_ppTracks[iTrack]->process(m_ppClips[iTrack],
+				m_iFrameStart, m_iFrameEnd, true);
+			++m_piSlotItems[iSlot];
+			ATOMIC_INC(&m_done);
+			unpark();
+			iItem = (isRevoked(iSlot) ? -1 : claim(iSlot));
+		}
+	}
+
+	ATOMIC_DEC(&m_active);
+
+	if (iSlot > 0)
+		unpark();
+}
+
+
+// Whether a worker may no longer claim items (RT-safe).
+bool qtractorAudioRenderPool::isRevoked ( unsigned int iSlot ) const
+{
+	return (iSlot > 0 && qtractorAudioRender_load(&m_revoke) > 0);
+}
+
+
+// Last cycle load-balance statistics.
+unsigned int qtractorAudioRenderPool::renderItems (void) const
+{
+	return m_iRenderItems;
+}
+
+unsigned int qtractorAudioRenderPool::renderSteals (void) const
+{
+	return m_iRenderSteals;
+}
+
+float qtractorAudioRenderPool::renderBalance (void) const
+{
+	return m_fRenderBalance;
+}
+
+
+// Accumulated load-balance statistics.
+unsigned long qtractorAudioRenderPool::renderCycles (void) const
+{
+	return m_iRenderCycles;
+}
+
+unsigned long qtractorAudioRenderPool::renderStealsTotal (void) const
+{
+	return m_iRenderStealsTotal;
+}
+
+float qtractorAudioRenderPool::renderBalanceAvg (void) const
+{
+	return (m_iRenderCycles > 0
+		? m_fRenderBalanceSum / float(m_iRenderCycles) : 1.0f);
+}
+
+
+void qtractorAudioRenderPool::resetStats (void)
+{
+	m_iRenderItems   = 0;
+	m_iRenderSteals  = 0;
+	m_fRenderBalance = 1.0f;
+
+	m_iRenderCycles  = 0;
+	m_iRenderStealsTotal = 0;
+	m_fRenderBalanceSum  = 0.0f;
+}
+
+
+// end of qtractorAudioRender.cpp
@@ -0,0 +1,216 @@
+// qtractorAudioRender.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioRender_h
+#define __qtractorAudioRender_h
+
+#include "qtractorAtomic.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSemaphore>
+#include <QAtomicPointer>
+
+
+// Forward declarations.
+class qtractorSession;
+class qtractorSessionCursor;
+class qtractorTrack;
+class qtractorClip;
+class qtractorAudioGraph;
+class qtractorAudioRenderPool;
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioRenderThread -- Parallel track render worker.
+//
+
+class qtractorAudioRenderThread : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorAudioRenderThread(qtractorAudioRenderPool *pRenderPool,
+		unsigned int iSlot, int iRtPriority = 0);
+
+	// Destructor.
+	~qtractorAudioRenderThread();
+
+	// Thread run state accessors.
+	void setRunState(bool bRunState);
+	bool runState() const;
+
+	// Wake from executive wait condition (RT-safe).
+	void sync();
+
+protected:
+
+	// The main thread executive.
+	void run();
+
+private:
+
+	// Instance variables.
+	qtractorAudioRenderPool *m_pRenderPool;
+	unsigned int m_iSlot;
+
+	// Real-time scheduling priority (0=none).
+	int m_iRtPriority;
+
+	// Pending wake-up flag.
+	qtractorAtomic m_syncPending;
+
+	// Whether the thread is logically running.
+	volatile bool m_bRunState;
+
+	// Thread synchronization objects.
+	QMutex m_mutex;
+	QWaitCondition m_cond;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioRenderPool -- Parallel track render scheduler.
+//
+
+class qtractorAudioRenderPool
+{
+public:
+
+	// Constructor.
+	qtractorAudioRenderPool(qtractorSession *pSession,
+		unsigned int iThreads, unsigned int iRenderSize = 0);
+
+	// Destructor.
+	~qtractorAudioRenderPool();
+
+	// Number of worker threads (not counting the caller's).
+	unsigned int threads() const;
+
+	// Whether render item tables are large enough.
+	bool isRenderSize(unsigned int iRenderSize) const;
+
+	// Conditional resize check (non RT-safe; session must be locked).
+	void checkRenderSize(unsigned int iRenderSize);
+
+	// Parallel track process cycle executive (RT-safe).
+	void process(qtractorSessionCursor *pSessionCursor,
+		unsigned long iFrameStart, unsigned long iFrameEnd);
+
+	// Parallel routing graph process cycle executive (RT-safe).
+	void process(qtractorAudioGraph *pGraph,
+		qtractorSessionCursor *pSessionCursor,
+		unsigned long iFrameStart, unsigned long iFrameEnd);
+
+	// Worker render executive (own queue first, then steal).
+	void render(unsigned int iSlot);
+
+	// Last cycle load-balance statistics.
+	unsigned int renderItems() const;
+	unsigned int renderSteals() const;
+	float renderBalance() const;
+
+	// Accumulated load-balance statistics.
+	unsigned long renderCycles() const;
+	unsigned long renderStealsTotal() const;
+	float renderBalanceAvg() const;
+
+	void resetStats();
+
+protected:
+
+	// Claim next render item, from own or someone else's queue.
+	int claim(unsigned int iSlot);
+
+	// Whether a track may be rendered out of (serial) order.
+	bool isRenderTrack(qtractorTrack *pTrack) const;
+
+	// Track automation processing (serial).
+	void process_curve(unsigned long iFrameStart);
+
+	// Wake up all workers (RT-safe).
+	void wakeup();
+
+	// Bounded spin-wait, yield, then revoke and park (RT-safe).
+	void wait(unsigned int& iSpin);
+
+	// Wake up the caller, if parked (RT-safe).
+	void unpark();
+
+	// Whether a worker may no longer claim items (RT-safe).
+	bool isRevoked(unsigned int iSlot) const;
+
+private:
+
+	// Instance variables.
+	qtractorSession *m_pSession;
+
+	unsigned int m_iThreads;
+	qtractorAudioRenderThread **m_ppThreads;
+
+	// Per-slot work queues, packed as (tail << 16 | head).
+	unsigned int    m_iSlots;
+	qtractorAtomic *m_pSlots;
+	unsigned int   *m_piSlotItems;
+
+	// Render item tables (per track index).
+	unsigned int    m_iRenderSize;
+	qtractorTrack **m_ppTracks;
+	qtractorClip  **m_ppClips;
+	bool           *m_pbRender;
+	unsigned int   *m_piWork;
+
+	// Current cycle frame range.
+	unsigned long m_iFrameStart;
+	unsigned long m_iFrameEnd;
+
+	// Current cycle routing graph, if any.
+	QAtomicPointer<qtractorAudioGraph> m_graph;
+
+	// Current cycle progress counters.
+	qtractorAtomic m_cycle;
+	qtractorAtomic m_done;
+	qtractorAtomic m_steals;
+	qtractorAtomic m_active;
+
+	// Whether workers may no longer claim items (caller out of budget).
+	qtractorAtomic m_revoke;
+
+	// Caller parking (out of budget) semaphore.
+	qtractorAtomic m_parked;
+	QSemaphore     m_park;
+
+	// Load-balance statistics.
+	unsigned int  m_iRenderItems;
+	unsigned int  m_iRenderSteals;
+	float         m_fRenderBalance;
+
+	unsigned long m_iRenderCycles;
+	unsigned long m_iRenderStealsTotal;
+	float         m_fRenderBalanceSum;
+};
+
+
+#endif  // __qtractorAudioRender_h
+
+
+// end of qtractorAudioRender.h
@@ -1210,6 +1210,14 @@ bool qtractorClipRecordExCommand::redo (void)
 	qtractorClip *pClipRecordEx = m_pTrack->clipRecord();
 	const bool bClipRecordEx = m_pTrack->isClipRecordEx();
 
+	// Overdub goes into clip sequence (copy-on-write)...
+	if (m_bClipRecordEx && m_pClipRecordEx
+		&& m_pTrack->trackType() == qtractorTrack::Midi) {
+		qtractorMidiClip *pMidiClip
+			= static_cast<qtractorMidiClip *> (m_pClipRecordEx);
+		pMidiClip->detachHashData();
+	}
+
 	m_pTrack->setRecord(m_bClipRecordEx);
 	m_pTrack->setClipRecord(m_bClipRecordEx ? m_pClipRecordEx : NULL);
 	m_pTrack->setClipRecordEx(m_bClipRecordEx);
@@ -29,6 +29,20 @@
 #include <math.h>
 
 
+// Maximum node steps on forward cursor seek, before binary-searching.
+#define QTRACTOR_CURVE_SEEK_STEPS	8
+
+// Minimum number of nodes worth a binary-search index.
+#define QTRACTOR_CURVE_INDEX_MIN	32
+
+// Maximum number of dropped nodes on a capture thinning run.
+#define QTRACTOR_CURVE_THIN_MAX		256
+
+
+// Capture thinning error tolerance (global).
+static float g_fThinTolerance = 0.0f;
+
+
 // Ref. P.448. Approximate cube root of an IEEE float
 // Hacker's Delight (2nd Edition), by Henry S. Warren
 // http://www.hackersdelight.org/hdcodetxt/acbrt.c.txt
@@ -190,7 +204,11 @@ qtractorCurve::qtractorCurve ( qtractorCurveList *pList,
 	qtractorSubject *pSubject, Mode mode, unsigned int iMinFrameDist )
 	: m_pList(pList), m_mode(mode), m_iMinFrameDist(iMinFrameDist),
 		m_observer(pSubject, this), m_state(Idle), m_cursor(this),
-		m_bLogarithmic(false), m_color(Qt::darkRed), m_pEditList(NULL)
+		m_bLogarithmic(false), m_color(Qt::darkRed), m_pEditList(NULL),
+		m_iLatency(0), m_bBlockValue(false), m_fBlockValue(0.0f),
+		m_indexSerial(1), m_iIndexSerial(0), m_pIndex(NULL),
+		m_pThinAnchor(NULL), m_pThinLast(NULL),
+		m_iThinNodes(0), m_iThinDropped(0), m_fThinMaxError(0.0f)
 {
 	m_nodes.setAutoDelete(true);
 
@@ -218,6 +236,17 @@ qtractorCurve::~qtractorCurve (void)
 	clear();
 
 	delete m_pEditList;
+
+	Index *pIndex = m_indexNext.fetchAndStoreOrdered(NULL);
+	if (pIndex)
+		delete pIndex;
+
+	pIndex = m_indexDone.fetchAndStoreOrdered(NULL);
+	if (pIndex)
+		delete pIndex;
+
+	if (m_pIndex)
+		delete m_pIndex;
 }
 
 
@@ -234,6 +263,9 @@ void qtractorCurve::clear (void)
 	m_tail.c = 0.0f;
 	m_tail.d = 0.0f;
 
+	resetIndex();
+	breakThin();
+
 	m_nodes.clear();
 	m_cursor.reset(NULL);
 
@@ -295,12 +327,15 @@ qtractorCurve::Node *qtractorCurve::addNode (
 		// Move/update the existing one as average...
 		if (pEditList)
 			pEditList->moveNode(pNode, pNode->frame, pNode->value);
+		if (pNode->frame != iFrame)
+			resetIndex();
 		pNode->frame = iFrame;
 		pNode->value = fValue;
 	} else {
 		// Create a brand new node,
 		// insert it in the right frame...
 		pNode = new Node(iFrame, fValue);
+		resetIndex();
 		if (pNext)
 			m_nodes.insertBefore(pNode, pNext);
 		else
@@ -331,6 +366,8 @@ void qtractorCurve::insertNode ( Node *pNode )
 
 	Node *pNext = m_cursor.seek(pNode->frame);
 
+	resetIndex();
+
 	if (pNext)
 		m_nodes.insertBefore(pNode, pNext);
 	else
@@ -355,6 +392,8 @@ void qtractorCurve::unlinkNode ( Node *pNode )
 #endif
 
 	m_cursor.reset(pNode);
+	resetIndex();
+	breakThin();
 
 	Node *pNext = pNode->next();
 	m_nodes.unlink(pNode);
@@ -377,6 +416,8 @@ void qtractorCurve::removeNode ( Node *pNode )
 #endif
 
 	m_cursor.reset(pNode);
+	resetIndex();
+	breakThin();
 
 	Node *pNext = pNode->next();
 	m_nodes.remove(pNode);
@@ -456,6 +497,10 @@ void qtractorCurve::update (void)
 	qDebug("qtractorCurve[%p]::update()", this);
 #endif
 
+	// Node frames might have been moved...
+	resetIndex();
+	breakThin();
+
 	for (Node *pNode = m_nodes.first(); pNode; pNode = pNode->next())
 		updateNodeEx(pNode);
 
@@ -496,6 +541,9 @@ void qtractorCurve::setLength ( unsigned long iLength )
 
 	m_tail.frame = iLength;
 
+	resetIndex();
+	breakThin();
+
 	Node *pNode = m_nodes.last();
 	while (pNode && pNode->frame > m_tail.frame) {
 		Node *pPrev = pNode->prev();
@@ -515,12 +563,26 @@ qtractorCurve::Node *qtractorCurve::Cursor::seek ( unsigned long iFrame )
 {
 	Node *pNode = m_pNode;
 
+	const Index *pIndex = m_pCurve->index();
+
 	if (iFrame > m_iFrame) {
 		// Seek forward...
 		if (pNode == NULL)
-			pNode = m_pCurve->nodes().first();
-		while (pNode && pNode->frame < iFrame)
+			pNode = (pIndex ? pIndex->seek(iFrame) : m_pCurve->nodes().first());
+		unsigned int iSteps = 0;
+		while (pNode && pNode->frame < iFrame) {
+			// Far ahead? jump straight there...
+			if (pIndex && ++iSteps > QTRACTOR_CURVE_SEEK_STEPS) {
+				pNode = pIndex->seek(iFrame);
+				break;
+			}
 			pNode = pNode->next();
+		}
+	}
+	else
+	if (pIndex) {
+		// Seek backward (binary search)...
+		pNode = pIndex->seek(iFrame);
 	} else {
 		// Seek backward...
 		if (pNode == NULL)
@@ -544,6 +606,206 @@ void qtractorCurve::Cursor::reset ( qtractorCurve::Node *pNode )
 }
 
 
+//----------------------------------------------------------------------
+// class qtractorCurve::Index -- Flat sorted node index.
+//
+
+// Constructor.
+qtractorCurve::Index::Index (
+	const qtractorList<Node>& nodes, int iSerial )
+	: m_iSerial(iSerial)
+{
+	m_nodes.reserve(nodes.count());
+
+	for (Node *pNode = nodes.first(); pNode; pNode = pNode->next())
+		m_nodes.append(pNode);
+}
+
+
+// First node at or past given frame (O(log n)).
+qtractorCurve::Node *qtractorCurve::Index::seek ( unsigned long iFrame ) const
+{
+	Node *const *ppNodes = m_nodes.constData();
+
+	unsigned int i = 0;
+	unsigned int n = m_nodes.count();
+	while (i < n) {
+		const unsigned int k = (i + n) >> 1;
+		if (ppNodes[k]->frame < iFrame)
+			i = k + 1;
+		else
+			n = k;
+	}
+
+	return (i < (unsigned int) m_nodes.count() ? ppNodes[i] : NULL);
+}
+
+
+// Node index (re)build, if invalid (non RT-safe).
+void qtractorCurve::updateIndex (void)
+{
+	const int iSerial = ATOMIC_GET(&m_indexSerial);
+	if (m_iIndexSerial == iSerial)
+		return;
+
+	m_iIndexSerial = iSerial;
+
+	// Dispose of the one retired by the RT thread...
+	Index *pIndex = m_indexDone.fetchAndStoreOrdered(NULL);
+	if (pIndex)
+		delete pIndex;
+
+	// Short curves are just fine stepping along...
+	pIndex = NULL;
+	if (m_nodes.count() >= QTRACTOR_CURVE_INDEX_MIN)
+		pIndex = new Index(m_nodes, iSerial);
+
+	// Post it; whatever was still pending never got used...
+	pIndex = m_indexNext.fetchAndStoreOrdered(pIndex);
+	if (pIndex)
+		delete pIndex;
+}
+
+
+// Node index swap-in (RT-safe).
+void qtractorCurve::takeIndex (void)
+{
+	// Take the newly posted index, but only if
+	// the previous one can be retired safely...
+	if (m_indexDone.testAndSetOrdered(NULL, NULL)) {
+		Index *pIndex = m_indexNext.fetchAndStoreOrdered(NULL);
+		if (pIndex) {
+			if (m_pIndex)
+				m_indexDone.fetchAndStoreOrdered(m_pIndex);
+			m_pIndex = pIndex;
+		}
+	}
+}
+
+
+// Capture thinning error tolerance (global).
+void qtractorCurve::setThinTolerance ( float fThinTolerance )
+{
+	g_fThinTolerance = fThinTolerance;
+}
+
+float qtractorCurve::thinTolerance (void)
+{
+	return g_fThinTolerance;
+}
+
+
+// Capture thinning statistics reset.
+void qtractorCurve::resetThin (void)
+{
+	breakThin();
+
+	m_iThinNodes = 0;
+	m_iThinDropped = 0;
+	m_fThinMaxError = 0.0f;
+}
+
+
+// Capture thinning run break (eg. on node list edits).
+void qtractorCurve::breakThin (void)
+{
+	m_pThinAnchor = NULL;
+	m_pThinLast = NULL;
+
+	m_thinNodes.clear();
+}
+
+
+// Capture thinning (incremental) pass: the last captured node gets
+// dropped whenever it and all the others already dropped since the
+// last kept node (anchor) lie close enough to the straight segment
+// from the anchor to the newly captured one. Only applies to linear
+// curves, as that's what actually gets rendered in between; dropping
+// a spline node would re-shape both neighbouring segments instead.
+void qtractorCurve::thinNode ( Node *pNode )
+{
+	if (g_fThinTolerance <= 0.0f || m_mode != Linear || !m_observer.isDecimal())
+		return;
+
+	++m_iThinNodes;
+
+	Node *pLast = m_pThinLast;
+	m_pThinLast = pNode;
+
+	// Last captured node just moved in place?
+	if (pNode == pLast) {
+		if (m_pThinAnchor && pNode->prev() == m_pThinAnchor) {
+			const float fError = thinError(m_pThinAnchor, pNode);
+			if (m_fThinMaxError < fError)
+				m_fThinMaxError = fError;
+		}
+		m_pThinAnchor = pNode->prev();
+		m_thinNodes.clear();
+		return;
+	}
+
+	// Not a plain append, start over...
+	if (pLast == NULL || pNode->prev() != pLast
+		|| m_pThinAnchor == NULL || pLast->prev() != m_pThinAnchor) {
+		m_pThinAnchor = pNode->prev();
+		m_thinNodes.clear();
+		return;
+	}
+
+	// Tentatively drop the last captured node...
+	m_thinNodes.append(Node(pLast->frame, pLast->value));
+
+	const float fError = thinError(m_pThinAnchor, pNode);
+	if (fError <= g_fThinTolerance
+		&& m_thinNodes.count() < QTRACTOR_CURVE_THIN_MAX
+		&& m_pEditList && m_pEditList->dropNode(pLast)) {
+		if (m_fThinMaxError < fError)
+			m_fThinMaxError = fError;
+		m_cursor.reset(pLast);
+		resetIndex();
+		m_nodes.remove(pLast);
+		updateNode(m_pThinAnchor);
+		updateNode(pNode);
+		++m_iThinDropped;
+	} else {
+		// Keep it as the new anchor...
+		m_pThinAnchor = pLast;
+		m_thinNodes.clear();
+	}
+}
+
+
+// Capture thinning maximum deviation of all dropped nodes,
+// normalized to the subject value range.
+float qtractorCurve::thinError (
+	const Node *pNode0, const Node *pNode1 ) const
+{
+	const float fRange = m_observer.maxValue() - m_observer.minValue();
+	if (fRange <= 0.0f)
+		return 0.0f;
+
+	const float x0 = float(pNode0->frame);
+	const float y0 = pNode0->value;
+	const float dx = float(pNode1->frame) - x0;
+	const float dy = pNode1->value - y0;
+
+	float fMaxError = 0.0f;
+
+	QVectorIterator<Node> iter(m_thinNodes);
+	while (iter.hasNext()) {
+		const Node& node = iter.next();
+		float y = y0;
+		if (dx > 0.0f)
+			y += dy * (float(node.frame) - x0) / dx;
+		const float fError = ::fabsf(node.value - y) / fRange;
+		if (fMaxError < fError)
+			fMaxError = fError;
+	}
+
+	return fMaxError;
+}
+
+
 // Common interpolate method.
 float qtractorCurve::value ( const Node *pNode, unsigned long iFrame ) const
 {
@@ -580,6 +842,36 @@ float qtractorCurve::value ( unsigned long iFrame )
 }
 
 
+// Block automation: whether a continuous curve value isn't
+// constant over the given (uncompensated) frame range.
+bool qtractorCurve::isRamping (
+	unsigned long iFrameStart, unsigned long iFrameEnd )
+{
+	if (!isProcess() || isCapture() || mode() == Hold)
+		return false;
+
+	// Follow the compensated (delayed) signal path...
+	if (m_iLatency > 0) {
+		iFrameStart = (iFrameStart > m_iLatency ? iFrameStart - m_iLatency : 0);
+		iFrameEnd = (iFrameEnd > m_iLatency ? iFrameEnd - m_iLatency : 0);
+	}
+
+	// Past the last node, it's flat...
+	const Node *pNode = seek(iFrameStart);
+	if (pNode == NULL)
+		return false;
+
+	// Crossing over a node?
+	if (pNode->frame < iFrameEnd)
+		return true;
+
+	// Same segment all along; flat only if both ends are level...
+	const Node *pPrev = pNode->prev();
+	const float y0 = (pPrev ? pPrev->value : m_tail.value);
+	return (::fabsf(pNode->value - y0) > 1e-9f);
+}
+
+
 // Normalized scale converters.
 float qtractorCurve::valueFromScale ( float fScale ) const 
 {
@@ -637,6 +929,8 @@ void qtractorCurve::copyNodes ( qtractorCurve *pCurve )
 		return;
 
 	// Remove existing nodes.
+	resetIndex();
+	breakThin();
 	m_nodes.clear();
 
 	// Clone new ones...
@@ -746,6 +1040,8 @@ void qtractorCurve::setCapture ( bool bCapture )
 
 	const bool bOldCapture = (m_state & Capture);
 	m_state = State(bCapture ? (m_state | Capture) : (m_state & ~Capture));
+	if (bCapture && !bOldCapture)
+		breakThin();
 	if ((bCapture && !bOldCapture) || (!bCapture && bOldCapture)) {
 		m_pList->updateCapture(bCapture);
 		// notify auto-plugin-deactivate
@@ -24,9 +24,12 @@
 
 #include "qtractorObserver.h"
 #include "qtractorMidiSequence.h"
+#include "qtractorAtomic.h"
 
 #include <QColor>
 #include <QObject>
+#include <QVector>
+#include <QAtomicPointer>
 
 
 // Forward declarations.
@@ -138,6 +141,39 @@ public:
 	// Refresh all coefficients.
 	void update();
 
+	// Flat sorted node index, for binary-search seeking.
+	class Index
+	{
+	public:
+
+		// Constructor.
+		Index(const qtractorList<Node>& nodes, int iSerial);
+
+		// Accessors.
+		int serial() const { return m_iSerial; }
+		unsigned int count() const { return m_nodes.count(); }
+
+		// First node at or past given frame (O(log n)).
+		Node *seek(unsigned long iFrame) const;
+
+	private:
+
+		// Member variables.
+		int m_iSerial;
+
+		QVector<Node *> m_nodes;
+	};
+
+	// Current node index, if still valid (RT-safe).
+	const Index *index() const
+	{
+		return (m_pIndex && m_pIndex->serial() == ATOMIC_GET(&m_indexSerial)
+			? m_pIndex : NULL);
+	}
+
+	// Node index (re)build, if invalid (non RT-safe).
+	void updateIndex();
+
 	// To optimize and keep track of current frame
 	// position, mostly like a sequence cursor/iterator.
 	class Cursor
@@ -199,23 +235,75 @@ public:
 	void setProcess(bool bProcess);
 	void setLocked(bool bLocked);
 
+	// Latency compensation offset accessors (in frames).
+	void setLatency(unsigned long iLatency)
+		{ m_iLatency = iLatency; }
+	unsigned long latency() const
+		{ return m_iLatency; }
+
 	// The meta-processing automation procedure.
 	void process(unsigned long iFrame)
 	{
 		if (isProcess()) {
+			// Take the newly posted node index...
+			takeIndex();
+			// Follow the compensated (delayed) signal path...
+			if (m_iLatency > 0)
+				iFrame = (iFrame > m_iLatency ? iFrame - m_iLatency : 0);
 			Node *pNode = seek(iFrame);
 			if (!isCapture())
 				m_observer.setValue(value(pNode, iFrame));
 		}
 	}
 
-	void process() { process(m_cursor.frame()); }
+	void process() { process(m_cursor.frame() + m_iLatency); }
+
+	// Block automation: whether a continuous curve value isn't
+	// constant over the given (uncompensated) frame range.
+	bool isRamping(unsigned long iFrameStart, unsigned long iFrameEnd);
+
+	// Block automation sub-block procedure (continuous curves only);
+	// the subject value is set straight, observers are left alone.
+	void process_block(unsigned long iFrame)
+	{
+		if (isProcess() && !isCapture() && mode() != Hold) {
+			if (m_iLatency > 0)
+				iFrame = (iFrame > m_iLatency ? iFrame - m_iLatency : 0);
+			Node *pNode = seek(iFrame);
+			qtractorSubject *pSubject = m_observer.subject();
+			if (pSubject) {
+				if (!m_bBlockValue) {
+					m_fBlockValue = pSubject->value();
+					m_bBlockValue = true;
+				}
+				pSubject->setDirectValue(value(pNode, iFrame));
+			}
+		}
+	}
+
+	// Block automation sub-block wrap-up: back to the last notified
+	// value, then set the last sub-block one, as observers must know.
+	void process_block_end()
+	{
+		if (m_bBlockValue) {
+			qtractorSubject *pSubject = m_observer.subject();
+			if (pSubject) {
+				const float fValue = pSubject->value();
+				pSubject->setDirectValue(m_fBlockValue);
+				m_observer.setValue(fValue);
+			}
+			m_bBlockValue = false;
+		}
+	}
 
 	// Record automation procedure.
 	void capture(unsigned long iFrame)
 	{
-		if (isCapture())
-			addNode(iFrame, m_observer.value(), m_pEditList);
+		if (isCapture()) {
+			Node *pNode = addNode(iFrame, m_observer.value(), m_pEditList);
+			if (pNode)
+				thinNode(pNode);
+		}
 	}
 
 	void capture() { capture(m_cursor.frame()); }
@@ -223,6 +311,22 @@ public:
 	qtractorCurveEditList *editList() const
 		{ return m_pEditList; }
 
+	// Capture thinning error tolerance (global; normalized
+	// as a fraction of the subject value range; 0=disabled);
+	// only linear mode curves get thinned.
+	static void setThinTolerance(float fThinTolerance);
+	static float thinTolerance();
+
+	// Capture thinning statistics.
+	unsigned int thinNodes() const
+		{ return m_iThinNodes; }
+	unsigned int thinDropped() const
+		{ return m_iThinDropped; }
+	float thinMaxError() const
+		{ return m_fThinMaxError; }
+
+	void resetThin();
+
 	// Copy all events from another curve (raw-copy).
 	void copyNodes(qtractorCurve *pCurve);
 
@@ -261,6 +365,17 @@ protected:
 	void updateNode(Node *pNode);
 	void updateNodeEx(Node *pNode);
 
+	// Node index invalidation (on any node list change).
+	void resetIndex() { ATOMIC_INC(&m_indexSerial); }
+
+	// Node index swap-in (RT-safe).
+	void takeIndex();
+
+	// Capture thinning (incremental) pass.
+	void thinNode(Node *pNode);
+	void breakThin();
+	float thinError(const Node *pNode0, const Node *pNode1) const;
+
 	// Observer for capture.
 	class Observer : public qtractorObserver
 	{
@@ -313,6 +428,33 @@ private:
 
 	// Capture (record) edit list.
 	qtractorCurveEditList *m_pEditList;
+
+	// Latency compensation offset (in frames).
+	unsigned long m_iLatency;
+
+	// Block automation saved period value.
+	bool  m_bBlockValue;
+	float m_fBlockValue;
+
+	// Node index (binary-search seeking).
+	qtractorAtomic m_indexSerial;
+	int            m_iIndexSerial;
+	Index         *m_pIndex;
+
+	QAtomicPointer<Index> m_indexNext;
+	QAtomicPointer<Index> m_indexDone;
+
+	// Capture thinning state: last kept node (anchor),
+	// last captured node and all dropped ones in between.
+	Node *m_pThinAnchor;
+	Node *m_pThinLast;
+
+	QVector<Node> m_thinNodes;
+
+	// Capture thinning statistics.
+	unsigned int m_iThinNodes;
+	unsigned int m_iThinDropped;
+	float        m_fThinMaxError;
 };
 
 
@@ -371,6 +513,28 @@ public:
 	void removeNode(qtractorCurve::Node *pNode)
 		{ m_items.append(new Item(RemoveNode, pNode)); }
 
+	// Withdraw a node added on this very list (eg. capture thinning);
+	// returns false if the node wasn't added here in the first place.
+	bool dropNode(qtractorCurve::Node *pNode)
+	{
+		int i = m_items.count();
+		while (--i >= 0) {
+			Item *pItem = m_items.at(i);
+			if (pItem->node == pNode && pItem->command == AddNode)
+				break;
+		}
+		if (i < 0)
+			return false;
+		for (int j = m_items.count() - 1; j >= i; --j) {
+			Item *pItem = m_items.at(j);
+			if (pItem->node == pNode) {
+				m_items.removeAt(j);
+				delete pItem;
+			}
+		}
+		return true;
+	}
+
 	// List appender.
 	void append(const qtractorCurveEditList& list)
 	{
@@ -511,6 +675,47 @@ public:
 		}
 	}
 
+	// Node index (re)build, if invalid (non RT-safe).
+	void updateIndex()
+	{
+		qtractorCurve *pCurve = first();
+		while (pCurve) {
+			pCurve->updateIndex();
+			pCurve = pCurve->next();
+		}
+	}
+
+	// Block automation: whether any continuous curve is ramping.
+	bool isRamping(unsigned long iFrameStart, unsigned long iFrameEnd)
+	{
+		qtractorCurve *pCurve = first();
+		while (pCurve) {
+			if (pCurve->isRamping(iFrameStart, iFrameEnd))
+				return true;
+			pCurve = pCurve->next();
+		}
+		return false;
+	}
+
+	// Block automation sub-block procedure.
+	void process_block(unsigned long iFrame)
+	{
+		qtractorCurve *pCurve = first();
+		while (pCurve) {
+			pCurve->process_block(iFrame);
+			pCurve = pCurve->next();
+		}
+	}
+
+	void process_block_end()
+	{
+		qtractorCurve *pCurve = first();
+		while (pCurve) {
+			pCurve->process_block_end();
+			pCurve = pCurve->next();
+		}
+	}
+
 	// Process management.
 	void updateProcess(bool bProcess)
 	{
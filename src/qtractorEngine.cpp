@@ -50,6 +50,7 @@ qtractorEngine::qtractorEngine ( qtractorSession *pSession,
 	m_pSessionCursor = m_pSession->createSessionCursor(0, syncType);
 	m_bActivated     = false;
 	m_bPlaying       = false;
+	m_bOffline       = false;
 
 	m_buses.setAutoDelete(true);
 	m_busesEx.setAutoDelete(false);
@@ -108,6 +109,18 @@ bool qtractorEngine::isActivated(void) const
 }
 
 
+// Offline (headless, no device) mode accessors.
+void qtractorEngine::setOffline ( bool bOffline )
+{
+	m_bOffline = bOffline;
+}
+
+bool qtractorEngine::isOffline (void) const
+{
+	return m_bOffline;
+}
+
+
 // Buses list managament methods.
 const qtractorList<qtractorBus>& qtractorEngine::buses (void) const
 {
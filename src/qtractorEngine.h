@@ -70,6 +70,10 @@ public:
 	// Engine status methods.
 	bool isActivated() const;
 
+	// Offline (headless, no device) mode accessors.
+	void setOffline(bool bOffline);
+	bool isOffline() const;
+
 	// Engine state methods.
 	void setPlaying(bool bPlaying);
 	bool isPlaying() const;
@@ -128,6 +132,7 @@ private:
 	// Engine running flags.
 	bool m_bActivated;
 	bool m_bPlaying;
+	bool m_bOffline;
 
 	qtractorList<qtractorBus> m_buses;
 	qtractorList<qtractorBus> m_busesEx;
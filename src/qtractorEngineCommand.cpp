@@ -567,6 +567,10 @@ bool qtractorMoveBusCommand::redo (void)
 	// Move it...
 	pEngine->moveBus(pBus, m_pNextBus);
 
+	// Audio routing (bus order) has changed...
+	if (pEngine->syncType() == qtractorTrack::Audio)
+		pSession->audioEngine()->resetGraph();
+
 	// Swap it nice, finally.
 	m_pNextBus = pNextBus;
 
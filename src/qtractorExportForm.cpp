@@ -26,6 +26,7 @@
 #include "qtractorMidiEngine.h"
 
 #include "qtractorAudioFile.h"
+#include "qtractorAudioExport.h"
 
 #include "qtractorMainForm.h"
 #include "qtractorTracks.h"
@@ -188,6 +189,10 @@ void qtractorExportForm::setExportType ( qtractorTrack::TrackType exportType )
 		}
 	}
 	
+	// Stems are for audio export only...
+	m_ui.ExportStemsCheckBox->setChecked(false);
+	m_ui.ExportStemsCheckBox->setVisible(m_exportType == qtractorTrack::Audio);
+
 	// Set proper time scales display format...
 	if (m_pTimeScale) {
 		m_ui.FormatComboBox->setCurrentIndex(
@@ -225,14 +230,32 @@ void qtractorExportForm::accept (void)
 	if (QFileInfo(sExportPath).suffix().isEmpty())
 		sExportPath += '.' + m_sExportExt;
 
+	// Stem files are named after each export bus...
+	const bool bExportStems = (m_exportType == qtractorTrack::Audio
+		&& m_ui.ExportStemsCheckBox->isChecked());
+
+	QString sExistingPath;
+	if (bExportStems) {
+		QListIterator<QListWidgetItem *> iter(exportBusNameItems);
+		while (iter.hasNext() && sExistingPath.isEmpty()) {
+			const QString& sStemPath = qtractorAudioExportPool::stemPath(
+				sExportPath, iter.next()->text());
+			if (QFileInfo(sStemPath).exists())
+				sExistingPath = sStemPath;
+		}
+	}
+	else
+	if (QFileInfo(sExportPath).exists())
+		sExistingPath = sExportPath;
+
 	// Check (again) wether the file already exists...
-	if (QFileInfo(sExportPath).exists()) {
+	if (!sExistingPath.isEmpty()) {
 		if (QMessageBox::warning(this,
 			tr("Warning") + " - " QTRACTOR_TITLE,
 			tr("The file already exists:\n\n"
 			"\"%1\"\n\n"
 			"Do you want to replace it?")
-			.arg(sExportPath),
+			.arg(sExistingPath),
 			QMessageBox::Ok | QMessageBox::Cancel) == QMessageBox::Cancel) {
 			m_ui.ExportPathComboBox->setFocus();
 			return;
@@ -270,26 +293,40 @@ void qtractorExportForm::accept (void)
 					tr("Audio file export: \"%1\" started...")
 					.arg(sExportPath));
 				// Do the export as commanded...
+				QStringList files;
 				QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-				const bool bResult = pAudioEngine->fileExport(
-					sExportPath, exportBuses,
-					m_ui.ExportStartSpinBox->value(),
-					m_ui.ExportEndSpinBox->value());
+				bool bResult = false;
+				if (bExportStems) {
+					bResult = pAudioEngine->fileExportStems(
+						sExportPath, exportBuses,
+						QList<qtractorTrack *> (),
+						m_ui.ExportStartSpinBox->value(),
+						m_ui.ExportEndSpinBox->value(), &files);
+				} else {
+					bResult = pAudioEngine->fileExport(
+						sExportPath, exportBuses,
+						m_ui.ExportStartSpinBox->value(),
+						m_ui.ExportEndSpinBox->value());
+					files.append(sExportPath);
+				}
 				QApplication::restoreOverrideCursor();
 				if (bResult) {
 					// Add new tracks if necessary...
 					qtractorTracks *pTracks = pMainForm->tracks();
 					if (pTracks && m_ui.AddTrackCheckBox->isChecked()) {
-						pTracks->addAudioTracks(
-							QStringList(sExportPath),
+						pTracks->addAudioTracks(files,
 							m_ui.ExportStartSpinBox->value(),
 							pTracks->currentTrack());
+					} else {
+						QStringListIterator iter(files);
+						while (iter.hasNext())
+							pMainForm->addAudioFile(iter.next());
 					}
-					else pMainForm->addAudioFile(sExportPath);
 					// Log the success...
 					pMainForm->appendMessages(
-						tr("Audio file export: \"%1\" complete.")
-						.arg(sExportPath));
+						tr("Audio file export: \"%1\" complete (%2x realtime).")
+						.arg(files.join("\", \""))
+						.arg(pAudioEngine->exportSpeed(), 0, 'f', 1));
 				} else {
 					// Log the failure...
 					pMainForm->appendMessagesError(
@@ -1210,6 +1210,14 @@ qtractorAudioAuxSendPlugin::qtractorAudioAuxSendPlugin (
 		this, pAuxSendType->channels());
 #endif
 
+	// Deferred (routing graph) mix-down state.
+	m_iSendChannels   = 0;
+	m_iSendBufferSize = 0;
+	m_ppSendBuffer    = NULL;
+	m_fSendGain       = 1.0f;
+	m_bSendDeferred   = false;
+	m_bSendPending    = false;
+
 	// Custom optimized processors.
 #if defined(__SSE__)
 	if (sse_enabled()) {
@@ -1240,6 +1248,9 @@ qtractorAudioAuxSendPlugin::~qtractorAudioAuxSendPlugin (void)
 {
 	// Cleanup plugin instance...
 	setChannels(0);
+
+	// Cleanup deferred mix-down buffer...
+	setSendBuffer(0, 0);
 }
 
 
@@ -1263,6 +1274,13 @@ void qtractorAudioAuxSendPlugin::setChannels ( unsigned short iChannels )
 	// Estimate the (new) number of instances...
 	const unsigned short iInstances
 		= pType->instances(iChannels, list()->isMidi());
+
+	// Deferred mix-down buffer must follow engine buffer-size...
+	if (iInstances > 0)
+		setSendBuffer(iChannels, pAudioEngine->bufferSize());
+	else
+		setSendBuffer(0, 0);
+
 	// Now see if instance count changed anyhow...
 	if (iInstances == instances())
 		return;
@@ -1272,8 +1290,10 @@ void qtractorAudioAuxSendPlugin::setChannels ( unsigned short iChannels )
 	setActivated(false);
 
 	// Cleanup bus...
-	if (m_pAudioBus)
+	if (m_pAudioBus) {
 		m_pAudioBus = NULL;
+		pAudioEngine->resetGraph();
+	}
 
 	// Set new instance number...
 	setInstances(iInstances);
@@ -1343,6 +1363,9 @@ void qtractorAudioAuxSendPlugin::setAudioBusName ( const QString& sAudioBusName
 	//	clearConfigs();
 	}
 
+	// Routing topology has changed...
+	pAudioEngine->resetGraph();
+
 	updateAudioBusName();
 }
 
@@ -1375,20 +1398,130 @@ void qtractorAudioAuxSendPlugin::process (
 
 //	m_pAudioBus->process_prepare(nframes);
 
-	float **ppOut = m_pAudioBus->out();
-
 	const unsigned short iChannels = channels();
 
 	for (unsigned short i = 0; i < iChannels; ++i)
 		::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
 
 	const float fGain = m_pSendGainParam->value();
+
+	float **ppOut = m_pAudioBus->out();
+
+	// Deferred mix-down and/or delay compensation: keep a copy...
+	const bool bLatencyDelay = (m_latencyDelay.delay() > 0);
+	if ((m_bSendDeferred || bLatencyDelay)
+		&& m_ppSendBuffer && iChannels <= m_iSendChannels) {
+		for (unsigned short i = 0; i < iChannels; ++i)
+			::memcpy(m_ppSendBuffer[i], ppIBuffer[i], nframes * sizeof(float));
+		m_latencyDelay.process(m_ppSendBuffer, nframes);
+		// Deferred mix-down: keep it until committed in order...
+		if (m_bSendDeferred) {
+			m_fSendGain = fGain;
+			m_bSendPending = true;
+		} else {
+			(*m_pfnProcessAdd)(ppOut, m_ppSendBuffer, nframes, iChannels, fGain);
+		}
+		return;
+	}
+
 	(*m_pfnProcessAdd)(ppOut, ppOBuffer, nframes, iChannels, fGain);
 
 //	m_pAudioBus->process_commit(nframes);
 }
 
 
+// Audio bus target accessor.
+qtractorAudioBus *qtractorAudioAuxSendPlugin::audioBus (void) const
+{
+	return m_pAudioBus;
+}
+
+
+// Deferred (routing graph) mix-down mode accessors.
+void qtractorAudioAuxSendPlugin::setSendDeferred ( bool bSendDeferred )
+{
+	m_bSendDeferred = bSendDeferred;
+}
+
+bool qtractorAudioAuxSendPlugin::isSendDeferred (void) const
+{
+	return m_bSendDeferred;
+}
+
+
+// Deferred (routing graph) mix-down commit (RT-safe).
+void qtractorAudioAuxSendPlugin::process_commit ( unsigned int nframes )
+{
+	m_bSendDeferred = false;
+
+	if (!m_bSendPending)
+		return;
+
+	m_bSendPending = false;
+
+	if (m_pAudioBus == NULL)
+		return;
+
+	if (!m_pAudioBus->isEnabled())
+		return;
+
+	(*m_pfnProcessAdd)(m_pAudioBus->out(), m_ppSendBuffer,
+		nframes, channels(), m_fSendGain);
+}
+
+
+// Plugin delay compensation (non RT-safe).
+void qtractorAudioAuxSendPlugin::setLatencyDelay ( unsigned long iLatencyDelay )
+{
+	m_latencyDelay.setDelay(m_iSendChannels, iLatencyDelay);
+}
+
+unsigned long qtractorAudioAuxSendPlugin::latencyDelay (void) const
+{
+	return m_latencyDelay.delay();
+}
+
+
+// Plugin delay compensation flush.
+void qtractorAudioAuxSendPlugin::resetLatencyDelay (void)
+{
+	m_latencyDelay.reset();
+}
+
+
+// Deferred mix-down buffer (re)allocation.
+void qtractorAudioAuxSendPlugin::setSendBuffer (
+	unsigned short iChannels, unsigned int iBufferSize )
+{
+	if (iChannels == m_iSendChannels && iBufferSize == m_iSendBufferSize)
+		return;
+
+	m_bSendDeferred = false;
+	m_bSendPending  = false;
+
+	if (m_ppSendBuffer) {
+		for (unsigned short i = 0; i < m_iSendChannels; ++i)
+			delete [] m_ppSendBuffer[i];
+		delete [] m_ppSendBuffer;
+		m_ppSendBuffer = NULL;
+	}
+
+	m_iSendChannels   = 0;
+	m_iSendBufferSize = 0;
+
+	// Plugin delay compensation must be set anew...
+	m_latencyDelay.setDelay(0, 0);
+
+	if (iChannels > 0 && iBufferSize > 0) {
+		m_ppSendBuffer = new float * [iChannels];
+		for (unsigned short i = 0; i < iChannels; ++i)
+			m_ppSendBuffer[i] = new float [iBufferSize];
+		m_iSendChannels   = iChannels;
+		m_iSendBufferSize = iBufferSize;
+	}
+}
+
+
 // Do the actual activation.
 void qtractorAudioAuxSendPlugin::activate (void)
 {
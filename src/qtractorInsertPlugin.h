@@ -24,6 +24,7 @@
 #define __qtractorInsertPlugin_h
 
 #include "qtractorPlugin.h"
+#include "qtractorAudioDelay.h"
 
 
 // Forward declarations.
@@ -350,12 +351,32 @@ public:
 	// Audio bus to appear on plugin lists.
 	void updateAudioBusName() const;
 
+	// Audio bus target accessor.
+	qtractorAudioBus *audioBus() const;
+
+	// Deferred (routing graph) mix-down mode accessors.
+	void setSendDeferred(bool bSendDeferred);
+	bool isSendDeferred() const;
+
+	// Deferred (routing graph) mix-down commit (RT-safe).
+	void process_commit(unsigned int nframes);
+
+	// Plugin delay compensation (non RT-safe).
+	void setLatencyDelay(unsigned long iLatencyDelay);
+	unsigned long latencyDelay() const;
+
+	// Plugin delay compensation flush.
+	void resetLatencyDelay();
+
 protected:
 
 	// Do the actual (de)activation.
 	void activate();
 	void deactivate();
 
+	// Deferred mix-down buffer (re)allocation.
+	void setSendBuffer(unsigned short iChannels, unsigned int iBufferSize);
+
 private:
 
 	// Instance variables.
@@ -364,6 +385,17 @@ private:
 
 	qtractorInsertPluginParam *m_pSendGainParam;
 
+	// Deferred (routing graph) mix-down state.
+	unsigned short m_iSendChannels;
+	unsigned int   m_iSendBufferSize;
+	float        **m_ppSendBuffer;
+	float          m_fSendGain;
+	volatile bool  m_bSendDeferred;
+	volatile bool  m_bSendPending;
+
+	// Plugin delay compensation.
+	qtractorAudioDelay m_latencyDelay;
+
 	// Custom optimized processors.
 	void (*m_pfnProcessAdd)(float **, float **, unsigned int,
 		unsigned short, float);
@@ -163,7 +163,7 @@ const QString& qtractorLadspaPluginType::aboutText (void)
 qtractorLadspaPlugin::qtractorLadspaPlugin ( qtractorPluginList *pList,
 	qtractorLadspaPluginType *pLadspaType )
 	: qtractorPlugin(pList, pLadspaType), m_phInstances(NULL),
-		m_piControlOuts(NULL), m_pfControlOuts(NULL),
+		m_piControlOuts(NULL), m_pfControlOuts(NULL), m_pfLatency(NULL),
 		m_piAudioIns(NULL), m_piAudioOuts(NULL),
 		m_pfIDummy(NULL), m_pfODummy(NULL)
 {
@@ -207,6 +207,11 @@ qtractorLadspaPlugin::qtractorLadspaPlugin ( qtractorPluginList *pList,
 				if (LADSPA_IS_PORT_CONTROL(portType)) {
 					m_piControlOuts[iControlOuts] = i;
 					m_pfControlOuts[iControlOuts] = 0.0f;
+					// Latency reporting port, by convention...
+					const QString sPortName
+						= QString(pLadspaDescriptor->PortNames[i]).toLower();
+					if (sPortName == "latency" || sPortName == "_latency")
+						m_pfLatency = &m_pfControlOuts[iControlOuts];
 					++iControlOuts;
 				}
 			}
@@ -463,6 +468,17 @@ void qtractorLadspaPlugin::process (
 }
 
 
+// Plugin processing latency (in frames), if any.
+unsigned long qtractorLadspaPlugin::latency (void) const
+{
+	if (m_pfLatency == NULL || !isActivated())
+		return 0;
+
+	const float fLatency = *m_pfLatency;
+	return (fLatency > 0.0f ? (unsigned long) fLatency : 0);
+}
+
+
 //----------------------------------------------------------------------------
 // qtractorLadspaPluginParam -- LADSPA plugin control input port instance.
 //
@@ -97,6 +97,9 @@ public:
 	// The main plugin processing procedure.
 	void process(float **ppIBuffer, float **ppOBuffer, unsigned int nframes);
 
+	// Plugin processing latency (in frames), if any.
+	unsigned long latency() const;
+
 	// Specific accessors.
 	const LADSPA_Descriptor *ladspa_descriptor() const;
 	LADSPA_Handle ladspa_handle(unsigned short iInstance) const;
@@ -116,6 +119,9 @@ protected:
 	unsigned long *m_piControlOuts;
 	float         *m_pfControlOuts;
 
+	// Output control port reporting latency, if any.
+	float         *m_pfLatency;
+
 	// List of audio port indexes.
 	unsigned long *m_piAudioIns;
 	unsigned long *m_piAudioOuts;
@@ -2109,6 +2109,7 @@ qtractorLv2Plugin::qtractorLv2Plugin ( qtractorPluginList *pList,
 		, m_piControlOuts(NULL)
 		, m_pfControlOuts(NULL)
 		, m_pfControlOutsLast(NULL)
+		, m_pfLatency(NULL)
 		, m_piAudioIns(NULL)
 		, m_piAudioOuts(NULL)
 		, m_pfIDummy(NULL)
@@ -2336,6 +2337,8 @@ qtractorLv2Plugin::qtractorLv2Plugin ( qtractorPluginList *pList,
 		iAtomIns = iAtomOuts = 0;
 	#endif	// CONFIG_LV2_ATOM
 		const unsigned long iNumPorts = lilv_plugin_get_num_ports(plugin);
+		const unsigned long iLatencyPort = (lilv_plugin_has_latency(plugin)
+			? lilv_plugin_get_latency_port_index(plugin) : iNumPorts);
 		for (unsigned long i = 0; i < iNumPorts; ++i) {
 			const LilvPort *port = lilv_plugin_get_port_by_index(plugin, i);
 			if (port) {
@@ -2377,6 +2380,8 @@ qtractorLv2Plugin::qtractorLv2Plugin ( qtractorPluginList *pList,
 						m_piControlOuts[iControlOuts] = i;
 						m_pfControlOuts[iControlOuts] = 0.0f;
 						m_pfControlOutsLast[iControlOuts] = 0.0f;
+						if (i == iLatencyPort)
+							m_pfLatency = &m_pfControlOuts[iControlOuts];
 						++iControlOuts;
 					}
 				}
@@ -3064,6 +3069,17 @@ void qtractorLv2Plugin::process (
 }
 
 
+// Plugin processing latency (in frames), if any.
+unsigned long qtractorLv2Plugin::latency (void) const
+{
+	if (m_pfLatency == NULL || !isActivated())
+		return 0;
+
+	const float fLatency = *m_pfLatency;
+	return (fLatency > 0.0f ? (unsigned long) fLatency : 0);
+}
+
+
 #ifdef CONFIG_LV2_UI
 
 // Open editor.
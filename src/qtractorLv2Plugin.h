@@ -209,6 +209,9 @@ public:
 	// The main plugin processing procedure.
 	void process(float **ppIBuffer, float **ppOBuffer, unsigned int nframes);
 
+	// Plugin processing latency (in frames), if any.
+	unsigned long latency() const;
+
 	// Specific accessors.
 	LilvPlugin *lv2_plugin() const;
 	LilvInstance *lv2_instance(unsigned short iInstance) const;
@@ -447,6 +450,9 @@ private:
 	float         *m_pfControlOuts;
 	float         *m_pfControlOutsLast;
 
+	// Output control port reporting latency, if any.
+	float         *m_pfLatency;
+
 	// List of audio port indexes.
 	unsigned long *m_piAudioIns;
 	unsigned long *m_piAudioOuts;
@@ -331,6 +331,10 @@ qtractorMainForm::qtractorMainForm (
 		QObject::connect(pAudioEngineProxy,
 			SIGNAL(propEvent()),
 			SLOT(audioPropNotify()));
+		QObject::connect(pAudioEngineProxy,
+			SIGNAL(graphEvent()),
+			SLOT(audioGraphNotify()),
+			Qt::QueuedConnection);
 	}
 
 	// Configure the MIDI engine event handling...
@@ -1493,6 +1497,7 @@ void qtractorMainForm::setup ( qtractorOptions *pOptions )
 	updateMidiControlModes();
 	updateMidiQueueTimer();
 	updateMidiDriftCorrect();
+	updateMidiJackOutput();
 	updateMidiPlayer();
 	updateMidiControl();
 	updateMidiMetronome();
@@ -1520,6 +1525,8 @@ void qtractorMainForm::setup ( qtractorOptions *pOptions )
 		m_pOptions->bAudioWsolaTimeStretch);
 	qtractorAudioBuffer::setDefaultWsolaQuickSeek(
 		m_pOptions->bAudioWsolaQuickSeek);
+	qtractorAudioBuffer::setDefaultLandingBudget(
+		m_pOptions->iAudioLandingBudget);
 
 	// Load (action) keyboard shortcuts...
 	m_pOptions->loadActionShortcuts(this);
@@ -1530,8 +1537,20 @@ void qtractorMainForm::setup ( qtractorOptions *pOptions )
 
 	// Some special defaults...
 	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
-	if (pAudioEngine)
+	if (pAudioEngine) {
 		pAudioEngine->setMasterAutoConnect(m_pOptions->bAudioMasterAutoConnect);
+		pAudioEngine->setRenderThreads(m_pOptions->iAudioRenderThreads);
+		pAudioEngine->setBlockAutomation(m_pOptions->iAudioBlockAutomation);
+		pAudioEngine->setSyncThreads(m_pOptions->iAudioSyncThreads);
+	}
+
+	// Automation capture thinning tolerance...
+	qtractorCurve::setThinTolerance(0.01f * m_pOptions->fCurveThinTolerance);
+
+	// Shared decoded audio cache memory budget...
+	qtractorAudioCache *pAudioCache = m_pSession->audioCache();
+	if (pAudioCache)
+		pAudioCache->setBudget(m_pOptions->iAudioCacheBudget);
 	
 	// Final widget slot connections....
 	QObject::connect(m_pFileSystem->toggleViewAction(),
@@ -5888,6 +5907,11 @@ bool qtractorMainForm::setPlaying ( bool bPlaying )
 		setRolling(0);
 		// Session tracks automation recording.
 		qtractorCurveCaptureListCommand *pCurveCommand = NULL;
+	#ifdef CONFIG_DEBUG
+		unsigned int iThinNodes = 0;
+		unsigned int iThinDropped = 0;
+		float fThinMaxError = 0.0f;
+	#endif
 		for (qtractorTrack *pTrack = m_pSession->tracks().first();
 				pTrack; pTrack = pTrack->next()) {
 			qtractorCurveList *pCurveList = pTrack->curveList();
@@ -5897,9 +5921,57 @@ bool qtractorMainForm::setPlaying ( bool bPlaying )
 					pCurveCommand = new qtractorCurveCaptureListCommand();
 				pCurveCommand->addCurveList(pCurveList);
 			}
+			// Automation capture thinning statistics...
+			if (pCurveList) {
+				for (qtractorCurve *pCurve = pCurveList->first();
+						pCurve; pCurve = pCurve->next()) {
+				#ifdef CONFIG_DEBUG
+					iThinNodes += pCurve->thinNodes();
+					iThinDropped += pCurve->thinDropped();
+					if (fThinMaxError < pCurve->thinMaxError())
+						fThinMaxError = pCurve->thinMaxError();
+				#endif
+					pCurve->resetThin();
+				}
+			}
 		}
 		if (pCurveCommand)
 			m_pSession->commands()->push(pCurveCommand);
+	#ifdef CONFIG_DEBUG
+		if (iThinNodes > 0 && iThinDropped > 0) {
+			qDebug("qtractorMainForm::setPlaying(false) "
+				"curve thinning: dropped=%u/%u (%.1f%%) max.error=%.2f%%",
+				iThinDropped, iThinNodes,
+				100.0f * float(iThinDropped) / float(iThinNodes),
+				100.0f * fThinMaxError);
+		}
+	#endif
+	#ifdef CONFIG_DEBUG
+		// MIDI output (adaptive read-ahead) statistics...
+		qtractorMidiEngine::OutputStats stats;
+		qtractorMidiEngine *pMidiEngine = m_pSession->midiEngine();
+		if (pMidiEngine && pMidiEngine->outputStats(stats)
+			&& stats.cycles > 0) {
+			qDebug("qtractorMainForm::setPlaying(false) "
+				"MIDI output: cycles=%lu events=%lu late=%lu coalesced=%lu "
+				"read-ahead=%lu (%s) min.headroom=%ld max.usecs=%lu",
+				(unsigned long) stats.cycles,
+				(unsigned long) stats.eventsTotal,
+				(unsigned long) stats.lateTotal,
+				(unsigned long) stats.coalescedTotal,
+				(unsigned long) stats.readAhead,
+				pMidiEngine->isReadAheadAuto() ? "auto" : "fixed",
+				(long) stats.headroomMin,
+				(unsigned long) stats.usecsMax);
+			const float fCycles = float(stats.cycles);
+			qDebug("qtractorMainForm::setPlaying(false) "
+				"MIDI output: outputs=%lu (%.1f/cycle) drains=%lu (%.1f/cycle) "
+				"avg.usecs=%.1f/cycle",
+				stats.outputsTotal, float(stats.outputsTotal) / fCycles,
+				stats.drainsTotal, float(stats.drainsTotal) / fCycles,
+				float(stats.usecsTotal) / fCycles);
+		}
+	#endif
 	}	// Start something... ;)
 	else ++m_iTransportUpdate;
 
@@ -6735,6 +6807,23 @@ void qtractorMainForm::updateMidiDriftCorrect (void)
 
 	// Configure the MIDI engine drift correction...
 	m_pSession->midiEngine()->setDriftCorrect(m_pOptions->bMidiDriftCorrect);
+
+	// And whether the read-ahead adapts to it...
+	m_pSession->midiEngine()->setReadAheadAuto(m_pOptions->bMidiReadAheadAuto);
+}
+
+
+// Update MIDI output through JACK MIDI ports.
+void qtractorMainForm::updateMidiJackOutput (void)
+{
+	if (m_pOptions == NULL)
+		return;
+
+	// Configure the MIDI engine output mode (takes effect on restart)...
+	m_pSession->midiEngine()->setJackOutput(m_pOptions->bMidiJackOutput);
+
+	// And whether track plugins get fed straight from the audio thread...
+	m_pSession->midiEngine()->setDirectPlugins(m_pOptions->bMidiDirectPlugins);
 }
 
 
@@ -7497,6 +7586,19 @@ void qtractorMainForm::slowTimerSlot (void)
 	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
 	qtractorMidiEngine  *pMidiEngine  = m_pSession->midiEngine();
 
+	// Audio routing graph (re)compilation, if applicable...
+	pAudioEngine->updateGraph();
+
+	// Plugin delay compensation (PDC) update, if applicable...
+	if (m_pSession->updateLatency() && m_pMixer)
+		m_pMixer->updateLatency();
+
+	// Predictive seek prefetch (landing) update, if applicable...
+	m_pSession->updatePrefetch();
+
+	// Automation curve seek index update...
+	m_pSession->updateCurveIndex();
+
 	// Read JACK transport state...
 	jack_client_t *pJackClient = pAudioEngine->jackClient();
 	if (pJackClient && !pAudioEngine->isFreewheel()) {
@@ -7974,6 +8076,21 @@ void qtractorMainForm::audioPropNotify (void)
 }
 
 
+// Custom audio routing graph change event handler.
+void qtractorMainForm::audioGraphNotify (void)
+{
+	// Topology has changed: (re)compile it right away,
+	// once the current edit is through (queued)...
+	// (otherwise left to the slow timer, if busy)...
+	if (m_pSession->isBusy())
+		return;
+
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine)
+		pAudioEngine->updateGraph();
+}
+
+
 // Custom MMC event handler.
 void qtractorMainForm::midiMmcNotify ( const qtractorMmcEvent& mmce )
 {
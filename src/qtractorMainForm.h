@@ -310,6 +310,7 @@ protected slots:
 	void audioSessNotify(void *pvSessionArg);
 	void audioSyncNotify(unsigned long iPlayHead);
 	void audioPropNotify();
+	void audioGraphNotify();
 
 	void midiMmcNotify(const qtractorMmcEvent& mmce);
 	void midiCtlNotify(const qtractorCtlEvent& ctle);
@@ -420,6 +421,7 @@ protected:
 	void updateAudioPlayer();
 	void updateMidiQueueTimer();
 	void updateMidiDriftCorrect();
+	void updateMidiJackOutput();
 	void updateMidiPlayer();
 	void updateMidiControl();
 	void updateAudioMetronome();
@@ -141,6 +141,24 @@ public:
 		}
 	}
 
+	// Remove channel events by tag, keeping order (non RT-safe).
+	void remove(unsigned char tag, unsigned char channel)
+	{
+		unsigned int i = m_iReadIndex;
+		unsigned int j = i;
+		while (i != m_iWriteIndex) {
+			snd_seq_event_t *pEv = &m_pBuffer[i];
+			if (pEv->tag != tag || !snd_seq_ev_is_channel_type(pEv)
+				|| pEv->data.note.channel != channel) {
+				if (j != i)
+					m_pBuffer[j] = *pEv;
+				++j &= m_iBufferMask;
+			}
+			++i &= m_iBufferMask;
+		}
+		m_iWriteIndex = j;
+	}
+
 private:
 
 	// Instance variables.
@@ -22,6 +22,8 @@
 #include "qtractorAbout.h"
 #include "qtractorMidiClip.h"
 #include "qtractorMidiEngine.h"
+#include "qtractorAudioEngine.h"
+#include "qtractorMidiSnapshot.h"
 
 #include "qtractorSession.h"
 #include "qtractorFileList.h"
@@ -54,6 +56,17 @@ const WindowFlags WindowCloseButtonHint = WindowFlags(0x08000000);
 #endif
 
 
+// Specific controller definitions
+#define BANK_SELECT_MSB		0x00
+#define BANK_SELECT_LSB		0x20
+
+#define CHANNEL_VOLUME		0x07
+
+
+// Export event batch size (tempo-map conversion).
+#define QTRACTOR_MIDI_EXPORT_BATCH	64
+
+
 //----------------------------------------------------------------------
 // class qtractorMidiClip::Key -- MIDI sequence clip (hash key).
 //
@@ -179,8 +192,17 @@ qtractorMidiClip::qtractorMidiClip ( qtractorTrack *pTrack )
 	m_iTrackChannel = 0;
 	m_iFormat = defaultFormat();
 	m_bSessionFlag = false;
+	m_pImportSeq = NULL;
 	m_iRevision = 0;
 
+	m_pSnapshot = NULL;
+	m_iSnapshotIndex = 0;
+	ATOMIC_SET(&m_snapshotSync, 0);
+
+	m_pSnapshotPrev = NULL;
+	m_iDirectIndex = 0;
+	ATOMIC_SET(&m_snapshotPins, 0);
+
 	m_pMidiEditorForm = NULL;
 }
 
@@ -200,8 +222,17 @@ qtractorMidiClip::qtractorMidiClip ( const qtractorMidiClip& clip )
 
 	m_iFormat = clip.format();
 	m_bSessionFlag = false;
+	m_pImportSeq = NULL;
 	m_iRevision = clip.revision();
 
+	m_pSnapshot = NULL;
+	m_iSnapshotIndex = 0;
+	ATOMIC_SET(&m_snapshotSync, 0);
+
+	m_pSnapshotPrev = NULL;
+	m_iDirectIndex = 0;
+	ATOMIC_SET(&m_snapshotPins, 0);
+
 	m_pMidiEditorForm = NULL;
 }
 
@@ -212,6 +243,20 @@ qtractorMidiClip::~qtractorMidiClip (void)
 	close();
 
 	closeMidiFile();
+
+	clearSnapshot();
+
+	setImportSequence(NULL);
+}
+
+
+// Pre-read track sequence, taken over on next open.
+void qtractorMidiClip::setImportSequence ( qtractorMidiSequence *pSeq )
+{
+	if (m_pImportSeq)
+		delete m_pImportSeq;
+
+	m_pImportSeq = pSeq;
 }
 
 
@@ -431,8 +476,18 @@ bool qtractorMidiClip::openMidiFile (
 	} else {
 		// On read mode, SMF format is properly given by open file.
 		setFormat(m_pFile->format());
-		// Read the event sequence in...
-		m_pFile->readTrack(pSeq, iTrackChannel);
+		// Read the event sequence in, unless it's been read
+		// already, along with all the other tracks (import);
+		// the session flag wants this file's own tempo-map...
+		if (m_pImportSeq && !m_bSessionFlag
+			&& m_pImportSeq->ticksPerBeat() == pSeq->ticksPerBeat()
+			&& pSeq->timeOffset() == 0 && pSeq->timeLength() == 0) {
+			m_pData->setSequence(m_pImportSeq);
+			m_pImportSeq = NULL;
+			delete pSeq;
+			pSeq = m_pData->sequence();
+		}
+		else m_pFile->readTrack(pSeq, iTrackChannel);
 		// For immediate feedback, once...
 		pTrack->setMidiNoteMin(pSeq->noteMin());
 		pTrack->setMidiNoteMax(pSeq->noteMax());
@@ -519,6 +574,7 @@ bool qtractorMidiClip::openMidiFile (
 void qtractorMidiClip::closeMidiFile (void)
 {
 	if (m_pData) {
+		cancelSnapshot();
 		m_pData->detach(this);
 		if (m_pData->count() < 1) {
 			removeHashKey();
@@ -703,25 +759,8 @@ void qtractorMidiClip::unlinkHashData (void)
 
 	m_pData->detach(this);
 
-	Data *pNewData = new Data();
-
-	qtractorMidiSequence *pOldSeq = m_pData->sequence();
-	qtractorMidiSequence *pNewSeq = pNewData->sequence();
-
-	pNewSeq->setName(pOldSeq->name());
-	pNewSeq->setChannel(pOldSeq->channel());
-	pNewSeq->setBankSelMethod(pOldSeq->bankSelMethod());
-	pNewSeq->setBank(pOldSeq->bank());
-	pNewSeq->setProg(pOldSeq->prog());
-	pNewSeq->setTicksPerBeat(pOldSeq->ticksPerBeat());
-	pNewSeq->setTimeOffset(pOldSeq->timeOffset());
-	pNewSeq->setTimeLength(pOldSeq->timeLength());
-	pNewSeq->setDuration(pOldSeq->duration());
-	pNewSeq->setNoteMin(pOldSeq->noteMin());
-	pNewSeq->setNoteMax(pOldSeq->noteMax());
-	pNewSeq->copyEvents(pOldSeq);
-
-	m_pData = pNewData;
+	// Events are shared, copied only on first change...
+	m_pData = new Data(m_pData);
 	m_pData->attach(this);
 
 	updateHashKey();
@@ -745,6 +784,7 @@ void qtractorMidiClip::relinkHashData (void)
 		delete m_pKey;
 		m_pKey = NULL;
 	} else {
+		cancelSnapshot();
 		m_pData->detach(this);
 		delete m_pData;
 		m_pData = pNewData;
@@ -755,6 +795,49 @@ void qtractorMidiClip::relinkHashData (void)
 }
 
 
+// Copy-on-write local hash data (before any sequence change).
+void qtractorMidiClip::detachHashData (void)
+{
+	if (m_pData == NULL)
+		return;
+	if (!m_pData->isShared())
+		return;
+
+	// We keep the original sequence, as current edit
+	// and undo/redo history are all about its events;
+	// all the others get a brand new (shared) copy...
+	qtractorMidiSequence *pOldSeq = m_pData->sequence();
+	qtractorMidiSequence *pNewSeq = new qtractorMidiSequence();
+
+	pNewSeq->setName(pOldSeq->name());
+	pNewSeq->setChannel(pOldSeq->channel());
+	pNewSeq->setBankSelMethod(pOldSeq->bankSelMethod());
+	pNewSeq->setBank(pOldSeq->bank());
+	pNewSeq->setProg(pOldSeq->prog());
+	pNewSeq->setTicksPerBeat(pOldSeq->ticksPerBeat());
+	pNewSeq->setTimeOffset(pOldSeq->timeOffset());
+	pNewSeq->setTimeLength(pOldSeq->timeLength());
+	pNewSeq->setDuration(pOldSeq->duration());
+	pNewSeq->setNoteMin(pOldSeq->noteMin());
+	pNewSeq->setNoteMax(pOldSeq->noteMax());
+	pNewSeq->copyEvents(pOldSeq);
+
+	Data *pFirstData = m_pData->unshare();
+	Data *pData = pFirstData;
+	do {
+		pData->setSequence(pNewSeq);
+		QListIterator<qtractorMidiClip *> iter(pData->clips());
+		while (iter.hasNext()) {
+			qtractorMidiClip *pMidiClip = iter.next();
+			pMidiClip->m_playCursor.reset(pNewSeq);
+			pMidiClip->m_drawCursor.reset(pNewSeq);
+			pMidiClip->updateEditor(true);
+		}
+		pData = pData->nextShared();
+	} while (pData != pFirstData);
+}
+
+
 // Whether local hash is being shared.
 bool qtractorMidiClip::isHashLinked (void) const
 {
@@ -929,17 +1012,44 @@ void qtractorMidiClip::process (
 	if (pSeq == NULL)
 		return;
 
+	// The MIDI output thread own tempo-map reader...
+	qtractorTimeScale::Reader *pTimeReader = pMidiEngine->timeReader();
+	if (pTimeReader == NULL)
+		return;
+
 	// Track mute state...
 	const bool bMute = (pTrack->isMute()
 		|| (pSession->soloTracks() && !pTrack->isSolo()));
 
-	const unsigned long t0 = pSession->tickFromFrame(clipStart());
-
-	const unsigned long iTimeStart = pSession->tickFromFrame(iFrameStart);
-	const unsigned long iTimeEnd   = pSession->tickFromFrame(iFrameEnd);
+	const unsigned long iTimeStart = pTimeReader->tickFromFrame(iFrameStart);
+	const unsigned long iTimeEnd   = pTimeReader->tickFromFrame(iFrameEnd);
 
-	// Enqueue the requested events...
 	const float fGain = clipGain();
+
+	// Enqueue the requested events, straight
+	// from the flat playback snapshot, if current...
+	qtractorMidiSnapshot *pSnapshot = snapshot(pSession);
+	if (pSnapshot) {
+		const unsigned long t0 = pSnapshot->clipStartTime();
+		const unsigned int iCount = pSnapshot->count();
+		qtractorMidiEvent ev(0, qtractorMidiEvent::NOTEON);
+		unsigned int i = pSnapshot->seek(
+			iTimeStart > t0 ? iTimeStart - t0 : 0, m_iSnapshotIndex);
+		for ( ; i < iCount; ++i) {
+			const unsigned long t1 = t0 + pSnapshot->time(i);
+			if (t1 >= iTimeEnd)
+				break;
+			if (!bMute || pSnapshot->type(i) != qtractorMidiEvent::NOTEON)
+				pMidiEngine->enqueue(pTrack, pSnapshot->event(i, ev), t1,
+					fGain * fadeInOutGain(pSnapshot->frame(i)));
+		}
+		m_iSnapshotIndex = i;
+		return;
+	}
+
+	// Otherwise, off the sequence itself...
+	const unsigned long t0 = pTimeReader->tickFromFrame(clipStart());
+
 	qtractorMidiEvent *pEvent
 		= m_playCursor.seek(pSeq, iTimeStart > t0 ? iTimeStart - t0 : 0);
 	while (pEvent) {
@@ -949,7 +1059,7 @@ void qtractorMidiClip::process (
 		if (t1 >= iTimeStart
 			&& (!bMute || pEvent->type() != qtractorMidiEvent::NOTEON))
 			pMidiEngine->enqueue(pTrack, pEvent, t1, fGain
-				* fadeInOutGain(pSession->frameFromTick(t1) - clipStart()));
+				* fadeInOutGain(pTimeReader->frameFromTick(t1) - clipStart()));
 		pEvent = pEvent->next();
 	}
 }
@@ -971,29 +1081,394 @@ void qtractorMidiClip::process_export (
 	if (pSeq == NULL)
 		return;
 
+	qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return;
+
+	// The audio thread own tempo-map reader...
+	qtractorTimeScale::Reader *pTimeReader = pAudioEngine->timeReader();
+	if (pTimeReader == NULL)
+		return;
+
 	// Track mute state...
 	const bool bMute = (pTrack->isMute()
 		|| (pSession->soloTracks() && !pTrack->isSolo()));
 
-	const unsigned long t0 = pSession->tickFromFrame(clipStart());
-
-	const unsigned long iTimeStart = pSession->tickFromFrame(iFrameStart);
-	const unsigned long iTimeEnd   = pSession->tickFromFrame(iFrameEnd);
+	const unsigned long iTimeStart = pTimeReader->tickFromFrame(iFrameStart);
+	const unsigned long iTimeEnd   = pTimeReader->tickFromFrame(iFrameEnd);
 
-	// Enqueue the requested events...
 	const float fGain = clipGain();
+
+	// Event times, converted to frames in batches...
+	unsigned long iTimeOn[QTRACTOR_MIDI_EXPORT_BATCH];
+	unsigned long iTimeOff[QTRACTOR_MIDI_EXPORT_BATCH];
+
+	// Enqueue the requested events, straight
+	// from the flat playback snapshot, if current...
+	qtractorMidiSnapshot *pSnapshot = snapshot(pSession);
+	if (pSnapshot) {
+		const unsigned long t0 = pSnapshot->clipStartTime();
+		const unsigned int iCount = pSnapshot->count();
+		qtractorMidiEvent ev(0, qtractorMidiEvent::NOTEON);
+		unsigned int i = pSnapshot->seek(
+			iTimeStart > t0 ? iTimeStart - t0 : 0, m_iSnapshotIndex);
+		for (;;) {
+			// Gather the next batch of note-off times
+			// (note-on frames are in the snapshot already)...
+			unsigned int n = 0;
+			while (i + n < iCount && n < QTRACTOR_MIDI_EXPORT_BATCH) {
+				const unsigned long t1 = t0 + pSnapshot->time(i + n);
+				if (t1 >= iTimeEnd)
+					break;
+				const unsigned long d1 = pSnapshot->duration(i + n);
+				iTimeOff[n++] = (d1 > 0 ? t1 + d1 - 1 : t1);
+			}
+			if (n < 1)
+				break;
+			pTimeReader->framesFromTicks(iTimeOff, iTimeOff, n);
+			for (unsigned int k = 0; k < n; ++k, ++i) {
+				if (bMute && pSnapshot->type(i) == qtractorMidiEvent::NOTEON)
+					continue;
+				const unsigned long f1 = pSnapshot->frame(i);
+				enqueue_export(pTrack, pSnapshot->event(i, ev),
+					t0 + pSnapshot->time(i), fGain * fadeInOutGain(f1),
+					clipStart() + f1, iTimeOff[k]);
+			}
+		}
+		m_iSnapshotIndex = i;
+		return;
+	}
+
+	// Otherwise, off the sequence itself...
+	const unsigned long t0 = pTimeReader->tickFromFrame(clipStart());
+
 	qtractorMidiEvent *pEvent
 		= m_playCursor.seek(pSeq, iTimeStart > t0 ? iTimeStart - t0 : 0);
 	while (pEvent) {
-		const unsigned long t1 = t0 + pEvent->time();
+		// Gather the next batch of note-on/off times...
+		qtractorMidiEvent *pBatch = NULL;
+		unsigned int n = 0;
+		while (pEvent && n < QTRACTOR_MIDI_EXPORT_BATCH) {
+			const unsigned long t1 = t0 + pEvent->time();
+			if (t1 >= iTimeEnd)
+				break;
+			if (t1 >= iTimeStart) {
+				if (pBatch == NULL)
+					pBatch = pEvent;
+				const unsigned long d1
+					= (pEvent->type() == qtractorMidiEvent::NOTEON
+						? pEvent->duration() : 0);
+				iTimeOn[n] = t1;
+				iTimeOff[n++] = (d1 > 0 ? t1 + d1 - 1 : t1);
+			}
+			pEvent = pEvent->next();
+		}
+		if (n < 1)
+			break;
+		pTimeReader->framesFromTicks(iTimeOn, iTimeOn, n);
+		pTimeReader->framesFromTicks(iTimeOff, iTimeOff, n);
+		for (unsigned int k = 0; k < n; pBatch = pBatch->next()) {
+			if (t0 + pBatch->time() < iTimeStart)
+				continue;
+			if (!bMute || pBatch->type() != qtractorMidiEvent::NOTEON) {
+				const unsigned long f1 = iTimeOn[k];
+				enqueue_export(pTrack, pBatch, t0 + pBatch->time(),
+					fGain * fadeInOutGain(f1 > clipStart() ? f1 - clipStart() : 0),
+					f1, iTimeOff[k]);
+			}
+			++k;
+		}
+	}
+}
+
+
+// MIDI clip event to plugin (sequencer) event conversion.
+static void qtractorMidiClipEvent ( snd_seq_event_t *pEv,
+	qtractorTrack *pTrack, qtractorMidiEvent *pEvent, float fGain )
+{
+	snd_seq_ev_clear(pEv);
+
+	switch (pEvent->type()) {
+	case qtractorMidiEvent::NOTEON:
+		pEv->type = SND_SEQ_EVENT_NOTE;
+		pEv->data.note.channel  = pTrack->midiChannel();
+		pEv->data.note.note     = pEvent->note();
+		pEv->data.note.velocity = int(fGain * float(pEvent->value())) & 0x7f;
+		pEv->data.note.duration = pEvent->duration();
+		break;
+	case qtractorMidiEvent::KEYPRESS:
+		pEv->type = SND_SEQ_EVENT_KEYPRESS;
+		pEv->data.note.channel  = pTrack->midiChannel();
+		pEv->data.note.note     = pEvent->note();
+		pEv->data.note.velocity = pEvent->velocity();
+		pEv->data.note.duration = 0;
+		break;
+	case qtractorMidiEvent::CONTROLLER:
+		pEv->type = SND_SEQ_EVENT_CONTROLLER;
+		pEv->data.control.channel = pTrack->midiChannel();
+		pEv->data.control.param   = pEvent->controller();
+		pEv->data.control.value   = pEvent->value();
+		break;
+	case qtractorMidiEvent::REGPARAM:
+		pEv->type = SND_SEQ_EVENT_REGPARAM;
+		pEv->data.control.channel = pTrack->midiChannel();
+		pEv->data.control.param   = pEvent->param();
+		pEv->data.control.value   = pEvent->value();
+		break;
+	case qtractorMidiEvent::NONREGPARAM:
+		pEv->type = SND_SEQ_EVENT_NONREGPARAM;
+		pEv->data.control.channel = pTrack->midiChannel();
+		pEv->data.control.param   = pEvent->param();
+		pEv->data.control.value   = pEvent->value();
+		break;
+	case qtractorMidiEvent::CONTROL14:
+		pEv->type = SND_SEQ_EVENT_CONTROL14;
+		pEv->data.control.channel = pTrack->midiChannel();
+		pEv->data.control.param   = pEvent->param();
+		pEv->data.control.value   = pEvent->value();
+		break;
+	case qtractorMidiEvent::PGMCHANGE:
+		pEv->type = SND_SEQ_EVENT_PGMCHANGE;
+		pEv->data.control.channel = pTrack->midiChannel();
+		pEv->data.control.value   = pEvent->param();
+		break;
+	case qtractorMidiEvent::CHANPRESS:
+		pEv->type = SND_SEQ_EVENT_CHANPRESS;
+		pEv->data.control.channel = pTrack->midiChannel();
+		pEv->data.control.value   = pEvent->value();
+		break;
+	case qtractorMidiEvent::PITCHBEND:
+		pEv->type = SND_SEQ_EVENT_PITCHBEND;
+		pEv->data.control.channel = pTrack->midiChannel();
+		pEv->data.control.value   = pEvent->pitchBend();
+		break;
+	case qtractorMidiEvent::SYSEX:
+		pEv->type = SND_SEQ_EVENT_SYSEX;
+		snd_seq_ev_set_sysex(pEv, pEvent->sysex_len(), pEvent->sysex());
+		break;
+	default:
+		break;
+	}
+}
+
+
+// MIDI clip direct plugin delivery cycle executive (RT-safe).
+void qtractorMidiClip::process_direct ( qtractorMidiManager *pMidiManager,
+	unsigned long iFrameStart, unsigned long iFrameEnd,
+	unsigned long iFrameTime )
+{
+	qtractorTrack *pTrack = track();
+	if (pTrack == NULL)
+		return;
+
+	qtractorSession *pSession = pTrack->session();
+	if (pSession == NULL)
+		return;
+
+	qtractorMidiSequence *pSeq = sequence();
+	if (pSeq == NULL)
+		return;
+
+	qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return;
+
+	// The audio thread own tempo-map reader...
+	qtractorTimeScale::Reader *pTimeReader = pAudioEngine->timeReader();
+	if (pTimeReader == NULL)
+		return;
+
+	const unsigned long iTimeStart = pTimeReader->tickFromFrame(iFrameStart);
+	const unsigned long iTimeEnd = pTimeReader->tickFromFrame(iFrameEnd);
+
+	const float fGain = clipGain();
+
+	// Notes must not outlast the loop, as when scheduled...
+	unsigned long iLoopEndTime = 0;
+	if (pSession->isLooping())
+		iLoopEndTime = pTimeReader->tickFromFrame(pSession->loopEnd());
+
+	// Pin whatever is the current playback snapshot (full barrier),
+	// as the output thread might be retiring it meanwhile...
+	ATOMIC_INC(&m_snapshotPins);
+
+	// Never off the sequence itself, which is not for the audio thread:
+	// while a rebuild is pending (eg. on some edit, tempo change or clip
+	// move), the previous snapshot keeps on playing, though relative to
+	// the current clip start, until the output thread hands a new one.
+	qtractorMidiSnapshot *pSnapshot = m_snapshotDirect.fetchAndAddOrdered(0);
+	if (pSnapshot == NULL) {
+		ATOMIC_DEC(&m_snapshotPins);
+		return;
+	}
+
+	snd_seq_event_t ev;
+	qtractorMidiEvent event(0, qtractorMidiEvent::NOTEON);
+
+	const unsigned long t0 = (pSnapshot->isCurrent(
+		pSeq, pSession->timeScale(), clipStart())
+		? pSnapshot->clipStartTime()
+		: pTimeReader->tickFromFrame(clipStart()));
+	const unsigned int iCount = pSnapshot->count();
+	unsigned int i = pSnapshot->seek(
+		iTimeStart > t0 ? iTimeStart - t0 : 0, m_iDirectIndex);
+	for ( ; i < iCount; ++i) {
+		const unsigned long t1 = t0 + pSnapshot->time(i);
 		if (t1 >= iTimeEnd)
 			break;
-		if (t1 >= iTimeStart
-			&& (!bMute || pEvent->type() != qtractorMidiEvent::NOTEON)) {
-			enqueue_export(pTrack, pEvent, t1, fGain
-				* fadeInOutGain(pSession->frameFromTick(t1) - clipStart()));
+		const unsigned long f1 = clipStart() + pSnapshot->frame(i);
+		qtractorMidiClipEvent(&ev, pTrack, pSnapshot->event(i, event),
+			fGain * fadeInOutGain(pSnapshot->frame(i)));
+		// Track properties override, as when scheduled...
+		switch (ev.type) {
+		case SND_SEQ_EVENT_NOTE:
+			if (t1 < iLoopEndTime
+				&& iLoopEndTime < t1 + ev.data.note.duration)
+				ev.data.note.duration = iLoopEndTime - t1;
+			break;
+		case SND_SEQ_EVENT_CONTROLLER:
+			switch (ev.data.control.param) {
+			case BANK_SELECT_MSB:
+				if (pTrack->midiBank() >= 0)
+					ev.data.control.value = (pTrack->midiBank() & 0x3f80) >> 7;
+				break;
+			case BANK_SELECT_LSB:
+				if (pTrack->midiBank() >= 0)
+					ev.data.control.value = (pTrack->midiBank() & 0x7f);
+				break;
+			case CHANNEL_VOLUME:
+				ev.data.control.value
+					= int(pTrack->gain() * float(ev.data.control.value)) & 0x7f;
+				break;
+			default:
+				break;
+			}
+			break;
+		case SND_SEQ_EVENT_PGMCHANGE:
+			if (pTrack->midiProg() >= 0)
+				ev.data.control.value = pTrack->midiProg();
+			break;
+		default:
+			break;
 		}
-		pEvent = pEvent->next();
+		// Frame offset, right into current period...
+		const unsigned long iTimeOn = iFrameTime
+			+ (f1 > iFrameStart ? f1 - iFrameStart : 0);
+		unsigned long iTimeOff = iTimeOn;
+		if (ev.type == SND_SEQ_EVENT_NOTE
+			&& ev.data.note.duration > 0) {
+			const unsigned long t2 = t1 + (ev.data.note.duration - 1);
+			iTimeOff += (pTimeReader->frameFromTick(t2) - f1);
+		}
+		pMidiManager->queued(&ev, iTimeOn, iTimeOff);
+	}
+	m_iDirectIndex = i;
+
+	ATOMIC_DEC(&m_snapshotPins);
+}
+
+
+// Current playback snapshot, if up-to-date (RT-safe).
+qtractorMidiSnapshot *qtractorMidiClip::snapshot ( qtractorSession *pSession )
+{
+	// Retire the previous snapshot, as soon as the audio thread
+	// is not into it and the one retired before is disposed of...
+	if (m_pSnapshotPrev && ATOMIC_GET(&m_snapshotPins) == 0
+		&& m_snapshotDone.testAndSetOrdered(NULL, m_pSnapshotPrev))
+		m_pSnapshotPrev = NULL;
+
+	// Take the newly posted snapshot, but only if
+	// the previous one has been retired already...
+	if (m_pSnapshotPrev == NULL) {
+		qtractorMidiSnapshot *pSnapshot = m_snapshotNext.fetchAndStoreOrdered(NULL);
+		if (pSnapshot) {
+			// Hand it over to the audio thread too (full barrier)...
+			m_snapshotDirect.fetchAndStoreOrdered(pSnapshot);
+			m_pSnapshotPrev = m_pSnapshot;
+			m_pSnapshot = pSnapshot;
+			m_iSnapshotIndex = 0;
+		}
+	}
+
+	if (m_pSnapshot && m_pSnapshot->isCurrent(
+			sequence(), pSession->timeScale(), clipStart()))
+		return m_pSnapshot;
+
+	// Otherwise, ask for a brand new one (once)...
+	if (ATOMIC_TAS(&m_snapshotSync)) {
+		qtractorMidiEngine *pMidiEngine = pSession->midiEngine();
+		if (pMidiEngine == NULL
+			|| !pMidiEngine->snapshotThread()->sync(this))
+			ATOMIC_SET(&m_snapshotSync, 0);
+	}
+
+	return NULL;
+}
+
+
+// Playback snapshot (re)build method (non RT-safe).
+void qtractorMidiClip::updateSnapshot (void)
+{
+	// Dispose of the one retired by the output thread...
+	qtractorMidiSnapshot *pSnapshot = m_snapshotDone.fetchAndStoreOrdered(NULL);
+	if (pSnapshot)
+		delete pSnapshot;
+
+	qtractorTrack *pTrack = track();
+	qtractorSession *pSession = (pTrack ? pTrack->session() : NULL);
+	qtractorMidiSequence *pSeq = sequence();
+
+	if (pSession && pSeq) {
+		// Our own private tempo-map reader...
+		qtractorTimeScale::Reader reader(pSession->timeScale());
+		pSnapshot = new qtractorMidiSnapshot(pSeq, reader, clipStart());
+		if (pSnapshot->isValid()) {
+			// Post it; whatever was still pending never got used...
+			pSnapshot = m_snapshotNext.fetchAndStoreOrdered(pSnapshot);
+		}
+		if (pSnapshot)
+			delete pSnapshot;
+	}
+
+	// Ready for another request...
+	ATOMIC_SET(&m_snapshotSync, 0);
+}
+
+
+// Withdraw any pending playback snapshot request (non RT-safe).
+void qtractorMidiClip::cancelSnapshot (void)
+{
+	qtractorSession *pSession = qtractorSession::getInstance();
+	if (pSession && pSession->midiEngine())
+		pSession->midiEngine()->snapshotThread()->cancel(this);
+
+	ATOMIC_SET(&m_snapshotSync, 0);
+}
+
+
+// Dispose of all playback snapshots (non RT-safe).
+void qtractorMidiClip::clearSnapshot (void)
+{
+	cancelSnapshot();
+
+	qtractorMidiSnapshot *pSnapshot = m_snapshotNext.fetchAndStoreOrdered(NULL);
+	if (pSnapshot)
+		delete pSnapshot;
+
+	pSnapshot = m_snapshotDone.fetchAndStoreOrdered(NULL);
+	if (pSnapshot)
+		delete pSnapshot;
+
+	m_snapshotDirect.fetchAndStoreOrdered(NULL);
+
+	if (m_pSnapshotPrev) {
+		delete m_pSnapshotPrev;
+		m_pSnapshotPrev = NULL;
+	}
+
+	if (m_pSnapshot) {
+		delete m_pSnapshot;
+		m_pSnapshot = NULL;
 	}
 }
 
@@ -1404,73 +1879,19 @@ bool qtractorMidiClip::clipExport (
 }
 
 
-// MIDI clip freewheeling event enqueue method (needed for export).
+// MIDI clip freewheeling event enqueue method (needed for export);
+// event on/off frames are given, as converted in batch by the caller.
 void qtractorMidiClip::enqueue_export ( qtractorTrack *pTrack,
-	qtractorMidiEvent *pEvent, unsigned long iTime, float fGain ) const
+	qtractorMidiEvent *pEvent, unsigned long iTime, float fGain,
+	unsigned long t1, unsigned long t2 ) const
 {
-	qtractorSession *pSession = pTrack->session();
-	if (pSession == NULL)
-		return;
-
 	snd_seq_event_t ev;
-	snd_seq_ev_clear(&ev);
+	qtractorMidiClipEvent(&ev, pTrack, pEvent, fGain);
 
 	snd_seq_ev_schedule_tick(&ev, 0, 0, iTime);
 
-	switch (pEvent->type()) {
-	case qtractorMidiEvent::NOTEON:
-		ev.type = SND_SEQ_EVENT_NOTE;
-		ev.data.note.channel  = pTrack->midiChannel();
-		ev.data.note.note     = pEvent->note();
-		ev.data.note.velocity = int(fGain * float(pEvent->value())) & 0x7f;
-		ev.data.note.duration = pEvent->duration();
-		break;
-	case qtractorMidiEvent::KEYPRESS:
-		ev.type = SND_SEQ_EVENT_KEYPRESS;
-		ev.data.note.channel  = pTrack->midiChannel();
-		ev.data.note.note     = pEvent->note();
-		ev.data.note.velocity = pEvent->velocity();
-		ev.data.note.duration = 0;
-		break;
-	case qtractorMidiEvent::CONTROLLER:
-		ev.type = SND_SEQ_EVENT_CONTROLLER;
-		ev.data.control.channel = pTrack->midiChannel();
-		ev.data.control.param   = pEvent->controller();
-		ev.data.control.value   = pEvent->value();
-		break;
-	case qtractorMidiEvent::PGMCHANGE:
-		ev.type = SND_SEQ_EVENT_PGMCHANGE;
-		ev.data.control.channel = pTrack->midiChannel();
-		ev.data.control.value   = pEvent->param();
-		break;
-	case qtractorMidiEvent::CHANPRESS:
-		ev.type = SND_SEQ_EVENT_CHANPRESS;
-		ev.data.control.channel = pTrack->midiChannel();
-		ev.data.control.value   = pEvent->value();
-		break;
-	case qtractorMidiEvent::PITCHBEND:
-		ev.type = SND_SEQ_EVENT_PITCHBEND;
-		ev.data.control.channel = pTrack->midiChannel();
-		ev.data.control.value   = pEvent->pitchBend();
-		break;
-	case qtractorMidiEvent::SYSEX:
-		ev.type = SND_SEQ_EVENT_SYSEX;
-		snd_seq_ev_set_sysex(&ev, pEvent->sysex_len(), pEvent->sysex());
-		break;
-	default:
-		break;
-	}
-
-	qtractorTimeScale::Cursor& cursor = pSession->timeScale()->cursor();
-	qtractorTimeScale::Node *pNode = cursor.seekTick(iTime);
-	const unsigned long t1 = pNode->frameFromTick(iTime);
-	unsigned long t2 = t1;
-	if (ev.type == SND_SEQ_EVENT_NOTE
-		&& ev.data.note.duration > 0) {
-		iTime += (ev.data.note.duration - 1);
-		pNode = cursor.seekTick(iTime);
-		t2 += (pNode->frameFromTick(iTime) - t1);
-	}
+	if (ev.type != SND_SEQ_EVENT_NOTE || t2 < t1)
+		t2 = t1;
 
 	// Do it for the MIDI track plugins...
 	qtractorMidiManager *pMidiManager
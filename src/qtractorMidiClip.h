@@ -25,6 +25,9 @@
 #include "qtractorClip.h"
 #include "qtractorMidiCursor.h"
 #include "qtractorMidiFile.h"
+#include "qtractorAtomic.h"
+
+#include <QAtomicPointer>
 
 #include <QPoint>
 #include <QSize>
@@ -32,6 +35,9 @@
 
 // Forward declartiuons.
 class qtractorMidiEditorForm;
+class qtractorMidiSnapshot;
+class qtractorMidiManager;
+class qtractorSession;
 
 
 //----------------------------------------------------------------------
@@ -77,6 +83,10 @@ public:
 	bool isSessionFlag() const
 		{ return m_bSessionFlag; }
 
+	// Pre-read track sequence, taken over on next open
+	// (eg. all tracks read in one go, on import).
+	void setImportSequence(qtractorMidiSequence *pSeq);
+
 	// Revisionist accessors.
 	void setRevision(unsigned short iRevision)
 		{ m_iRevision = iRevision; }
@@ -117,6 +127,15 @@ public:
 	// MIDI clip freewheeling process cycle executive (needed for export).
 	void process_export(unsigned long iFrameStart, unsigned long iFrameEnd);
 
+	// MIDI clip direct plugin delivery cycle executive (RT-safe);
+	// events are stamped in frame-time, relative to iFrameTime.
+	void process_direct(qtractorMidiManager *pMidiManager,
+		unsigned long iFrameStart, unsigned long iFrameEnd,
+		unsigned long iFrameTime);
+
+	// Playback snapshot (re)build method (non RT-safe).
+	void updateSnapshot();
+
 	// Clip paint method.
 	void draw(QPainter *pPainter,
 		const QRect& clipRect, unsigned long iClipOffset);
@@ -159,15 +178,43 @@ public:
 	public:
 
 		// Constructor.
-		Data() : m_pSeq(new qtractorMidiSequence()) {}
+		Data() : m_pSeq(new qtractorMidiSequence())
+			{ m_pPrevShared = m_pNextShared = this; }
+
+		// Copy-on-write constructor (shares the very same sequence).
+		Data(Data *pData) : m_pSeq(pData->m_pSeq)
+		{
+			m_pPrevShared = pData;
+			m_pNextShared = pData->m_pNextShared;
+			m_pNextShared->m_pPrevShared = this;
+			pData->m_pNextShared = this;
+		}
 
 		// Destructor.
-		~Data() { clear(); delete m_pSeq; }
+		~Data() { clear(); if (isShared()) unshare(); else delete m_pSeq; }
 
-		// Sequence accessor.
+		// Sequence accessors.
+		void setSequence(qtractorMidiSequence *pSeq)
+			{ m_pSeq = pSeq; }
 		qtractorMidiSequence *sequence() const
 			{ return m_pSeq; }
 
+		// Copy-on-write sharing methods.
+		bool isShared() const
+			{ return (m_pNextShared != this); }
+		Data *nextShared() const
+			{ return m_pNextShared; }
+
+		// Leave the shared ring, returning one of the remaining.
+		Data *unshare()
+		{
+			Data *pNextShared = m_pNextShared;
+			m_pPrevShared->m_pNextShared = m_pNextShared;
+			m_pNextShared->m_pPrevShared = m_pPrevShared;
+			m_pPrevShared = m_pNextShared = this;
+			return pNextShared;
+		}
+
 		// Sequence properties accessors.
 		unsigned short channel() const
 			{ return m_pSeq->channel(); }
@@ -202,6 +249,10 @@ public:
 
 		// Ref-counting related stuff.
 		QList<qtractorMidiClip *> m_clips;
+
+		// Copy-on-write shared ring.
+		Data *m_pPrevShared;
+		Data *m_pNextShared;
 	};
 
 	typedef QHash<Key, Data *> Hash;
@@ -227,6 +278,9 @@ public:
 	void unlinkHashData();
 	void relinkHashData();
 
+	// Copy-on-write local hash data (before any sequence change).
+	void detachHashData();
+
 	// Whether local hash is being shared.
 	bool isHashLinked() const;
 
@@ -260,8 +314,17 @@ protected:
 	void closeMidiFile();
 
 	// MIDI clip freewheeling event enqueue method (needed for export).
-	void enqueue_export(qtractorTrack *pTrack,
-		qtractorMidiEvent *pEvent, unsigned long iTime, float fGain) const;
+	void enqueue_export(qtractorTrack *pTrack, qtractorMidiEvent *pEvent,
+		unsigned long iTime, float fGain,
+		unsigned long t1, unsigned long t2) const;
+
+	// Current playback snapshot, if up-to-date (RT-safe);
+	// otherwise a brand new one gets requested, off-thread.
+	qtractorMidiSnapshot *snapshot(qtractorSession *pSession);
+
+	// Withdraw and dispose of playback snapshots (non RT-safe).
+	void cancelSnapshot();
+	void clearSnapshot();
 
 private:
 
@@ -272,6 +335,9 @@ private:
 	unsigned short m_iFormat;
 	bool           m_bSessionFlag;
 
+	// Pre-read track sequence (owned).
+	qtractorMidiSequence *m_pImportSeq;
+
 	// Revisionist count.
 	unsigned short m_iRevision;
 
@@ -289,6 +355,20 @@ private:
 	qtractorMidiCursor m_playCursor;
 	qtractorMidiCursor m_drawCursor;
 
+	// Playback snapshot (current, posted and retired).
+	qtractorMidiSnapshot *m_pSnapshot;
+	QAtomicPointer<qtractorMidiSnapshot> m_snapshotNext;
+	QAtomicPointer<qtractorMidiSnapshot> m_snapshotDone;
+	qtractorAtomic m_snapshotSync;
+	unsigned int m_iSnapshotIndex;
+
+	// Direct plugin delivery snapshot (audio thread), pinned
+	// while in use; the previous current one waits on it.
+	QAtomicPointer<qtractorMidiSnapshot> m_snapshotDirect;
+	qtractorAtomic m_snapshotPins;
+	qtractorMidiSnapshot *m_pSnapshotPrev;
+	unsigned int m_iDirectIndex;
+
 	// This clip editor form widget.
 	qtractorMidiEditorForm *m_pMidiEditorForm;
 
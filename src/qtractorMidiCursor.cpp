@@ -23,6 +23,10 @@
 #include "qtractorMidiSequence.h"
 
 
+// Maximum forward event walk, before looking up the time index.
+#define QTRACTOR_MIDI_CURSOR_HOPS	16
+
+
 //-------------------------------------------------------------------------
 // qtractorMidiCursor -- MIDI event cursor capsule.
 
@@ -43,22 +47,37 @@ qtractorMidiEvent *qtractorMidiCursor::seek (
 	}
 	else
 	if (iTime > m_iTime) {
-		// Seek forward...
+		// Seek forward (short hops are walked, long ones looked up)...
 		if (m_pEvent == NULL)
 			m_pEvent = pSeq->events().first();
+		int iHops = 0;
 		while (m_pEvent && m_pEvent->next()
-			&& (m_pEvent->next())->time() < iTime)
+			&& (m_pEvent->next())->time() < iTime) {
+			if (++iHops > QTRACTOR_MIDI_CURSOR_HOPS) {
+				qtractorMidiEvent *pEvent = pSeq->seekEvent(iTime);
+				if (pEvent) {
+					m_pEvent = pEvent;
+					break;
+				}
+				iHops = 0;
+			}
 			m_pEvent = m_pEvent->next();
+		}
 		if (m_pEvent == NULL)
 			m_pEvent = pSeq->events().last();
 	}
 	else
 	if (iTime < m_iTime) {
-		// Seek backward...
-		if (m_pEvent == NULL)
-			m_pEvent = pSeq->events().last();
-		while (m_pEvent && m_pEvent->time() >= iTime)
-			m_pEvent = m_pEvent->prev();
+		// Seek backward (looked up, unless index is busy)...
+		qtractorMidiEvent *pEvent = pSeq->seekEvent(iTime);
+		if (pEvent) {
+			m_pEvent = pEvent;
+		} else {
+			if (m_pEvent == NULL)
+				m_pEvent = pSeq->events().last();
+			while (m_pEvent && m_pEvent->time() >= iTime)
+				m_pEvent = m_pEvent->prev();
+		}
 		if (m_pEvent == NULL)
 			m_pEvent = pSeq->events().first();
 	}
@@ -23,6 +23,7 @@
 
 #include "qtractorMidiClip.h"
 #include "qtractorMidiEngine.h"
+#include "qtractorMidiSnapshot.h"
 
 #include "qtractorSession.h"
 
@@ -52,27 +53,29 @@ qtractorMidiEditCommand::~qtractorMidiEditCommand (void)
 
 	qDeleteAll(m_items);
 	m_items.clear();
+
+	m_events.clear();
 }
 
 
 // Primitive command methods.
 void qtractorMidiEditCommand::insertEvent ( qtractorMidiEvent *pEvent )
 {
-	m_items.append(new Item(InsertEvent, pEvent));
+	addItem(InsertEvent, pEvent);
 }
 
 
 void qtractorMidiEditCommand::moveEvent ( qtractorMidiEvent *pEvent,
 	int iNote, unsigned long iTime )
 {
-	m_items.append(new Item(MoveEvent, pEvent, iNote, iTime));
+	addItem(MoveEvent, pEvent, iNote, iTime);
 }
 
 
 void qtractorMidiEditCommand::resizeEventTime ( qtractorMidiEvent *pEvent,
 	unsigned long iTime, unsigned long iDuration )
 {
-	m_items.append(new Item(ResizeEventTime, pEvent, 0, iTime, iDuration));
+	addItem(ResizeEventTime, pEvent, 0, iTime, iDuration);
 }
 
 
@@ -82,13 +85,50 @@ void qtractorMidiEditCommand::resizeEventValue ( qtractorMidiEvent *pEvent,
 	if (pEvent->type() == qtractorMidiEvent::NOTEON && iValue < 1)
 		iValue = 1;	// Avoid zero velocity (aka. NOTEOFF)
 
-	m_items.append(new Item(ResizeEventValue, pEvent, 0, 0, 0, iValue));
+	addItem(ResizeEventValue, pEvent, 0, 0, 0, iValue);
 }
 
 
 void qtractorMidiEditCommand::removeEvent ( qtractorMidiEvent *pEvent )
 {
-	m_items.append(new Item(RemoveEvent, pEvent));
+	addItem(RemoveEvent, pEvent);
+}
+
+
+// Compound command method.
+void qtractorMidiEditCommand::updateEvent ( qtractorMidiEvent *pEvent,
+	int iNote, unsigned long iTime, unsigned long iDuration,
+	int iValue, unsigned int iFlags )
+{
+	if ((iFlags & UpdateValue)
+		&& pEvent->type() == qtractorMidiEvent::NOTEON && iValue < 1)
+		iValue = 1;	// Avoid zero velocity (aka. NOTEOFF)
+
+	addItem(UpdateEvent, pEvent, iNote, iTime, iDuration, iValue, iFlags);
+}
+
+
+// Append a command item, keeping track of its event.
+void qtractorMidiEditCommand::addItem ( CommandType cmd,
+	qtractorMidiEvent *pEvent, int iNote, unsigned long iTime,
+	unsigned long iDuration, int iValue, unsigned int iFlags )
+{
+	m_items.append(new Item(cmd, pEvent,
+		iNote, iTime, iDuration, iValue, iFlags));
+
+	// Compound items stand for whatever primitives they restore...
+	unsigned int mask = (1 << cmd);
+	if (cmd == UpdateEvent) {
+		if (iFlags & UpdateTime) {
+			mask |= (1 << ResizeEventTime);
+			if (iFlags & UpdateNote)
+				mask |= (1 << MoveEvent);
+		}
+		if (iFlags & UpdateValue)
+			mask |= (1 << ResizeEventValue);
+	}
+
+	m_events[pEvent] |= mask;
 }
 
 
@@ -96,14 +136,8 @@ void qtractorMidiEditCommand::removeEvent ( qtractorMidiEvent *pEvent )
 bool qtractorMidiEditCommand::findEvent ( qtractorMidiEvent *pEvent,
 	qtractorMidiEditCommand::CommandType cmd ) const
 {
-	QListIterator<Item *> iter(m_items);
-	while (iter.hasNext()) {
-		Item *pItem = iter.next();
-		if (pItem->event == pEvent
-			&& (pItem->command == InsertEvent || pItem->command == cmd))
-			return true;
-	}
-	return false;
+	const unsigned int mask = m_events.value(pEvent, 0);
+	return (mask & ((1 << InsertEvent) | (1 << cmd))) != 0;
 }
 
 
@@ -113,6 +147,9 @@ bool qtractorMidiEditCommand::execute ( bool bRedo )
 	if (m_pMidiClip == NULL)
 		return false;
 
+	// Copy-on-write, if still sharing...
+	m_pMidiClip->detachHashData();
+
 	qtractorMidiSequence *pSeq = m_pMidiClip->sequence();
 	if (pSeq == NULL)
 		return false;
@@ -126,6 +163,13 @@ bool qtractorMidiEditCommand::execute ( bool bRedo )
 	if (pSession && pSession->isPlaying())
 		pSession->midiEngine()->trackMute(pTrack, true);
 #endif
+	// No playback snapshot gets built while we're at it...
+	qtractorMidiSnapshotThread *pSnapshotThread = NULL;
+	if (pSession && pSession->midiEngine())
+		pSnapshotThread = pSession->midiEngine()->snapshotThread();
+	if (pSnapshotThread)
+		pSnapshotThread->lockEdit();
+
 	// Track sequence duration changes...
 	const unsigned long iOldDuration = pSeq->duration();
 	int iSelectClear = 0;
@@ -183,6 +227,37 @@ bool qtractorMidiEditCommand::execute ( bool bRedo )
 			pItem->value = iOldValue;
 			break;
 		}
+		case UpdateEvent: {
+			const int iOldNote = int(pEvent->note());
+			const unsigned long iOldTime = pEvent->time();
+			const unsigned long iOldDuration = pEvent->duration();
+			if (pItem->flags & (UpdateNote | UpdateTime)) {
+				pSeq->unlinkEvent(pEvent);
+				if (pItem->flags & UpdateNote)
+					pEvent->setNote(pItem->note);
+				if (pItem->flags & UpdateTime) {
+					pEvent->setTime(pItem->time);
+					if (pEvent->type() == qtractorMidiEvent::NOTEON)
+						pEvent->setDuration(pItem->duration);
+				}
+				pSeq->insertEvent(pEvent);
+			}
+			if (pItem->flags & UpdateValue) {
+				int iOldValue;
+				if (pEvent->type() == qtractorMidiEvent::PITCHBEND) {
+					iOldValue = pEvent->pitchBend();
+					pEvent->setPitchBend(pItem->value);
+				} else {
+					iOldValue = pEvent->value();
+					pEvent->setValue(pItem->value);
+				}
+				pItem->value = iOldValue;
+			}
+			pItem->note = iOldNote;
+			pItem->time = iOldTime;
+			pItem->duration = iOldDuration;
+			break;
+		}
 		case RemoveEvent: {
 			if (bRedo)
 				pSeq->unlinkEvent(pEvent);
@@ -209,6 +284,12 @@ bool qtractorMidiEditCommand::execute ( bool bRedo )
 	// Adjust edit-command result to prevent event overlapping.
 	if (bRedo && !m_bAdjusted) m_bAdjusted = adjust();
 
+	// Some events might have been changed in place...
+	pSeq->touch();
+
+	if (pSnapshotThread)
+		pSnapshotThread->unlockEdit();
+
 	// Or are we changing something more durable?
 	if (pSeq->duration() != iOldDuration) {
 		pSeq->setTimeLength(pSeq->duration());
@@ -242,6 +323,9 @@ bool qtractorMidiEditCommand::adjust (void)
 	if (m_pMidiClip == NULL)
 		return false;
 
+	// Copy-on-write, if still sharing...
+	m_pMidiClip->detachHashData();
+
 	qtractorMidiSequence *pSeq = m_pMidiClip->sequence();
 	if (pSeq == NULL)
 		return false;
@@ -27,6 +27,7 @@
 #include "qtractorMidiEvent.h"
 
 #include <QList>
+#include <QHash>
 
 
 // Forward declarations.
@@ -56,9 +57,17 @@ public:
 		MoveEvent,
 		ResizeEventTime,
 		ResizeEventValue,
-		RemoveEvent
+		RemoveEvent,
+		UpdateEvent
 	};
-	
+
+	// Compound (update) command flags.
+	enum UpdateFlag {
+		UpdateNote  = 1,
+		UpdateTime  = 2,
+		UpdateValue = 4
+	};
+
 	// Primitive command methods.
 	void insertEvent(qtractorMidiEvent *pEvent);
 	void moveEvent(qtractorMidiEvent *pEvent,
@@ -68,6 +77,12 @@ public:
 	void resizeEventValue(qtractorMidiEvent *pEvent, int iValue);
 	void removeEvent(qtractorMidiEvent *pEvent);
 
+	// Compound command method: one single record per event
+	// for any note, time/duration and value change (see flags).
+	void updateEvent(qtractorMidiEvent *pEvent, int iNote,
+		unsigned long iTime, unsigned long iDuration,
+		int iValue, unsigned int iFlags);
+
 	// Check whether the event is already in chain.
 	bool findEvent(qtractorMidiEvent *pEvent, CommandType cmd) const;
 
@@ -83,6 +98,12 @@ protected:
 	// Common executive method.
 	bool execute(bool bRedo);
 
+	// Append a command item, keeping track of its event.
+	void addItem(CommandType cmd, qtractorMidiEvent *pEvent,
+		int iNote = 0, unsigned long iTime = 0,
+		unsigned long iDuration = 0, int iValue = 0,
+		unsigned int iFlags = 0);
+
 private:
 
 	// Event item struct.
@@ -91,10 +112,10 @@ private:
 		// Item constructor.
 		Item(CommandType cmd, qtractorMidiEvent *pEvent, int iNote = 0,
 			unsigned long iTime = 0, unsigned long iDuration = 0,
-			unsigned int iValue = 0)
+			unsigned int iValue = 0, unsigned int iFlags = 0)
 			: command(cmd), event(pEvent), note(iNote),
 				time(iTime), duration(iDuration), value(iValue),
-				autoDelete(false) {}
+				flags(iFlags), autoDelete(false) {}
 		// Item members.
 		CommandType        command;
 		qtractorMidiEvent *event;
@@ -102,6 +123,7 @@ private:
 		unsigned long      time;
 		unsigned long      duration;
 		int                value;
+		unsigned int       flags;
 		bool               autoDelete;
 	};
 
@@ -110,6 +132,9 @@ private:
 
 	QList<Item *> m_items;
 
+	// Command types already in chain, per event (bitmask).
+	QHash<qtractorMidiEvent *, unsigned int> m_events;
+
 	bool m_bAdjusted;
 
 	unsigned long m_iDuration;
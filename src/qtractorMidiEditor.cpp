@@ -2465,8 +2465,10 @@ void qtractorMidiEditor::clear (void)
 
 	m_pCommands->clear();
 
-	if (m_pMidiClip)
+	if (m_pMidiClip) {
+		m_pMidiClip->detachHashData();
 		m_pMidiClip->sequence()->clear();
+	}
 
 	reset(true);
 }
@@ -33,7 +33,9 @@
 
 #include "qtractorMidiSequence.h"
 #include "qtractorMidiClip.h"
+#include "qtractorMidiSnapshot.h"
 #include "qtractorMidiManager.h"
+#include "qtractorMidiJackPort.h"
 #include "qtractorMidiControl.h"
 #include "qtractorMidiTimer.h"
 #include "qtractorMidiSysex.h"
@@ -55,8 +57,10 @@
 #include <QSocketNotifier>
 
 #include <QTime>
+#include <QElapsedTimer>
 
 #include <math.h>
+#include <string.h>
 
 
 // Specific controller definitions
@@ -78,6 +82,10 @@
 #define DRIFT_CHECK_MAX     (DRIFT_CHECK << 1)
 
 
+// Adaptive read-ahead: clean cycles before shrinking.
+#define READ_AHEAD_CLEAN    32
+
+
 //----------------------------------------------------------------------
 // class qtractorMidiInputRpn -- MIDI RPN/NRPN input parser (singleton).
 //
@@ -129,6 +137,84 @@ private:
 };
 
 
+//----------------------------------------------------------------------
+// class qtractorMidiOutputStage -- MIDI output staging buffer.
+//
+// Scheduled events are staged here during an output cycle, then get
+// sorted, redundant same-tick controller values coalesced, and handed
+// over to the ALSA sequencer in one single batch; owned by the MIDI
+// output thread only, thus no locking whatsoever.
+//
+
+class qtractorMidiOutputStage
+{
+public:
+
+	// Constructor.
+	qtractorMidiOutputStage(unsigned int iBufferSize = 0x400);
+
+	// Destructor.
+	~qtractorMidiOutputStage();
+
+	// Stage a scheduled event (SysEx payload gets copied).
+	void push(const snd_seq_event_t *pEv);
+
+	// Output all staged events and drain (one batch);
+	// returns the number of events coalesced away.
+	unsigned int flush(snd_seq_t *pAlsaSeq);
+
+	// Drop all staged events.
+	void clear();
+
+	// ALSA sequencer output/drain calls, since last taken.
+	void takeCalls(unsigned int& iOutputs, unsigned int& iDrains);
+
+	// Whether there's nothing staged.
+	bool isEmpty() const
+		{ return (m_iCount == 0); }
+
+protected:
+
+	// Staged event item.
+	struct Item
+	{
+		snd_seq_event_t ev;
+		unsigned int    index;	// staging order
+		int             sysex;	// payload offset (-1 if none)
+	};
+
+	// Sort predicate (by tick, then staging order).
+	static bool lessThan(const Item& item1, const Item& item2);
+
+	// Coalescing predicates.
+	static bool isCoalescing(const snd_seq_event_t *pEv);
+	static bool isSameTarget(
+		const snd_seq_event_t *pEv1, const snd_seq_event_t *pEv2);
+	static bool isBarrier(
+		const snd_seq_event_t *pEv1, const snd_seq_event_t *pEv2);
+
+	// Drop redundant same-tick events, keeping the last one.
+	unsigned int coalesce();
+
+private:
+
+	// Instance variables.
+	Item        *m_pItems;
+	unsigned int m_iItems;
+	unsigned int m_iCount;
+	bool         m_bSorted;
+
+	// SysEx payload arena.
+	unsigned char *m_pSysex;
+	unsigned int   m_iSysex;
+	unsigned int   m_iSysexCount;
+
+	// ALSA sequencer calls tally.
+	unsigned int m_iOutputs;
+	unsigned int m_iDrains;
+};
+
+
 //----------------------------------------------------------------------
 // class qtractorMidiOutputThread -- MIDI output thread (singleton).
 //
@@ -152,6 +238,14 @@ public:
 	void setReadAhead(unsigned int iReadAhead);
 	unsigned int readAhead() const;
 
+	// Adaptive read-ahead mode.
+	void setReadAheadAuto(bool bReadAheadAuto);
+	bool isReadAheadAuto() const;
+
+	// Output cycle statistics.
+	void stats(qtractorMidiEngine::OutputStats& stats);
+	void resetStats();
+
 	// MIDI/Audio sync-check predicate.
 	qtractorSessionCursor *midiCursorSync(bool bStart = false);
 
@@ -170,6 +264,9 @@ public:
 	// Wake from executive wait condition.
 	void sync();
 
+	// Stage a scheduled event for output.
+	void stage(const snd_seq_event_t *pEv);
+
 protected:
 
 	// The main thread executive.
@@ -178,13 +275,35 @@ protected:
 	// MIDI output process cycle iteration.
 	void process();
 
+	// Output staged events in one batch and drain.
+	void drain();
+
+	// Adapt read-ahead and publish cycle statistics.
+	void update(unsigned int iReadAhead,
+		unsigned long iFrame, long iHeadroom, unsigned int iUsecs);
+
 private:
 
 	// The thread launcher engine.
 	qtractorMidiEngine *m_pMidiEngine;
 
-	// The number of frames to read-ahead.
-	unsigned int m_iReadAhead;
+	// The number of frames to read-ahead
+	// (adapted by the thread, set by others).
+	qtractorAtomic m_iReadAhead;
+
+	// Adaptive read-ahead bounds and state.
+	bool         m_bReadAheadAuto;
+	unsigned int m_iReadAheadMin;
+	unsigned int m_iReadAheadMax;
+	unsigned int m_iReadAheadClean;
+
+	// Output cycle statistics.
+	qtractorMidiEngine::OutputStats m_stats;
+	QMutex m_statsMutex;
+
+	// Output staging buffer.
+	qtractorMidiOutputStage m_stage;
+	unsigned int m_iCoalesced;
 
 	// Whether the thread is logically running.
 	bool m_bRunState;
@@ -446,6 +565,254 @@ void qtractorMidiInputThread::run (void)
 }
 
 
+//----------------------------------------------------------------------
+// class qtractorMidiOutputStage -- MIDI output staging buffer.
+//
+
+// Constructor.
+qtractorMidiOutputStage::qtractorMidiOutputStage ( unsigned int iBufferSize )
+	: m_pItems(NULL), m_iItems(iBufferSize), m_iCount(0), m_bSorted(true),
+		m_pSysex(NULL), m_iSysex(iBufferSize << 2), m_iSysexCount(0),
+		m_iOutputs(0), m_iDrains(0)
+{
+	m_pItems = new Item [m_iItems];
+	m_pSysex = new unsigned char [m_iSysex];
+}
+
+
+// Destructor.
+qtractorMidiOutputStage::~qtractorMidiOutputStage (void)
+{
+	delete [] m_pSysex;
+	delete [] m_pItems;
+}
+
+
+// Stage a scheduled event (SysEx payload gets copied).
+void qtractorMidiOutputStage::push ( const snd_seq_event_t *pEv )
+{
+	// Grow as needed (hardly ever, after a while)...
+	if (m_iCount >= m_iItems) {
+		const unsigned int iItems = (m_iItems << 1);
+		Item *pItems = new Item [iItems];
+		::memcpy(pItems, m_pItems, m_iCount * sizeof(Item));
+		delete [] m_pItems;
+		m_pItems = pItems;
+		m_iItems = iItems;
+	}
+
+	Item& item = m_pItems[m_iCount];
+	item.ev    = *pEv;
+	item.index = m_iCount;
+	item.sysex = -1;
+
+	// Payload may not outlive this very cycle (eg. snapshots)...
+	if (pEv->type == SND_SEQ_EVENT_SYSEX) {
+		const unsigned int iSysex = pEv->data.ext.len;
+		if (m_iSysexCount + iSysex > m_iSysex) {
+			unsigned int iSysexSize = (m_iSysex << 1);
+			while (iSysexSize < m_iSysexCount + iSysex)
+				iSysexSize <<= 1;
+			unsigned char *pSysex = new unsigned char [iSysexSize];
+			::memcpy(pSysex, m_pSysex, m_iSysexCount);
+			delete [] m_pSysex;
+			m_pSysex = pSysex;
+			m_iSysex = iSysexSize;
+		}
+		::memcpy(m_pSysex + m_iSysexCount, pEv->data.ext.ptr, iSysex);
+		item.sysex = int(m_iSysexCount);
+		item.ev.data.ext.ptr = NULL;
+		m_iSysexCount += iSysex;
+	}
+
+	// Most often, already staged in order...
+	if (m_bSorted && m_iCount > 0
+		&& m_pItems[m_iCount - 1].ev.time.tick > pEv->time.tick)
+		m_bSorted = false;
+
+	++m_iCount;
+}
+
+
+// Output all staged events and drain (one batch).
+unsigned int qtractorMidiOutputStage::flush ( snd_seq_t *pAlsaSeq )
+{
+	unsigned int iCoalesced = 0;
+
+	if (m_iCount > 0) {
+		// Sort and coalesce...
+		if (!m_bSorted)
+			qSort(m_pItems, m_pItems + m_iCount, lessThan);
+		iCoalesced = coalesce();
+		// Make sure the whole batch fits in the output buffer,
+		// otherwise it would get drained on its own, many times...
+		const size_t iOutput = snd_seq_get_output_buffer_size(pAlsaSeq);
+		const size_t iNeeded = snd_seq_event_output_pending(pAlsaSeq)
+			+ (m_iCount - iCoalesced) * sizeof(snd_seq_event_t) + m_iSysexCount;
+		if (iNeeded > iOutput) {
+			size_t iOutputSize = (iOutput > 0 ? iOutput : 0x4000);
+			while (iOutputSize < iNeeded)
+				iOutputSize <<= 1;
+			// Resizing drops anything pending...
+			snd_seq_drain_output(pAlsaSeq);
+			snd_seq_set_output_buffer_size(pAlsaSeq, iOutputSize);
+			++m_iDrains;
+		}
+		// Pump it all into the queue...
+		for (unsigned int i = 0; i < m_iCount; ++i) {
+			Item& item = m_pItems[i];
+			if (item.ev.type == SND_SEQ_EVENT_NONE)
+				continue;
+			if (item.sysex >= 0)
+				item.ev.data.ext.ptr = m_pSysex + item.sysex;
+			snd_seq_event_output(pAlsaSeq, &item.ev);
+			++m_iOutputs;
+		}
+	}
+
+	// Flush the whole lot, at once.
+	snd_seq_drain_output(pAlsaSeq);
+	++m_iDrains;
+
+	clear();
+
+	return iCoalesced;
+}
+
+
+// Drop all staged events.
+void qtractorMidiOutputStage::clear (void)
+{
+	m_iCount = 0;
+	m_iSysexCount = 0;
+	m_bSorted = true;
+}
+
+
+// ALSA sequencer output/drain calls, since last taken.
+void qtractorMidiOutputStage::takeCalls (
+	unsigned int& iOutputs, unsigned int& iDrains )
+{
+	iOutputs = m_iOutputs;
+	iDrains  = m_iDrains;
+
+	m_iOutputs = 0;
+	m_iDrains  = 0;
+}
+
+
+// Sort predicate (by tick, then staging order).
+bool qtractorMidiOutputStage::lessThan (
+	const Item& item1, const Item& item2 )
+{
+	if (item1.ev.time.tick == item2.ev.time.tick)
+		return (item1.index < item2.index);
+	else
+		return (item1.ev.time.tick < item2.ev.time.tick);
+}
+
+
+// Whether a later value on the very same tick supersedes it.
+bool qtractorMidiOutputStage::isCoalescing ( const snd_seq_event_t *pEv )
+{
+	switch (pEv->type) {
+	case SND_SEQ_EVENT_CONTROLLER:
+		// (N)RPN selection and data entry are stateful,
+		// switches and channel mode messages are actions...
+		switch (pEv->data.control.param) {
+		case 0x06: case 0x26:	// DATA_ENTRY_MSB/LSB
+		case 0x60: case 0x61:	// DATA_INCREMENT/DECREMENT
+		case 0x62: case 0x63:	// NRPN_LSB/MSB
+		case 0x64: case 0x65:	// RPN_LSB/MSB
+			return false;
+		default:
+			// SUSTAIN..HOLD_2 (64-69), ALL_SOUND_OFF..POLY_MODE_ON (120-127).
+			return (pEv->data.control.param < 0x40
+				|| (pEv->data.control.param > 0x45
+					&& pEv->data.control.param < 0x78));
+		}
+	case SND_SEQ_EVENT_CONTROL14:
+	case SND_SEQ_EVENT_REGPARAM:
+	case SND_SEQ_EVENT_NONREGPARAM:
+	case SND_SEQ_EVENT_KEYPRESS:
+	case SND_SEQ_EVENT_PGMCHANGE:
+	case SND_SEQ_EVENT_CHANPRESS:
+	case SND_SEQ_EVENT_PITCHBEND:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+// Whether both events target the very same value.
+bool qtractorMidiOutputStage::isSameTarget (
+	const snd_seq_event_t *pEv1, const snd_seq_event_t *pEv2 )
+{
+	if (pEv1->type != pEv2->type
+		|| pEv1->tag != pEv2->tag
+		|| pEv1->source.port != pEv2->source.port
+		|| pEv1->dest.client != pEv2->dest.client
+		|| pEv1->dest.port != pEv2->dest.port
+		|| pEv1->data.control.channel != pEv2->data.control.channel)
+		return false;
+
+	switch (pEv1->type) {
+	case SND_SEQ_EVENT_CONTROLLER:
+	case SND_SEQ_EVENT_CONTROL14:
+	case SND_SEQ_EVENT_REGPARAM:
+	case SND_SEQ_EVENT_NONREGPARAM:
+		return (pEv1->data.control.param == pEv2->data.control.param);
+	case SND_SEQ_EVENT_KEYPRESS:
+		return (pEv1->data.note.note == pEv2->data.note.note);
+	default:
+		return true;
+	}
+}
+
+
+// Whether a later event must still see the earlier value
+// (eg. notes, SysEx or (N)RPN data entry in between).
+bool qtractorMidiOutputStage::isBarrier (
+	const snd_seq_event_t *pEv1, const snd_seq_event_t *pEv2 )
+{
+	if (pEv2->source.port != pEv1->source.port || isCoalescing(pEv2))
+		return false;
+
+	if (pEv2->type == SND_SEQ_EVENT_SYSEX)
+		return true;
+
+	return (snd_seq_ev_is_channel_type(pEv2)
+		&& pEv2->data.control.channel == pEv1->data.control.channel);
+}
+
+
+// Drop redundant same-tick events, keeping the last one.
+unsigned int qtractorMidiOutputStage::coalesce (void)
+{
+	unsigned int iCoalesced = 0;
+
+	for (unsigned int i = 0; i < m_iCount; ++i) {
+		snd_seq_event_t *pEv1 = &m_pItems[i].ev;
+		if (!isCoalescing(pEv1))
+			continue;
+		for (unsigned int j = i + 1; j < m_iCount; ++j) {
+			const snd_seq_event_t *pEv2 = &m_pItems[j].ev;
+			if (pEv2->time.tick != pEv1->time.tick
+				|| isBarrier(pEv1, pEv2))
+				break;
+			if (isSameTarget(pEv1, pEv2)) {
+				pEv1->type = SND_SEQ_EVENT_NONE;
+				++iCoalesced;
+				break;
+			}
+		}
+	}
+
+	return iCoalesced;
+}
+
+
 //----------------------------------------------------------------------
 // class qtractorMidiOutputThread -- MIDI output thread (singleton).
 //
@@ -456,7 +823,19 @@ qtractorMidiOutputThread::qtractorMidiOutputThread (
 {
 	m_pMidiEngine = pMidiEngine;
 	m_bRunState   = false;
-	m_iReadAhead  = iReadAhead;
+
+	ATOMIC_SET(&m_iReadAhead, iReadAhead);
+
+	// The given read-ahead is also the ceiling;
+	// the floor is some reasonable fraction of it...
+	m_bReadAheadAuto  = true;
+	m_iReadAheadMin   = (iReadAhead >> 5);
+	m_iReadAheadMax   = iReadAhead;
+	m_iReadAheadClean = 0;
+
+	m_stats.readAhead = iReadAhead;
+
+	m_iCoalesced = 0;
 }
 
 
@@ -492,12 +871,49 @@ void qtractorMidiOutputThread::setReadAhead ( unsigned int iReadAhead )
 {
 	QMutexLocker locker(&m_mutex);
 
-	m_iReadAhead = iReadAhead;
+	m_iReadAheadMin = (iReadAhead >> 5);
+	m_iReadAheadMax = iReadAhead;
+
+	ATOMIC_SET(&m_iReadAhead, iReadAhead);
 }
 
 unsigned int qtractorMidiOutputThread::readAhead (void) const
 {
-	return m_iReadAhead;
+	return (unsigned int) ATOMIC_GET(&m_iReadAhead);
+}
+
+
+// Adaptive read-ahead mode.
+void qtractorMidiOutputThread::setReadAheadAuto ( bool bReadAheadAuto )
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_bReadAheadAuto = bReadAheadAuto;
+
+	if (!m_bReadAheadAuto)
+		ATOMIC_SET(&m_iReadAhead, m_iReadAheadMax);
+}
+
+bool qtractorMidiOutputThread::isReadAheadAuto (void) const
+{
+	return m_bReadAheadAuto;
+}
+
+
+// Output cycle statistics.
+void qtractorMidiOutputThread::stats ( qtractorMidiEngine::OutputStats& stats )
+{
+	QMutexLocker locker(&m_statsMutex);
+
+	stats = m_stats;
+}
+
+void qtractorMidiOutputThread::resetStats (void)
+{
+	QMutexLocker locker(&m_statsMutex);
+
+	m_stats = qtractorMidiEngine::OutputStats();
+	m_stats.readAhead = readAhead();
 }
 
 
@@ -521,7 +937,7 @@ qtractorSessionCursor *qtractorMidiOutputThread::midiCursorSync ( bool bStart )
 	//	pMidiCursor->setFrameTime(pAudioCursor->frameTime());
 	}
 	else // No, it cannot be behind more than the read-ahead period...
-	if (pMidiCursor->frameTime() > pAudioCursor->frameTime() + m_iReadAhead)
+	if (pMidiCursor->frameTime() > pAudioCursor->frameTime() + readAhead())
 		return NULL;
 
 	// Nope. OK.
@@ -573,12 +989,25 @@ void qtractorMidiOutputThread::process (void)
 	if (pMidiCursor == NULL)
 		return;
 
+	// Cycle telemetry: how far ahead of audio we've been waken...
+	QElapsedTimer timer;
+	timer.start();
+
+	const unsigned long iFrameTime
+		= pSession->audioEngine()->sessionCursor()->frameTime();
+	const long iHeadroom = long(pMidiCursor->frameTime()) - long(iFrameTime);
+
+	m_pMidiEngine->resetEnqueueTally(iFrameTime);
+
 	// Free overriden SysEx queued events.
 	m_pMidiEngine->clearSysexCache();
 
+	// The read-ahead window size might change on our way out...
+	const unsigned int iReadAhead = readAhead();
+
 	// Now for the next readahead bunch...
 	unsigned long iFrameStart = pMidiCursor->frame();
-	unsigned long iFrameEnd   = iFrameStart + m_iReadAhead;
+	unsigned long iFrameEnd   = iFrameStart + iReadAhead;
 
 #ifdef CONFIG_DEBUG_0
 	qDebug("qtractorMidiOutputThread[%p]::process(%lu, %lu)",
@@ -615,14 +1044,116 @@ void qtractorMidiOutputThread::process (void)
 
 	// Sync to the next bunch, also critical for Audio-MIDI sync...
 	pMidiCursor->seek(iFrameEnd);
-	pMidiCursor->process(m_iReadAhead);
+	pMidiCursor->process(iReadAhead);
 
 	// Flush the MIDI engine output queue...
-	snd_seq_drain_output(m_pMidiEngine->alsaSeq());
+	drain();
 
 	// Always do the queue drift stats
 	// at the bottom of the pack...
 	m_pMidiEngine->driftCheck();
+
+	// Adapt the read-ahead window, for the next bunch...
+	update(iReadAhead, iFrameEnd, iHeadroom,
+		(unsigned int) (timer.nsecsElapsed() / 1000));
+}
+
+
+// Adapt read-ahead and publish cycle statistics.
+void qtractorMidiOutputThread::update ( unsigned int iReadAhead,
+	unsigned long iFrame, long iHeadroom, unsigned int iUsecs )
+{
+	qtractorSession *pSession = m_pMidiEngine->session();
+	qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+
+	const unsigned int iEvents = m_pMidiEngine->enqueueCount();
+	const unsigned int iLate   = m_pMidiEngine->enqueueLate();
+	const long iTimeDrift      = m_pMidiEngine->timeDrift();
+	const unsigned int iCoalesced = m_iCoalesced;
+
+	m_iCoalesced = 0;
+
+	// ALSA sequencer calls: staged batch, plus tempo/metronome/clock...
+	unsigned int iOutputs = 0;
+	unsigned int iDrains  = 0;
+	m_stage.takeCalls(iOutputs, iDrains);
+	iOutputs += m_pMidiEngine->enqueueOutputs();
+
+	// The very first cycle (on start) is never ahead of audio...
+	const bool bFirst = (m_stats.cycles == 0);
+
+	if (m_bReadAheadAuto && !bFirst) {
+		const unsigned int iPeriod = pAudioEngine->bufferSize();
+		// Floor: a few periods, twice the queue drift
+		// and the time spent, whichever's greater...
+		unsigned int iReadAheadMin = m_iReadAheadMin;
+		if (iReadAheadMin < (iPeriod << 2))
+			iReadAheadMin = (iPeriod << 2);
+		qtractorTimeScale::Reader *pTimeReader = m_pMidiEngine->timeReader();
+		if (iTimeDrift && pTimeReader) {
+			const unsigned long iTime = pTimeReader->tickFromFrame(iFrame);
+			const unsigned long iDrift
+				= (iTimeDrift < 0 ? -iTimeDrift : iTimeDrift);
+			const unsigned long iDriftFrames
+				= pTimeReader->frameFromTick(iTime + iDrift) - iFrame;
+			if (iReadAheadMin < (iDriftFrames << 1))
+				iReadAheadMin = (iDriftFrames << 1);
+		}
+		const unsigned long iUsecFrames
+			= (unsigned long) (iUsecs) * pAudioEngine->sampleRate() / 1000000;
+		if (iReadAheadMin < (iUsecFrames << 1))
+			iReadAheadMin = (iUsecFrames << 1);
+		// Grow fast on any lateness, shrink slowly otherwise...
+		unsigned int iReadAheadNext = iReadAhead;
+		if (iLate > 0 || iHeadroom < long(iPeriod << 1)) {
+			iReadAheadNext = (iReadAhead << 1);
+			m_iReadAheadClean = 0;
+		}
+		else
+		if (++m_iReadAheadClean >= READ_AHEAD_CLEAN) {
+			iReadAheadNext = iReadAhead - (iReadAhead >> 3);
+			m_iReadAheadClean = 0;
+		}
+		if (iReadAheadNext < iReadAheadMin)
+			iReadAheadNext = iReadAheadMin;
+		if (iReadAheadNext > m_iReadAheadMax)
+			iReadAheadNext = m_iReadAheadMax;
+		ATOMIC_SET(&m_iReadAhead, iReadAheadNext);
+	}
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorMidiOutputThread[%p]::update(): read-ahead=%u (%u)"
+		" events=%u late=%u coalesced=%u outputs=%u drains=%u"
+		" headroom=%ld drift=%ld usecs=%u", this, iReadAhead, readAhead(),
+		iEvents, iLate, iCoalesced, iOutputs, iDrains,
+		iHeadroom, iTimeDrift, iUsecs);
+#endif
+
+	// Publish...
+	QMutexLocker locker(&m_statsMutex);
+
+	m_stats.readAhead = readAhead();
+	m_stats.events    = iEvents;
+	m_stats.late      = iLate;
+	m_stats.coalesced = iCoalesced;
+	m_stats.outputs   = iOutputs;
+	m_stats.drains    = iDrains;
+	m_stats.headroom  = iHeadroom;
+	m_stats.drift     = iTimeDrift;
+	m_stats.usecs     = iUsecs;
+
+	m_stats.eventsTotal += iEvents;
+	m_stats.lateTotal   += iLate;
+	m_stats.coalescedTotal += iCoalesced;
+	m_stats.outputsTotal += iOutputs;
+	m_stats.drainsTotal  += iDrains;
+	m_stats.usecsTotal   += iUsecs;
+	if (!bFirst && (m_stats.cycles == 1 || m_stats.headroomMin > iHeadroom))
+		m_stats.headroomMin = iHeadroom;
+	if (m_stats.usecsMax < iUsecs)
+		m_stats.usecsMax = iUsecs;
+
+	++m_stats.cycles;
 }
 
 
@@ -644,7 +1175,7 @@ void qtractorMidiOutputThread::flushSync (void)
 #ifdef CONFIG_DEBUG_0
 	qDebug("qtractorMidiOutputThread[%p]::flushSync()", this);
 #endif
-	snd_seq_drain_output(m_pMidiEngine->alsaSeq());
+	drain();
 }
 
 
@@ -688,7 +1219,7 @@ void qtractorMidiOutputThread::trackSync (
 	}
 
 	// Surely must realize the output queue...
-	snd_seq_drain_output(m_pMidiEngine->alsaSeq());
+	drain();
 }
 
 
@@ -714,7 +1245,7 @@ void qtractorMidiOutputThread::metroSync ( unsigned long iFrameStart )
 	m_pMidiEngine->processMetro(iFrameStart, iFrameEnd);
 
 	// Surely must realize the output queue...
-	snd_seq_drain_output(m_pMidiEngine->alsaSeq());
+	drain();
 }
 
 
@@ -731,6 +1262,20 @@ void qtractorMidiOutputThread::sync (void)
 }
 
 
+// Stage a scheduled event for output (output thread only).
+void qtractorMidiOutputThread::stage ( const snd_seq_event_t *pEv )
+{
+	m_stage.push(pEv);
+}
+
+
+// Output staged events in one batch and drain.
+void qtractorMidiOutputThread::drain (void)
+{
+	m_iCoalesced += m_stage.flush(m_pMidiEngine->alsaSeq());
+}
+
+
 //----------------------------------------------------------------------
 // class qtractorMidiPlayerThread -- MIDI player thread.
 //
@@ -1204,6 +1749,17 @@ qtractorMidiEngine::qtractorMidiEngine ( qtractorSession *pSession )
 
 	m_bDriftCorrect = true;
 
+	m_bJackOutput   = false;
+
+	m_bDirectPlugins = false;
+
+	m_bReadAheadAuto = true;
+
+	m_iEnqueueFrameTime = 0;
+	m_iEnqueueCount = 0;
+	m_iEnqueueLate  = 0;
+	m_iEnqueueOutputs = 0;
+
 	m_iDriftCheck   = 0;
 	m_iDriftCount   = DRIFT_CHECK;
 
@@ -1235,6 +1791,7 @@ qtractorMidiEngine::qtractorMidiEngine ( qtractorSession *pSession )
 
 	// Time-scale cursor (tempo/time-signature map)
 	m_pMetroCursor = NULL;
+	m_pTimeReader  = NULL;
 
 	// Track down tempo changes.
 	m_fMetroTempo = 0.0f;
@@ -1261,6 +1818,18 @@ qtractorMidiEngine::qtractorMidiEngine ( qtractorSession *pSession )
 	// MIDI Clock tempo tracking.
 	m_iClockCount = 0;
 	m_fClockTempo = 120.0f;
+
+	// MIDI clip playback snapshot builder,
+	// which shall outlive any engine (re)start.
+	m_pSnapshotThread = new qtractorMidiSnapshotThread();
+	m_pSnapshotThread->start(QThread::LowPriority);
+}
+
+
+// Destructor.
+qtractorMidiEngine::~qtractorMidiEngine (void)
+{
+	delete m_pSnapshotThread;
 }
 
 
@@ -1332,6 +1901,70 @@ unsigned int qtractorMidiEngine::readAhead (void) const
 }
 
 
+// Adaptive read-ahead mode.
+void qtractorMidiEngine::setReadAheadAuto ( bool bReadAheadAuto )
+{
+	m_bReadAheadAuto = bReadAheadAuto;
+
+	if (m_pOutputThread)
+		m_pOutputThread->setReadAheadAuto(bReadAheadAuto);
+}
+
+bool qtractorMidiEngine::isReadAheadAuto (void) const
+{
+	return m_bReadAheadAuto;
+}
+
+
+// MIDI output thread statistics.
+bool qtractorMidiEngine::outputStats ( OutputStats& stats ) const
+{
+	if (m_pOutputThread == NULL)
+		return false;
+
+	m_pOutputThread->stats(stats);
+	return true;
+}
+
+void qtractorMidiEngine::resetOutputStats (void)
+{
+	if (m_pOutputThread)
+		m_pOutputThread->resetStats();
+}
+
+
+// Output cycle enqueue tally (late events by frame-time).
+void qtractorMidiEngine::resetEnqueueTally ( unsigned long iFrameTime )
+{
+	m_iEnqueueFrameTime = iFrameTime;
+	m_iEnqueueCount = 0;
+	m_iEnqueueLate  = 0;
+	m_iEnqueueOutputs = 0;
+}
+
+unsigned int qtractorMidiEngine::enqueueCount (void) const
+{
+	return m_iEnqueueCount;
+}
+
+unsigned int qtractorMidiEngine::enqueueLate (void) const
+{
+	return m_iEnqueueLate;
+}
+
+unsigned int qtractorMidiEngine::enqueueOutputs (void) const
+{
+	return m_iEnqueueOutputs;
+}
+
+
+// Current queue drift correction (ticks).
+long qtractorMidiEngine::timeDrift (void) const
+{
+	return m_iTimeDrift;
+}
+
+
 // Reset queue tempo.
 void qtractorMidiEngine::resetTempo (void)
 {
@@ -1827,7 +2460,7 @@ void qtractorMidiEngine::capture ( snd_seq_event_t *pEv )
 						snd_seq_ev_set_source(pEv, pMidiBus->alsaPort());
 						snd_seq_ev_set_subs(pEv);
 						snd_seq_ev_set_direct(pEv);
-						snd_seq_event_output_direct(m_pAlsaSeq, pEv);
+						pMidiBus->outputDirect(m_pAlsaSeq, pEv);
 						// Done with MIDI-thru.
 						pMidiBus->midiMonitor_out()->enqueue(type, value);
 						// Do it for the MIDI plugins too...
@@ -1873,7 +2506,7 @@ void qtractorMidiEngine::capture ( snd_seq_event_t *pEv )
 				snd_seq_ev_set_source(pEv, pMidiBus->alsaPort());
 				snd_seq_ev_set_subs(pEv);
 				snd_seq_ev_set_direct(pEv);
-				snd_seq_event_output_direct(m_pAlsaSeq, pEv);
+				pMidiBus->outputDirect(m_pAlsaSeq, pEv);
 				// Done with MIDI-thru.
 				pMidiBus->midiMonitor_out()->enqueue(type, value);
 			}
@@ -1921,10 +2554,25 @@ void qtractorMidiEngine::enqueue ( qtractorTrack *pTrack,
 #endif
 	const int iAlsaPort = pMidiBus->alsaPort();
 
+	// Tempo-map reader, for frame/tick conversions...
+	qtractorTimeScale::Reader *pTimeReader = m_pTimeReader;
+	if (pTimeReader == NULL)
+		return;
+
+	// Plugin delay compensation: output as late as the
+	// (compensated) audio gets through on the track target bus...
+	const unsigned long iLatencyDelay = pTrack->latencyDelay();
+	unsigned long iTimeOut = iTime;
+	if (iLatencyDelay > 0) {
+		const unsigned long iFrameOut
+			= pTimeReader->frameFromTick(iTime) + iLatencyDelay;
+		iTimeOut = pTimeReader->tickFromFrame(iFrameOut);
+	}
+
 	// Scheduled delivery: take into account
 	// the time playback/queue started...
 	const unsigned long tick
-		= (long(iTime) > m_iTimeStart ? iTime - m_iTimeStart : 0);
+		= (long(iTimeOut) > m_iTimeStart ? iTimeOut - m_iTimeStart : 0);
 
 #ifdef CONFIG_DEBUG_0
 	// - show event for debug purposes...
@@ -1967,7 +2615,7 @@ void qtractorMidiEngine::enqueue ( qtractorTrack *pTrack,
 			ev.data.note.duration = pEvent->duration();
 			if (pSession->isLooping()) {
 				const unsigned long iLoopEndTime
-					= pSession->tickFromFrame(pSession->loopEnd());
+					= pTimeReader->tickFromFrame(pSession->loopEnd());
 				if (iLoopEndTime < iTime + ev.data.note.duration)
 					ev.data.note.duration = iLoopEndTime - iTime;
 			}
@@ -2061,8 +2709,13 @@ void qtractorMidiEngine::enqueue ( qtractorTrack *pTrack,
 			break;
 	}
 
-	// Pump it into the queue.
-	snd_seq_event_output(m_pAlsaSeq, &ev);
+	// Stage it for the output queue,
+	// unless it goes out through JACK MIDI...
+#ifdef CONFIG_JACK_MIDI
+	qtractorMidiJackPort *pJackMidiOut = pMidiBus->jackMidiOut();
+	if (pJackMidiOut == NULL)
+#endif
+	m_pOutputThread->stage(&ev);
 
 	// MIDI track monitoring...
 	qtractorMidiMonitor *pMidiMonitor
@@ -2075,22 +2728,31 @@ void qtractorMidiEngine::enqueue ( qtractorTrack *pTrack,
 			pEvent->type(), pEvent->value(), tick);
 
 	// Do it for the MIDI track plugins too...
-	qtractorTimeScale::Cursor& cursor = pSession->timeScale()->cursor();
-	qtractorTimeScale::Node *pNode = cursor.seekTick(iTime);
 	const long f0 = m_iFrameStart;
-	const unsigned long t0 = pNode->frameFromTick(iTime);
-	const unsigned long t1 = (long(t0) < f0 ? t0 : t0 - f0);
+	const unsigned long t0 = pTimeReader->frameFromTick(iTime);
+	const unsigned long t1 = (long(t0) < f0 ? t0 : t0 - f0) + iLatencyDelay;
 	unsigned long t2 = t1;
 
+	// Output cycle tally: is it already due?
+	++m_iEnqueueCount;
+	if (t1 < m_iEnqueueFrameTime)
+		++m_iEnqueueLate;
+
 	if (ev.type == SND_SEQ_EVENT_NOTE && ev.data.note.duration > 0) {
 		const unsigned long iTimeOff = iTime + (ev.data.note.duration - 1);
-		pNode = cursor.seekTick(iTimeOff);
-		t2 += (pNode->frameFromTick(iTimeOff) - t0);
+		t2 += (pTimeReader->frameFromTick(iTimeOff) - t0);
 	}
 
+#ifdef CONFIG_JACK_MIDI
+	// Sample-accurate JACK MIDI output...
+	if (pJackMidiOut)
+		pJackMidiOut->queued(&ev, t1, t2);
+#endif
+
+	// Track plugins might be fed straight from the audio thread...
 	qtractorMidiManager *pMidiManager
 		= (pTrack->pluginList())->midiManager();
-	if (pMidiManager)
+	if (pMidiManager && !m_bDirectPlugins)
 		pMidiManager->queued(&ev, t1, t2);
 
 	// And for the MIDI output plugins as well...
@@ -2102,6 +2764,13 @@ void qtractorMidiEngine::enqueue ( qtractorTrack *pTrack,
 }
 
 
+// MIDI clip playback snapshot builder.
+qtractorMidiSnapshotThread *qtractorMidiEngine::snapshotThread (void) const
+{
+	return m_pSnapshotThread;
+}
+
+
 // Reset ouput queue drift stats (audio vs. MIDI)...
 void qtractorMidiEngine::resetDrift (void)
 {
@@ -2144,7 +2813,7 @@ void qtractorMidiEngine::driftCheck (void)
 	if (pAudioEngine == NULL)
 		return;
 
-	if (m_pMetroCursor == NULL)
+	if (m_pTimeReader == NULL)
 		return;
 
 	// Time to have some corrective approach...?
@@ -2154,15 +2823,14 @@ void qtractorMidiEngine::driftCheck (void)
 			m_pAlsaSeq, m_iAlsaQueue, pQueueStatus) >= 0) {
 		const long iAudioFrame = m_iFrameStart
 			+ pAudioEngine->jackFrameTime() - m_iAudioFrameStart;
-		qtractorTimeScale::Node *pNode = m_pMetroCursor->seekFrame(iAudioFrame);
 		const long iAudioTime
-			= long(pNode->tickFromFrame(iAudioFrame)) - m_iTimeStart;
+			= long(m_pTimeReader->tickFromFrame(iAudioFrame)) - m_iTimeStart;
 		const long iMidiTime
 			= long(snd_seq_queue_status_get_tick_time(pQueueStatus));
 		long iDeltaTime = (iAudioTime - iMidiTime);
 	//	if (pSession->isLooping()) {
 			const long iDeadTime
-				= pSession->tickFromFrame(iAudioFrame + readAhead())
+				= m_pTimeReader->tickFromFrame(iAudioFrame + readAhead())
 				- iAudioTime - m_iTimeStart;
 			const long iDeadTime2 = long(iDeadTime >> 4);
 			if (iDeltaTime < -iDeadTime2 || iDeltaTime > +iDeadTime2)
@@ -2230,6 +2898,14 @@ bool qtractorMidiEngine::init (void)
 	if (pSession == NULL)
 		return false;
 
+	// Offline (headless) rendering goes without any ALSA sequencer;
+	// only plugin MIDI managers get their events, directly queued...
+	if (isOffline()) {
+		m_pMetroCursor = new qtractorTimeScale::Cursor(pSession->timeScale());
+		m_pTimeReader  = new qtractorTimeScale::Reader(pSession->timeScale());
+		return true;
+	}
+
 	// Try open a new client...
 	if (snd_seq_open(&m_pAlsaSeq, "default",
 			SND_SEQ_OPEN_DUPLEX, SND_SEQ_NONBLOCK) < 0)
@@ -2287,6 +2963,9 @@ bool qtractorMidiEngine::init (void)
 	// Time-scale cursor (tempo/time-signature map)
 	m_pMetroCursor = new qtractorTimeScale::Cursor(pSession->timeScale());
 
+	// Tempo-map reader (MIDI output thread)...
+	m_pTimeReader = new qtractorTimeScale::Reader(pSession->timeScale());
+
 	return true;
 }
 
@@ -2299,6 +2978,12 @@ bool qtractorMidiEngine::activate (void)
 	if (pSession == NULL)
 		return false;
 
+	// Offline (headless) rendering has no queue threads whatsoever...
+	if (m_pAlsaSeq == NULL) {
+		resetAllMonitors();
+		return isOffline();
+	}
+
 	// Open SMF player to last...
 	openPlayerBus();
 
@@ -2313,6 +2998,7 @@ bool qtractorMidiEngine::activate (void)
 	// Create and start our own MIDI output queue thread...
 	const unsigned int iReadAhead = (pSession->sampleRate() >> 1);
 	m_pOutputThread = new qtractorMidiOutputThread(this, iReadAhead);
+	m_pOutputThread->setReadAheadAuto(m_bReadAheadAuto);
 	m_pOutputThread->start(QThread::HighPriority);
 
 	// Reset/zero tickers...
@@ -2375,6 +3061,9 @@ bool qtractorMidiEngine::start (void)
 
 	m_iAudioFrameStart = pSession->audioEngine()->jackFrameTime();
 
+	// Reset output cycle telemetry...
+	m_pOutputThread->resetStats();
+
 	// Effectively start sequencer queue timer...
 	snd_seq_start_queue(m_pAlsaSeq, m_iAlsaQueue, NULL);
 	snd_seq_drain_output(m_pAlsaSeq);
@@ -2392,6 +3081,10 @@ void qtractorMidiEngine::stop (void)
 	if (!isActivated())
 		return;
 
+	// Offline (headless) rendering has no queues...
+	if (m_pAlsaSeq == NULL)
+		return;
+
 	// Cleanup queues...
 	snd_seq_drop_input(m_pAlsaSeq);
 	snd_seq_drop_output(m_pAlsaSeq);
@@ -2401,6 +3094,22 @@ void qtractorMidiEngine::stop (void)
 
 	flush();
 
+#ifdef CONFIG_JACK_MIDI
+	// Cleanup JACK MIDI queues too...
+	qtractorSession *pSession = session();
+	if (pSession && isJackOutput()) {
+		pSession->lock();
+		for (qtractorBus *pBus = qtractorEngine::buses().first();
+				pBus; pBus = pBus->next()) {
+			qtractorMidiBus *pMidiBus
+				= static_cast<qtractorMidiBus *> (pBus);
+			if (pMidiBus && pMidiBus->jackMidiOut())
+				pMidiBus->jackMidiOut()->reset();
+		}
+		pSession->unlock();
+	}
+#endif
+
 	// Shut-off all MIDI buses...
 	shutOffAllBuses();
 
@@ -2416,9 +3125,12 @@ void qtractorMidiEngine::deactivate (void)
 	setPlaying(false);
 
 	// Stop our queue threads...
-	m_pInputThread->setRunState(false);
-	m_pOutputThread->setRunState(false);
-	m_pOutputThread->sync();
+	if (m_pInputThread)
+		m_pInputThread->setRunState(false);
+	if (m_pOutputThread) {
+		m_pOutputThread->setRunState(false);
+		m_pOutputThread->sync();
+	}
 }
 
 
@@ -2461,6 +3173,12 @@ void qtractorMidiEngine::clean (void)
 		m_pMetroCursor = NULL;
 	}
 
+	// Tempo-map reader (MIDI output thread)...
+	if (m_pTimeReader) {
+		delete m_pTimeReader;
+		m_pTimeReader = NULL;
+	}
+
 	// Drop subscription stuff.
 	if (m_pAlsaSubsSeq) {
 		if (m_pAlsaNotifier) {
@@ -2562,6 +3280,15 @@ void qtractorMidiEngine::trackMute ( qtractorTrack *pTrack, bool bMute )
 		// Immediate all current notes off.
 		qtractorMidiBus *pMidiBus
 			= static_cast<qtractorMidiBus *> (pTrack->outputBus());
+	#ifdef CONFIG_JACK_MIDI
+		// Same removal from the JACK MIDI queue...
+		if (pMidiBus && pMidiBus->jackMidiOut()) {
+			pSession->lock();
+			pMidiBus->jackMidiOut()->remove(
+				pTrack->midiTag(), pTrack->midiChannel());
+			pSession->unlock();
+		}
+	#endif
 		if (pMidiBus)
 			pMidiBus->setController(pTrack, ALL_NOTES_OFF);
 		// Clear/reset track monitor...
@@ -3174,10 +3901,12 @@ unsigned long qtractorMidiEngine::metroOffset (void) const
 void qtractorMidiEngine::processMetro (
 	unsigned long iFrameStart, unsigned long iFrameEnd )
 {
-	if (m_pMetroCursor == NULL)
+	if (m_pTimeReader == NULL)
 		return;
 
-	qtractorTimeScale::Node *pNode = m_pMetroCursor->seekFrame(iFrameEnd);
+	const qtractorTimeScale::Node *pNode = m_pTimeReader->seekFrame(iFrameEnd);
+	if (pNode == NULL)
+		return;
 
 	// Take this moment to check for tempo changes...
 	if (pNode->tempo != m_fMetroTempo) {
@@ -3200,11 +3929,12 @@ void qtractorMidiEngine::processMetro (
 		ev.dest.port = SND_SEQ_PORT_SYSTEM_TIMER;
 		// Pump it into the queue.
 		snd_seq_event_output(m_pAlsaSeq, &ev);
+		++m_iEnqueueOutputs;
 		// Save for next change.
 		m_fMetroTempo = pNode->tempo;
 		// Update MIDI monitor slot stuff...
 		qtractorMidiMonitor::splitTime(
-			m_pMetroCursor->timeScale(), pNode->frame, tick);
+			m_pTimeReader->timeScale(), pNode->frame, tick);
 	}
 
 	// Get on with the actual metronome/clock stuff...
@@ -3214,7 +3944,7 @@ void qtractorMidiEngine::processMetro (
 	// Register the next metronome/clock beat slot.
 	const unsigned long iTimeEnd = pNode->tickFromFrame(iFrameEnd);
 
-	pNode = m_pMetroCursor->seekFrame(iFrameStart);
+	pNode = m_pTimeReader->seekFrame(iFrameStart);
 	const unsigned long iTimeStart = pNode->tickFromFrame(iFrameStart);
 	unsigned int  iBeat = pNode->beatFromTick(iTimeStart);
 	unsigned long iTime = pNode->tickFromBeat(iBeat);
@@ -3258,6 +3988,7 @@ void qtractorMidiEngine::processMetro (
 						= (long(iTimeClock) > m_iTimeStart ? iTimeClock - m_iTimeStart : 0);
 					snd_seq_ev_schedule_tick(&ev_clock, m_iAlsaQueue, 0, tick);
 					snd_seq_event_output(m_pAlsaSeq, &ev_clock);
+					++m_iEnqueueOutputs;
 				}
 				iTimeClock += iTicksPerClock;
 			}
@@ -3282,6 +4013,7 @@ void qtractorMidiEngine::processMetro (
 			}
 			// Pump it into the queue.
 			snd_seq_event_output(m_pAlsaSeq, &ev);
+			++m_iEnqueueOutputs;
 			// MIDI track monitoring...
 			if (m_pMetroBus && m_pMetroBus->midiMonitor_out()) {
 				m_pMetroBus->midiMonitor_out()->enqueue(
@@ -3290,7 +4022,7 @@ void qtractorMidiEngine::processMetro (
 		}
 		// Go for next beat...
 		iTime += pNode->ticksPerBeat;
-		pNode = m_pMetroCursor->seekBeat(++iBeat);
+		pNode = m_pTimeReader->seekBeat(++iBeat);
 	}
 }
 
@@ -3302,6 +4034,13 @@ qtractorTimeScale::Cursor *qtractorMidiEngine::metroCursor (void) const
 }
 
 
+// Tempo-map reader accessor (MIDI output thread only).
+qtractorTimeScale::Reader *qtractorMidiEngine::timeReader (void) const
+{
+	return m_pTimeReader;
+}
+
+
 // Document element methods.
 bool qtractorMidiEngine::loadElement (
 	qtractorDocument *pDocument, QDomElement *pElement )
@@ -3702,6 +4441,137 @@ bool qtractorMidiEngine::isDriftCorrect (void) const
 }
 
 
+// JACK MIDI output mode accessors
+// (takes effect on next bus activation).
+void qtractorMidiEngine::setJackOutput ( bool bJackOutput )
+{
+	m_bJackOutput = bJackOutput;
+}
+
+bool qtractorMidiEngine::isJackOutput (void) const
+{
+#ifdef CONFIG_JACK_MIDI
+	return m_bJackOutput;
+#else
+	return false;
+#endif
+}
+
+
+// JACK MIDI output process cycle (RT-safe).
+void qtractorMidiEngine::process_jack (
+	unsigned long iFrameTimeStart, unsigned int nframes )
+{
+#ifdef CONFIG_JACK_MIDI
+	const unsigned long iFrameTimeEnd = iFrameTimeStart + nframes;
+
+	for (qtractorBus *pBus = qtractorEngine::buses().first();
+			pBus; pBus = pBus->next()) {
+		qtractorMidiBus *pMidiBus
+			= static_cast<qtractorMidiBus *> (pBus);
+		if (pMidiBus && pMidiBus->jackMidiOut()) {
+			pMidiBus->jackMidiOut()->process(
+				iFrameTimeStart, iFrameTimeEnd, nframes);
+		}
+	}
+#else
+	Q_UNUSED(iFrameTimeStart);
+	Q_UNUSED(nframes);
+#endif
+}
+
+
+// MIDI track plugins direct delivery mode accessors.
+void qtractorMidiEngine::setDirectPlugins ( bool bDirectPlugins )
+{
+	m_bDirectPlugins = bDirectPlugins;
+}
+
+bool qtractorMidiEngine::isDirectPlugins (void) const
+{
+	return m_bDirectPlugins;
+}
+
+
+// MIDI track plugins direct delivery cycle (RT-safe).
+void qtractorMidiEngine::process_direct (
+	qtractorSessionCursor *pAudioCursor, unsigned int nframes )
+{
+	if (!m_bDirectPlugins)
+		return;
+
+	qtractorSession *pSession = session();
+	if (pSession == NULL)
+		return;
+
+	// Same legal process cycle frame range as audio...
+	unsigned long iFrameStart = pAudioCursor->frame();
+	unsigned long iFrameEnd   = iFrameStart + nframes;
+	unsigned long iFrameTime  = pAudioCursor->frameTime();
+
+	// Split processing, in case we're looping...
+	bool bLoopStart = false;
+	if (pSession->isLooping()) {
+		const unsigned long iLoopEnd = pSession->loopEnd();
+		if (iFrameStart < iLoopEnd) {
+			// Loop-length might be shorter than the buffer-period...
+			while (iFrameEnd >= iLoopEnd + nframes) {
+				process_direct(pAudioCursor,
+					iFrameStart, iLoopEnd, iFrameTime, bLoopStart);
+				iFrameTime += (iLoopEnd - iFrameStart);
+				iFrameStart = pSession->loopStart();
+				iFrameEnd   = iFrameStart + (iFrameEnd - iLoopEnd);
+				bLoopStart  = true;
+			}
+		}
+	}
+
+	process_direct(pAudioCursor,
+		iFrameStart, iFrameEnd, iFrameTime, bLoopStart);
+}
+
+
+void qtractorMidiEngine::process_direct (
+	qtractorSessionCursor *pAudioCursor,
+	unsigned long iFrameStart, unsigned long iFrameEnd,
+	unsigned long iFrameTime, bool bLoopStart )
+{
+	qtractorSession *pSession = session();
+
+	int iTrack = 0;
+	qtractorTrack *pTrack = pSession->tracks().first();
+	for ( ; pTrack; pTrack = pTrack->next(), ++iTrack) {
+		if (pTrack->trackType() != qtractorTrack::Midi)
+			continue;
+		if (pTrack->isMute() || (pSession->soloTracks() && !pTrack->isSolo()))
+			continue;
+		qtractorMidiManager *pMidiManager
+			= (pTrack->pluginList())->midiManager();
+		if (pMidiManager == NULL)
+			continue;
+		// Audio cursor isn't there yet, on loop turn-around...
+		qtractorClip *pClip = NULL;
+		if (bLoopStart) {
+			pClip = pTrack->clips().first();
+			while (pClip && iFrameStart > pClip->clipStart() + pClip->clipLength())
+				pClip = pClip->next();
+		} else {
+			pClip = pAudioCursor->clip(iTrack);
+		}
+		// Now, for every clip...
+		while (pClip && pClip->clipStart() < iFrameEnd) {
+			if (iFrameStart < pClip->clipStart() + pClip->clipLength()) {
+				qtractorMidiClip *pMidiClip
+					= static_cast<qtractorMidiClip *> (pClip);
+				pMidiClip->process_direct(pMidiManager, iFrameStart,
+					iFrameEnd, iFrameTime + pTrack->latencyDelay());
+			}
+			pClip = pClip->next();
+		}
+	}
+}
+
+
 // MMC device-id accessors.
 void qtractorMidiEngine::setMmcDevice ( unsigned char mmcDevice )
 {
@@ -3769,6 +4639,8 @@ qtractorMidiBus::qtractorMidiBus ( qtractorMidiEngine *pMidiEngine,
 {
 	m_iAlsaPort = -1;
 
+	m_pJackMidiOut = NULL;
+
 	if ((busMode & qtractorBus::Input) && !(busMode & qtractorBus::Ex)) {
 		m_pIMidiMonitor = new qtractorMidiMonitor();
 		m_pIPluginList  = createPluginList(qtractorPluginList::MidiInBus);
@@ -3815,6 +4687,13 @@ int qtractorMidiBus::alsaPort (void) const
 }
 
 
+// JACK MIDI output port accessor (if any).
+qtractorMidiJackPort *qtractorMidiBus::jackMidiOut (void) const
+{
+	return m_pJackMidiOut;
+}
+
+
 // Register and pre-allocate bus port buffers.
 bool qtractorMidiBus::open (void)
 {
@@ -3826,8 +4705,16 @@ bool qtractorMidiBus::open (void)
 		return false;
 
 	snd_seq_t *pAlsaSeq = pMidiEngine->alsaSeq();
-	if (pAlsaSeq == NULL)
-		return false;
+	if (pAlsaSeq == NULL) {
+		if (!pMidiEngine->isOffline())
+			return false;
+		// Offline (headless): no port, just the plugin lists...
+		if (m_pIPluginList)
+			updatePluginList(m_pIPluginList, qtractorPluginList::MidiInBus);
+		if (m_pOPluginList)
+			updatePluginList(m_pOPluginList, qtractorPluginList::MidiOutBus);
+		return true;
+	}
 
 	const qtractorBus::BusMode busMode
 		= qtractorMidiBus::busMode();
@@ -3861,6 +4748,25 @@ bool qtractorMidiBus::open (void)
 	if (snd_seq_set_port_info(pAlsaSeq, m_iAlsaPort, pinfo) < 0)
 		return false;
 
+#ifdef CONFIG_JACK_MIDI
+	// Output through JACK MIDI instead, if asked for...
+	if ((busMode & qtractorBus::Output) && !(busMode & qtractorBus::Ex)
+		&& pMidiEngine->isJackOutput()) {
+		qtractorAudioEngine *pAudioEngine = NULL;
+		qtractorSession *pSession = pMidiEngine->session();
+		if (pSession)
+			pAudioEngine = pSession->audioEngine();
+		if (pAudioEngine && pAudioEngine->jackClient()) {
+			m_pJackMidiOut = new qtractorMidiJackPort();
+			if (!m_pJackMidiOut->open(pAudioEngine->jackClient(),
+					busName() + "/midi_out")) {
+				delete m_pJackMidiOut;
+				m_pJackMidiOut = NULL;
+			}
+		}
+	}
+#endif
+
 	// Update monitor subject names...
 	qtractorMidiBus::updateBusName();
 
@@ -3896,6 +4802,19 @@ void qtractorMidiBus::close (void)
 
 	shutOff(true);
 
+#ifdef CONFIG_JACK_MIDI
+	if (m_pJackMidiOut) {
+		qtractorSession *pSession = pMidiEngine->session();
+		if (pSession)
+			pSession->lock();
+		qtractorMidiJackPort *pJackMidiOut = m_pJackMidiOut;
+		m_pJackMidiOut = NULL;
+		if (pSession)
+			pSession->unlock();
+		delete pJackMidiOut;
+	}
+#endif
+
 	snd_seq_delete_simple_port(pAlsaSeq, m_iAlsaPort);
 
 	m_iAlsaPort = -1;
@@ -4093,7 +5012,7 @@ void qtractorMidiBus::setPatch ( unsigned short iChannel,
 			ev.data.control.value = (iBank & 0x3f80) >> 7;
 		else
 			ev.data.control.value = (iBank & 0x007f);
-		snd_seq_event_output_direct(pAlsaSeq, &ev);
+		outputDirect(pAlsaSeq, &ev);
 		if (pTrackMidiManager)
 			pTrackMidiManager->direct(&ev);
 		if (pBusMidiManager)
@@ -4106,7 +5025,7 @@ void qtractorMidiBus::setPatch ( unsigned short iChannel,
 		ev.data.control.channel = iChannel;
 		ev.data.control.param   = BANK_SELECT_LSB;
 		ev.data.control.value   = (iBank & 0x007f);
-		snd_seq_event_output_direct(pAlsaSeq, &ev);
+		outputDirect(pAlsaSeq, &ev);
 		if (pTrackMidiManager)
 			pTrackMidiManager->direct(&ev);
 		if (pBusMidiManager)
@@ -4118,7 +5037,7 @@ void qtractorMidiBus::setPatch ( unsigned short iChannel,
 		ev.type = SND_SEQ_EVENT_PGMCHANGE;
 		ev.data.control.channel = iChannel;
 		ev.data.control.value   = iProg;
-		snd_seq_event_output_direct(pAlsaSeq, &ev);
+		outputDirect(pAlsaSeq, &ev);
 		if (pTrackMidiManager)
 			pTrackMidiManager->direct(&ev);
 		if (pBusMidiManager)
@@ -4180,7 +5099,7 @@ void qtractorMidiBus::setControllerEx ( unsigned short iChannel,
 	ev.data.control.channel = iChannel;
 	ev.data.control.param   = iController;
 	ev.data.control.value   = iValue;
-	snd_seq_event_output_direct(pAlsaSeq, &ev);
+	outputDirect(pAlsaSeq, &ev);
 
 	// Do it for the MIDI plugins too...
 	if (pTrack && (pTrack->pluginList())->midiManager())
@@ -4192,6 +5111,21 @@ void qtractorMidiBus::setControllerEx ( unsigned short iChannel,
 }
 
 
+// Direct event output helper: through JACK MIDI when present,
+// otherwise through the ALSA sequencer, as scheduled events do.
+void qtractorMidiBus::outputDirect (
+	snd_seq_t *pAlsaSeq, snd_seq_event_t *pEv ) const
+{
+#ifdef CONFIG_JACK_MIDI
+	if (m_pJackMidiOut) {
+		m_pJackMidiOut->direct(pEv);
+		return;
+	}
+#endif
+	snd_seq_event_output_direct(pAlsaSeq, pEv);
+}
+
+
 // Direct MIDI channel event helper.
 void qtractorMidiBus::sendEvent ( qtractorMidiEvent::EventType etype,
 	unsigned short iChannel, unsigned short iParam, unsigned short iValue ) const
@@ -4289,7 +5223,7 @@ void qtractorMidiBus::sendEvent ( qtractorMidiEvent::EventType etype,
 		break;
 	}
 
-	snd_seq_event_output_direct(pAlsaSeq, &ev);
+	outputDirect(pAlsaSeq, &ev);
 }
 
 
@@ -4332,7 +5266,7 @@ void qtractorMidiBus::sendNote (
 	ev.data.note.channel  = iChannel;
 	ev.data.note.note     = iNote;
 	ev.data.note.velocity = iVelocity;
-	snd_seq_event_output_direct(pAlsaSeq, &ev);
+	outputDirect(pAlsaSeq, &ev);
 
 	// Do it for the MIDI plugins too...
 	if ((pTrack->pluginList())->midiManager())
@@ -4394,7 +5328,7 @@ void qtractorMidiBus::sendSysex (
 	// Just set SYSEX stuff and send it out..
 	ev.type = SND_SEQ_EVENT_SYSEX;
 	snd_seq_ev_set_sysex(&ev, iSysex, pSysex);
-	snd_seq_event_output_direct(pAlsaSeq, &ev);
+	outputDirect(pAlsaSeq, &ev);
 
 //	pMidiEngine->flush();
 }
@@ -4443,6 +5377,11 @@ void qtractorMidiBus::sendSysexList (void) const
 		// Just set SYSEX stuff and send it out..
 		ev.type = SND_SEQ_EVENT_SYSEX;
 		snd_seq_ev_set_sysex(&ev, pSysex->size(), pSysex->data());
+	#ifdef CONFIG_JACK_MIDI
+		if (m_pJackMidiOut)
+			m_pJackMidiOut->direct(&ev);
+		else
+	#endif
 		snd_seq_event_output(pAlsaSeq, &ev);
 		// AG: Do it for the MIDI plugins too...
 		if (pluginList_out() && pluginList_out()->midiManager())
@@ -38,10 +38,12 @@ class qtractorMidiEvent;
 class qtractorMidiSequence;
 class qtractorMidiInputThread;
 class qtractorMidiOutputThread;
+class qtractorMidiSnapshotThread;
 class qtractorMidiMonitor;
 class qtractorMidiSysexList;
 class qtractorMidiInputBuffer;
 class qtractorMidiPlayer;
+class qtractorMidiJackPort;
 class qtractorPluginList;
 class qtractorCurveList;
 
@@ -93,6 +95,9 @@ public:
 	// Constructor.
 	qtractorMidiEngine(qtractorSession *pSession);
 
+	// Destructor.
+	~qtractorMidiEngine();
+
 	// Engine initialization.
 	bool init();
 
@@ -115,6 +120,55 @@ public:
 	void setReadAhead(unsigned int iReadAhead);
 	unsigned int readAhead() const;
 
+	// Adaptive read-ahead mode.
+	void setReadAheadAuto(bool bReadAheadAuto);
+	bool isReadAheadAuto() const;
+
+	// MIDI output thread statistics.
+	struct OutputStats
+	{
+		// Default constructor.
+		OutputStats() : readAhead(0), events(0), late(0), coalesced(0),
+			outputs(0), drains(0), headroom(0), drift(0), usecs(0),
+			cycles(0), eventsTotal(0), lateTotal(0), coalescedTotal(0),
+			outputsTotal(0), drainsTotal(0), headroomMin(0), usecsMax(0),
+			usecsTotal(0) {}
+
+		// Last output cycle.
+		unsigned int  readAhead;	// window size (frames)
+		unsigned int  events;		// events enqueued
+		unsigned int  late;			// events already due
+		unsigned int  coalesced;	// redundant events dropped
+		unsigned int  outputs;		// snd_seq_event_output() calls
+		unsigned int  drains;		// snd_seq_drain_output() calls
+		long          headroom;		// frames ahead of audio, on wake
+		long          drift;		// queue drift correction (ticks)
+		unsigned int  usecs;		// time spent (microseconds)
+
+		// Accumulated, since playback started.
+		unsigned long cycles;
+		unsigned long eventsTotal;
+		unsigned long lateTotal;
+		unsigned long coalescedTotal;
+		unsigned long outputsTotal;
+		unsigned long drainsTotal;
+		long          headroomMin;
+		unsigned int  usecsMax;
+		unsigned long usecsTotal;
+	};
+
+	bool outputStats(OutputStats& stats) const;
+	void resetOutputStats();
+
+	// Output cycle enqueue tally (late events by frame-time).
+	void resetEnqueueTally(unsigned long iFrameTime);
+	unsigned int enqueueCount() const;
+	unsigned int enqueueLate() const;
+	unsigned int enqueueOutputs() const;
+
+	// Current queue drift correction (ticks).
+	long timeDrift() const;
+
 	// Reset queue tempo.
 	void resetTempo();
 
@@ -204,6 +258,9 @@ public:
 	// Access to current tempo/time-signature cursor.
 	qtractorTimeScale::Cursor *metroCursor() const;
 
+	// Tempo-map reader accessor (MIDI output thread only).
+	qtractorTimeScale::Reader *timeReader() const;
+
 	// Control bus accessors.
 	void setControlBus(bool bControlBus);
 	bool isControlBus() const;
@@ -256,6 +313,21 @@ public:
 	void setDriftCorrect(bool bDriftCorrect);
 	bool isDriftCorrect() const;
 
+	// JACK MIDI output mode accessors.
+	void setJackOutput(bool bJackOutput);
+	bool isJackOutput() const;
+
+	// JACK MIDI output process cycle (RT-safe).
+	void process_jack(unsigned long iFrameTimeStart, unsigned int nframes);
+
+	// MIDI track plugins direct delivery mode accessors.
+	void setDirectPlugins(bool bDirectPlugins);
+	bool isDirectPlugins() const;
+
+	// MIDI track plugins direct delivery cycle (RT-safe).
+	void process_direct(qtractorSessionCursor *pAudioCursor,
+		unsigned int nframes);
+
 	// MMC device-id accessors.
 	void setMmcDevice(unsigned char mmcDevice);
 	unsigned char mmcDevice() const;
@@ -278,6 +350,9 @@ public:
 	// Reset ouput queue drift stats (audio vs. MIDI)...
 	void resetDrift();
 
+	// MIDI clip playback snapshot builder.
+	qtractorMidiSnapshotThread *snapshotThread() const;
+
 protected:
 
 	// Concrete device (de)activation methods.
@@ -305,6 +380,11 @@ protected:
 	void closePlayerBus();
 	void deletePlayerBus();
 
+	// MIDI track plugins direct delivery (sub-range).
+	void process_direct(qtractorSessionCursor *pAudioCursor,
+		unsigned long iFrameStart, unsigned long iFrameEnd,
+		unsigned long iFrameTime, bool bLoopStart);
+
 private:
 
 	// Special event notifier proxy object.
@@ -325,6 +405,9 @@ private:
 	qtractorMidiInputThread  *m_pInputThread;
 	qtractorMidiOutputThread *m_pOutputThread;
 
+	// MIDI clip playback snapshot builder.
+	qtractorMidiSnapshotThread *m_pSnapshotThread;
+
 	// ALSA port input registries.
 	QHash<int, qtractorMidiBus *> m_inputBuses;
 	QHash<int, qtractorMidiInputBuffer *> m_inputBuffers;
@@ -332,6 +415,21 @@ private:
 	// Whether to check for time drift.
 	bool m_bDriftCorrect;
 
+	// Whether the read-ahead window adapts itself.
+	bool m_bReadAheadAuto;
+
+	// Output cycle enqueue tally.
+	unsigned long m_iEnqueueFrameTime;
+	unsigned int  m_iEnqueueCount;
+	unsigned int  m_iEnqueueLate;
+	unsigned int  m_iEnqueueOutputs;
+
+	// Whether buses output through JACK MIDI.
+	bool m_bJackOutput;
+
+	// Whether track plugins get fed by the audio thread.
+	bool m_bDirectPlugins;
+
 	// The number of times we check for time drift.
 	unsigned int m_iDriftCheck;
 	unsigned int m_iDriftCount;
@@ -369,6 +467,9 @@ private:
 	// Time-scale cursor (tempo/time-signature map)
 	qtractorTimeScale::Cursor *m_pMetroCursor;
 
+	// Tempo-map reader (MIDI output thread).
+	qtractorTimeScale::Reader *m_pTimeReader;
+
 	// Track down tempo changes.
 	float m_fMetroTempo;
 
@@ -420,6 +521,9 @@ public:
 	// ALSA sequencer port accessor.
 	int alsaPort() const;
 
+	// JACK MIDI output port accessor (if any).
+	qtractorMidiJackPort *jackMidiOut() const;
+
 	// Activation methods.
 	bool open();
 	void close();
@@ -478,6 +582,9 @@ public:
 	void sendSysex(unsigned char *pSysex, unsigned int iSysex) const;
 	void sendSysexList() const;
 
+	// Direct event output helper (JACK MIDI or ALSA sequencer).
+	void outputDirect(snd_seq_t *pAlsaSeq, snd_seq_event_t *pEv) const;
+
 	// Import/export SysEx setup from/into event sequence.
 	bool importSysexList(qtractorMidiSequence *pSeq);
 	bool exportSysexList(qtractorMidiSequence *pSeq);
@@ -546,6 +653,9 @@ private:
 	// Instance variables.
 	int m_iAlsaPort;
 
+	// JACK MIDI output port (optional).
+	qtractorMidiJackPort *m_pJackMidiOut;
+
 	// Specific monitor instances.
 	qtractorMidiMonitor *m_pIMidiMonitor;
 	qtractorMidiMonitor *m_pOMidiMonitor;
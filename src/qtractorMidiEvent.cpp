@@ -0,0 +1,292 @@
+// qtractorMidiEvent.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorMidiEvent.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QList>
+
+#include <stdlib.h>
+
+#include <new>
+
+
+// Event nodes per slab (at least).
+#define QTRACTOR_MIDI_EVENT_SLAB	4096
+
+// Sysex buffer size classes (16, 32, 64, 128 and 256 bytes).
+#define QTRACTOR_MIDI_SYSEX_MIN		16
+#define QTRACTOR_MIDI_SYSEX_CLASSES	5
+
+// Pool shards, each one with its own lock (power of two).
+#define QTRACTOR_MIDI_EVENT_SHARDS	8
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiEventPool -- Fixed size node slab allocator.
+//
+// Nodes are carved out of big contiguous slabs and recycled through
+// an intrusive free-list; slabs are given back all at once, as soon
+// as the last node in use gets released (eg. on session close).
+//
+// Each thread allocates from its own shard (by thread id), each with
+// its own lock, free-list and slabs, so that concurrent threads (eg.
+// parallel MIDI file track readers) hardly ever contend. Slabs are
+// aligned to their own (power of two) size, with the owner shard in
+// the header, so that nodes always go back where they came from.
+//
+
+class qtractorMidiEventPool
+{
+public:
+
+	// Constructor.
+	qtractorMidiEventPool(size_t iNodeSize, unsigned int iSlabNodes)
+		: m_iNodeSize(align(iNodeSize)), m_iSlabSize(sizeof(Slab))
+	{
+		while (m_iSlabSize < sizeof(Slab) + iSlabNodes * m_iNodeSize)
+			m_iSlabSize <<= 1;
+		m_iSlabNodes = (m_iSlabSize - sizeof(Slab)) / m_iNodeSize;
+		m_pShards = new Shard [QTRACTOR_MIDI_EVENT_SHARDS];
+	}
+
+	// Destructor.
+	~qtractorMidiEventPool()
+	{
+		for (unsigned int i = 0; i < QTRACTOR_MIDI_EVENT_SHARDS; ++i)
+			reset(&m_pShards[i], false);
+		delete [] m_pShards;
+	}
+
+	// Node allocator.
+	void *alloc()
+	{
+		Shard *pShard = &m_pShards[currentShard()];
+
+		QMutexLocker locker(&pShard->mutex);
+
+		if (pShard->freeList == NULL)
+			grow(pShard);
+
+		Node *pNode = pShard->freeList;
+		pShard->freeList = pNode->next;
+		++pShard->count;
+
+		return pNode;
+	}
+
+	// Node deallocator.
+	void free(void *p)
+	{
+		// Back to the shard it was allocated from...
+		Slab *pSlab = reinterpret_cast<Slab *> (
+			quintptr(p) & ~quintptr(m_iSlabSize - 1));
+		Shard *pShard = pSlab->shard;
+
+		QMutexLocker locker(&pShard->mutex);
+
+		Node *pNode = static_cast<Node *> (p);
+		pNode->next = pShard->freeList;
+		pShard->freeList = pNode;
+
+		// Bulk release, when nothing's left in use...
+		if (--pShard->count == 0 && pShard->slabs.count() > 1)
+			reset(pShard);
+	}
+
+protected:
+
+	// Free-list node.
+	struct Node { Node *next; };
+
+	// Pool shard.
+	struct Shard
+	{
+		Shard() : freeList(NULL), count(0) {}
+
+		Node         *freeList;
+		unsigned long count;
+		QList<char *> slabs;
+		QMutex        mutex;
+	};
+
+	// Slab header (nodes follow).
+	struct Slab { Shard *shard; };
+
+	// Node size alignment (pointer-wise).
+	static size_t align(size_t iSize)
+	{
+		const size_t iAlign = sizeof(void *);
+		if (iSize < sizeof(Node))
+			iSize = sizeof(Node);
+		return (iSize + iAlign - 1) & ~(iAlign - 1);
+	}
+
+	// Current thread shard index.
+	static unsigned int currentShard()
+	{
+		quintptr h = quintptr(QThread::currentThreadId());
+		h ^= (h >> 16);
+		h ^= (h >> 8);
+		h ^= (h >> 4);
+		return (unsigned int) (h & (QTRACTOR_MIDI_EVENT_SHARDS - 1));
+	}
+
+	// Add a new slab to the shard free-list.
+	void grow(Shard *pShard)
+	{
+		void *pvSlab = NULL;
+		if (::posix_memalign(&pvSlab, m_iSlabSize, m_iSlabSize))
+			throw std::bad_alloc();
+		char *pSlab = static_cast<char *> (pvSlab);
+		reinterpret_cast<Slab *> (pSlab)->shard = pShard;
+		pShard->slabs.append(pSlab);
+		link(pShard, pSlab);
+	}
+
+	// Link all slab nodes in the free-list, in address order.
+	void link(Shard *pShard, char *pSlab)
+	{
+		char *p = pSlab + sizeof(Slab) + (m_iSlabNodes * m_iNodeSize);
+		for (unsigned int i = 0; i < m_iSlabNodes; ++i) {
+			p -= m_iNodeSize;
+			Node *pNode = reinterpret_cast<Node *> (p);
+			pNode->next = pShard->freeList;
+			pShard->freeList = pNode;
+		}
+	}
+
+	// Release all shard slabs at once; the first one
+	// is kept around, unless told otherwise, so that
+	// a lonely node coming and going won't thrash.
+	void reset(Shard *pShard, bool bKeepFirst = true)
+	{
+		pShard->freeList = NULL;
+
+		char *pFirst = NULL;
+		if (bKeepFirst && !pShard->slabs.isEmpty())
+			pFirst = pShard->slabs.takeFirst();
+
+		QListIterator<char *> iter(pShard->slabs);
+		while (iter.hasNext())
+			::free(iter.next());
+		pShard->slabs.clear();
+
+		if (pFirst) {
+			pShard->slabs.append(pFirst);
+			link(pShard, pFirst);
+		}
+	}
+
+private:
+
+	// Instance variables.
+	size_t        m_iNodeSize;
+	size_t        m_iSlabSize;
+	unsigned int  m_iSlabNodes;
+
+	Shard        *m_pShards;
+};
+
+
+// The event node pool (never destroyed, as events may well
+// outlive any static storage, eg. the editor clipboard).
+static qtractorMidiEventPool *midiEventPool (void)
+{
+	static qtractorMidiEventPool *g_pPool = new qtractorMidiEventPool(
+		sizeof(qtractorMidiEvent), QTRACTOR_MIDI_EVENT_SLAB);
+
+	return g_pPool;
+}
+
+
+// The sysex buffer pools, one per size class.
+static qtractorMidiEventPool *midiSysexPool ( unsigned short iSysex )
+{
+	static qtractorMidiEventPool *g_apPools[QTRACTOR_MIDI_SYSEX_CLASSES] = {
+		new qtractorMidiEventPool(QTRACTOR_MIDI_SYSEX_MIN << 0, 256),
+		new qtractorMidiEventPool(QTRACTOR_MIDI_SYSEX_MIN << 1, 256),
+		new qtractorMidiEventPool(QTRACTOR_MIDI_SYSEX_MIN << 2, 128),
+		new qtractorMidiEventPool(QTRACTOR_MIDI_SYSEX_MIN << 3, 64),
+		new qtractorMidiEventPool(QTRACTOR_MIDI_SYSEX_MIN << 4, 32)
+	};
+
+	unsigned int iSize = QTRACTOR_MIDI_SYSEX_MIN;
+	for (int i = 0; i < QTRACTOR_MIDI_SYSEX_CLASSES; ++i) {
+		if (iSysex <= iSize)
+			return g_apPools[i];
+		iSize <<= 1;
+	}
+
+	// Too big, left to the heap.
+	return NULL;
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiEvent -- The generic MIDI event element.
+//
+
+// Pooled (slab) allocation operators.
+void *qtractorMidiEvent::operator new ( size_t iSize )
+{
+	// Derived classes (if ever) are left to the heap...
+	if (iSize != sizeof(qtractorMidiEvent))
+		return ::operator new(iSize);
+
+	return midiEventPool()->alloc();
+}
+
+void qtractorMidiEvent::operator delete ( void *pEvent, size_t iSize )
+{
+	if (pEvent == NULL)
+		return;
+
+	if (iSize != sizeof(qtractorMidiEvent))
+		::operator delete(pEvent);
+	else
+		midiEventPool()->free(pEvent);
+}
+
+
+// Pooled sysex buffer allocators.
+unsigned char *qtractorMidiEvent::allocSysex ( unsigned short iSysex )
+{
+	qtractorMidiEventPool *pPool = midiSysexPool(iSysex);
+	if (pPool)
+		return static_cast<unsigned char *> (pPool->alloc());
+	else
+		return new unsigned char [iSysex];
+}
+
+void qtractorMidiEvent::freeSysex ( unsigned char *pSysex, unsigned short iSysex )
+{
+	qtractorMidiEventPool *pPool = midiSysexPool(iSysex);
+	if (pPool)
+		pPool->free(pSysex);
+	else
+		delete [] pSysex;
+}
+
+
+// end of qtractorMidiEvent.cpp
@@ -27,12 +27,37 @@
 #include "qtractorMidiRpn.h"
 
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QVector>
+#include <QHash>
+
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+
+#ifdef CONFIG_MMAP_FILE
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
 
 
 // Symbolic header markers.
 #define SMF_MTHD "MThd"
 #define SMF_MTRK "MTrk"
 
+// Minimum number of tracks worth decoding in parallel.
+#define QTRACTOR_MIDI_FILE_PARALLEL	4
+
+// Maximum number of files kept in the track index cache.
+#define QTRACTOR_MIDI_FILE_CACHE	32
+
 
 // - Bank-select (controller) types...
 #define BANK_MSB  0x00
@@ -106,6 +131,568 @@ public:
 };
 
 
+//----------------------------------------------------------------------
+// class qtractorMidiFileChunk -- SMF chunk (in memory) reader.
+//
+class qtractorMidiFileChunk
+{
+public:
+
+	// Constructor.
+	qtractorMidiFileChunk ( const unsigned char *pData, unsigned long iLength )
+		: m_pData(pData), m_iLength(iLength), m_iOffset(0) {}
+
+	// End-of-chunk predicate.
+	bool isEnd() const
+		{ return (m_iOffset >= m_iLength); }
+
+	// Force end-of-chunk.
+	void end()
+		{ m_iOffset = m_iLength; }
+
+	// Go back one byte (eg. running status).
+	void unread()
+		{ if (m_iOffset > 0) --m_iOffset; }
+
+	// Integer read method.
+	int readInt ( unsigned short n = 0 )
+	{
+		int val = 0;
+
+		if (n > 0) {
+			// Fixed length (n bytes) integer read.
+			for (unsigned short i = 0; i < n; ++i) {
+				if (m_iOffset >= m_iLength)
+					return -1;
+				val <<= 8;
+				val |= m_pData[m_iOffset++];
+			}
+		} else {
+			// Variable length integer read.
+			unsigned char c;
+			do {
+				if (m_iOffset >= m_iLength)
+					return -1;
+				c = m_pData[m_iOffset++];
+				val <<= 7;
+				val |= (c & 0x7f);
+			}
+			while ((c & 0x80) == 0x80);
+		}
+
+		return val;
+	}
+
+	// Raw data read method (in place).
+	const unsigned char *readData ( unsigned int n )
+	{
+		if (m_iOffset + n > m_iLength) {
+			m_iOffset = m_iLength;
+			return NULL;
+		}
+
+		const unsigned char *pData = m_pData + m_iOffset;
+		m_iOffset += n;
+		return pData;
+	}
+
+private:
+
+	// Instance variables.
+	const unsigned char *m_pData;
+	unsigned long m_iLength;
+	unsigned long m_iOffset;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiFileTrack -- SMF track chunk decoder.
+//
+class qtractorMidiFileTrack
+{
+public:
+
+	// Constructor.
+	qtractorMidiFileTrack ( const unsigned char *pData, unsigned long iLength,
+		unsigned short iTicksPerBeat, bool bFormat0,
+		qtractorMidiSequence **ppSeqs, unsigned short iSeqs,
+		unsigned short iSeqTrack, unsigned short iTrack,
+		unsigned short iChannelFilter )
+		: m_chunk(pData, iLength), m_iTicksPerBeat(iTicksPerBeat),
+			m_bFormat0(bFormat0), m_ppSeqs(ppSeqs), m_iSeqs(iSeqs),
+			m_iSeqTrack(iSeqTrack), m_iTrack(iTrack),
+			m_iChannelFilter(iChannelFilter), m_bResult(false) {}
+
+	// Decode the whole track chunk into sequence(s).
+	bool decode();
+
+	// Decoding outcome.
+	bool result() const
+		{ return m_bResult; }
+
+	// Commit tempo/time-signature nodes and markers.
+	void commit(qtractorMidiFileTempo *pTempoMap) const;
+
+private:
+
+	// Deferred tempo-map (META) event.
+	struct Meta
+	{
+		int            type;
+		unsigned long  time;
+		float          tempo;
+		unsigned short beatsPerBar;
+		unsigned short beatDivisor;
+		QString        text;
+	};
+
+	// Instance variables.
+	qtractorMidiFileChunk m_chunk;
+
+	unsigned short m_iTicksPerBeat;
+	bool           m_bFormat0;
+
+	qtractorMidiSequence **m_ppSeqs;
+	unsigned short m_iSeqs;
+	unsigned short m_iSeqTrack;
+	unsigned short m_iTrack;
+	unsigned short m_iChannelFilter;
+
+	QList<Meta>    m_metas;
+
+	bool           m_bResult;
+};
+
+
+// Decode the whole track chunk into sequence(s).
+bool qtractorMidiFileTrack::decode (void)
+{
+	// Expedite RPN/NRPN controllers processor...
+	qtractorMidiFileRpn xrpn;
+
+	qtractorMidiSequence *pSeq = NULL;
+
+	unsigned long iTrackTime  = 0;
+	unsigned int  iLastStatus = 0;
+	unsigned long iTimeout    = 0;
+
+	m_bResult = false;
+
+	// While this track lasts...
+	while (!m_chunk.isEnd()) {
+
+		// Read delta timestamp...
+		const int iDeltaTime = m_chunk.readInt();
+		if (iDeltaTime < 0)
+			break;
+		iTrackTime += iDeltaTime;
+
+		// Read probable status byte...
+		int iStatus = m_chunk.readInt(1);
+		if (iStatus < 0)
+			break;
+		// Maybe a running status byte?
+		if ((iStatus & 0x80) == 0) {
+			// Go back one byte...
+			m_chunk.unread();
+			iStatus = iLastStatus;
+		} else {
+			iLastStatus = iStatus;
+		}
+
+		const unsigned short iChannel = (iStatus & 0x0f);
+
+		qtractorMidiEvent *pEvent;
+		qtractorMidiEvent::EventType type
+			= qtractorMidiEvent::EventType(iStatus & 0xf0);
+		if (iStatus == qtractorMidiEvent::META)
+			type = qtractorMidiEvent::META;
+
+		// Make proper sequence reference...
+		unsigned short iSeq = 0;
+		if (m_iSeqs > 1)
+			iSeq = (m_bFormat0 ? iChannel : m_iTrack);
+		pSeq = m_ppSeqs[iSeq];
+
+		// Event time converted to sequence resolution...
+		const unsigned long iTime
+			= pSeq->timeq(iTrackTime, m_iTicksPerBeat);
+
+		// Check for sequence time length, if any...
+		if (pSeq->timeLength() > 0
+			&& iTime >= pSeq->timeOffset() + pSeq->timeLength())
+			break;
+
+		// Flush/timeout RPN/NRPN stuff...
+		if (iTimeout < iTime || type != qtractorMidiEvent::CONTROLLER) {
+			iTimeout = iTime + (pSeq->ticksPerBeat() >> 2);
+			xrpn.flush();
+		}
+
+		// Check whether it won't be channel filtered...
+		const bool bChannelEvent = (iTime >= pSeq->timeOffset()
+			&& ((m_iChannelFilter & 0xf0) || (m_iChannelFilter == iChannel)));
+
+		const unsigned char *data;
+		unsigned char data1, data2;
+		int len, meta;
+		unsigned int bank;
+
+		switch (type) {
+		case qtractorMidiEvent::NOTEOFF:
+		case qtractorMidiEvent::NOTEON:
+			data1 = m_chunk.readInt(1);
+			data2 = m_chunk.readInt(1);
+			// Check if its channel filtered...
+			if (bChannelEvent) {
+				if (data2 == 0 && type == qtractorMidiEvent::NOTEON)
+					type = qtractorMidiEvent::NOTEOFF;
+				pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
+				pSeq->addEvent(pEvent);
+				pSeq->setChannel(iChannel);
+			}
+			break;
+		case qtractorMidiEvent::KEYPRESS:
+			data1 = m_chunk.readInt(1);
+			data2 = m_chunk.readInt(1);
+			// Check if its channel filtered...
+			if (bChannelEvent) {
+				// Create the new event...
+				pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
+				pSeq->addEvent(pEvent);
+				pSeq->setChannel(iChannel);
+			}
+			break;
+		case qtractorMidiEvent::CONTROLLER:
+			data1 = m_chunk.readInt(1);
+			data2 = m_chunk.readInt(1);
+			// Check if its channel filtered...
+			if (bChannelEvent) {
+				// Check for RPN/NRPN stuff...
+				if (xrpn.process(iTime, m_iSeqTrack,
+					(qtractorMidiRpn::CC | iChannel), data1, data2)) {
+					iTimeout = iTime + (pSeq->ticksPerBeat() >> 2);
+					break;
+				}
+				// Create the new event...
+				pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
+				pSeq->addEvent(pEvent);
+				pSeq->setChannel(iChannel);
+				// Set the primordial bank patch...
+				switch (data1) {
+				case BANK_MSB:
+					// Bank MSB
+					if (pSeq->bankSelMethod() < 0)
+						pSeq->setBankSelMethod(1);
+					// Bank-select method (MSB)...
+					switch (pSeq->bankSelMethod()) {
+					case 1: // Bank MSB (current)
+						pSeq->setBank(data2);
+						break;
+					case 2: // Bank LSB (previous)
+						pSeq->setBankSelMethod(0);
+						// Fall thru...
+					case 0:
+					default:
+						bank = (pSeq->bank() < 0 ? 0 : (pSeq->bank() & 0x007f));
+						pSeq->setBank(bank | (data2 << 7));
+						break;
+					}
+					break;
+				case BANK_LSB:
+					// Bank LSB
+					if (pSeq->bankSelMethod() < 0)
+						pSeq->setBankSelMethod(2);
+					// Bank-select method (LSB)...
+					switch (pSeq->bankSelMethod()) {
+					case 1: // Bank MSB (previous)
+						bank = (pSeq->bank() < 0 ? 0 : (pSeq->bank() & 0x007f));
+						pSeq->setBank((bank << 7) | data2);
+						pSeq->setBankSelMethod(0);
+						break;
+					case 2: // Bank LSB (current)
+						pSeq->setBank(data2);
+						break;
+					case 0: // Normal
+					default:
+						bank = (pSeq->bank() < 0 ? 0 : (pSeq->bank() & 0x3f80));
+						pSeq->setBank(bank | data2);
+						break;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			break;
+		case qtractorMidiEvent::PGMCHANGE:
+			data1 = m_chunk.readInt(1);
+			data2 = 0x7f;
+			// Check if its channel filtered...
+			if (bChannelEvent) {
+				// Create the new event...
+				pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
+				pSeq->addEvent(pEvent);
+				pSeq->setChannel(iChannel);
+				// Set the primordial program patch...
+				if (pSeq->prog() < 0)
+					pSeq->setProg(data1);
+			}
+			break;
+		case qtractorMidiEvent::CHANPRESS:
+			data1 = 0;
+			data2 = m_chunk.readInt(1);
+			// Check if its channel filtered...
+			if (bChannelEvent) {
+				// Create the new event...
+				pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
+				pSeq->addEvent(pEvent);
+				pSeq->setChannel(iChannel);
+			}
+			break;
+		case qtractorMidiEvent::PITCHBEND:
+			data1 = m_chunk.readInt(1);
+			data2 = m_chunk.readInt(1);
+			// Check if its channel filtered...
+			if (bChannelEvent) {
+				const unsigned short value = (data2 << 7) | data1;
+				// Create the new event...
+				pEvent = new qtractorMidiEvent(iTime, type, 0, value);
+				pSeq->addEvent(pEvent);
+				pSeq->setChannel(iChannel);
+			}
+			break;
+		case qtractorMidiEvent::SYSEX:
+			len = m_chunk.readInt();
+			if (len < 1) {
+				m_chunk.end(); // Force EoT!
+				break;
+			}
+			data = m_chunk.readData(len);
+			if (data == NULL)
+				return false;
+			// Check if its channel filtered...
+			if (bChannelEvent) {
+				// Copy straight into the (pooled) event buffer...
+				pEvent = new qtractorMidiEvent(iTime, type);
+				unsigned char *sysex = pEvent->resizeSysex(1 + len);
+				sysex[0] = (unsigned char) type;	// Skip 0xf0 head.
+				::memcpy(&sysex[1], data, len);
+				pSeq->addEvent(pEvent);
+				pSeq->setChannel(iChannel);
+			}
+			break;
+		case qtractorMidiEvent::META:
+			meta = m_chunk.readInt(1);
+			// Get the meta data...
+			len = m_chunk.readInt();
+			if (len < 1) {
+			//	m_chunk.end(); // Force EoT!
+				break;
+			}
+			data = m_chunk.readData(len);
+			if (data == NULL)
+				return false;
+			// Now, we'll deal only with some...
+			switch (meta) {
+			case qtractorMidiEvent::TEMPO: {
+				unsigned int tempo = 0;
+				for (int i = 0; i < len; ++i)
+					tempo = (tempo << 8) | data[i];
+				if (tempo > 0) {
+					Meta item;
+					item.type  = meta;
+					item.time  = iTrackTime;
+					item.tempo = qtractorTimeScale::uroundf(
+						60000000.0f / float(tempo));
+					m_metas.append(item);
+				}
+				break;
+			}
+			case qtractorMidiEvent::TRACKNAME:
+				pSeq->setName(QString::fromLatin1((const char *) data,
+					::qstrnlen((const char *) data, len)).simplified());
+				break;
+			case qtractorMidiEvent::TIME:
+				// Beats per bar is the numerator of time signature...
+				if ((unsigned short) data[0] > 0) {
+					Meta item;
+					item.type = meta;
+					item.time = iTrackTime;
+					item.beatsPerBar = (unsigned short) data[0];
+					item.beatDivisor = (len > 1 ? (unsigned short) data[1] : 0);
+					m_metas.append(item);
+				}
+				break;
+			case qtractorMidiEvent::MARKER: {
+				Meta item;
+				item.type = meta;
+				item.time = iTrackTime;
+				item.text = QString::fromLatin1((const char *) data,
+					::qstrnlen((const char *) data, len)).simplified();
+				m_metas.append(item);
+				break;
+			}
+			default:
+				// Ignore all others...
+				break;
+			}
+			// Fall thru...
+		default:
+			break;
+		}
+
+		// Flush/pending RPN/NRPN stuff...
+		xrpn.dequeue(pSeq);
+	}
+
+	// Flush any left-over RPN/NRPN stuff...
+	if (pSeq) {
+		xrpn.flush();
+		xrpn.dequeue(pSeq);
+	}
+
+	m_bResult = true;
+	return true;
+}
+
+
+// Commit tempo/time-signature nodes and markers.
+void qtractorMidiFileTrack::commit ( qtractorMidiFileTempo *pTempoMap ) const
+{
+	QListIterator<Meta> iter(m_metas);
+	while (iter.hasNext()) {
+		const Meta& item = iter.next();
+		switch (item.type) {
+		case qtractorMidiEvent::TEMPO:
+			pTempoMap->addNodeTempo(item.time, item.tempo);
+			break;
+		case qtractorMidiEvent::TIME:
+			pTempoMap->addNodeTime(item.time,
+				item.beatsPerBar, item.beatDivisor);
+			break;
+		case qtractorMidiEvent::MARKER:
+			pTempoMap->addMarker(item.time, item.text);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiFileThread -- SMF track chunk decoder worker.
+//
+class qtractorMidiFileThread : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorMidiFileThread ( const QList<qtractorMidiFileTrack *>& tracks,
+		QAtomicInt& index ) : QThread(), m_tracks(tracks), m_index(index) {}
+
+	// Decode next available tracks, until none's left.
+	static void decode ( const QList<qtractorMidiFileTrack *>& tracks,
+		QAtomicInt& index )
+	{
+		const int iTracks = tracks.count();
+		for (;;) {
+			const int iTrack = index.fetchAndAddOrdered(1);
+			if (iTrack >= iTracks)
+				break;
+			tracks.at(iTrack)->decode();
+		}
+	}
+
+protected:
+
+	// The main thread executive.
+	void run() { decode(m_tracks, m_index); }
+
+private:
+
+	// Instance variables.
+	const QList<qtractorMidiFileTrack *>& m_tracks;
+	QAtomicInt& m_index;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiFileCache -- SMF track chunk index cache.
+//
+class qtractorMidiFileCache
+{
+public:
+
+	// Cached header and index.
+	struct Item
+	{
+		unsigned short format;
+		unsigned short tracks;
+		unsigned short ticksPerBeat;
+		QVector<qtractorMidiFile::TrackInfo> info;
+	};
+
+	// Singleton instance accessor.
+	static qtractorMidiFileCache *getInstance ()
+	{
+		static qtractorMidiFileCache s_cache;
+		return &s_cache;
+	}
+
+	// Cache lookup (most recently used).
+	bool find ( const QString& sKey, Item& item )
+	{
+		QMutexLocker locker(&m_mutex);
+
+		QHash<QString, Item>::ConstIterator iter = m_items.constFind(sKey);
+		if (iter == m_items.constEnd())
+			return false;
+
+		item = iter.value();
+
+		m_keys.removeAll(sKey);
+		m_keys.append(sKey);
+
+		return true;
+	}
+
+	// Cache (re)insertion, evicting the least recently used.
+	void insert ( const QString& sKey, const Item& item )
+	{
+		QMutexLocker locker(&m_mutex);
+
+		m_items.insert(sKey, item);
+
+		m_keys.removeAll(sKey);
+		m_keys.append(sKey);
+
+		while (m_keys.count() > QTRACTOR_MIDI_FILE_CACHE)
+			m_items.remove(m_keys.takeFirst());
+	}
+
+	// Cache track update (eg. once scanned).
+	void update ( const QString& sKey,
+		unsigned short iTrack, const qtractorMidiFile::TrackInfo& info )
+	{
+		QMutexLocker locker(&m_mutex);
+
+		QHash<QString, Item>::Iterator iter = m_items.find(sKey);
+		if (iter != m_items.end() && iTrack < iter.value().info.count())
+			iter.value().info[iTrack] = info;
+	}
+
+private:
+
+	// Instance variables.
+	QHash<QString, Item> m_items;
+	QList<QString> m_keys;
+
+	QMutex m_mutex;
+};
+
+
 
 //----------------------------------------------------------------------
 // class qtractorMidiFile -- A SMF (Standard MIDI File) class.
@@ -119,6 +706,12 @@ qtractorMidiFile::qtractorMidiFile (void)
 	m_pFile         = NULL;
 	m_iOffset       = 0;
 
+	// Whole file contents (read mode).
+	m_pData         = NULL;
+	m_iSize         = 0;
+	m_bMapped       = false;
+	m_iDataFd       = -1;
+
 	// Header informational data.
 	m_iFormat       = 0;
 	m_iTracks       = 0;
@@ -146,101 +739,272 @@ bool qtractorMidiFile::open ( const QString& sFilename, int iMode )
 	if (iMode == None)
 		iMode = Read;
 
-	const QByteArray aFilename = sFilename.toUtf8();
-	m_pFile = ::fopen(aFilename.constData(), iMode == Write ? "w+b" : "rb");
-	if (m_pFile == NULL)
+	// Write mode goes through the plain file stream...
+	if (iMode == Write) {
+		const QByteArray aFilename = sFilename.toUtf8();
+		m_pFile = ::fopen(aFilename.constData(), "w+b");
+		if (m_pFile == NULL)
+			return false;
+		m_sFilename = sFilename;
+		m_iMode     = iMode;
+		m_iOffset   = 0;
+		return true;
+	}
+
+	// Read mode: whole file contents, mapped in memory...
+	if (!openData(sFilename))
 		return false;
 
 	m_sFilename = sFilename;
 	m_iMode     = iMode;
 	m_iOffset   = 0;
 
-	// Bail out of here, if in write mode...
-	if (m_iMode == Write)
+	// Header and track chunk index, either cached or read...
+	if (!loadTrackInfo()) {
+		if (!readTrackInfo()) {
+			close();
+			return false;
+		}
+		saveTrackInfo();
+	}
+
+	// Special tempo/time-signature map.
+	m_pTempoMap = new qtractorMidiFileTempo(this);
+
+	// We're in business...
+	return true;
+}
+
+
+// Close file method.
+void qtractorMidiFile::close (void)
+{
+	if (m_pFile) {
+		::fclose(m_pFile);
+		m_pFile = NULL;
+	}
+
+	closeData();
+
+	if (m_pTrackInfo) {
+		delete [] m_pTrackInfo;
+		m_pTrackInfo = NULL;
+	}
+
+	if (m_pTempoMap) {
+		delete m_pTempoMap;
+		m_pTempoMap = NULL;
+	}
+}
+
+
+// Whole file contents (read mode).
+bool qtractorMidiFile::openData ( const QString& sFilename )
+{
+	closeData();
+
+#ifdef CONFIG_MMAP_FILE
+
+	const QByteArray aFilename = sFilename.toUtf8();
+	const int fd = ::open(aFilename.constData(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) < 0 || st.st_size < 14
+		|| (quint64) st.st_size != (quint64) (size_t) st.st_size) {
+		::close(fd);
+		return false;
+	}
+
+	// Private mapping, file descriptor kept open for size re-checks...
+	void *pMap = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (pMap != MAP_FAILED) {
+		// Hardly that big, so have it all read ahead...
+		::posix_madvise(pMap, st.st_size, POSIX_MADV_WILLNEED);
+		m_pData   = (const unsigned char *) pMap;
+		m_iSize   = st.st_size;
+		m_bMapped = true;
+		m_iDataFd = fd;
 		return true;
+	}
+
+	::close(fd);
 
+#endif
+
+	// Otherwise, just read it all at once...
+	QFile file(sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	m_data = file.readAll();
+	file.close();
+
+	if (m_data.size() < 14) {
+		m_data.clear();
+		return false;
+	}
+
+	m_pData = (const unsigned char *) m_data.constData();
+	m_iSize = m_data.size();
+
+	return true;
+}
+
+
+void qtractorMidiFile::closeData (void)
+{
+#ifdef CONFIG_MMAP_FILE
+	if (m_pData && m_bMapped)
+		::munmap((void *) m_pData, m_iSize);
+	if (m_iDataFd >= 0)
+		::close(m_iDataFd);
+#endif
+
+	m_data.clear();
+
+	m_pData   = NULL;
+	m_iSize   = 0;
+	m_bMapped = false;
+	m_iDataFd = -1;
+
+	m_sCacheKey.clear();
+}
+
+
+// Whether the whole file contents are still there; touching
+// mapped pages past a truncated end of file would raise SIGBUS.
+bool qtractorMidiFile::checkData (void) const
+{
+	if (m_pData == NULL)
+		return false;
+
+#ifdef CONFIG_MMAP_FILE
+	if (m_bMapped) {
+		struct stat st;
+		if (::fstat(m_iDataFd, &st) < 0
+			|| (quint64) st.st_size < (quint64) m_iSize)
+			return false;
+	}
+#endif
+
+	return true;
+}
+
+
+// Track chunk index (read mode).
+bool qtractorMidiFile::readTrackInfo (void)
+{
 	// First word must identify the file as a SMF;
 	// must be literal "MThd"
 	char header[5];
 	readData((unsigned char *) &header[0], 4); header[4] = (char) 0;
-	if (::strcmp(header, SMF_MTHD)) {
-		close();
+	if (::strcmp(header, SMF_MTHD))
 		return false;
-	}
 
 	// Second word should be the total header chunk length...
-	int iMThdLength = readInt(4);
-	if (iMThdLength < 6) {
-		close();
+	const int iMThdLength = readInt(4);
+	if (iMThdLength < 6)
 		return false;
-	}
 
 	// Read header data...
 	m_iFormat = (unsigned short) readInt(2);
 	m_iTracks = (unsigned short) readInt(2);
 	m_iTicksPerBeat = (unsigned short) readInt(2);
 	// Should skip any extra bytes...
-	while (iMThdLength > 6) {
-		if (::fgetc(m_pFile) < 0) {
-			close();
-			return false;
-		}
-		++m_iOffset;
-		--iMThdLength;
-	}
+	m_iOffset += (iMThdLength - 6);
+	if (m_iOffset > m_iSize)
+		return false;
 
 	// Allocate the track map.
 	m_pTrackInfo = new TrackInfo [m_iTracks];
-	for (int iTrack = 0; iTrack < m_iTracks; ++iTrack) {
-		// Must be a track header "MTrk"...
-		readData((unsigned char *) &header[0], 4); header[4] = (char) 0;
-		if (::strcmp(header, SMF_MTRK)) {
-			close();
+
+	unsigned short iTrack = 0;
+	while (iTrack < m_iTracks) {
+		// Must be a chunk header...
+		if (readData((unsigned char *) &header[0], 4) < 4)
 			return false;
-		}
-		// Check track chunk length...
-		const int iMTrkLength = readInt(4);
-		if (iMTrkLength < 0) {
-			close();
+		header[4] = (char) 0;
+		// Check chunk length...
+		const int iChunkLength = readInt(4);
+		if (iChunkLength < 0)
 			return false;
+		// Alien chunks are to be skipped...
+		if (::strcmp(header, SMF_MTRK)) {
+			m_iOffset += iChunkLength;
+			continue;
 		}
-		// Set this one track info.
-		m_pTrackInfo[iTrack].length = iMTrkLength;
-		m_pTrackInfo[iTrack].offset = m_iOffset;
+		// Set this one track info (truncated if short)...
+		TrackInfo& info = m_pTrackInfo[iTrack++];
+		::memset(&info, 0, sizeof(info));
+		info.offset = m_iOffset;
+		info.length = iChunkLength;
+		if (info.offset + info.length > m_iSize)
+			info.length = m_iSize - info.offset;
 		// Set next track offset...
-		m_iOffset += iMTrkLength;
-		// Advance to next one...
-		if (::fseek(m_pFile, m_iOffset, SEEK_SET)) {
-			close();
+		m_iOffset += iChunkLength;
+	}
+
+	return true;
+}
+
+
+// Track chunk index cache.
+bool qtractorMidiFile::loadTrackInfo (void)
+{
+	// Cache key: file path, size and modification time...
+	const QFileInfo fi(m_sFilename);
+	m_sCacheKey = fi.absoluteFilePath()
+		+ ':' + QString::number(fi.size())
+		+ ':' + QString::number(fi.lastModified().toMSecsSinceEpoch());
+
+	qtractorMidiFileCache::Item item;
+	if (!qtractorMidiFileCache::getInstance()->find(m_sCacheKey, item))
+		return false;
+
+	// Just make sure it's still the very same thing...
+	const unsigned short iTracks = item.info.count();
+	for (unsigned short iTrack = 0; iTrack < iTracks; ++iTrack) {
+		const TrackInfo& info = item.info.at(iTrack);
+		if (info.offset < 8 || info.offset + info.length > m_iSize
+			|| ::memcmp(m_pData + info.offset - 8, SMF_MTRK, 4))
 			return false;
-		}
 	}
 
-	// Special tempo/time-signature map.
-	m_pTempoMap = new qtractorMidiFileTempo(this);
+	m_iFormat = item.format;
+	m_iTracks = iTracks;
+	m_iTicksPerBeat = item.ticksPerBeat;
+
+	m_pTrackInfo = new TrackInfo [m_iTracks];
+	for (unsigned short iTrack = 0; iTrack < m_iTracks; ++iTrack)
+		m_pTrackInfo[iTrack] = item.info.at(iTrack);
 
-	// We're in business...
 	return true;
 }
 
 
-// Close file method.
-void qtractorMidiFile::close (void)
+void qtractorMidiFile::saveTrackInfo ( int iTrack )
 {
-	if (m_pFile) {
-		::fclose(m_pFile);
-		m_pFile = NULL;
-	}
+	if (m_sCacheKey.isEmpty() || m_pTrackInfo == NULL)
+		return;
 
-	if (m_pTrackInfo) {
-		delete [] m_pTrackInfo;
-		m_pTrackInfo = NULL;
-	}
+	qtractorMidiFileCache *pCache = qtractorMidiFileCache::getInstance();
 
-	if (m_pTempoMap) {
-		delete m_pTempoMap;
-		m_pTempoMap = NULL;
+	if (iTrack >= 0) {
+		pCache->update(m_sCacheKey, iTrack, m_pTrackInfo[iTrack]);
+		return;
 	}
+
+	qtractorMidiFileCache::Item item;
+	item.format = m_iFormat;
+	item.tracks = m_iTracks;
+	item.ticksPerBeat = m_iTicksPerBeat;
+	item.info.reserve(m_iTracks);
+	for (unsigned short i = 0; i < m_iTracks; ++i)
+		item.info.append(m_pTrackInfo[i]);
+
+	pCache->insert(m_sCacheKey, item);
 }
 
 
@@ -248,20 +1012,18 @@ void qtractorMidiFile::close (void)
 bool qtractorMidiFile::readTracks ( qtractorMidiSequence **ppSeqs,
 	unsigned short iSeqs, unsigned short iTrackChannel )
 {
-	if (m_pFile == NULL)
+	if (!checkData())
 		return false;
 	if (m_pTempoMap == NULL)
 		return false;
 	if (m_iMode != Read)
 		return false;
 
-	// Expedite RPN/NRPN controllers processor...
-	qtractorMidiFileRpn xrpn;
-
 	// So, how many tracks are we reading in a row?...
 	const unsigned short iSeqTracks = (iSeqs > 1 ? m_iTracks : 1);
 
-	// Go fetch them...
+	// Set up a decoder for each one...
+	QList<qtractorMidiFileTrack *> tracks;
 	for (unsigned short iSeqTrack = 0; iSeqTrack < iSeqTracks; ++iSeqTrack) {
 
 		// If under a format 0 file, we'll filter for one single channel.
@@ -269,283 +1031,64 @@ bool qtractorMidiFile::readTracks ( qtractorMidiSequence **ppSeqs,
 			iTrackChannel = iSeqTrack;
 
 		const unsigned short iTrack = (m_iFormat == 1 ? iTrackChannel : 0);
-		if (iTrack >= m_iTracks)
+		if (iTrack >= m_iTracks) {
+			qDeleteAll(tracks);
 			return false;
+		}
 
 		const unsigned short iChannelFilter
 			= (m_iFormat == 1 || iSeqs > 1 ? 0xf0 : iTrackChannel);
 
-		// Locate the desired track stuff...
-		const unsigned long iTrackStart = m_pTrackInfo[iTrack].offset;
-		if (iTrackStart != m_iOffset) {
-			if (::fseek(m_pFile, iTrackStart, SEEK_SET))
-				return false;
-			m_iOffset = iTrackStart;
-		}
-
-		// Now we're going into business...
-		const unsigned long iTrackEnd
-			= m_iOffset + m_pTrackInfo[iTrack].length;
-
-		unsigned long iTrackTime  = 0;
-		unsigned int  iLastStatus = 0;
-		unsigned long iTimeout    = 0;
-
-		// While this track lasts...
-		while (m_iOffset < iTrackEnd) {
-
-			// Read delta timestamp...
-			iTrackTime += readInt();
-
-			// Read probable status byte...
-			unsigned int iStatus = readInt(1);
-			// Maybe a running status byte?
-			if ((iStatus & 0x80) == 0) {
-				// Go back one byte...
-				::ungetc(iStatus, m_pFile);
-				--m_iOffset;
-				iStatus = iLastStatus;
-			} else {
-				iLastStatus = iStatus;
-			}
+		const TrackInfo& info = m_pTrackInfo[iTrack];
+		tracks.append(new qtractorMidiFileTrack(
+			m_pData + info.offset, info.length,
+			m_iTicksPerBeat, (m_iFormat == 0), ppSeqs, iSeqs,
+			iSeqTrack, iTrack, iChannelFilter));
+	}
 
-			const unsigned short iChannel = (iStatus & 0x0f);
+	// Tracks may be decoded in parallel, only if
+	// each one goes into its own sequence (SMF format 1)...
+	const int iTracks = tracks.count();
+	int iThreads = 0;
+	if (m_iFormat == 1 && iSeqs > 1 && iTracks >= QTRACTOR_MIDI_FILE_PARALLEL) {
+		iThreads = QThread::idealThreadCount() - 1;
+		if (iThreads > iTracks - 1)
+			iThreads = iTracks - 1;
+	}
 
-			qtractorMidiEvent *pEvent;
-			qtractorMidiEvent::EventType type
-				= qtractorMidiEvent::EventType(iStatus & 0xf0);
-			if (iStatus == qtractorMidiEvent::META)
-				type = qtractorMidiEvent::META;
-
-			// Make proper sequence reference...
-			unsigned short iSeq = 0;
-			if (iSeqs > 1)
-				iSeq = (m_iFormat == 0 ? iChannel : iTrack);
-			qtractorMidiSequence *pSeq = ppSeqs[iSeq];
-
-			// Event time converted to sequence resolution...
-			const unsigned long iTime
-				= pSeq->timeq(iTrackTime, m_iTicksPerBeat);
-
-			// Check for sequence time length, if any...
-			if (pSeq->timeLength() > 0
-				&& iTime >= pSeq->timeOffset() + pSeq->timeLength()) {
-				xrpn.flush();
-				xrpn.dequeue(pSeq);
-				break;
-			}
+	QAtomicInt index(0);
+	QList<qtractorMidiFileThread *> threads;
+	for (int i = 0; i < iThreads; ++i) {
+		qtractorMidiFileThread *pThread
+			= new qtractorMidiFileThread(tracks, index);
+		pThread->start();
+		threads.append(pThread);
+	}
 
-			// Flush/timeout RPN/NRPN stuff...
-			if (iTimeout < iTime || type != qtractorMidiEvent::CONTROLLER) {
-				iTimeout = iTime + (pSeq->ticksPerBeat() >> 2);
-				xrpn.flush();
-			}
+	// Do our own share of the work...
+	qtractorMidiFileThread::decode(tracks, index);
 
-			// Check whether it won't be channel filtered...
-			const bool bChannelEvent = (iTime >= pSeq->timeOffset()
-				&& ((iChannelFilter & 0xf0) || (iChannelFilter == iChannel)));
-
-			unsigned char *data, data1, data2;
-			unsigned int len, meta, bank;
-
-			switch (type) {
-			case qtractorMidiEvent::NOTEOFF:
-			case qtractorMidiEvent::NOTEON:
-				data1 = readInt(1);
-				data2 = readInt(1);
-				// Check if its channel filtered...
-				if (bChannelEvent) {
-					if (data2 == 0 && type == qtractorMidiEvent::NOTEON)
-						type = qtractorMidiEvent::NOTEOFF;
-					pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
-					pSeq->addEvent(pEvent);
-					pSeq->setChannel(iChannel);
-				}
-				break;
-			case qtractorMidiEvent::KEYPRESS:
-				data1 = readInt(1);
-				data2 = readInt(1);
-				// Check if its channel filtered...
-				if (bChannelEvent) {
-					// Create the new event...
-					pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
-					pSeq->addEvent(pEvent);
-					pSeq->setChannel(iChannel);
-				}
-				break;
-			case qtractorMidiEvent::CONTROLLER:
-				data1 = readInt(1);
-				data2 = readInt(1);
-				// Check if its channel filtered...
-				if (bChannelEvent) {
-					// Check for RPN/NRPN stuff...
-					if (xrpn.process(iTime, iSeqTrack,
-						(qtractorMidiRpn::CC | iChannel), data1, data2)) {
-						iTimeout = iTime + (pSeq->ticksPerBeat() >> 2);
-						break;
-					}
-					// Create the new event...
-					pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
-					pSeq->addEvent(pEvent);
-					pSeq->setChannel(iChannel);
-					// Set the primordial bank patch...
-					switch (data1) {
-					case BANK_MSB:
-						// Bank MSB
-						if (pSeq->bankSelMethod() < 0)
-							pSeq->setBankSelMethod(1);
-						// Bank-select method (MSB)...
-						switch (pSeq->bankSelMethod()) {
-						case 1: // Bank MSB (current)
-							pSeq->setBank(data2);
-							break;
-						case 2: // Bank LSB (previous)
-							pSeq->setBankSelMethod(0);
-							// Fall thru...
-						case 0:
-						default:
-							bank = (pSeq->bank() < 0 ? 0 : (pSeq->bank() & 0x007f));
-							pSeq->setBank(bank | (data2 << 7));
-							break;
-						}
-						break;
-					case BANK_LSB:
-						// Bank LSB
-						if (pSeq->bankSelMethod() < 0)
-							pSeq->setBankSelMethod(2);
-						// Bank-select method (LSB)...
-						switch (pSeq->bankSelMethod()) {
-						case 1: // Bank MSB (previous)
-							bank = (pSeq->bank() < 0 ? 0 : (pSeq->bank() & 0x007f));
-							pSeq->setBank((bank << 7) | data2);
-							pSeq->setBankSelMethod(0);
-							break;
-						case 2: // Bank LSB (current)
-							pSeq->setBank(data2);
-							break;
-						case 0: // Normal
-						default:
-							bank = (pSeq->bank() < 0 ? 0 : (pSeq->bank() & 0x3f80));
-							pSeq->setBank(bank | data2);
-							break;
-						}
-						break;
-					default:
-						break;
-					}
-				}
-				break;
-			case qtractorMidiEvent::PGMCHANGE:
-				data1 = readInt(1);
-				data2 = 0x7f;
-				// Check if its channel filtered...
-				if (bChannelEvent) {
-					// Create the new event...
-					pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
-					pSeq->addEvent(pEvent);
-					pSeq->setChannel(iChannel);
-					// Set the primordial program patch...
-					if (pSeq->prog() < 0)
-						pSeq->setProg(data1);
-				}
-				break;
-			case qtractorMidiEvent::CHANPRESS:
-				data1 = 0;
-				data2 = readInt(1);
-				// Check if its channel filtered...
-				if (bChannelEvent) {
-					// Create the new event...
-					pEvent = new qtractorMidiEvent(iTime, type, data1, data2);
-					pSeq->addEvent(pEvent);
-					pSeq->setChannel(iChannel);
-				}
-				break;
-			case qtractorMidiEvent::PITCHBEND:
-				data1 = readInt(1);
-				data2 = readInt(1);
-				// Check if its channel filtered...
-				if (bChannelEvent) {
-					const unsigned short value = (data2 << 7) | data1;
-					// Create the new event...
-					pEvent = new qtractorMidiEvent(iTime, type, 0, value);
-					pSeq->addEvent(pEvent);
-					pSeq->setChannel(iChannel);
-				}
-				break;
-			case qtractorMidiEvent::SYSEX:
-				len = readInt();
-				if ((int) len < 1) {
-					m_iOffset = iTrackEnd; // Force EoT!
-					break;
-				}
-				data = new unsigned char [1 + len];
-				data[0] = (unsigned char) type;	// Skip 0xf0 head.
-				if (readData(&data[1], len) < (int) len) {
-					delete [] data;
-					return false;
-				}
-				// Check if its channel filtered...
-				if (bChannelEvent) {
-					pEvent = new qtractorMidiEvent(iTime, type);
-					pEvent->setSysex(data, 1 + len);
-					pSeq->addEvent(pEvent);
-					pSeq->setChannel(iChannel);
-				}
-				delete [] data;
-				break;
-			case qtractorMidiEvent::META:
-				meta = qtractorMidiEvent::MetaType(readInt(1));
-				// Get the meta data...
-				len = readInt();
-				if ((int) len < 1) {
-				//	m_iOffset = iTrackEnd; // Force EoT!
-					break;
-				}
-				if (meta == qtractorMidiEvent::TEMPO) {
-					m_pTempoMap->addNodeTempo(iTrackTime,
-						qtractorTimeScale::uroundf(
-							60000000.0f / float(readInt(len))));
-				} else {
-					data = new unsigned char [len + 1];
-					if (readData(data, len) < (int) len) {
-						delete [] data;
-						return false;
-					}
-					data[len] = (unsigned char) 0;
-					// Now, we'll deal only with some...
-					switch (meta) {
-					case qtractorMidiEvent::TRACKNAME:
-						pSeq->setName(
-							QString::fromLatin1((const char *) data).simplified());
-						break;
-					case qtractorMidiEvent::TIME:
-						// Beats per bar is the numerator of time signature...
-						if ((unsigned short) data[0] > 0) {
-							m_pTempoMap->addNodeTime(iTrackTime,
-								(unsigned short) data[0],
-								(unsigned short) data[1]);
-						}
-						break;
-					case qtractorMidiEvent::MARKER:
-						m_pTempoMap->addMarker(iTrackTime,
-							QString::fromLatin1((const char *) data).simplified());
-						break;
-					default:
-						// Ignore all others...
-						break;
-					}
-					delete [] data;
-				}
-				// Fall thru...
-			default:
-				break;
-			}
+	while (!threads.isEmpty()) {
+		qtractorMidiFileThread *pThread = threads.takeFirst();
+		pThread->wait();
+		delete pThread;
+	}
 
-			// Flush/pending RPN/NRPN stuff...
-			xrpn.dequeue(pSeq);
-		}
+	// Tempo-map nodes and markers, in track order...
+	bool bResult = true;
+	QListIterator<qtractorMidiFileTrack *> iter(tracks);
+	while (iter.hasNext()) {
+		qtractorMidiFileTrack *pTrack = iter.next();
+		pTrack->commit(m_pTempoMap);
+		if (!pTrack->result())
+			bResult = false;
 	}
 
+	qDeleteAll(tracks);
+
+	if (!bResult)
+		return false;
+
 	// FIXME: Commit the sequence(s) length...
 	for (unsigned short iSeq = 0; iSeq < iSeqs; ++iSeq)
 		ppSeqs[iSeq]->close();
@@ -576,57 +1119,76 @@ bool qtractorMidiFile::readTrack ( qtractorMidiSequence *pSeq,
 // Sequence/track/channel duration reader helper.
 unsigned long qtractorMidiFile::readTrackDuration ( unsigned short iTrackChannel )
 {
-	if (m_pFile == NULL)
-		return 0;
+	const TrackScan *pScan = trackScan(iTrackChannel);
+	return (pScan ? pScan->duration : 0);
+}
+
+
+// Track chunk summary, scanned only once.
+const qtractorMidiFile::TrackScan *qtractorMidiFile::trackScan (
+	unsigned short iTrackChannel )
+{
+	if (!checkData())
+		return NULL;
 	if (m_iMode != Read)
-		return 0;
+		return NULL;
 
 	const unsigned short iTrack = (m_iFormat == 1 ? iTrackChannel : 0);
 	if (iTrack >= m_iTracks)
-		return 0;
+		return NULL;
+
+	TrackInfo& info = m_pTrackInfo[iTrack];
+	if (!info.scanned) {
+		scanTrack(info);
+		saveTrackInfo(iTrack);
+	}
 
 	const unsigned short iChannelFilter
 		= (m_iFormat == 1 ? 0xf0 : iTrackChannel);
+	if (iChannelFilter & 0xf0)
+		return &info.track;
+	else
+		return &info.channels[iChannelFilter];
+}
 
-	// Locate the desired track stuff...
-	const unsigned long iTrackStart = m_pTrackInfo[iTrack].offset;
-	if (iTrackStart != m_iOffset) {
-		if (::fseek(m_pFile, iTrackStart, SEEK_SET))
-			return 0;
-		m_iOffset = iTrackStart;
-	}
 
-	// Now we're going into business...
-	const unsigned long iTrackEnd
-		= m_iOffset + m_pTrackInfo[iTrack].length;
+// Track chunk summary scanner.
+void qtractorMidiFile::scanTrack ( TrackInfo& info ) const
+{
+	::memset(&info.track, 0, sizeof(info.track));
+	::memset(&info.channels, 0, sizeof(info.channels));
 
-	unsigned long iTrackDuration = 0;
+	qtractorMidiFileChunk chunk(m_pData + info.offset, info.length);
 
 	unsigned long iTrackTime  = 0;
 	unsigned int  iLastStatus = 0;
 
 	// While this track lasts...
-	while (m_iOffset < iTrackEnd) {
+	while (!chunk.isEnd()) {
 
 		// Read delta timestamp...
-		iTrackTime += readInt();
+		const int iDeltaTime = chunk.readInt();
+		if (iDeltaTime < 0)
+			break;
+		iTrackTime += iDeltaTime;
 
 		// Read probable status byte...
-		unsigned int iStatus = readInt(1);
+		int iStatus = chunk.readInt(1);
+		if (iStatus < 0)
+			break;
 		// Maybe a running status byte?
 		if ((iStatus & 0x80) == 0) {
 			// Go back one byte...
-			::ungetc(iStatus, m_pFile);
-			--m_iOffset;
+			chunk.unread();
 			iStatus = iLastStatus;
 		} else {
 			iLastStatus = iStatus;
 		}
 
-		// Check whether it won't be channel filtered...
-		const unsigned short iChannel = (iStatus & 0x0f);
-		if ((iChannelFilter & 0xf0) || (iChannelFilter == iChannel))
-			iTrackDuration = iTrackTime;
+		// Last event time, whether channel filtered or not...
+		TrackScan& scan = info.channels[iStatus & 0x0f];
+		scan.duration = iTrackTime;
+		info.track.duration = iTrackTime;
 
 		qtractorMidiEvent::EventType type
 			= qtractorMidiEvent::EventType(iStatus & 0xf0);
@@ -634,34 +1196,32 @@ unsigned long qtractorMidiFile::readTrackDuration ( unsigned short iTrackChannel
 			type = qtractorMidiEvent::META;
 
 		switch (type) {
-		case qtractorMidiEvent::NOTEOFF:
 		case qtractorMidiEvent::NOTEON:
+		case qtractorMidiEvent::NOTEOFF:
 		case qtractorMidiEvent::KEYPRESS:
 		case qtractorMidiEvent::CONTROLLER:
 		case qtractorMidiEvent::PITCHBEND:
-			readInt(2);
+			chunk.readData(2);
 			break;
 		case qtractorMidiEvent::PGMCHANGE:
 		case qtractorMidiEvent::CHANPRESS:
-			readInt(1);
+			chunk.readData(1);
 			break;
 		case qtractorMidiEvent::META:
-			readInt(1);
+			chunk.readInt(1);
 			// Fall thru...
-		case qtractorMidiEvent::SYSEX:
-		{
-			int n = readInt();
-			if (n < 1 || ::fseek(m_pFile, m_iOffset + n, SEEK_SET))
-				m_iOffset = iTrackEnd; // Force EoT!
-			else
-				m_iOffset += n;
-		}	// Fall thru...
+		case qtractorMidiEvent::SYSEX: {
+			const int n = chunk.readInt();
+			if (n < 1 || chunk.readData(n) == NULL)
+				chunk.end(); // Force EoT!
+			break;
+		}
 		default:
 			break;
 		}
 	}
 
-	return iTrackDuration;
+	info.scanned = true;
 }
 
 
@@ -1168,7 +1728,7 @@ bool qtractorMidiFile::writeTrack ( qtractorMidiSequence *pSeq )
 }
 
 
-// Integer read method.
+// Integer read method (header only).
 int qtractorMidiFile::readInt ( unsigned short n )
 {
 	int c, val = 0;
@@ -1177,21 +1737,19 @@ int qtractorMidiFile::readInt ( unsigned short n )
 		// Fixed length (n bytes) integer read.
 		for (int i = 0; i < n; ++i) {
 			val <<= 8;
-			c = ::fgetc(m_pFile);
-			if (c < 0)
+			if (m_iOffset >= m_iSize)
 				return -1;
+			c = m_pData[m_iOffset++];
 			val |= c;
-			++m_iOffset;
 		}
 	} else {
 		// Variable length integer read.
 		do {
-			c = ::fgetc(m_pFile);
-			if (c < 0)
+			if (m_iOffset >= m_iSize)
 				return -1;
+			c = m_pData[m_iOffset++];
 			val <<= 7;
 			val |= (c & 0x7f);
-			++m_iOffset;
 		}
 		while ((c & 0x80) == 0x80);
 	}
@@ -1200,12 +1758,16 @@ int qtractorMidiFile::readInt ( unsigned short n )
 }
 
 
-// Raw data read method.
+// Raw data read method (header only).
 int qtractorMidiFile::readData ( unsigned char *pData, unsigned short n )
 {
-	const int nread = ::fread(pData, sizeof(unsigned char), n, m_pFile);
-	if (nread > 0)
+	int nread = n;
+	if (m_iOffset + nread > m_iSize)
+		nread = m_iSize - m_iOffset;
+	if (nread > 0) {
+		::memcpy(pData, m_pData + m_iOffset, nread);
 		m_iOffset += nread;
+	}
 	return nread;
 }
 
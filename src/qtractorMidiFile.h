@@ -88,12 +88,46 @@ public:
 	static QString createFilePathRevision(
 		const QString& sFilename, int iRevision = 0);
 
+	// Track chunk summary (scanned once, cached).
+	struct TrackScan
+	{
+		unsigned long duration;
+	};
+
+	// Track chunk index entry.
+	struct TrackInfo
+	{
+		unsigned int  length;
+		unsigned long offset;
+		bool          scanned;
+		TrackScan     track;
+		TrackScan     channels[16];
+	};
+
 protected:
 
-	// Read methods.
+	// Read methods (header only).
 	int readInt   (unsigned short n = 0);
 	int readData  (unsigned char *pData, unsigned short n);
 
+	// Whole file contents (read mode).
+	bool openData(const QString& sFilename);
+	void closeData();
+
+	// Whether the whole file contents are still there (SIGBUS safe-guard).
+	bool checkData() const;
+
+	// Track chunk index (read mode).
+	bool readTrackInfo();
+
+	// Track chunk index cache.
+	bool loadTrackInfo();
+	void saveTrackInfo(int iTrack = -1);
+
+	// Track chunk summary scanner.
+	void scanTrack(TrackInfo& info) const;
+	const TrackScan *trackScan(unsigned short iTrackChannel);
+
 	// Write methods.
 	int writeInt  (int val, unsigned short n = 0);
 	int writeData (unsigned char *pData, unsigned short n);
@@ -114,16 +148,23 @@ private:
 	FILE          *m_pFile;
 	unsigned long  m_iOffset;
 
+	// Whole file contents (read mode).
+	const unsigned char *m_pData;
+	unsigned long  m_iSize;
+	bool           m_bMapped;
+	int            m_iDataFd;
+	QByteArray     m_data;
+
+	// Track chunk index cache key.
+	QString        m_sCacheKey;
+
 	// Header informational data.
 	unsigned short m_iFormat;
 	unsigned short m_iTracks;
 	unsigned short m_iTicksPerBeat;
 
 	// Track info map.
-	struct TrackInfo {
-		unsigned int  length;
-		unsigned long offset;
-	} *m_pTrackInfo;
+	TrackInfo     *m_pTrackInfo;
 
 	// Special tempo/time-signature map.
 	qtractorMidiFileTempo *m_pTempoMap;
@@ -0,0 +1,389 @@
+// qtractorMidiJackPort.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorMidiJackPort.h"
+
+#ifdef CONFIG_JACK_MIDI
+
+#include <jack/midiport.h>
+
+#include <string.h>
+
+
+// Direct raw event ring buffer size (in bytes).
+#define QTRACTOR_MIDI_JACK_DIRECT	0x4000
+
+// Raw (decoded) channel event maximum size,
+// eg. (N)RPN decode as four controllers.
+#define QTRACTOR_MIDI_JACK_RAW		16
+
+// Queued SysEx payload arena size (in bytes).
+#define QTRACTOR_MIDI_JACK_SYSEX	0x10000
+
+
+// Queued SysEx arena chunk header.
+struct qtractorMidiJackSysex
+{
+	unsigned long time;	// event frame-time.
+	unsigned int  size;	// payload size; zero skips to arena end.
+};
+
+// Arena chunk size (header plus payload, header aligned).
+static inline unsigned int qtractorMidiJackSysex_size ( unsigned int iSize )
+{
+	const unsigned int iAlign = sizeof(qtractorMidiJackSysex);
+	return iAlign + ((iSize + iAlign - 1) / iAlign) * iAlign;
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiJackPort -- JACK MIDI output port.
+//
+
+// Constructor.
+qtractorMidiJackPort::qtractorMidiJackPort ( unsigned int iBufferSize )
+	: m_pJackClient(NULL), m_pJackPort(NULL),
+		m_queuedBuffer(iBufferSize), m_postedBuffer(iBufferSize),
+		m_iTimeDone(0), m_pMidiParser(NULL), m_pDirectParser(NULL)
+{
+	m_pDirectBuffer = ::jack_ringbuffer_create(QTRACTOR_MIDI_JACK_DIRECT);
+
+	m_pSysexData = new unsigned char [QTRACTOR_MIDI_JACK_SYSEX];
+	sysexReset();
+
+	if (snd_midi_event_new(4, &m_pMidiParser) == 0)
+		snd_midi_event_no_status(m_pMidiParser, 1);
+	if (snd_midi_event_new(4, &m_pDirectParser) == 0)
+		snd_midi_event_no_status(m_pDirectParser, 1);
+}
+
+
+// Destructor.
+qtractorMidiJackPort::~qtractorMidiJackPort (void)
+{
+	close();
+
+	if (m_pDirectParser)
+		snd_midi_event_free(m_pDirectParser);
+	if (m_pMidiParser)
+		snd_midi_event_free(m_pMidiParser);
+
+	::jack_ringbuffer_free(m_pDirectBuffer);
+
+	delete [] m_pSysexData;
+}
+
+
+// Port (un)registration.
+bool qtractorMidiJackPort::open (
+	jack_client_t *pJackClient, const QString& sPortName )
+{
+	close();
+
+	if (pJackClient == NULL)
+		return false;
+
+	m_pJackPort = ::jack_port_register(pJackClient,
+		sPortName.toUtf8().constData(),
+		JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+	if (m_pJackPort == NULL)
+		return false;
+
+	m_pJackClient = pJackClient;
+
+	m_queuedBuffer.clear();
+	m_postedBuffer.clear();
+
+	::jack_ringbuffer_reset(m_pDirectBuffer);
+
+	sysexReset();
+
+	return true;
+}
+
+
+void qtractorMidiJackPort::close (void)
+{
+	if (m_pJackPort && m_pJackClient)
+		::jack_port_unregister(m_pJackClient, m_pJackPort);
+
+	m_pJackPort = NULL;
+	m_pJackClient = NULL;
+}
+
+
+// Scheduled event queue (frame-time; output thread only).
+bool qtractorMidiJackPort::queued (
+	snd_seq_event_t *pEv, unsigned long iTime, unsigned long iTimeOff )
+{
+	// Notes get split as the sequencer would have done...
+	if (pEv->type == SND_SEQ_EVENT_NOTE) {
+		snd_seq_event_t ev = *pEv;
+		ev.type = SND_SEQ_EVENT_NOTEON;
+		if (!m_queuedBuffer.insert(&ev, iTime))
+			return false;
+		ev.type = SND_SEQ_EVENT_NOTEOFF;
+		ev.data.note.velocity = 0;
+		ev.data.note.duration = 0;
+		// Zero-length notes must not be turned off before on...
+		if (iTimeOff <= iTime)
+			iTimeOff = iTime + 1;
+		return m_postedBuffer.insert(&ev, iTimeOff);
+	}
+
+	// SysEx payload gets copied, as it might not last long enough...
+	if (pEv->type == SND_SEQ_EVENT_SYSEX) {
+		const unsigned int iSysex = pEv->data.ext.len;
+		if (iSysex < 1)
+			return false;
+		unsigned char *pSysex = sysexAlloc(iSysex, iTime);
+		if (pSysex == NULL)
+			return false;
+		::memcpy(pSysex, pEv->data.ext.ptr, iSysex);
+		snd_seq_event_t ev = *pEv;
+		ev.data.ext.ptr = pSysex;
+		return m_queuedBuffer.insert(&ev, iTime);
+	}
+
+	if (pEv->type == SND_SEQ_EVENT_NOTEOFF)
+		return m_postedBuffer.insert(pEv, iTime);
+	else
+		return m_queuedBuffer.insert(pEv, iTime);
+}
+
+
+// Direct (immediate) event output.
+bool qtractorMidiJackPort::direct ( snd_seq_event_t *pEv )
+{
+	QMutexLocker locker(&m_mutex);
+
+	unsigned char midiData[QTRACTOR_MIDI_JACK_RAW];
+	unsigned char *pMidiData = &midiData[0];
+	unsigned int iMidiData = 0;
+
+	if (pEv->type == SND_SEQ_EVENT_SYSEX) {
+		pMidiData = (unsigned char *) pEv->data.ext.ptr;
+		iMidiData = pEv->data.ext.len;
+	}
+	else
+	if (m_pDirectParser) {
+		const long iDecoded = snd_midi_event_decode(
+			m_pDirectParser, pMidiData, sizeof(midiData), pEv);
+		if (iDecoded > 0)
+			iMidiData = iDecoded;
+	}
+
+	if (iMidiData < 1)
+		return false;
+
+	const size_t iSize = sizeof(iMidiData) + iMidiData;
+	if (::jack_ringbuffer_write_space(m_pDirectBuffer) < iSize)
+		return false;
+
+	::jack_ringbuffer_write(m_pDirectBuffer,
+		(const char *) &iMidiData, sizeof(iMidiData));
+	::jack_ringbuffer_write(m_pDirectBuffer,
+		(const char *) pMidiData, iMidiData);
+
+	return true;
+}
+
+
+// Withdraw already queued channel events (eg. track mute).
+void qtractorMidiJackPort::remove ( unsigned char tag, unsigned char channel )
+{
+	// Pending note-offs are left alone, on purpose.
+	m_queuedBuffer.remove(tag, channel);
+}
+
+
+// Drop all queued events, flushing pending note-offs.
+void qtractorMidiJackPort::reset (void)
+{
+	m_queuedBuffer.clear();
+	m_postedBuffer.reset(); // due right away.
+
+	sysexReset();
+
+	if (m_pMidiParser)
+		snd_midi_event_reset_decode(m_pMidiParser);
+}
+
+
+// Process cycle (RT-safe).
+void qtractorMidiJackPort::process (
+	unsigned long iTimeStart, unsigned long iTimeEnd, unsigned int nframes )
+{
+	if (m_pJackPort == NULL)
+		return;
+
+	void *pJackBuffer = ::jack_port_get_buffer(m_pJackPort, nframes);
+	if (pJackBuffer == NULL)
+		return;
+
+	::jack_midi_clear_buffer(pJackBuffer);
+
+	// Direct events go first, right on cycle start...
+	unsigned int iMidiData = 0;
+	size_t iReadSpace = ::jack_ringbuffer_read_space(m_pDirectBuffer);
+	while (iReadSpace > sizeof(iMidiData)) {
+		::jack_ringbuffer_peek(m_pDirectBuffer,
+			(char *) &iMidiData, sizeof(iMidiData));
+		// Not yet complete?
+		if (iReadSpace < sizeof(iMidiData) + iMidiData)
+			break;
+		::jack_ringbuffer_read_advance(m_pDirectBuffer, sizeof(iMidiData));
+		jack_midi_data_t *pMidiData
+			= ::jack_midi_event_reserve(pJackBuffer, 0, iMidiData);
+		if (pMidiData)
+			::jack_ringbuffer_read(m_pDirectBuffer, (char *) pMidiData, iMidiData);
+		else
+			::jack_ringbuffer_read_advance(m_pDirectBuffer, iMidiData);
+		iReadSpace -= sizeof(iMidiData) + iMidiData;
+	}
+
+	// Queued/posted events (merge)...
+	snd_seq_event_t *pEv1 = m_queuedBuffer.peek();
+	snd_seq_event_t *pEv2 = m_postedBuffer.peek();
+
+	while ((pEv1 && pEv1->time.tick < iTimeEnd)
+		|| (pEv2 && pEv2->time.tick < iTimeEnd)) {
+		// Note-offs go first, on the very same frame...
+		while (pEv2 && pEv2->time.tick < iTimeEnd
+			&& (pEv1 == NULL || pEv2->time.tick <= pEv1->time.tick)) {
+			write(pJackBuffer, (pEv2->time.tick > iTimeStart
+				? pEv2->time.tick - iTimeStart : 0), pEv2);
+			pEv2 = m_postedBuffer.next();
+		}
+		while (pEv1 && pEv1->time.tick < iTimeEnd
+			&& (pEv2 == NULL || pEv1->time.tick < pEv2->time.tick)) {
+			write(pJackBuffer, (pEv1->time.tick > iTimeStart
+				? pEv1->time.tick - iTimeStart : 0), pEv1);
+			pEv1 = m_queuedBuffer.next();
+		}
+	}
+
+	// Queued SysEx payloads up to here may be reclaimed.
+	m_iTimeDone = iTimeEnd;
+}
+
+
+// Write one event to the port buffer (RT-safe).
+void qtractorMidiJackPort::write ( void *pJackBuffer,
+	jack_nframes_t iOffset, snd_seq_event_t *pEv )
+{
+	if (pEv->type == SND_SEQ_EVENT_SYSEX) {
+		const size_t iMidiData = pEv->data.ext.len;
+		jack_midi_data_t *pMidiData
+			= ::jack_midi_event_reserve(pJackBuffer, iOffset, iMidiData);
+		if (pMidiData)
+			::memcpy(pMidiData, pEv->data.ext.ptr, iMidiData);
+		return;
+	}
+
+	if (m_pMidiParser == NULL)
+		return;
+
+	unsigned char midiData[QTRACTOR_MIDI_JACK_RAW];
+	const long iMidiData = snd_midi_event_decode(
+		m_pMidiParser, midiData, sizeof(midiData), pEv);
+	if (iMidiData > 0)
+		::jack_midi_event_write(pJackBuffer, iOffset, midiData, iMidiData);
+}
+
+
+// Queued SysEx arena allocator (output thread only).
+unsigned char *qtractorMidiJackPort::sysexAlloc (
+	unsigned int iSize, unsigned long iTime )
+{
+	const unsigned int iArena = QTRACTOR_MIDI_JACK_SYSEX;
+
+	// Reclaim chunks already written out...
+	const unsigned long iTimeDone = m_iTimeDone;
+	while (m_iSysexUsed > 0) {
+		qtractorMidiJackSysex *pChunk
+			= (qtractorMidiJackSysex *) (m_pSysexData + m_iSysexTail);
+		if (pChunk->size == 0) {
+			m_iSysexUsed -= iArena - m_iSysexTail;
+			m_iSysexTail = 0;
+			continue;
+		}
+		if (pChunk->time >= iTimeDone)
+			break;
+		const unsigned int iChunk = qtractorMidiJackSysex_size(pChunk->size);
+		m_iSysexUsed -= iChunk;
+		m_iSysexTail += iChunk;
+		if (m_iSysexTail >= iArena)
+			m_iSysexTail = 0;
+	}
+
+	if (m_iSysexUsed == 0)
+		m_iSysexHead = m_iSysexTail = 0;
+
+	const unsigned int iChunk = qtractorMidiJackSysex_size(iSize);
+	if (m_iSysexUsed + iChunk > iArena)
+		return NULL;
+
+	if (m_iSysexHead >= m_iSysexTail) {
+		const unsigned int iEnd = iArena - m_iSysexHead;
+		if (iEnd < iChunk) {
+			// Wrap around, skipping the arena end...
+			if (m_iSysexTail < iChunk)
+				return NULL;
+			qtractorMidiJackSysex *pSkip
+				= (qtractorMidiJackSysex *) (m_pSysexData + m_iSysexHead);
+			pSkip->time = iTime;
+			pSkip->size = 0;
+			m_iSysexUsed += iEnd;
+			m_iSysexHead = 0;
+		}
+	}
+	else
+	if (m_iSysexTail - m_iSysexHead < iChunk)
+		return NULL;
+
+	qtractorMidiJackSysex *pChunk
+		= (qtractorMidiJackSysex *) (m_pSysexData + m_iSysexHead);
+	pChunk->time = iTime;
+	pChunk->size = iSize;
+
+	m_iSysexUsed += iChunk;
+	m_iSysexHead += iChunk;
+	if (m_iSysexHead >= iArena)
+		m_iSysexHead = 0;
+
+	return (unsigned char *) (pChunk + 1);
+}
+
+
+void qtractorMidiJackPort::sysexReset (void)
+{
+	m_iSysexHead = 0;
+	m_iSysexTail = 0;
+	m_iSysexUsed = 0;
+}
+
+
+#endif	// CONFIG_JACK_MIDI
+
+
+// end of qtractorMidiJackPort.cpp
@@ -0,0 +1,134 @@
+// qtractorMidiJackPort.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorMidiJackPort_h
+#define __qtractorMidiJackPort_h
+
+#include "qtractorAbout.h"
+
+#ifdef CONFIG_JACK_MIDI
+
+#include "qtractorMidiBuffer.h"
+
+#include <jack/jack.h>
+#include <jack/ringbuffer.h>
+
+#include <QMutex>
+#include <QString>
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiJackPort -- JACK MIDI output port.
+//
+// Scheduled events are queued by the MIDI output thread, in the very
+// same frame-time domain as plugin MIDI managers, then written out
+// sample-accurately on each JACK process cycle; direct (immediate)
+// events are raw-encoded on a lock-free ring buffer instead.
+//
+// Queued SysEx payloads are copied into a port-owned arena, as the
+// original data may well be gone before the event is written out.
+//
+
+class qtractorMidiJackPort
+{
+public:
+
+	// Constructor.
+	qtractorMidiJackPort(unsigned int iBufferSize
+		= (qtractorMidiBuffer::MinBufferSize << 2));
+
+	// Destructor.
+	~qtractorMidiJackPort();
+
+	// Port (un)registration.
+	bool open(jack_client_t *pJackClient, const QString& sPortName);
+	void close();
+
+	// JACK port accessor.
+	jack_port_t *jackPort() const
+		{ return m_pJackPort; }
+
+	// Scheduled event queue (frame-time; output thread only).
+	bool queued(snd_seq_event_t *pEv,
+		unsigned long iTime, unsigned long iTimeOff = 0);
+
+	// Direct (immediate) event output.
+	bool direct(snd_seq_event_t *pEv);
+
+	// Withdraw already queued channel events (eg. track mute);
+	// must be called with the session locked.
+	void remove(unsigned char tag, unsigned char channel);
+
+	// Drop all queued events, flushing pending note-offs;
+	// must be called with the session locked.
+	void reset();
+
+	// Process cycle (RT-safe).
+	void process(unsigned long iTimeStart,
+		unsigned long iTimeEnd, unsigned int nframes);
+
+protected:
+
+	// Write one event to the port buffer (RT-safe).
+	void write(void *pJackBuffer,
+		jack_nframes_t iOffset, snd_seq_event_t *pEv);
+
+	// Queued SysEx arena allocator (output thread only).
+	unsigned char *sysexAlloc(unsigned int iSize, unsigned long iTime);
+	void sysexReset();
+
+private:
+
+	// Instance variables.
+	jack_client_t *m_pJackClient;
+	jack_port_t   *m_pJackPort;
+
+	// Scheduled event buffers.
+	qtractorMidiBuffer m_queuedBuffer;
+	qtractorMidiBuffer m_postedBuffer;
+
+	// Direct raw event ring buffer.
+	jack_ringbuffer_t *m_pDirectBuffer;
+
+	// Queued SysEx payload arena (chunk ring).
+	unsigned char *m_pSysexData;
+	unsigned int   m_iSysexHead;
+	unsigned int   m_iSysexTail;
+	unsigned int   m_iSysexUsed;
+
+	// Last processed cycle end time (JACK thread only).
+	volatile unsigned long m_iTimeDone;
+
+	// Raw MIDI decoders (process and direct).
+	snd_midi_event_t *m_pMidiParser;
+	snd_midi_event_t *m_pDirectParser;
+
+	// Direct producers serialization.
+	QMutex m_mutex;
+};
+
+
+#endif	// CONFIG_JACK_MIDI
+
+#endif  // __qtractorMidiJackPort_h
+
+
+// end of qtractorMidiJackPort.h
@@ -21,6 +21,221 @@
 
 #include "qtractorMidiSequence.h"
 
+#include <QThread>
+
+
+// Event index block size (split threshold is twice as much).
+#define QTRACTOR_MIDI_INDEX_BLOCK	256
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiEventIndex -- MIDI event time index (sorted blocks).
+//
+
+// Constructor.
+qtractorMidiEventIndex::qtractorMidiEventIndex (void) : m_iCount(0)
+{
+	ATOMIC_SET(&m_busy, 0);
+}
+
+
+// Destructor.
+qtractorMidiEventIndex::~qtractorMidiEventIndex (void)
+{
+	clear();
+}
+
+
+// Index reset method.
+void qtractorMidiEventIndex::clear (void)
+{
+	lock();
+
+	qDeleteAll(m_blocks);
+	m_blocks.clear();
+	m_iCount = 0;
+
+	unlock();
+}
+
+
+// Exclusive access (writer side).
+void qtractorMidiEventIndex::lock (void) const
+{
+	while (!ATOMIC_TAS(&m_busy))
+		QThread::yieldCurrentThread();
+}
+
+void qtractorMidiEventIndex::unlock (void) const
+{
+	ATOMIC_SET(&m_busy, 0);
+}
+
+
+// Last block whose first event time is not after given time
+// (or the very first block, if none).
+int qtractorMidiEventIndex::findBlockUpper ( unsigned long iTime ) const
+{
+	int lo = 0;
+	int hi = m_blocks.count() - 1;
+	while (lo < hi) {
+		const int mid = (lo + hi + 1) >> 1;
+		if (m_blocks.at(mid)->first()->time() <= iTime)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+
+// First block whose last event time is not before given time
+// (or past the last block, if none).
+int qtractorMidiEventIndex::findBlockLower ( unsigned long iTime ) const
+{
+	int lo = 0;
+	int hi = m_blocks.count();
+	while (lo < hi) {
+		const int mid = (lo + hi) >> 1;
+		if (m_blocks.at(mid)->last()->time() < iTime)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+
+// Index an event after all others of same or earlier time.
+qtractorMidiEvent *qtractorMidiEventIndex::insert ( qtractorMidiEvent *pEvent )
+{
+	const unsigned long iTime = pEvent->time();
+
+	qtractorMidiEvent *pEventAfter = NULL;
+
+	lock();
+
+	if (m_blocks.isEmpty())
+		m_blocks.append(new Block());
+
+	// Find the proper block...
+	const int iBlock = findBlockUpper(iTime);
+	Block *pBlock = m_blocks.at(iBlock);
+
+	// Find the proper position in block (upper bound)...
+	int lo = 0;
+	int hi = pBlock->count();
+	if (hi > 0 && pBlock->last()->time() <= iTime) {
+		lo = hi; // Append fast path.
+	} else {
+		while (lo < hi) {
+			const int mid = (lo + hi) >> 1;
+			if (pBlock->at(mid)->time() <= iTime)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+	}
+
+	if (lo > 0)
+		pEventAfter = pBlock->at(lo - 1);
+	else
+	if (iBlock > 0)
+		pEventAfter = m_blocks.at(iBlock - 1)->last();
+
+	pBlock->insert(lo, pEvent);
+	++m_iCount;
+
+	// Split block in halves when too big...
+	const int iBlockSize = pBlock->count();
+	if (iBlockSize >= (QTRACTOR_MIDI_INDEX_BLOCK << 1)) {
+		const int iHalf = (iBlockSize >> 1);
+		Block *pNewBlock = new Block(pBlock->mid(iHalf));
+		pBlock->resize(iHalf);
+		m_blocks.insert(iBlock + 1, pNewBlock);
+	}
+
+	unlock();
+
+	return pEventAfter;
+}
+
+
+// Drop an event from the index.
+void qtractorMidiEventIndex::remove ( qtractorMidiEvent *pEvent )
+{
+	lock();
+
+	const unsigned long iTime = pEvent->time();
+	const int iBlocks = m_blocks.count();
+
+	int iBlock = findBlockLower(iTime);
+	int iIndex = -1;
+
+	// Look among all of the same time...
+	for ( ; iBlock < iBlocks && iIndex < 0; ++iBlock) {
+		Block *pBlock = m_blocks.at(iBlock);
+		if (pBlock->first()->time() > iTime)
+			break;
+		iIndex = pBlock->indexOf(pEvent);
+		if (iIndex >= 0)
+			break;
+	}
+
+	// Not where it should be? (time changed while indexed)...
+	if (iIndex < 0) {
+		for (iBlock = 0; iBlock < iBlocks && iIndex < 0; ++iBlock) {
+			iIndex = m_blocks.at(iBlock)->indexOf(pEvent);
+			if (iIndex >= 0)
+				break;
+		}
+	}
+
+	if (iIndex >= 0) {
+		Block *pBlock = m_blocks.at(iBlock);
+		pBlock->remove(iIndex);
+		--m_iCount;
+		if (pBlock->isEmpty()) {
+			m_blocks.remove(iBlock);
+			delete pBlock;
+		}
+	}
+
+	unlock();
+}
+
+
+// First event at or after given time (NULL if none).
+bool qtractorMidiEventIndex::seek (
+	unsigned long iTime, qtractorMidiEvent *& pEvent ) const
+{
+	// Never wait on the reader side (eg. MIDI output thread)...
+	if (!ATOMIC_TAS(&m_busy))
+		return false;
+
+	pEvent = NULL;
+
+	const int iBlock = findBlockLower(iTime);
+	if (iBlock < m_blocks.count()) {
+		const Block *pBlock = m_blocks.at(iBlock);
+		int lo = 0;
+		int hi = pBlock->count();
+		while (lo < hi) {
+			const int mid = (lo + hi) >> 1;
+			if (pBlock->at(mid)->time() < iTime)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < pBlock->count())
+			pEvent = pBlock->at(lo);
+	}
+
+	unlock();
+
+	return true;
+}
+
 
 //----------------------------------------------------------------------
 // class qtractorMidiSequence -- The generic MIDI event sequence buffer.
@@ -39,6 +254,8 @@ qtractorMidiSequence::qtractorMidiSequence ( const QString& sName,
 
 	m_events.setAutoDelete(true);
 
+	m_iRevision = 0;
+
 	m_noteMax = 0;
 	m_noteMin = 0;
 
@@ -66,6 +283,9 @@ void qtractorMidiSequence::clear (void)
 
 	m_duration = 0;
 
+	++m_iRevision;
+
+	m_index.clear();
 	m_events.clear();
 	m_notes.clear();
 }
@@ -99,6 +319,7 @@ void qtractorMidiSequence::addEvent ( qtractorMidiEvent *pEvent )
 					m_duration = t2;
 			}
 			m_notes.erase(iter_last);
+			++m_iRevision;
 		}
 		// NOTEOFF: Won't own this any longer...
 		delete pEvent;
@@ -126,9 +347,7 @@ void qtractorMidiSequence::addEvent ( qtractorMidiEvent *pEvent )
 void qtractorMidiSequence::insertEvent ( qtractorMidiEvent *pEvent )
 {
 	// Find the proper position in time sequence...
-	qtractorMidiEvent *pEventAfter = m_events.last();
-	while (pEventAfter && pEventAfter->time() > pEvent->time())
-		pEventAfter = pEventAfter->prev();
+	qtractorMidiEvent *pEventAfter = m_index.insert(pEvent);
 
 	// Insert it...
 	if (pEventAfter)
@@ -136,6 +355,8 @@ void qtractorMidiSequence::insertEvent ( qtractorMidiEvent *pEvent )
 	else
 		m_events.prepend(pEvent);
 
+	++m_iRevision;
+
 	unsigned long iTime = pEvent->time();
 	// NOTEON: Keep note stats and make it pending on a NOTEOFF...
 	if (pEvent->type() == qtractorMidiEvent::NOTEON) {
@@ -154,17 +375,41 @@ void qtractorMidiSequence::insertEvent ( qtractorMidiEvent *pEvent )
 // Unlink event from a channel sequence.
 void qtractorMidiSequence::unlinkEvent ( qtractorMidiEvent *pEvent )
 {
+	m_index.remove(pEvent);
 	m_events.unlink(pEvent);
+
+	++m_iRevision;
 }
 
 
 // Remove event from a channel sequence.
 void qtractorMidiSequence::removeEvent ( qtractorMidiEvent *pEvent )
 {
+	++m_iRevision;
+
+	m_index.remove(pEvent);
 	m_events.remove(pEvent);
 }
 
 
+// Event time index seek: last event before given time,
+// otherwise the very first one (NULL when index is busy).
+qtractorMidiEvent *qtractorMidiSequence::seekEvent ( unsigned long iTime ) const
+{
+	qtractorMidiEvent *pEvent = NULL;
+	if (!m_index.seek(iTime, pEvent))
+		return NULL;
+
+	if (pEvent == NULL)
+		return m_events.last();
+	else
+	if (pEvent->prev())
+		return pEvent->prev();
+	else
+		return pEvent;
+}
+
+
 // Sequence closure method.
 void qtractorMidiSequence::close (void)
 {
@@ -184,6 +429,8 @@ void qtractorMidiSequence::close (void)
 
 	// Reset all pending notes.
 	m_notes.clear();
+
+	++m_iRevision;
 }
 
 
@@ -232,12 +479,18 @@ void qtractorMidiSequence::replaceEvents ( qtractorMidiSequence *pSeq,
 void qtractorMidiSequence::copyEvents ( qtractorMidiSequence *pSeq )
 {
 	// Remove existing events.
+	++m_iRevision;
+
+	m_index.clear();
 	m_events.clear();
 	
 	// Clone new ones...
 	qtractorMidiEvent *pEvent = pSeq->events().first();
-	for (; pEvent; pEvent = pEvent->next())
-		m_events.append(new qtractorMidiEvent(*pEvent));
+	for (; pEvent; pEvent = pEvent->next()) {
+		qtractorMidiEvent *pNewEvent = new qtractorMidiEvent(*pEvent);
+		m_index.insert(pNewEvent);
+		m_events.append(pNewEvent);
+	}
 
 	// Done.
 }
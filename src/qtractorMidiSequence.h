@@ -23,14 +23,74 @@
 #define __qtractorMidiSequence_h
 
 #include "qtractorMidiEvent.h"
+#include "qtractorAtomic.h"
 
 #include <QString>
 #include <QMultiHash>
+#include <QVector>
 
 // typedef unsigned long long uint64_t;
 #include <stdint.h>
 
 
+//----------------------------------------------------------------------
+// class qtractorMidiEventIndex -- MIDI event time index (sorted blocks).
+//
+// Keeps the very same order as the sequence event list, as an array of
+// small sorted blocks of event references, giving logarithmic time seek
+// and insert positioning on the longest and most dense sequences.
+//
+
+class qtractorMidiEventIndex
+{
+public:
+
+	// Constructor.
+	qtractorMidiEventIndex();
+
+	// Destructor.
+	~qtractorMidiEventIndex();
+
+	// Index reset method.
+	void clear();
+
+	// Index an event after all others of same or earlier time;
+	// returns the event it must be linked after (NULL=prepend).
+	qtractorMidiEvent *insert(qtractorMidiEvent *pEvent);
+
+	// Drop an event from the index (same time as indexed).
+	void remove(qtractorMidiEvent *pEvent);
+
+	// First event at or after given time (NULL if none);
+	// return false if index is busy (caller should walk instead).
+	bool seek(unsigned long iTime, qtractorMidiEvent *& pEvent) const;
+
+	// Number of indexed events.
+	unsigned int count() const { return m_iCount; }
+
+protected:
+
+	// Block locators (binary search).
+	int findBlockUpper(unsigned long iTime) const;
+	int findBlockLower(unsigned long iTime) const;
+
+	// Exclusive access (writer side spins, reader side bails out).
+	void lock() const;
+	void unlock() const;
+
+private:
+
+	// Sorted block of event references.
+	typedef QVector<qtractorMidiEvent *> Block;
+
+	// Instance variables.
+	QVector<Block *> m_blocks;
+	unsigned int     m_iCount;
+
+	mutable qtractorAtomic m_busy;
+};
+
+
 //----------------------------------------------------------------------
 // class qtractorMidiSequence -- The generic MIDI event sequence buffer.
 //
@@ -101,6 +161,10 @@ public:
 	// Event list accessor.
 	const qtractorList<qtractorMidiEvent>& events() const { return m_events; }
 
+	// Event time index seek: last event before given time,
+	// otherwise the very first one (as expected by cursors).
+	qtractorMidiEvent *seekEvent(unsigned long iTime) const;
+
 	// Event list management methods.
 	void addEvent    (qtractorMidiEvent *pEvent);
 	void insertEvent (qtractorMidiEvent *pEvent);
@@ -123,6 +187,10 @@ public:
 	// Sequence closure method.
 	void close();
 
+	// Content revision (bumped on every change).
+	unsigned int revision() const { return m_iRevision; }
+	void touch() { ++m_iRevision; }
+
 	// Typed hash table to track note-ons.
 	typedef QMultiHash<unsigned char, qtractorMidiEvent *> NoteMap;
 
@@ -150,8 +218,14 @@ private:
 	// Sequence instance event list (all same MIDI channel).
 	qtractorList<qtractorMidiEvent> m_events;
 
+	// Sequence instance event time index.
+	qtractorMidiEventIndex m_index;
+
 	// Local hash table to track note-ons.
 	NoteMap m_notes;
+
+	// Content revision (eg. for playback snapshots).
+	volatile unsigned int m_iRevision;
 };
 
 
@@ -0,0 +1,297 @@
+// qtractorMidiSnapshot.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorMidiSnapshot.h"
+
+#include "qtractorMidiSequence.h"
+#include "qtractorMidiClip.h"
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiSnapshot -- MIDI sequence playback snapshot.
+//
+
+// Constructor.
+qtractorMidiSnapshot::qtractorMidiSnapshot ( qtractorMidiSequence *pSeq,
+	qtractorTimeScale::Reader& reader, unsigned long iClipStart )
+	: m_pSeq(pSeq), m_iRevision(pSeq->revision()), m_iTimeScaleRevision(0),
+		m_iClipStart(iClipStart), m_bValid(false), m_iCount(0)
+{
+	// The immutable tempo-map copy (not the live one)...
+	const qtractorTimeScale::Snapshot *pTimeSnapshot = reader.snapshot();
+	if (pTimeSnapshot)
+		m_iTimeScaleRevision = pTimeSnapshot->revision();
+
+	m_iClipStartTime = reader.tickFromFrame(iClipStart);
+
+	const int iEvents = pSeq->events().count();
+
+	m_times.reserve(iEvents);
+	m_frames.reserve(iEvents);
+	m_durations.reserve(iEvents);
+	m_params.reserve(iEvents);
+	m_values.reserve(iEvents);
+	m_types.reserve(iEvents);
+
+	qtractorMidiEvent *pEvent = pSeq->events().first();
+	while (pEvent && int(m_iCount) < iEvents) {
+		const unsigned long iTime = pEvent->time();
+		m_times.append(iTime);
+		m_frames.append(m_iClipStartTime + iTime);
+		m_types.append((unsigned char) pEvent->type());
+		if (pEvent->type() == qtractorMidiEvent::SYSEX) {
+			// SysEx payload gets copied, to be owned...
+			m_params.append(0);
+			m_values.append((unsigned short) m_sysex.count());
+			m_durations.append(0);
+			m_sysex.append(new qtractorMidiEvent(*pEvent));
+		} else {
+			m_params.append(pEvent->param());
+			m_values.append(pEvent->value());
+			m_durations.append(pEvent->duration());
+		}
+		++m_iCount;
+		pEvent = pEvent->next();
+	}
+
+	// Event frames, all converted in one (batch) pass...
+	unsigned long *pFrames = m_frames.data();
+	reader.framesFromTicks(pFrames, pFrames, m_iCount);
+	for (unsigned int i = 0; i < m_iCount; ++i) {
+		const unsigned long iFrame = pFrames[i];
+		pFrames[i] = (iFrame > iClipStart ? iFrame - iClipStart : 0);
+	}
+
+	m_pTimes     = m_times.constData();
+	m_pFrames    = m_frames.constData();
+	m_pDurations = m_durations.constData();
+	m_pParams    = m_params.constData();
+	m_pValues    = m_values.constData();
+	m_pTypes     = m_types.constData();
+
+	// Only valid if nothing has changed in the meantime...
+	m_bValid = (pTimeSnapshot != NULL
+		&& m_iRevision == pSeq->revision()
+		&& m_iTimeScaleRevision == reader.timeScale()->revision()
+		&& m_sysex.count() < 0x10000);
+}
+
+
+// Destructor.
+qtractorMidiSnapshot::~qtractorMidiSnapshot (void)
+{
+	qDeleteAll(m_sysex);
+	m_sysex.clear();
+}
+
+
+// Whether it still reflects the sequence and tempo-map.
+bool qtractorMidiSnapshot::isCurrent ( qtractorMidiSequence *pSeq,
+	qtractorTimeScale *pTimeScale, unsigned long iClipStart ) const
+{
+	return (m_pSeq == pSeq
+		&& m_iRevision == pSeq->revision()
+		&& m_iTimeScaleRevision == pTimeScale->revision()
+		&& m_iClipStart == iClipStart);
+}
+
+
+// First event index at or after given time.
+unsigned int qtractorMidiSnapshot::seek (
+	unsigned long iTime, unsigned int iHint ) const
+{
+	// Most likely, right where we've left off...
+	if (iHint <= m_iCount
+		&& (iHint == 0 || m_pTimes[iHint - 1] < iTime)
+		&& (iHint == m_iCount || m_pTimes[iHint] >= iTime))
+		return iHint;
+
+	// Otherwise, binary search (lower bound)...
+	unsigned int lo = 0;
+	unsigned int hi = m_iCount;
+	while (lo < hi) {
+		const unsigned int mid = (lo + hi) >> 1;
+		if (m_pTimes[mid] < iTime)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiSnapshotThread -- MIDI playback snapshot builder.
+//
+
+// Constructor.
+qtractorMidiSnapshotThread::qtractorMidiSnapshotThread (
+	unsigned int iSyncSize ) : QThread()
+{
+	m_iSyncSize = 128;
+	while (m_iSyncSize < iSyncSize)
+		m_iSyncSize <<= 1;
+	m_iSyncMask = (m_iSyncSize - 1);
+	m_pSyncItems = new QAtomicPointer<qtractorMidiClip> [m_iSyncSize];
+
+	ATOMIC_SET(&m_syncWrite, 0);
+	m_iSyncRead = 0;
+
+	m_pActive = NULL;
+
+	m_bRunState = false;
+}
+
+
+// Destructor.
+qtractorMidiSnapshotThread::~qtractorMidiSnapshotThread (void)
+{
+	if (isRunning()) do {
+		setRunState(false);
+	//	terminate();
+	} while (!wait(100));
+
+	delete [] m_pSyncItems;
+}
+
+
+// Thread run state accessors.
+void qtractorMidiSnapshotThread::setRunState ( bool bRunState )
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_bRunState = bRunState;
+
+	if (!m_bRunState)
+		m_cond.wakeAll();
+}
+
+bool qtractorMidiSnapshotThread::runState (void) const
+{
+	return m_bRunState;
+}
+
+
+// Post a clip snapshot (re)build request (RT-safe).
+bool qtractorMidiSnapshotThread::sync ( qtractorMidiClip *pMidiClip )
+{
+	// Reserve a request slot (there may be concurrent producers)...
+	unsigned int w;
+	do {
+		w = ATOMIC_GET(&m_syncWrite);
+		if (w - m_iSyncRead >= m_iSyncMask)
+			return false;
+	} while (!ATOMIC_CAS(&m_syncWrite, w, w + 1));
+
+	m_pSyncItems[w & m_iSyncMask].fetchAndStoreOrdered(pMidiClip);
+
+	if (m_mutex.tryLock()) {
+		m_cond.wakeAll();
+		m_mutex.unlock();
+	}
+
+	return true;
+}
+
+
+// Withdraw all requests of a closing clip (non RT-safe).
+void qtractorMidiSnapshotThread::cancel ( qtractorMidiClip *pMidiClip )
+{
+	QMutexLocker locker(&m_mutex);
+
+	drain();
+
+	m_pending.removeAll(pMidiClip);
+
+	while (m_pActive == pMidiClip)
+		m_idle.wait(&m_mutex);
+}
+
+
+// Sequence edit exclusion (non RT-safe).
+void qtractorMidiSnapshotThread::lockEdit (void)
+{
+	m_edit.lock();
+}
+
+void qtractorMidiSnapshotThread::unlockEdit (void)
+{
+	m_edit.unlock();
+
+	// Resume building, if anything's left pending...
+	QMutexLocker locker(&m_mutex);
+	m_cond.wakeAll();
+}
+
+
+// The main thread executive.
+void qtractorMidiSnapshotThread::run (void)
+{
+	m_mutex.lock();
+
+	m_bRunState = true;
+
+	while (m_bRunState) {
+		// Build whatever's pending, but not while editing...
+		drain();
+		if (!m_pending.isEmpty() && m_edit.tryLock()) {
+			m_pActive = m_pending.takeFirst();
+			m_mutex.unlock();
+			m_pActive->updateSnapshot();
+			m_mutex.lock();
+			m_pActive = NULL;
+			m_edit.unlock();
+			m_idle.wakeAll();
+			continue;
+		}
+		// Wait for sync...
+		m_cond.wait(&m_mutex);
+	}
+
+	m_mutex.unlock();
+}
+
+
+// Move all posted requests into the pending list;
+// must be called with the mutex locked.
+void qtractorMidiSnapshotThread::drain (void)
+{
+	unsigned int r = m_iSyncRead;
+	const unsigned int w = ATOMIC_GET(&m_syncWrite);
+
+	while (r != w) {
+		// Slot reserved but not yet published?
+		qtractorMidiClip *pMidiClip
+			= m_pSyncItems[r & m_iSyncMask].fetchAndStoreOrdered(NULL);
+		if (pMidiClip == NULL)
+			break;
+		if (!m_pending.contains(pMidiClip))
+			m_pending.append(pMidiClip);
+		++r;
+	}
+
+	m_iSyncRead = r;
+}
+
+
+// end of qtractorMidiSnapshot.cpp
@@ -0,0 +1,206 @@
+// qtractorMidiSnapshot.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorMidiSnapshot_h
+#define __qtractorMidiSnapshot_h
+
+#include "qtractorMidiEvent.h"
+#include "qtractorTimeScale.h"
+#include "qtractorAtomic.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicPointer>
+
+#include <QVector>
+#include <QList>
+
+
+// Forward declarations.
+class qtractorMidiSequence;
+class qtractorMidiClip;
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiSnapshot -- MIDI sequence playback snapshot.
+//
+// An immutable and flat (struct-of-arrays) copy of a clip sequence,
+// with event frame times precomputed under the current tempo-map
+// snapshot; the sequence must not be edited while it's being taken
+// (cf. qtractorMidiSnapshotThread::lockEdit).
+//
+
+class qtractorMidiSnapshot
+{
+public:
+
+	// Constructor.
+	qtractorMidiSnapshot(qtractorMidiSequence *pSeq,
+		qtractorTimeScale::Reader& reader, unsigned long iClipStart);
+
+	// Destructor.
+	~qtractorMidiSnapshot();
+
+	// Whether it was taken without any concurrent change.
+	bool isValid() const { return m_bValid; }
+
+	// Whether it still reflects the sequence and tempo-map.
+	bool isCurrent(qtractorMidiSequence *pSeq,
+		qtractorTimeScale *pTimeScale, unsigned long iClipStart) const;
+
+	// Clip start time (in ticks).
+	unsigned long clipStartTime() const { return m_iClipStartTime; }
+
+	// Number of events.
+	unsigned int count() const { return m_iCount; }
+
+	// Flat event data accessors.
+	unsigned long  time(unsigned int i)  const { return m_pTimes[i]; }
+	unsigned long  frame(unsigned int i) const { return m_pFrames[i]; }
+
+	unsigned long duration(unsigned int i) const
+		{ return m_pDurations[i]; }
+
+	qtractorMidiEvent::EventType type(unsigned int i) const
+		{ return qtractorMidiEvent::EventType(m_pTypes[i]); }
+
+	// Event proxy: fills in a transient (non-SysEx) event,
+	// unless it's a SysEx, which the snapshot owns a copy of.
+	qtractorMidiEvent *event(unsigned int i, qtractorMidiEvent& ev) const
+	{
+		if (m_pTypes[i] == qtractorMidiEvent::SYSEX)
+			return m_sysex.at(m_pValues[i]);
+		ev.setTime(m_pTimes[i]);
+		ev.setType(type(i));
+		ev.setParam(m_pParams[i]);
+		ev.setValue(m_pValues[i]);
+		ev.setDuration(m_pDurations[i]);
+		return &ev;
+	}
+
+	// First event index at or after given time (ticks,
+	// relative to clip start); the hint index is checked
+	// first, as playback goes mostly forward.
+	unsigned int seek(unsigned long iTime, unsigned int iHint = 0) const;
+
+private:
+
+	// Snapshot keys.
+	qtractorMidiSequence *m_pSeq;
+	unsigned int  m_iRevision;
+	unsigned int  m_iTimeScaleRevision;
+	unsigned long m_iClipStart;
+	unsigned long m_iClipStartTime;
+
+	bool m_bValid;
+
+	// Flat event data (struct-of-arrays).
+	unsigned int m_iCount;
+
+	QVector<unsigned long>  m_times;
+	QVector<unsigned long>  m_frames;
+	QVector<unsigned long>  m_durations;
+	QVector<unsigned short> m_params;
+	QVector<unsigned short> m_values;
+	QVector<unsigned char>  m_types;
+
+	// Raw data pointers (for speed).
+	const unsigned long  *m_pTimes;
+	const unsigned long  *m_pFrames;
+	const unsigned long  *m_pDurations;
+	const unsigned short *m_pParams;
+	const unsigned short *m_pValues;
+	const unsigned char  *m_pTypes;
+
+	// Owned SysEx event copies.
+	QList<qtractorMidiEvent *> m_sysex;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiSnapshotThread -- MIDI playback snapshot builder.
+//
+
+class qtractorMidiSnapshotThread : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorMidiSnapshotThread(unsigned int iSyncSize = 1024);
+
+	// Destructor.
+	~qtractorMidiSnapshotThread();
+
+	// Thread run state accessors.
+	void setRunState(bool bRunState);
+	bool runState() const;
+
+	// Post a clip snapshot (re)build request (RT-safe).
+	bool sync(qtractorMidiClip *pMidiClip);
+
+	// Withdraw all requests of a closing clip (non RT-safe).
+	void cancel(qtractorMidiClip *pMidiClip);
+
+	// Sequence edit exclusion: no snapshot gets built
+	// while any clip sequence is being changed (non RT-safe).
+	void lockEdit();
+	void unlockEdit();
+
+protected:
+
+	// The main thread executive.
+	void run();
+
+	// Move all posted requests into the pending list.
+	void drain();
+
+private:
+
+	// Multi-producer request ring (free-running counters).
+	unsigned int    m_iSyncSize;
+	unsigned int    m_iSyncMask;
+	QAtomicPointer<qtractorMidiClip> *m_pSyncItems;
+
+	qtractorAtomic  m_syncWrite;
+	volatile unsigned int m_iSyncRead;
+
+	// Pending and currently in-flight requests.
+	QList<qtractorMidiClip *> m_pending;
+	qtractorMidiClip *m_pActive;
+
+	// Whether the thread is logically running.
+	volatile bool m_bRunState;
+
+	// Thread synchronization objects.
+	QMutex m_mutex;
+	QWaitCondition m_cond;
+	QWaitCondition m_idle;
+
+	// Sequence edit exclusion.
+	QMutex m_edit;
+};
+
+
+#endif  // __qtractorMidiSnapshot_h
+
+
+// end of qtractorMidiSnapshot.h
@@ -0,0 +1,760 @@
+// qtractorMidiTools.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorMidiTools.h"
+
+#include "qtractorMidiEditCommand.h"
+#include "qtractorMidiEditSelect.h"
+#include "qtractorMidiEditor.h"
+
+#include "qtractorTimeScale.h"
+#include "qtractorSession.h"
+
+#include "qtractorMainForm.h"
+
+#include "qtractorAtomic.h"
+
+#include <QApplication>
+#include <QProgressBar>
+
+#include <QThread>
+#include <QVector>
+
+#include <stdlib.h>
+#include <math.h>
+
+
+// Minimum number of selected events worth transforming in parallel.
+#define QTRACTOR_MIDI_TOOLS_PARALLEL	0x1000
+
+// Number of events transformed per chunk.
+#define QTRACTOR_MIDI_TOOLS_CHUNK		0x200
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiToolsBatch -- MIDI tools chunked batch transform.
+//
+class qtractorMidiToolsBatch
+{
+public:
+
+	// Transformed event record.
+	struct Result
+	{
+		int           note;
+		unsigned long time;
+		unsigned long duration;
+		int           value;
+		unsigned int  flags;
+	};
+
+	// Constructor.
+	qtractorMidiToolsBatch ( const qtractorMidiTools *pTools,
+		const QVector<qtractorMidiEvent *>& events, unsigned long iTimeOffset );
+
+	// First scan pass, for the value and time range dependent tools.
+	void scan ( qtractorMidiEvent *pAnchorEvent,
+		unsigned long iTimeStart, unsigned long iTimeEnd );
+
+	// Transform next available chunks, until none's left.
+	void process ();
+
+	// Accessors.
+	int chunks () const { return m_seeds.count(); }
+	int done () const { return ATOMIC_GET(&m_done); }
+
+	const Result& result ( int i ) const { return m_results.at(i); }
+
+protected:
+
+	// Transform one chunk of events.
+	void transform ( int iChunk );
+
+	// Chunk local pseudo-random generator (xorshift).
+	static int random ( unsigned int& seed )
+	{
+		seed ^= (seed << 13);
+		seed ^= (seed >> 17);
+		seed ^= (seed << 5);
+		return int(seed & 0x7fffffff);
+	}
+
+private:
+
+	// Instance variables.
+	const qtractorMidiTools::Options& m_options;
+
+	qtractorTimeScale *m_pTimeScale;
+
+	const QVector<qtractorMidiEvent *>& m_events;
+
+	QVector<Result> m_results;
+	QVector<unsigned int> m_seeds;
+
+	// Direct (detached) results access, for the workers.
+	Result *m_pResults;
+
+	unsigned long m_iTimeOffset;
+
+	// Selection time and value ranges.
+	long m_iMinTime;
+	long m_iMaxTime;
+	long m_iMinTime2;
+	long m_iMaxTime2;
+	int  m_iMinValue;
+	int  m_iMaxValue;
+
+	// Timeshift edit range (ticks).
+	unsigned long m_iEditHeadTime;
+	unsigned long m_iEditTailTime;
+
+	// Chunk dispatch and completion counters.
+	qtractorAtomic m_index;
+	qtractorAtomic m_done;
+};
+
+
+// Constructor.
+qtractorMidiToolsBatch::qtractorMidiToolsBatch (
+	const qtractorMidiTools *pTools,
+	const QVector<qtractorMidiEvent *>& events, unsigned long iTimeOffset )
+	: m_options(pTools->options()), m_pTimeScale(pTools->timeScale()),
+		m_events(events), m_results(events.count()),
+		m_iTimeOffset(iTimeOffset), m_index(0), m_done(0)
+{
+	m_iMinTime  = m_iMaxTime  = iTimeOffset;
+	m_iMinTime2 = m_iMaxTime2 = iTimeOffset;
+	m_iMinValue = m_iMaxValue = 0;
+
+	m_iEditHeadTime = m_iEditTailTime = 0;
+
+	m_pResults = m_results.data();
+
+	// Each chunk gets its own random seed, so that
+	// it doesn't matter which thread transforms it...
+	const int iChunks = (events.count() + QTRACTOR_MIDI_TOOLS_CHUNK - 1)
+		/ QTRACTOR_MIDI_TOOLS_CHUNK;
+	m_seeds.resize(iChunks);
+	for (int i = 0; i < iChunks; ++i)
+		m_seeds[i] = (unsigned int) (::rand()) | 1;
+
+	// Session (edit-head/tail) dependencies are only safe here...
+	qtractorSession *pSession = qtractorSession::getInstance();
+	if (pSession && m_options.timeshift) {
+		m_iEditHeadTime = pSession->tickFromFrame(pSession->editHead());
+		m_iEditTailTime = pSession->tickFromFrame(pSession->editTail());
+	}
+}
+
+
+// First scan pass, for the value and time range dependent tools.
+void qtractorMidiToolsBatch::scan ( qtractorMidiEvent *pAnchorEvent,
+	unsigned long iTimeStart, unsigned long iTimeEnd )
+{
+	// Seed time range with a value from the list of selected events.
+	if (pAnchorEvent)
+		m_iMinTime = m_iMaxTime = pAnchorEvent->time() + m_iTimeOffset;
+
+	m_iMinTime2 = m_iMinTime;
+	m_iMaxTime2 = m_iMaxTime;
+
+	if (iTimeStart < iTimeEnd) {
+		m_iMinTime += long(iTimeStart);
+		m_iMaxTime += long(iTimeEnd);
+	}
+
+	// Find maximum and minimum times and values from the selection,
+	// for the normalize and resize value ramp tools...
+	if (!m_options.normalize
+		&& !(m_options.transpose && m_options.transposeReverse)
+		&& !(m_options.resize && m_options.resizeValue
+			&& m_options.resizeValueRamp))
+		return;
+
+	const int iEvents = m_events.count();
+	for (int i = 0; i < iEvents; ++i) {
+		qtractorMidiEvent *pEvent = m_events.at(i);
+		const long iTime = pEvent->time() + m_iTimeOffset;
+		const long iTime2 = iTime + pEvent->duration();
+		if (m_iMinTime  > iTime)
+			m_iMinTime  = iTime;
+		if (m_iMaxTime  < iTime)
+			m_iMaxTime  = iTime;
+		if (m_iMinTime2 > iTime || i == 0)
+			m_iMinTime2 = iTime;
+		if (m_iMaxTime2 < iTime2)
+			m_iMaxTime2 = iTime2;
+		const bool bPitchBend = (pEvent->type() == qtractorMidiEvent::PITCHBEND);
+		const int iValue = (bPitchBend ? pEvent->pitchBend() : pEvent->value());
+		if (m_iMinValue > iValue || i == 0)
+			m_iMinValue = iValue;
+		if (m_iMaxValue < iValue)
+			m_iMaxValue = iValue;
+	}
+}
+
+
+// Transform next available chunks, until none's left.
+void qtractorMidiToolsBatch::process (void)
+{
+	const int iChunks = m_seeds.count();
+	for (;;) {
+		const int iChunk = m_index.fetchAndAddOrdered(1);
+		if (iChunk >= iChunks)
+			break;
+		transform(iChunk);
+		m_done.fetchAndAddOrdered(1);
+	}
+}
+
+
+// Transform one chunk of events.
+void qtractorMidiToolsBatch::transform ( int iChunk )
+{
+	const qtractorMidiTools::Options& opts = m_options;
+
+	const long iTimeOffset = long(m_iTimeOffset);
+
+	unsigned int seed = m_seeds.at(iChunk);
+
+	qtractorTimeScale::Cursor cursor(m_pTimeScale);
+
+	const int i0 = iChunk * QTRACTOR_MIDI_TOOLS_CHUNK;
+	int i1 = i0 + QTRACTOR_MIDI_TOOLS_CHUNK;
+	if (i1 > m_events.count())
+		i1 = m_events.count();
+
+	for (int i = i0; i < i1; ++i) {
+		qtractorMidiEvent *pEvent = m_events.at(i);
+		long iTime = pEvent->time() + iTimeOffset;
+		long iDuration = pEvent->duration();
+		const bool bPitchBend = (pEvent->type() == qtractorMidiEvent::PITCHBEND);
+		int iValue = (bPitchBend ? pEvent->pitchBend() : pEvent->value());
+		qtractorTimeScale::Node *pNode = cursor.seekTick(iTime);
+		// Start from current event state...
+		Result& r = m_pResults[i];
+		r.note = int(pEvent->note());
+		r.time = pEvent->time();
+		r.duration = pEvent->duration();
+		r.value = iValue;
+		r.flags = 0;
+		// Quantize tool...
+		if (opts.quantize) {
+			// Swing quantize...
+			if (opts.quantizeSwing) {
+				const unsigned short p = qtractorTimeScale::snapFromIndex(
+					opts.quantizeSwingIndex + 1);
+				const unsigned long q = pNode->ticksPerBeat / p;
+				if (q > 0) {
+					const unsigned long t0 = q * (iTime / q);
+					float d0 = 0.0f;
+					if ((iTime / q) % 2)
+						d0 = float(long(t0 + q) - long(iTime));
+					else
+						d0 = float(long(iTime) - long(t0));
+					float ds = 0.01f * opts.quantizeSwingPercent;
+					ds = ds * d0;
+					const int n = opts.quantizeSwingType;
+					for (int j = 0; j < n; ++j) // 0=Linear; 1=Quadratic; 2=Cubic.
+						ds = (ds * d0) / float(q);
+					iTime += long(ds);
+					if (iTime < iTimeOffset)
+						iTime = iTimeOffset;
+				}
+			}
+			// Time quantize...
+			if (opts.quantizeTime) {
+				const unsigned short p = qtractorTimeScale::snapFromIndex(
+					opts.quantizeTimeIndex + 1);
+				const unsigned long q = pNode->ticksPerBeat / p;
+				iTime = q * ((iTime + (q >> 1)) / q);
+				// Time percent quantize...
+				const float delta = 0.01f
+					* (100.0f - opts.quantizeTimePercent)
+					* float(long(pEvent->time() + iTimeOffset) - iTime);
+				iTime += long(delta);
+				if (iTime < iTimeOffset)
+					iTime = iTimeOffset;
+			}
+			// Duration quantize...
+			if (opts.quantizeDuration
+				&& pEvent->type() == qtractorMidiEvent::NOTEON) {
+				const unsigned short p = qtractorTimeScale::snapFromIndex(
+					opts.quantizeDurationIndex + 1);
+				const unsigned long q = pNode->ticksPerBeat / p;
+				iDuration = q * ((iDuration + q - 1) / q);
+				// Duration percent quantize...
+				const float delta = 0.01f
+					* (100.0f - opts.quantizeDurationPercent)
+					* float(long(pEvent->duration()) - iDuration);
+				iDuration += long(delta);
+				if (iDuration < 0)
+					iDuration = 0;
+			}
+			r.time = iTime - iTimeOffset;
+			r.duration = iDuration;
+			r.flags |= qtractorMidiEditCommand::UpdateTime;
+			// Scale quantize...
+			if (opts.quantizeScale) {
+				r.note = qtractorMidiEditor::snapToScale(pEvent->note(),
+					opts.quantizeScaleKey, opts.quantizeScaleType);
+				r.flags |= qtractorMidiEditCommand::UpdateNote;
+			}
+		}
+		// Transpose tool...
+		if (opts.transpose) {
+			int iNote = int(pEvent->note());
+			if (opts.transposeNote
+				&& pEvent->type() == qtractorMidiEvent::NOTEON) {
+				iNote += opts.transposeNoteDelta;
+				if (iNote < 0)
+					iNote = 0;
+				else
+				if (iNote > 127)
+					iNote = 127;
+			}
+			if (opts.transposeTime) {
+				iTime = pNode->tickFromFrame(pNode->frameFromTick(iTime)
+					+ opts.transposeTimeDelta);
+				if (iTime < iTimeOffset)
+					iTime = iTimeOffset;
+			}
+			if (opts.transposeReverse) {
+				iTime = m_iMinTime2 + m_iMaxTime2 - iTime - iDuration;
+				if (iTime < iTimeOffset)
+					iTime = iTimeOffset;
+			}
+			r.note = iNote;
+			r.time = iTime - iTimeOffset;
+			r.flags |= qtractorMidiEditCommand::UpdateNote
+				| qtractorMidiEditCommand::UpdateTime;
+		}
+		// Normalize tool...
+		if (opts.normalize) {
+			float p, q = float(m_iMaxValue);
+			if (opts.normalizeValue)
+				p = float(opts.normalizeValueMax);
+			else
+				p = (bPitchBend ? 8192.0f : 128.0f);
+			if (opts.normalizePercent) {
+				p *= opts.normalizePercentValue;
+				q *= 100.0f;
+			}
+			if (q > 0.0f) {
+				iValue = int((p * float(iValue)) / q);
+				if (bPitchBend) {
+					if (iValue > +8191)
+						iValue = +8191;
+					else
+					if (iValue < -8191)
+						iValue = -8191;
+				} else {
+					if (iValue > 127)
+						iValue = 127;
+					else
+					if (iValue < 0)
+						iValue = 0;
+				}
+			}
+			r.value = iValue;
+			r.flags |= qtractorMidiEditCommand::UpdateValue;
+		}
+		// Randomize tool...
+		if (opts.randomize) {
+			float p; int q;
+			if (opts.randomizeNote) {
+				int iNote = int(pEvent->note());
+				p = 0.01f * opts.randomizeNotePercent;
+				q = 127;
+				if (p > 0.0f) {
+					iNote += int(p * float(q - (random(seed) % (q << 1))));
+					if (iNote > 127)
+						iNote = 127;
+					else
+					if (iNote < 0)
+						iNote = 0;
+					r.note = iNote;
+					r.time = iTime - iTimeOffset;
+					r.flags |= qtractorMidiEditCommand::UpdateNote
+						| qtractorMidiEditCommand::UpdateTime;
+				}
+			}
+			if (opts.randomizeTime) {
+				p = 0.01f * opts.randomizeTimePercent;
+				q = pNode->ticksPerBeat;
+				if (p > 0.0f) {
+					iTime += long(p * float(q - (random(seed) % (q << 1))));
+					if (iTime < iTimeOffset)
+						iTime = iTimeOffset;
+					r.time = iTime - iTimeOffset;
+					r.duration = iDuration;
+					r.flags |= qtractorMidiEditCommand::UpdateTime;
+				}
+			}
+			if (opts.randomizeDuration) {
+				p = 0.01f * opts.randomizeDurationPercent;
+				q = pNode->ticksPerBeat;
+				if (p > 0.0f) {
+					iDuration += long(p * float(q - (random(seed) % (q << 1))));
+					if (iDuration < 0)
+						iDuration = 0;
+					r.time = iTime - iTimeOffset;
+					r.duration = iDuration;
+					r.flags |= qtractorMidiEditCommand::UpdateTime;
+				}
+			}
+			if (opts.randomizeValue) {
+				p = 0.01f * opts.randomizeValuePercent;
+				q = (bPitchBend ? 8192 : 128);
+				if (p > 0.0f) {
+					iValue += int(p * float(q - (random(seed) % (q << 1))));
+					if (bPitchBend) {
+						if (iValue > +8191)
+							iValue = +8191;
+						else
+						if (iValue < -8191)
+							iValue = -8191;
+					} else {
+						if (iValue > 127)
+							iValue = 127;
+						else
+						if (iValue < 0)
+							iValue = 0;
+					}
+					r.value = iValue;
+					r.flags |= qtractorMidiEditCommand::UpdateValue;
+				}
+			}
+		}
+		// Resize tool...
+		if (opts.resize) {
+			if (opts.resizeDuration) {
+				iDuration = pNode->tickFromFrame(pNode->frameFromTick(iTime)
+					+ opts.resizeDurationDelta) - iTime;
+				r.time = iTime - iTimeOffset;
+				r.duration = iDuration;
+				r.flags |= qtractorMidiEditCommand::UpdateTime;
+			}
+			if (opts.resizeValue) {
+				const int p = (bPitchBend && iValue < 0 ? -1 : 1); // sign
+				iValue = p * opts.resizeValue1;
+				if (bPitchBend) iValue <<= 6; // *128
+				if (opts.resizeValueRamp) {
+					int iValue2 = p * opts.resizeValue2;
+					if (bPitchBend) iValue2 <<= 6; // *128
+					const int iDeltaValue = iValue2 - iValue;
+					const long iDeltaTime = m_iMaxTime - m_iMinTime;
+					if (iDeltaTime > 0)
+						iValue += iDeltaValue * (iTime - m_iMinTime) / iDeltaTime;
+				}
+				r.value = iValue;
+				r.flags |= qtractorMidiEditCommand::UpdateValue;
+			}
+		}
+		// Rescale tool...
+		if (opts.rescale) {
+			float p;
+			if (opts.rescaleTime) {
+				p = 0.01f * opts.rescaleTimePercent;
+				iTime = m_iMinTime + long(p * float(iTime - m_iMinTime));
+				if (iTime < iTimeOffset)
+					iTime = iTimeOffset;
+				r.note = int(pEvent->note());
+				r.time = iTime - iTimeOffset;
+				r.flags |= qtractorMidiEditCommand::UpdateNote
+					| qtractorMidiEditCommand::UpdateTime;
+			}
+			if (opts.rescaleDuration) {
+				p = 0.01f * opts.rescaleDurationPercent;
+				iDuration = long(p * float(iDuration));
+				if (iDuration < 0)
+					iDuration = 0;
+				r.time = iTime - iTimeOffset;
+				r.duration = iDuration;
+				r.flags |= qtractorMidiEditCommand::UpdateTime;
+			}
+			if (opts.rescaleValue) {
+				p = 0.01f * opts.rescaleValuePercent;
+				iValue = int(p * float(iValue));
+				if (bPitchBend) {
+					if (iValue > +8191)
+						iValue = +8191;
+					else
+					if (iValue < -8191)
+						iValue = -8191;
+				} else {
+					if (iValue > 127)
+						iValue = 127;
+					else
+					if (iValue < 0)
+						iValue = 0;
+				}
+				r.value = iValue;
+				r.flags |= qtractorMidiEditCommand::UpdateValue;
+			}
+		}
+		// Timeshift tool...
+		if (opts.timeshift) {
+			const float d = float(m_iEditTailTime - m_iEditHeadTime);
+			const float p = opts.timeshiftPercent;
+			if ((p < -1e-6f || p > 1e-6f) && (d > 0.0f)) {
+				const float t = float(iTime - m_iEditHeadTime);
+				float t1 = t / d;
+				float t2 = (t + float(iDuration)) / d;
+				if (t1 > 0.0f && t1 < 1.0f)
+					t1 = qtractorMidiTools::timeshift(t1, p);
+				if (opts.timeshiftDuration
+					&& (t2 > 0.0f && t2 < 1.0f))
+					t2 = qtractorMidiTools::timeshift(t2, p);
+				t1 = t1 * d + float(m_iEditHeadTime);
+				if (opts.timeshiftDuration) {
+					t2 = t2 * d + float(m_iEditHeadTime);
+					r.time = t1 - iTimeOffset;
+					r.duration = t2 - t1;
+					r.flags |= qtractorMidiEditCommand::UpdateTime;
+				} else {
+					r.note = int(pEvent->note());
+					r.time = t1 - iTimeOffset;
+					r.flags |= qtractorMidiEditCommand::UpdateNote
+						| qtractorMidiEditCommand::UpdateTime;
+				}
+			}
+		}
+		// Drop whatever ends up the same as before...
+		if (r.note == int(pEvent->note()))
+			r.flags &= ~qtractorMidiEditCommand::UpdateNote;
+		if (r.time == pEvent->time()
+			&& (pEvent->type() != qtractorMidiEvent::NOTEON
+				|| r.duration == pEvent->duration()))
+			r.flags &= ~qtractorMidiEditCommand::UpdateTime;
+		if (r.value == (bPitchBend ? pEvent->pitchBend() : pEvent->value()))
+			r.flags &= ~qtractorMidiEditCommand::UpdateValue;
+	}
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiToolsThread -- MIDI tools batch transform worker.
+//
+class qtractorMidiToolsThread : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorMidiToolsThread ( qtractorMidiToolsBatch& batch )
+		: QThread(), m_batch(batch) {}
+
+protected:
+
+	// The main thread executive.
+	void run() { m_batch.process(); }
+
+private:
+
+	// Instance variables.
+	qtractorMidiToolsBatch& m_batch;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiTools::Options -- MIDI tools settings.
+//
+
+// Constructor (all tools off).
+qtractorMidiTools::Options::Options (void)
+{
+	quantize = false;
+	quantizeTime = false;
+	quantizeTimeIndex = 0;
+	quantizeTimePercent = 100.0f;
+	quantizeDuration = false;
+	quantizeDurationIndex = 0;
+	quantizeDurationPercent = 100.0f;
+	quantizeSwing = false;
+	quantizeSwingIndex = 0;
+	quantizeSwingPercent = 0.0f;
+	quantizeSwingType = 0;
+	quantizeScale = false;
+	quantizeScaleKey = 0;
+	quantizeScaleType = 0;
+
+	transpose = false;
+	transposeNote = false;
+	transposeNoteDelta = 0;
+	transposeTime = false;
+	transposeTimeDelta = 0;
+	transposeReverse = false;
+
+	normalize = false;
+	normalizePercent = false;
+	normalizePercentValue = 100.0f;
+	normalizeValue = false;
+	normalizeValueMax = 127;
+
+	randomize = false;
+	randomizeNote = false;
+	randomizeNotePercent = 0.0f;
+	randomizeTime = false;
+	randomizeTimePercent = 0.0f;
+	randomizeDuration = false;
+	randomizeDurationPercent = 0.0f;
+	randomizeValue = false;
+	randomizeValuePercent = 0.0f;
+
+	resize = false;
+	resizeDuration = false;
+	resizeDurationDelta = 0;
+	resizeValue = false;
+	resizeValue1 = 0;
+	resizeValueRamp = false;
+	resizeValue2 = 0;
+
+	rescale = false;
+	rescaleTime = false;
+	rescaleTimePercent = 100.0f;
+	rescaleDuration = false;
+	rescaleDurationPercent = 100.0f;
+	rescaleValue = false;
+	rescaleValuePercent = 100.0f;
+
+	timeshift = false;
+	timeshiftPercent = 0.0f;
+	timeshiftDuration = false;
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiTools -- MIDI event batch transform tools.
+//
+
+// Constructor.
+qtractorMidiTools::qtractorMidiTools (
+	qtractorTimeScale *pTimeScale, const Options& options )
+	: m_pTimeScale(pTimeScale), m_options(options)
+{
+}
+
+
+// Create edit command based on given selection.
+qtractorMidiEditCommand *qtractorMidiTools::editCommand (
+	qtractorMidiClip *pMidiClip, qtractorMidiEditSelect *pSelect,
+	const QString& sName, unsigned long iTimeOffset,
+	unsigned long iTimeStart, unsigned long iTimeEnd ) const
+{
+	// Create command, it will be handed over...
+	qtractorMidiEditCommand *pEditCommand
+		= new qtractorMidiEditCommand(pMidiClip, sName);
+
+	// Flatten the selection, for chunked access...
+	const qtractorMidiEditSelect::ItemList& items = pSelect->items();
+	qtractorMidiEditSelect::ItemList::ConstIterator iter = items.constBegin();
+	const qtractorMidiEditSelect::ItemList::ConstIterator& iter_end = items.constEnd();
+
+	QVector<qtractorMidiEvent *> events;
+	events.reserve(items.count());
+	for ( ; iter != iter_end; ++iter)
+		events.append(iter.key());
+
+	qtractorMidiToolsBatch batch(this, events, iTimeOffset);
+	batch.scan(pSelect->anchorEvent(), iTimeStart, iTimeEnd);
+
+	// Big selections get transformed in parallel...
+	const int iChunks = batch.chunks();
+	int iThreads = 0;
+	if (events.count() >= QTRACTOR_MIDI_TOOLS_PARALLEL) {
+		iThreads = QThread::idealThreadCount();
+		if (iThreads > iChunks)
+			iThreads = iChunks;
+	}
+
+	if (iThreads > 0) {
+		QList<qtractorMidiToolsThread *> threads;
+		for (int i = 0; i < iThreads; ++i) {
+			qtractorMidiToolsThread *pThread
+				= new qtractorMidiToolsThread(batch);
+			pThread->start();
+			threads.append(pThread);
+		}
+		// A progress indication might be friendly...
+		QProgressBar *pProgressBar = NULL;
+		qtractorMainForm *pMainForm = qtractorMainForm::getInstance();
+		if (pMainForm)
+			pProgressBar = pMainForm->progressBar();
+		if (pProgressBar) {
+			pProgressBar->setRange(0, iChunks);
+			pProgressBar->reset();
+			pProgressBar->show();
+		}
+		// Keep the GUI alive while waiting...
+		while (!threads.isEmpty()) {
+			qtractorMidiToolsThread *pThread = threads.first();
+			if (pThread->wait(20)) {
+				threads.removeFirst();
+				delete pThread;
+				continue;
+			}
+			if (pProgressBar)
+				pProgressBar->setValue(batch.done());
+			QApplication::processEvents(
+				QEventLoop::ExcludeUserInputEvents);
+		}
+		if (pProgressBar)
+			pProgressBar->hide();
+	}
+	else batch.process();
+
+	// Hand over the outcome, one record per changed event...
+	const int iEvents = events.count();
+	for (int i = 0; i < iEvents; ++i) {
+		const qtractorMidiToolsBatch::Result& r = batch.result(i);
+		if (r.flags) {
+			pEditCommand->updateEvent(events.at(i),
+				r.note, r.time, r.duration, r.value, r.flags);
+		}
+	}
+
+	// Done.
+	return pEditCommand;
+}
+
+
+// Timeshift characteristic curve function.
+float qtractorMidiTools::timeshift ( float t, float p )
+{
+#if 0//TIMESHIFT_LOGSCALE
+	if (p > 0.0f)
+		t = ::sqrtf(t * ::powf(1.0f - (10.0f * ::logf(t) / p), 0.1f * p));
+	else
+	if (p < 0.0f)
+		t = ::sqrtf(1.0f - ((1.0f - t) * ::powf(1.0f + (::logf(1.0f - t) / p), -p)));
+#else
+	if (p > 0.0f)
+		t = 1.0f - ::powf(1.0f - t, 1.0f / (1.0f - 0.01f * (p + 1e-9f)));
+	else
+	if (p < 0.0f)
+		t = 1.0f - ::powf(1.0f - t, 1.0f + 0.01f * p);
+#endif
+	return t;
+}
+
+
+// end of qtractorMidiTools.cpp
@@ -0,0 +1,148 @@
+// qtractorMidiTools.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorMidiTools_h
+#define __qtractorMidiTools_h
+
+#include <QString>
+
+
+// Forward declarations.
+class qtractorMidiClip;
+class qtractorMidiEditSelect;
+class qtractorMidiEditCommand;
+class qtractorTimeScale;
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiTools -- MIDI event batch transform tools.
+//
+// The selected events are split in chunks and transformed on a few
+// worker threads, when there's plenty of them; the outcome is handed
+// over as one single edit command, holding one compound record for
+// each and every changed event.
+//
+
+class qtractorMidiTools
+{
+public:
+
+	// Tool settings.
+	struct Options
+	{
+		// Constructor (all tools off).
+		Options();
+
+		// Quantize tool.
+		bool  quantize;
+		bool  quantizeTime;
+		int   quantizeTimeIndex;
+		float quantizeTimePercent;
+		bool  quantizeDuration;
+		int   quantizeDurationIndex;
+		float quantizeDurationPercent;
+		bool  quantizeSwing;
+		int   quantizeSwingIndex;
+		float quantizeSwingPercent;
+		int   quantizeSwingType;
+		bool  quantizeScale;
+		int   quantizeScaleKey;
+		int   quantizeScaleType;
+
+		// Transpose tool.
+		bool  transpose;
+		bool  transposeNote;
+		int   transposeNoteDelta;
+		bool  transposeTime;
+		unsigned long transposeTimeDelta;
+		bool  transposeReverse;
+
+		// Normalize tool.
+		bool  normalize;
+		bool  normalizePercent;
+		float normalizePercentValue;
+		bool  normalizeValue;
+		int   normalizeValueMax;
+
+		// Randomize tool.
+		bool  randomize;
+		bool  randomizeNote;
+		float randomizeNotePercent;
+		bool  randomizeTime;
+		float randomizeTimePercent;
+		bool  randomizeDuration;
+		float randomizeDurationPercent;
+		bool  randomizeValue;
+		float randomizeValuePercent;
+
+		// Resize tool.
+		bool  resize;
+		bool  resizeDuration;
+		unsigned long resizeDurationDelta;
+		bool  resizeValue;
+		int   resizeValue1;
+		bool  resizeValueRamp;
+		int   resizeValue2;
+
+		// Rescale tool.
+		bool  rescale;
+		bool  rescaleTime;
+		float rescaleTimePercent;
+		bool  rescaleDuration;
+		float rescaleDurationPercent;
+		bool  rescaleValue;
+		float rescaleValuePercent;
+
+		// Timeshift tool.
+		bool  timeshift;
+		float timeshiftPercent;
+		bool  timeshiftDuration;
+	};
+
+	// Constructor.
+	qtractorMidiTools(qtractorTimeScale *pTimeScale, const Options& options);
+
+	// Settings accessors.
+	qtractorTimeScale *timeScale() const { return m_pTimeScale; }
+	const Options& options() const { return m_options; }
+
+	// Create edit command based on given selection.
+	qtractorMidiEditCommand *editCommand(
+		qtractorMidiClip *pMidiClip, qtractorMidiEditSelect *pSelect,
+		const QString& sName, unsigned long iTimeOffset,
+		unsigned long iTimeStart = 0, unsigned long iTimeEnd = 0) const;
+
+	// Timeshift characteristic curve function.
+	static float timeshift(float t, float p);
+
+private:
+
+	// Instance variables.
+	qtractorTimeScale *m_pTimeScale;
+
+	Options m_options;
+};
+
+
+#endif	// __qtractorMidiTools_h
+
+
+// end of qtractorMidiTools.h
@@ -26,6 +26,7 @@
 #include "qtractorMidiClip.h"
 
 #include "qtractorMidiEditCommand.h"
+#include "qtractorMidiTools.h"
 
 #include "qtractorOptions.h"
 #include "qtractorSession.h"
@@ -54,22 +55,7 @@ public:
 
 	// Characteristic method.
 	static float timeshift(float t, float p)
-	{
-	#if 0//TIMESHIFT_LOGSCALE
-		if (p > 0.0f)
-			t = ::sqrtf(t * ::powf(1.0f - (10.0f * ::logf(t) / p), 0.1f * p));
-		else
-		if (p < 0.0f)
-			t = ::sqrtf(1.0f - ((1.0f - t) * ::powf(1.0f + (::logf(1.0f - t) / p), -p)));
-	#else
-		if (p > 0.0f)
-			t = 1.0f - ::powf(1.0f - t, 1.0f / (1.0f - 0.01f * (p + 1e-9f)));
-		else
-		if (p < 0.0f)
-			t = 1.0f - ::powf(1.0f - t, 1.0f + 0.01f * p);
-	#endif
-		return t;
-	}
+		{ return qtractorMidiTools::timeshift(t, p); }
 
 protected:
 
@@ -768,10 +754,6 @@ qtractorMidiEditCommand *qtractorMidiToolsForm::editCommand (
 	qtractorMidiClip *pMidiClip, qtractorMidiEditSelect *pSelect,
 	unsigned long iTimeOffset, unsigned long iTimeStart, unsigned long iTimeEnd )
 {
-	// Create command, it will be handed over...
-	qtractorMidiEditCommand *pEditCommand
-		= new qtractorMidiEditCommand(pMidiClip, tr("none"));
-
 	// Set composite command title.
 	QStringList tools;
 	if (m_ui.QuantizeCheckBox->isChecked())
@@ -788,349 +770,73 @@ qtractorMidiEditCommand *qtractorMidiToolsForm::editCommand (
 		tools.append(tr("rescale"));
 	if (m_ui.TimeshiftCheckBox->isChecked())
 		tools.append(tr("timeshift"));
-	pEditCommand->setName(tools.join(", "));
-
-	const qtractorMidiEditSelect::ItemList& items = pSelect->items();
-	qtractorMidiEditSelect::ItemList::ConstIterator iter = items.constBegin();
-	const qtractorMidiEditSelect::ItemList::ConstIterator& iter_end = items.constEnd();
-
-	// Seed time range with a value from the list of selected events.
-	long iMinTime = iTimeOffset;
-	long iMaxTime = iTimeOffset;
-
-	if (pSelect->anchorEvent())
-		iMinTime = iMaxTime = pSelect->anchorEvent()->time() + iTimeOffset;
-
-	long iMinTime2 = iMinTime;
-	long iMaxTime2 = iMaxTime;
-
-	if (iTimeStart < iTimeEnd) {
-		iMinTime += long(iTimeStart);
-		iMaxTime += long(iTimeEnd);
-	}
-
-	// First scan pass for the normalize and resize value ramp tools:
-	// find maximum and minimum times and values from the selection...
-	int iMaxValue = 0;
-	int iMinValue = 0;
-	if (m_ui.NormalizeCheckBox->isChecked()
-		|| (m_ui.TransposeCheckBox->isChecked() &&
-			m_ui.TransposeReverseCheckBox->isChecked())
-		|| (m_ui.ResizeCheckBox->isChecked() &&
-			m_ui.ResizeValueCheckBox->isChecked() &&
-			m_ui.ResizeValue2ComboBox->currentIndex() > 0)) {
-		// Make it through one time...
-		for (int i = 0 ; iter != iter_end; ++i, ++iter) {
-			qtractorMidiEvent *pEvent = iter.key();
-			const long iTime = pEvent->time() + iTimeOffset;
-			const long iTime2 = iTime + pEvent->duration();
-			if (iMinTime  > iTime)
-				iMinTime  = iTime;
-			if (iMaxTime  < iTime)
-				iMaxTime  = iTime;
-			if (iMinTime2 > iTime || i == 0)
-				iMinTime2 = iTime;
-			if (iMaxTime2 < iTime2)
-				iMaxTime2 = iTime2;
-			const bool bPitchBend = (pEvent->type() == qtractorMidiEvent::PITCHBEND);
-			const int iValue = (bPitchBend ? pEvent->pitchBend() : pEvent->value());
-			if (iMinValue > iValue || i == 0)
-				iMinValue = iValue;
-			if (iMaxValue < iValue)
-				iMaxValue = iValue;
-		}
-		// Get it back to front...
-		iter = items.constBegin();
-	}
-
-	// Go for the main pass...
-	qtractorTimeScale::Cursor cursor(m_pTimeScale);
-
-	for ( ; iter != iter_end; ++iter) {
-		qtractorMidiEvent *pEvent = iter.key();
-		long iTime = pEvent->time() + iTimeOffset;
-		long iDuration = pEvent->duration();
-		const bool bPitchBend = (pEvent->type() == qtractorMidiEvent::PITCHBEND);
-		int iValue = (bPitchBend ? pEvent->pitchBend() : pEvent->value());
-		qtractorTimeScale::Node *pNode = cursor.seekTick(iTime);
-		// Quantize tool...
-		if (m_ui.QuantizeCheckBox->isChecked()) {
-			tools.append(tr("quantize"));
-			// Swing quantize...
-			if (m_ui.QuantizeSwingCheckBox->isChecked()) {
-				const unsigned short p = qtractorTimeScale::snapFromIndex(
-					m_ui.QuantizeSwingComboBox->currentIndex() + 1);
-				const unsigned long q = pNode->ticksPerBeat / p;
-				if (q > 0) {
-					const unsigned long t0 = q * (iTime / q);
-					float d0 = 0.0f;
-					if ((iTime / q) % 2)
-						d0 = float(long(t0 + q) - long(iTime));
-					else
-						d0 = float(long(iTime) - long(t0));
-					float ds = 0.01f * float(m_ui.QuantizeSwingSpinBox->value());
-					ds = ds * d0;
-					const int n = m_ui.QuantizeSwingTypeComboBox->currentIndex();
-					for (int i = 0; i < n; ++i) // 0=Linear; 1=Quadratic; 2=Cubic.
-						ds = (ds * d0) / float(q);
-					iTime += long(ds);
-					if (iTime < long(iTimeOffset))
-						iTime = long(iTimeOffset);
-				}
-			}
-			// Time quantize...
-			if (m_ui.QuantizeTimeCheckBox->isChecked()) {
-				const unsigned short p = qtractorTimeScale::snapFromIndex(
-					m_ui.QuantizeTimeComboBox->currentIndex() + 1);
-				const unsigned long q = pNode->ticksPerBeat / p;
-				iTime = q * ((iTime + (q >> 1)) / q);
-				// Time percent quantize...
-				const float delta = 0.01f
-					* (100.0f - float(m_ui.QuantizeTimeSpinBox->value()))
-					* float(long(pEvent->time() + iTimeOffset) - iTime);
-				iTime += long(delta);
-				if (iTime < long(iTimeOffset))
-					iTime = long(iTimeOffset);
-			}
-			// Duration quantize...
-			if (m_ui.QuantizeDurationCheckBox->isChecked()
-				&& pEvent->type() == qtractorMidiEvent::NOTEON) {
-				const unsigned short p = qtractorTimeScale::snapFromIndex(
-					m_ui.QuantizeDurationComboBox->currentIndex() + 1);
-				const unsigned long q = pNode->ticksPerBeat / p;
-				iDuration = q * ((iDuration + q - 1) / q);
-				// Duration percent quantize...
-				const float delta = 0.01f
-					* (100.0f - float(m_ui.QuantizeDurationSpinBox->value()))
-					* float(long(pEvent->duration()) - iDuration);
-				iDuration += long(delta);
-				if (iDuration < 0)
-					iDuration = 0;
-			}
-			pEditCommand->resizeEventTime(pEvent, iTime - iTimeOffset, iDuration);
-			// Scale quantize...
-			if (m_ui.QuantizeScaleCheckBox->isChecked()) {
-				const int iNote = qtractorMidiEditor::snapToScale(pEvent->note(),
-					m_ui.QuantizeScaleKeyComboBox->currentIndex(),
-					m_ui.QuantizeScaleComboBox->currentIndex());
-				pEditCommand->moveEvent(pEvent, iNote, iTime - iTimeOffset);
-			}
-		}
-		// Transpose tool...
-		if (m_ui.TransposeCheckBox->isChecked()) {
-			tools.append(tr("transpose"));
-			int iNote = int(pEvent->note());
-			if (m_ui.TransposeNoteCheckBox->isChecked()
-				&& pEvent->type() == qtractorMidiEvent::NOTEON) {
-				iNote += m_ui.TransposeNoteSpinBox->value();
-				if (iNote < 0)
-					iNote = 0;
-				else
-				if (iNote > 127)
-					iNote = 127;
-			}
-			if (m_ui.TransposeTimeCheckBox->isChecked()) {
-				iTime = pNode->tickFromFrame(pNode->frameFromTick(iTime)
-					+ m_ui.TransposeTimeSpinBox->value());
-				if (iTime < long(iTimeOffset))
-					iTime = long(iTimeOffset);
-			}
-			if (m_ui.TransposeReverseCheckBox->isChecked()) {
-				iTime = iMinTime2 + iMaxTime2 - iTime - iDuration;
-				if (iTime < long(iTimeOffset))
-					iTime = long(iTimeOffset);
-			}
-			pEditCommand->moveEvent(pEvent, iNote, iTime - iTimeOffset);
-		}
-		// Normalize tool...
-		if (m_ui.NormalizeCheckBox->isChecked()) {
-			tools.append(tr("normalize"));
-			float p, q = float(iMaxValue);
-			if (m_ui.NormalizeValueCheckBox->isChecked())
-				p = float(m_ui.NormalizeValueSpinBox->value());
-			else
-				p = (bPitchBend ? 8192.0f : 128.0f);
-			if (m_ui.NormalizePercentCheckBox->isChecked()) {
-				p *= float(m_ui.NormalizePercentSpinBox->value());
-				q *= 100.0f;
-			}
-			if (q > 0.0f) {
-				iValue = int((p * float(iValue)) / q);
-				if (bPitchBend) {
-					if (iValue > +8191)
-						iValue = +8191;
-					else
-					if (iValue < -8191)
-						iValue = -8191;
-				} else {
-					if (iValue > 127)
-						iValue = 127;
-					else
-					if (iValue < 0)
-						iValue = 0;
-				}
-			}
-			pEditCommand->resizeEventValue(pEvent, iValue);
-		}
-		// Randomize tool...
-		if (m_ui.RandomizeCheckBox->isChecked()) {
-			tools.append(tr("randomize"));
-			float p; int q;
-			if (m_ui.RandomizeNoteCheckBox->isChecked()) {
-				int iNote = int(pEvent->note());
-				p = 0.01f * float(m_ui.RandomizeNoteSpinBox->value());
-				q = 127;
-				if (p > 0.0f) {
-					iNote += int(p * float(q - (::rand() % (q << 1))));
-					if (iNote > 127)
-						iNote = 127;
-					else
-					if (iNote < 0)
-						iNote = 0;
-					pEditCommand->moveEvent(pEvent, iNote, iTime);
-				}
-			}
-			if (m_ui.RandomizeTimeCheckBox->isChecked()) {
-				p = 0.01f * float(m_ui.RandomizeTimeSpinBox->value());
-				q = pNode->ticksPerBeat;
-				if (p > 0.0f) {
-					iTime += long(p * float(q - (::rand() % (q << 1))));
-					if (iTime < long(iTimeOffset))
-						iTime = long(iTimeOffset);
-					pEditCommand->resizeEventTime(pEvent,
-						iTime - iTimeOffset, iDuration);
-				}
-			}
-			if (m_ui.RandomizeDurationCheckBox->isChecked()) {
-				p = 0.01f * float(m_ui.RandomizeDurationSpinBox->value());
-				q = pNode->ticksPerBeat;
-				if (p > 0.0f) {
-					iDuration += long(p * float(q - (::rand() % (q << 1))));
-					if (iDuration < 0)
-						iDuration = 0;
-					pEditCommand->resizeEventTime(pEvent,
-						iTime - iTimeOffset, iDuration);
-				}
-			}
-			if (m_ui.RandomizeValueCheckBox->isChecked()) {
-				p = 0.01f * float(m_ui.RandomizeValueSpinBox->value());
-				q = (bPitchBend ? 8192 : 128);
-				if (p > 0.0f) {
-					iValue += int(p * float(q - (::rand() % (q << 1))));
-					if (bPitchBend) {
-						if (iValue > +8191)
-							iValue = +8191;
-						else
-						if (iValue < -8191)
-							iValue = -8191;
-					} else {
-						if (iValue > 127)
-							iValue = 127;
-						else
-						if (iValue < 0)
-							iValue = 0;
-					}
-					pEditCommand->resizeEventValue(pEvent, iValue);
-				}
-			}
-		}
-		// Resize tool...
-		if (m_ui.ResizeCheckBox->isChecked()) {
-			tools.append(tr("resize"));
-			if (m_ui.ResizeDurationCheckBox->isChecked()) {
-				iDuration = pNode->tickFromFrame(pNode->frameFromTick(iTime)
-					+ m_ui.ResizeDurationSpinBox->value()) - iTime;
-				pEditCommand->resizeEventTime(pEvent,
-					iTime - iTimeOffset, iDuration);
-			}
-			if (m_ui.ResizeValueCheckBox->isChecked()) {
-				const int p = (bPitchBend && iValue < 0 ? -1 : 1); // sign
-				iValue = p * m_ui.ResizeValueSpinBox->value();
-				if (bPitchBend) iValue <<= 6; // *128
-				if (m_ui.ResizeValue2ComboBox->currentIndex() > 0) {
-					int iValue2 = p * m_ui.ResizeValue2SpinBox->value();
-					if (bPitchBend) iValue2 <<= 6; // *128
-					const int iDeltaValue = iValue2 - iValue;
-					const long iDeltaTime = iMaxTime - iMinTime;
-					if (iDeltaTime > 0)
-						iValue += iDeltaValue * (iTime - iMinTime) / iDeltaTime;
-				}
-				pEditCommand->resizeEventValue(pEvent, iValue);
-			}
-		}
-		// Rescale tool...
-		if (m_ui.RescaleCheckBox->isChecked()) {
-			tools.append(tr("rescale"));
-			float p;
-			if (m_ui.RescaleTimeCheckBox->isChecked()) {
-				p = 0.01f * float(m_ui.RescaleTimeSpinBox->value());
-				iTime = iMinTime + long(p * float(iTime - iMinTime));
-				if (iTime < long(iTimeOffset))
-					iTime = long(iTimeOffset);
-				pEditCommand->moveEvent(pEvent,
-					pEvent->note(), iTime - iTimeOffset);
-			}
-			if (m_ui.RescaleDurationCheckBox->isChecked()) {
-				p = 0.01f * float(m_ui.RescaleDurationSpinBox->value());
-				iDuration = long(p * float(iDuration));
-				if (iDuration < 0)
-					iDuration = 0;
-				pEditCommand->resizeEventTime(pEvent,
-					iTime - iTimeOffset, iDuration);
-			}
-			if (m_ui.RescaleValueCheckBox->isChecked()) {
-				p = 0.01f * float(m_ui.RescaleValueSpinBox->value());
-				iValue = int(p * float(iValue));
-				if (bPitchBend) {
-					if (iValue > +8191)
-						iValue = +8191;
-					else
-					if (iValue < -8191)
-						iValue = -8191;
-				} else {
-					if (iValue > 127)
-						iValue = 127;
-					else
-					if (iValue < 0)
-						iValue = 0;
-				}
-				pEditCommand->resizeEventValue(pEvent, iValue);
-			}
-		}
-		// Timeshift tool...
-		if (m_ui.TimeshiftCheckBox->isChecked()) {
-			tools.append(tr("timeshift"));
-			qtractorSession *pSession = qtractorSession::getInstance();
-			const unsigned long iEditHeadTime
-				= pSession->tickFromFrame(pSession->editHead());
-			const unsigned long iEditTailTime
-				= pSession->tickFromFrame(pSession->editTail());
-			const float d = float(iEditTailTime - iEditHeadTime);
-			const float p = float(m_ui.TimeshiftSpinBox->value());
-			if ((p < -1e-6f || p > 1e-6f) && (d > 0.0f)) {
-				const float t = float(iTime - iEditHeadTime);
-				float t1 = t / d;
-				float t2 = (t + float(iDuration)) / d;
-				if (t1 > 0.0f && t1 < 1.0f)
-					t1 = TimeshiftCurve::timeshift(t1, p);
-				if (m_ui.TimeshiftDurationCheckBox->isChecked()
-					&& (t2 > 0.0f && t2 < 1.0f))
-					t2 = TimeshiftCurve::timeshift(t2, p);
-				t1 = t1 * d + float(iEditHeadTime);
-				if (m_ui.TimeshiftDurationCheckBox->isChecked()) {
-					t2 = t2 * d + float(iEditHeadTime);
-					pEditCommand->resizeEventTime(pEvent,
-						t1 - iTimeOffset, t2 - t1);
-				} else {
-					pEditCommand->moveEvent(pEvent,
-						pEvent->note(), t1 - iTimeOffset);
-				}
-			}
-		}
-	}
 
-	// Done.
-	return pEditCommand;
+	// Tool settings, as they are...
+	qtractorMidiTools::Options opts;
+
+	opts.quantize = m_ui.QuantizeCheckBox->isChecked();
+	opts.quantizeTime = m_ui.QuantizeTimeCheckBox->isChecked();
+	opts.quantizeTimeIndex = m_ui.QuantizeTimeComboBox->currentIndex();
+	opts.quantizeTimePercent = float(m_ui.QuantizeTimeSpinBox->value());
+	opts.quantizeDuration = m_ui.QuantizeDurationCheckBox->isChecked();
+	opts.quantizeDurationIndex = m_ui.QuantizeDurationComboBox->currentIndex();
+	opts.quantizeDurationPercent = float(m_ui.QuantizeDurationSpinBox->value());
+	opts.quantizeSwing = m_ui.QuantizeSwingCheckBox->isChecked();
+	opts.quantizeSwingIndex = m_ui.QuantizeSwingComboBox->currentIndex();
+	opts.quantizeSwingPercent = float(m_ui.QuantizeSwingSpinBox->value());
+	opts.quantizeSwingType = m_ui.QuantizeSwingTypeComboBox->currentIndex();
+	opts.quantizeScale = m_ui.QuantizeScaleCheckBox->isChecked();
+	opts.quantizeScaleKey = m_ui.QuantizeScaleKeyComboBox->currentIndex();
+	opts.quantizeScaleType = m_ui.QuantizeScaleComboBox->currentIndex();
+
+	opts.transpose = m_ui.TransposeCheckBox->isChecked();
+	opts.transposeNote = m_ui.TransposeNoteCheckBox->isChecked();
+	opts.transposeNoteDelta = m_ui.TransposeNoteSpinBox->value();
+	opts.transposeTime = m_ui.TransposeTimeCheckBox->isChecked();
+	opts.transposeTimeDelta = m_ui.TransposeTimeSpinBox->value();
+	opts.transposeReverse = m_ui.TransposeReverseCheckBox->isChecked();
+
+	opts.normalize = m_ui.NormalizeCheckBox->isChecked();
+	opts.normalizePercent = m_ui.NormalizePercentCheckBox->isChecked();
+	opts.normalizePercentValue = float(m_ui.NormalizePercentSpinBox->value());
+	opts.normalizeValue = m_ui.NormalizeValueCheckBox->isChecked();
+	opts.normalizeValueMax = m_ui.NormalizeValueSpinBox->value();
+
+	opts.randomize = m_ui.RandomizeCheckBox->isChecked();
+	opts.randomizeNote = m_ui.RandomizeNoteCheckBox->isChecked();
+	opts.randomizeNotePercent = float(m_ui.RandomizeNoteSpinBox->value());
+	opts.randomizeTime = m_ui.RandomizeTimeCheckBox->isChecked();
+	opts.randomizeTimePercent = float(m_ui.RandomizeTimeSpinBox->value());
+	opts.randomizeDuration = m_ui.RandomizeDurationCheckBox->isChecked();
+	opts.randomizeDurationPercent = float(m_ui.RandomizeDurationSpinBox->value());
+	opts.randomizeValue = m_ui.RandomizeValueCheckBox->isChecked();
+	opts.randomizeValuePercent = float(m_ui.RandomizeValueSpinBox->value());
+
+	opts.resize = m_ui.ResizeCheckBox->isChecked();
+	opts.resizeDuration = m_ui.ResizeDurationCheckBox->isChecked();
+	opts.resizeDurationDelta = m_ui.ResizeDurationSpinBox->value();
+	opts.resizeValue = m_ui.ResizeValueCheckBox->isChecked();
+	opts.resizeValue1 = m_ui.ResizeValueSpinBox->value();
+	opts.resizeValueRamp = (m_ui.ResizeValue2ComboBox->currentIndex() > 0);
+	opts.resizeValue2 = m_ui.ResizeValue2SpinBox->value();
+
+	opts.rescale = m_ui.RescaleCheckBox->isChecked();
+	opts.rescaleTime = m_ui.RescaleTimeCheckBox->isChecked();
+	opts.rescaleTimePercent = float(m_ui.RescaleTimeSpinBox->value());
+	opts.rescaleDuration = m_ui.RescaleDurationCheckBox->isChecked();
+	opts.rescaleDurationPercent = float(m_ui.RescaleDurationSpinBox->value());
+	opts.rescaleValue = m_ui.RescaleValueCheckBox->isChecked();
+	opts.rescaleValuePercent = float(m_ui.RescaleValueSpinBox->value());
+
+	opts.timeshift = m_ui.TimeshiftCheckBox->isChecked();
+	opts.timeshiftPercent = float(m_ui.TimeshiftSpinBox->value());
+	opts.timeshiftDuration = m_ui.TimeshiftDurationCheckBox->isChecked();
+
+	// Go for the batch transform...
+	qtractorMidiTools midiTools(m_pTimeScale, opts);
+
+	return midiTools.editCommand(pMidiClip, pSelect,
+		tools.join(", "), iTimeOffset, iTimeStart, iTimeEnd);
 }
 
 
@@ -23,6 +23,7 @@
 #include "qtractorMixer.h"
 
 #include "qtractorPluginListView.h"
+#include "qtractorPlugin.h"
 
 #include "qtractorAudioMeter.h"
 #include "qtractorMidiMeter.h"
@@ -571,7 +572,38 @@ void qtractorMixerStrip::updateName (void)
 	m_pLabel->setText(sName);
 	m_pLabel->update(); // Make sure icon and text gets visibly updated!
 
-	QFrame::setToolTip(sName + ' ' + sType);
+	m_sCaption = sName + ' ' + sType;
+
+	updateLatency();
+}
+
+
+// Plugin delay compensation (latency) feedback.
+void qtractorMixerStrip::updateLatency (void)
+{
+	unsigned long iLatency = 0;
+	if (m_pTrack) {
+		iLatency = m_pTrack->latency();
+	}
+	else
+	if (m_pBus && m_pBus->busType() == qtractorTrack::Audio) {
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (m_pBus);
+		if (m_busMode & qtractorBus::Input) {
+			if (pAudioBus->pluginList_in())
+				iLatency = pAudioBus->pluginList_in()->latency();
+		} else {
+			iLatency = pAudioBus->latencyComp();
+			if (pAudioBus->pluginList_out())
+				iLatency += pAudioBus->pluginList_out()->latency();
+		}
+	}
+
+	QString sToolTip = m_sCaption;
+	if (iLatency > 0)
+		sToolTip += '\n' + tr("Latency: %1 frames").arg(iLatency);
+
+	QFrame::setToolTip(sToolTip);
 }
 
 
@@ -1183,6 +1215,16 @@ void qtractorMixerRack::setSelectedStrip ( qtractorMixerStrip *pStrip )
 }
 
 
+// Update all mixer strips latency feedback.
+void qtractorMixerRack::updateLatency (void)
+{
+	Strips::ConstIterator strip = m_strips.constBegin();
+	const Strips::ConstIterator& strip_end = m_strips.constEnd();
+	for ( ; strip != strip_end; ++strip)
+		strip.value()->updateLatency();
+}
+
+
 // Hacko-list-management marking...
 void qtractorMixerRack::markStrips ( int iMark )
 {
@@ -1504,6 +1546,15 @@ void qtractorMixer::updateTracks ( bool bReset )
 }
 
 
+// Update all mixer strips latency feedback.
+void qtractorMixer::updateLatency (void)
+{
+	m_pInputRack->updateLatency();
+	m_pTrackRack->updateLatency();
+	m_pOutputRack->updateLatency();
+}
+
+
 // Complete mixer recycle.
 void qtractorMixer::clear (void)
 {
@@ -156,6 +156,9 @@ public:
 	// Track monitor dispatcher.
 	void trackMonitor(bool bMonitor);
 
+	// Plugin delay compensation (latency) feedback.
+	void updateLatency();
+
 protected slots:
 
 	// Bus connections button notification.
@@ -204,6 +207,9 @@ private:
 	QPushButton            *m_pBusButton;
 	QLabel                 *m_pMidiLabel;
 
+	// Caption (tool-tip) title.
+	QString m_sCaption;
+
 	// Selection stuff.
 	bool m_bSelected;
 
@@ -298,6 +304,9 @@ public:
 	// Update a mixer strip on rack list.
 	void updateStrip(qtractorMixerStrip *pStrip, qtractorMonitor *pMonitor);
 
+	// Update all mixer strips latency feedback.
+	void updateLatency();
+
 	// Current Strip count.
 	int stripCount() const
 		{ return m_strips.count(); }
@@ -384,6 +393,9 @@ public:
 		qtractorBus::BusMode busMode, bool bReset = false);
 	void updateTrackStrip(qtractorTrack *pTrack, bool bReset = false);
 
+	// Update all mixer strips latency feedback.
+	void updateLatency();
+
 	// Complete mixer recycle.
 	void clear();
 
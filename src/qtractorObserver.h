@@ -55,6 +55,10 @@ public:
 	float prevValue() const
 		{ return m_fPrevValue; }
 
+	// Direct value settler, leaving observers alone (RT-safe).
+	void setDirectValue(float fValue)
+		{ m_fValue = safeValue(fValue); }
+
 	// Observers notification.
 	void notify(qtractorObserver *pSender, bool bUpdate);
 
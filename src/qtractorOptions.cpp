@@ -29,6 +29,7 @@
 #include <QList>
 
 #include <QTextStream>
+#include <QFileInfo>
 
 
 // Supposed to be determinant as default audio file type
@@ -61,6 +62,10 @@ qtractorOptions::qtractorOptions (void)
 	// Pseudo-singleton reference setup.
 	g_pOptions = this;
 
+	// Not rendering, by default.
+	bRender = false;
+	bRenderStems = false;
+
 	loadOptions();
 }
 
@@ -145,6 +150,11 @@ void qtractorOptions::loadOptions (void)
 	bAudioPlayerAutoConnect = m_settings.value("/PlayerAutoConnect", true).toBool();
 	bAudioMetroAutoConnect = m_settings.value("/MetroAutoConnect", true).toBool();
 	iAudioMetroOffset  = (unsigned long) m_settings.value("/MetroOffset", 0).toUInt();
+	iAudioRenderThreads = m_settings.value("/RenderThreads", 0).toInt();
+	iAudioBlockAutomation = m_settings.value("/BlockAutomation", 0).toInt();
+	iAudioSyncThreads = m_settings.value("/SyncThreads", 4).toInt();
+	iAudioLandingBudget = m_settings.value("/LandingBudget", 64).toInt();
+	iAudioCacheBudget = m_settings.value("/CacheBudget", 256).toInt();
 	m_settings.endGroup();
 
 	// MIDI rendering options group.
@@ -153,6 +163,9 @@ void qtractorOptions::loadOptions (void)
 	iMidiCaptureQuantize = m_settings.value("/CaptureQuantize", 0).toInt();
 	iMidiQueueTimer    = m_settings.value("/QueueTimer", 0).toInt();
 	bMidiDriftCorrect  = m_settings.value("/DriftCorrect", true).toBool();
+	bMidiJackOutput    = m_settings.value("/JackOutput", false).toBool();
+	bMidiReadAheadAuto = m_settings.value("/ReadAheadAuto", true).toBool();
+	bMidiDirectPlugins = m_settings.value("/DirectPlugins", false).toBool();
 	bMidiPlayerBus     = m_settings.value("/PlayerBus", false).toBool();
 	bMidiControlBus    = m_settings.value("/ControlBus", false).toBool();
 	bMidiMetroBus      = m_settings.value("/MetroBus", false).toBool();
@@ -210,6 +223,7 @@ void qtractorOptions::loadOptions (void)
 	iPluginType     = m_settings.value("/PluginType", 1).toInt();
 	bPluginActivate = m_settings.value("/PluginActivate", false).toBool();
 	iCurveMode      = m_settings.value("/CurveMode", 0).toInt();
+	fCurveThinTolerance = float(m_settings.value("/CurveThinTolerance", 0.0).toDouble());
 	iEditRangeOptions = m_settings.value("/EditRangeOptions", 3).toInt();
 	bShiftKeyModifier = m_settings.value("/ShiftKeyModifier", false).toBool();
 	bMidButtonModifier = m_settings.value("/MidButtonModifier", false).toBool();
@@ -442,6 +456,11 @@ void qtractorOptions::saveOptions (void)
 	m_settings.setValue("/PlayerAutoConnect", bAudioPlayerAutoConnect);
 	m_settings.setValue("/MetroAutoConnect", bAudioMetroAutoConnect);
 	m_settings.setValue("/MetroOffset", uint(iAudioMetroOffset));
+	m_settings.setValue("/RenderThreads", iAudioRenderThreads);
+	m_settings.setValue("/BlockAutomation", iAudioBlockAutomation);
+	m_settings.setValue("/SyncThreads", iAudioSyncThreads);
+	m_settings.setValue("/LandingBudget", iAudioLandingBudget);
+	m_settings.setValue("/CacheBudget", iAudioCacheBudget);
 	m_settings.endGroup();
 
 	// MIDI rendering options group.
@@ -450,6 +469,9 @@ void qtractorOptions::saveOptions (void)
 	m_settings.setValue("/CaptureQuantize", iMidiCaptureQuantize);
 	m_settings.setValue("/QueueTimer", iMidiQueueTimer);
 	m_settings.setValue("/DriftCorrect", bMidiDriftCorrect);
+	m_settings.setValue("/JackOutput", bMidiJackOutput);
+	m_settings.setValue("/ReadAheadAuto", bMidiReadAheadAuto);
+	m_settings.setValue("/DirectPlugins", bMidiDirectPlugins);
 	m_settings.setValue("/PlayerBus", bMidiPlayerBus);
 	m_settings.setValue("/ControlBus", bMidiControlBus);
 	m_settings.setValue("/MetroBus", bMidiMetroBus);
@@ -507,6 +529,7 @@ void qtractorOptions::saveOptions (void)
 	m_settings.setValue("/PluginType", iPluginType);
 	m_settings.setValue("/PluginActivate", bPluginActivate);
 	m_settings.setValue("/CurveMode", iCurveMode);
+	m_settings.setValue("/CurveThinTolerance", double(fCurveThinTolerance));
 	m_settings.setValue("/EditRangeOptions", iEditRangeOptions);
 	m_settings.setValue("/ShiftKeyModifier", bShiftKeyModifier);
 	m_settings.setValue("/MidButtonModifier", bMidButtonModifier);
@@ -686,6 +709,14 @@ void qtractorOptions::print_usage ( const QString& arg0 )
 	out << "  -s, --session-id=[uuid]" + sEot +
 		QObject::tr("Set session identification (uuid)") + sEol;
 #endif
+	out << "  -R, --render=[file]" + sEot +
+		QObject::tr("Render session offline (headless) into audio file") + sEol;
+	out << "  -B, --render-bus=[name]" + sEot +
+		QObject::tr("Set audio output bus to render (may be repeated)") + sEol;
+	out << "  -S, --render-stems" + sEot +
+		QObject::tr("Render each audio output bus into its own file (stems)") + sEol;
+	out << "  -T, --render-track=[name]" + sEot +
+		QObject::tr("Render audio track into its own file (may be repeated)") + sEol;
 	out << "  -h, --help" + sEot +
 		QObject::tr("Show help about command line options") + sEol;
 	out << "  -v, --version" + sEot +
@@ -701,6 +732,14 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 	int iCmdArgs = 0;
 	const int argc = args.count();
 
+	// Headless rendering is implied when invoked as "qtractor-render"...
+	bRender = (argc > 0
+		&& QFileInfo(args.at(0)).fileName() == QTRACTOR_TITLE "-render");
+	sRenderFile.clear();
+	renderBuses.clear();
+	bRenderStems = false;
+	renderTracks.clear();
+
 	for (int i = 1; i < argc; ++i) {
 
 		if (iCmdArgs > 0) {
@@ -712,7 +751,6 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 
 		QString sArg = args.at(i);
 
-	#ifdef CONFIG_JACK_SESSION
 		QString sVal = QString::null;
 		int iEqual = sArg.indexOf('=');
 		if (iEqual >= 0) {
@@ -724,6 +762,8 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 			if (sVal[0] == '-')
 				sVal.clear();
 		}
+
+	#ifdef CONFIG_JACK_SESSION
 		if (sArg == "-s" || sArg == "--session-id") {
 			if (sVal.isNull()) {
 				out << QObject::tr("Option -s requires an argument (session-id).") + sEol;
@@ -735,7 +775,40 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 		}
 		else
 	#endif
-		if (sArg == "-h" || sArg == "--help") {
+		if (sArg == "-R" || sArg == "--render") {
+			if (sVal.isNull()) {
+				out << QObject::tr("Option -R requires an argument (file).") + sEol;
+				return false;
+			}
+			sRenderFile = sVal;
+			bRender = true;
+			if (iEqual < 0)
+				++i;
+		}
+		else if (sArg == "-B" || sArg == "--render-bus") {
+			if (sVal.isNull()) {
+				out << QObject::tr("Option -B requires an argument (name).") + sEol;
+				return false;
+			}
+			renderBuses.append(sVal);
+			if (iEqual < 0)
+				++i;
+		}
+		else if (sArg == "-S" || sArg == "--render-stems") {
+			bRenderStems = true;
+			bRender = true;
+		}
+		else if (sArg == "-T" || sArg == "--render-track") {
+			if (sVal.isNull()) {
+				out << QObject::tr("Option -T requires an argument (name).") + sEol;
+				return false;
+			}
+			renderTracks.append(sVal);
+			bRender = true;
+			if (iEqual < 0)
+				++i;
+		}
+		else if (sArg == "-h" || sArg == "--help") {
 			print_usage(args.at(0));
 			return false;
 		}
@@ -755,6 +828,13 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 		}
 	}
 
+	// Headless rendering needs a session file, at least...
+	if (bRender && sSessionFile.isEmpty()) {
+		out << QObject::tr("Render mode requires a session file.") + sEol;
+		print_usage(args.at(0));
+		return false;
+	}
+
 	// Alright with argument parsing.
 	return true;
 }
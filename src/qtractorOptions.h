@@ -62,6 +62,16 @@ public:
 	// Startup supplied session file.
 	QString sSessionFile;
 
+	// Headless (offline) session rendering mode;
+	// export file and (named) audio buses to render.
+	bool        bRender;
+	QString     sRenderFile;
+	QStringList renderBuses;
+
+	// Headless stem rendering: one file per bus/track.
+	bool        bRenderStems;
+	QStringList renderTracks;
+
 	// Display options...
 	QString sMessagesFont;
 	bool    bMessagesLimit;
@@ -120,6 +130,21 @@ public:
 	// Audio metronome latency offset compensation.
 	unsigned long iAudioMetroOffset;
 
+	// Audio parallel track rendering threads (0=serial).
+	int     iAudioRenderThreads;
+
+	// Audio block automation sub-block size (0=per-period).
+	int     iAudioBlockAutomation;
+
+	// Audio buffer disk I/O worker threads.
+	int     iAudioSyncThreads;
+
+	// Audio buffer seek prefetch memory budget (MB).
+	int     iAudioLandingBudget;
+
+	// Shared decoded audio cache memory budget (MB).
+	int     iAudioCacheBudget;
+
 	// Audio metronome parameters.
 	QString sMetroBarFilename;
 	float   fMetroBarGain;
@@ -131,6 +156,9 @@ public:
 	int  iMidiCaptureQuantize;
 	int  iMidiQueueTimer;
 	bool bMidiDriftCorrect;
+	bool bMidiJackOutput;
+	bool bMidiReadAheadAuto;
+	bool bMidiDirectPlugins;
 	bool bMidiPlayerBus;
 	bool bMidiControlBus;
 	bool bMidiMetroBus;
@@ -188,6 +216,9 @@ public:
 	// Automation curve mode default.
 	int     iCurveMode;
 
+	// Automation capture thinning tolerance (in percent; 0=disabled).
+	float   fCurveThinTolerance;
+
 	// Edit-range options.
 	int     iEditRangeOptions;
 
@@ -62,6 +62,15 @@ typedef void (*qtractorPluginFile_Function)(void);
 #endif
 
 
+// Audio routing graph invalidation helper.
+static inline void qtractorPluginList_resetGraph (void)
+{
+	qtractorSession *pSession = qtractorSession::getInstance();
+	if (pSession && pSession->audioEngine())
+		pSession->audioEngine()->resetGraph();
+}
+
+
 //----------------------------------------------------------------------------
 // qtractorPluginFile -- Plugin file library instance.
 //
@@ -1624,6 +1633,9 @@ void qtractorPluginList::insertPlugin (
 	else
 		append(pPlugin);
 
+	// Routing topology might have changed...
+	qtractorPluginList_resetGraph();
+
 	// Now update each observer list-view...
 	QListIterator<qtractorPluginListView *> iter(m_views);
 	while (iter.hasNext()) {
@@ -1661,6 +1673,9 @@ void qtractorPluginList::movePlugin (
 		append(pPlugin);
 	}
 
+	// Routing topology might have changed...
+	qtractorPluginList_resetGraph();
+
 	// DANGER: Gasp, we might be not the same...
 	if (pPluginList != this) {
 		// Move all plugin automation curves...
@@ -1725,6 +1740,9 @@ void qtractorPluginList::removePlugin ( qtractorPlugin *pPlugin )
 	// Just unlink the plugin from the list...
 	unlink(pPlugin);
 
+	// Routing topology might have changed...
+	qtractorPluginList_resetGraph();
+
 	if (pPlugin->isActivated())
 		updateActivated(false);
 
@@ -1838,6 +1856,39 @@ void qtractorPluginList::process ( float **ppBuffer, unsigned int nframes )
 }
 
 
+// Whether the plugin-chain may be processed in sub-blocks.
+bool qtractorPluginList::isBlockProcess (void) const
+{
+	for (qtractorPlugin *pPlugin = first();
+			pPlugin; pPlugin = pPlugin->next()) {
+		if (!pPlugin->isActivated())
+			continue;
+		const qtractorPluginType::Hint typeHint
+			= (pPlugin->type())->typeHint();
+		if (typeHint == qtractorPluginType::Insert ||
+			typeHint == qtractorPluginType::AuxSend)
+			return false;
+	}
+
+	return true;
+}
+
+
+// Total plugin-chain processing latency (in frames).
+unsigned long qtractorPluginList::latency (void) const
+{
+	unsigned long iLatency = 0;
+
+	for (qtractorPlugin *pPlugin = first();
+			pPlugin; pPlugin = pPlugin->next()) {
+		if (pPlugin->isActivated())
+			iLatency += pPlugin->latency();
+	}
+
+	return iLatency;
+}
+
+
 // Document element methods.
 bool qtractorPluginList::loadElement (
 	qtractorDocument *pDocument, QDomElement *pElement )
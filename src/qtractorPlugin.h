@@ -428,6 +428,9 @@ public:
 	virtual void process(
 		float **ppIBuffer, float **ppOBuffer, unsigned int nframes) = 0;
 
+	// Plugin processing latency (in frames), if any.
+	virtual unsigned long latency() const { return 0; }
+
 	// Parameter update method.
 	virtual void updateParam(
 		qtractorPluginParam */*pParam*/, float /*fValue*/, bool /*bUpdate*/) {}
@@ -836,6 +839,13 @@ public:
 	// The meta-main audio-processing plugin-chain procedure.
 	void process(float **ppBuffer, unsigned int nframes);
 
+	// Whether the plugin-chain may be processed in sub-blocks
+	// (ie. no inserts nor aux-sends, bound to whole periods).
+	bool isBlockProcess() const;
+
+	// Total plugin-chain processing latency (in frames).
+	unsigned long latency() const;
+
 	// Document element methods.
 	bool loadElement(qtractorDocument *pDocument, QDomElement *pElement);
 	bool saveElement(qtractorDocument *pDocument, QDomElement *pElement);
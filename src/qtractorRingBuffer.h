@@ -51,6 +51,13 @@ public:
 	// Direct ring-buffer accessor (DANGEROUS).
 	T **buffer() const { return m_ppBuffer; }
 
+	// Shared ring-buffer storage (DANGEROUS):
+	// adopt someone else's (same sized) storage,
+	// or give up ownership of our own (to someone else).
+	void setBuffer(T **ppBuffer);
+	void detachBuffer() { m_bOwner = false; }
+	bool isOwner() const { return m_bOwner; }
+
 	// Ring-buffer cache properties.
 	unsigned int readable() const;
 	unsigned int writable() const;
@@ -79,6 +86,8 @@ private:
 	qtractorAtomic m_iWriteIndex;
 
 	T** m_ppBuffer;
+
+	bool m_bOwner;
 };
 
 
@@ -107,6 +116,8 @@ qtractorRingBuffer<T>::qtractorRingBuffer ( unsigned short iChannels,
 	for (unsigned short i = 0; i < m_iChannels; ++i)
 		m_ppBuffer[i] = new T [m_iBufferSize];
 
+	m_bOwner = true;
+
 	ATOMIC_SET(&m_iReadIndex,  0);
 	ATOMIC_SET(&m_iWriteIndex, 0);
 }
@@ -116,7 +127,7 @@ template<typename T>
 qtractorRingBuffer<T>::~qtractorRingBuffer (void)
 {
 	// Deallocate any buffer stuff...
-	if (m_ppBuffer) {
+	if (m_ppBuffer && m_bOwner) {
 		for (unsigned short i = 0; i < m_iChannels; ++i)
 			delete [] m_ppBuffer[i];
 		delete [] m_ppBuffer;
@@ -124,6 +135,21 @@ qtractorRingBuffer<T>::~qtractorRingBuffer (void)
 }
 
 
+// Shared ring-buffer storage (DANGEROUS).
+template<typename T>
+void qtractorRingBuffer<T>::setBuffer ( T **ppBuffer )
+{
+	if (m_ppBuffer && m_bOwner) {
+		for (unsigned short i = 0; i < m_iChannels; ++i)
+			delete [] m_ppBuffer[i];
+		delete [] m_ppBuffer;
+	}
+
+	m_ppBuffer = ppBuffer;
+	m_bOwner = false;
+}
+
+
 template<typename T>
 unsigned int qtractorRingBuffer<T>::readable (void) const
 {
@@ -29,13 +29,17 @@
 #include "qtractorAudioPeak.h"
 #include "qtractorAudioClip.h"
 #include "qtractorAudioBuffer.h"
+#include "qtractorAudioCache.h"
+#include "qtractorAudioRender.h"
 
 #include "qtractorMidiEngine.h"
 #include "qtractorMidiClip.h"
 #include "qtractorMidiManager.h"
 
 #include "qtractorPlugin.h"
+#include "qtractorInsertPlugin.h"
 #include "qtractorCurve.h"
+#include "qtractorMonitor.h"
 
 #include "qtractorInstrument.h"
 #include "qtractorCommand.h"
@@ -52,6 +56,7 @@
 #include <QDomDocument>
 
 #include <stdlib.h>
+#include <limits.h>
 
 
 //-------------------------------------------------------------------------
@@ -116,6 +121,7 @@ qtractorSession::qtractorSession (void)
 	m_pMidiEngine       = new qtractorMidiEngine(this);
 	m_pAudioEngine      = new qtractorAudioEngine(this);
 	m_pAudioPeakFactory = new qtractorAudioPeakFactory();
+	m_pAudioCache       = new qtractorAudioCache();
 
 	m_bAutoTimeStretch  = false;
 
@@ -123,6 +129,8 @@ qtractorSession::qtractorSession (void)
 
 	m_iLoopRecordingMode = 0;
 
+	m_iUpdateSerial = 0;
+
 	clear();
 }
 
@@ -136,6 +144,7 @@ qtractorSession::~qtractorSession (void)
 	delete m_pAudioPeakFactory;
 	delete m_pAudioEngine;
 	delete m_pMidiEngine;
+	delete m_pAudioCache;
 
 	delete m_pInstruments;
 	delete m_pCommands;
@@ -292,6 +301,17 @@ void qtractorSession::clear (void)
 
 	m_iPlayHeadAutoBackward = 0;
 
+	++m_iUpdateSerial;
+
+	m_iLatencyUpdate  = 0;
+	m_iLatencyGraph   = 0;
+	m_iLatencySum     = 0;
+
+	m_iPrefetchUpdate = 0;
+	m_iPrefetchGraph  = 0;
+	m_iPrefetchHead   = 0;
+	m_iPrefetchTail   = 0;
+
 	m_bRecording = false;
 
 	updateTimeScale();
@@ -393,6 +413,9 @@ void qtractorSession::updateSession (
 		return;
 	}
 
+	// Something might have changed...
+	++m_iUpdateSerial;
+
 	// Set initial one...
 	m_iSessionStart = iSessionStart;
 	m_iSessionEnd   = iSessionEnd;
@@ -583,6 +606,8 @@ void qtractorSession::setEditHead ( unsigned long iEditHead )
 {
 	m_iEditHead     = iEditHead;
 	m_iEditHeadTime = tickFromFrame(iEditHead);
+
+	++m_iUpdateSerial;
 }
 
 unsigned long qtractorSession::editHead (void) const
@@ -595,6 +620,8 @@ void qtractorSession::setEditTail ( unsigned long iEditTail )
 {
 	m_iEditTail     = iEditTail;
 	m_iEditTailTime = tickFromFrame(iEditTail);
+
+	++m_iUpdateSerial;
 }
 
 unsigned long qtractorSession::editTail (void) const
@@ -907,6 +934,16 @@ void qtractorSession::insertTrack ( qtractorTrack *pTrack,
 		pSessionCursor = pSessionCursor->next();
 	}
 
+	// Render item tables may only grow while out of (RT) business...
+	qtractorAudioRenderPool *pRenderPool = m_pAudioEngine->renderPool();
+	if (pRenderPool && !pRenderPool->isRenderSize(m_tracks.count())) {
+		lock();
+		pRenderPool->checkRenderSize(m_tracks.count());
+		unlock();
+	}
+
+	m_pAudioEngine->resetGraph();
+
 	pTrack->setLoop(m_iLoopStart, m_iLoopEnd);
 	pTrack->open();
 
@@ -925,6 +962,8 @@ void qtractorSession::moveTrack (
 	else
 		m_tracks.append(pTrack);
 
+	m_pAudioEngine->resetGraph();
+
 	qtractorSessionCursor *pSessionCursor = m_cursors.first();
 	while (pSessionCursor) {
 		pSessionCursor->resetClips();
@@ -982,6 +1021,8 @@ void qtractorSession::unlinkTrack ( qtractorTrack *pTrack )
 
 	m_tracks.unlink(pTrack);
 
+	m_pAudioEngine->resetGraph();
+
 //	unlock();
 }
 
@@ -1204,6 +1245,10 @@ void qtractorSession::setPlaying ( bool bPlaying )
 		}
 	}
 
+	// Flush any stale plugin delay compensation leftovers...
+	if (bPlaying)
+		resetLatency();
+
 	// Do it.
 	m_pAudioEngine->setPlaying(bPlaying);
 	m_pMidiEngine->setPlaying(bPlaying);
@@ -1381,6 +1426,8 @@ void qtractorSession::setLoop (
 	lock();
 	setPlaying(false);
 
+	++m_iUpdateSerial;
+
 	// Local prepare...
 	if (iLoopStart >= iLoopEnd) {
 		iLoopStart = 0;
@@ -1866,6 +1913,13 @@ qtractorAudioPeakFactory *qtractorSession::audioPeakFactory (void) const
 }
 
 
+// Shared decoded audio cache accessor.
+qtractorAudioCache *qtractorSession::audioCache (void) const
+{
+	return m_pAudioCache;
+}
+
+
 // MIDI track tagging specifics.
 unsigned short qtractorSession::midiTag (void) const
 {
@@ -1940,6 +1994,15 @@ void qtractorSession::process (
 {
 	const qtractorTrack::TrackType syncType = pSessionCursor->syncType();
 
+	// Parallel track rendering, if applicable...
+	if (syncType == qtractorTrack::Audio) {
+		qtractorAudioRenderPool *pRenderPool = m_pAudioEngine->renderPool();
+		if (pRenderPool) {
+			pRenderPool->process(pSessionCursor, iFrameStart, iFrameEnd);
+			return;
+		}
+	}
+
 	// Now, for every track...
 	int iTrack = 0;
 	qtractorTrack *pTrack = m_tracks.first();
@@ -1985,6 +2048,357 @@ void qtractorSession::process_curve ( unsigned long iFrame )
 }
 
 
+// Plugin delay compensation (PDC) update (non RT-safe).
+bool qtractorSession::updateLatency (void)
+{
+	if (!m_pAudioEngine->isActivated()) {
+		m_iLatencyUpdate = 0;
+		return false;
+	}
+
+	// Cheap change check first: any session contents or routing
+	// topology change, otherwise any plugin (de)activation or
+	// latency as (re)reported, which may change at any time...
+	unsigned long iLatencySum = 0;
+	qtractorTrack *pTrack = m_tracks.first();
+	for ( ; pTrack; pTrack = pTrack->next()) {
+		qtractorPluginList *pPluginList = pTrack->pluginList();
+		if (pPluginList == NULL)
+			continue;
+		qtractorPlugin *pPlugin = pPluginList->first();
+		for ( ; pPlugin; pPlugin = pPlugin->next()) {
+			iLatencySum = 31 * iLatencySum
+				+ (pPlugin->isActivated() ? pPlugin->latency() + 1 : 0);
+		}
+		// MIDI instrument plugins may go into any audio bus...
+		qtractorMidiManager *pMidiManager = pPluginList->midiManager();
+		if (pMidiManager) {
+			iLatencySum = 31 * iLatencySum
+				+ (unsigned long) pMidiManager->audioOutputBus();
+		}
+	}
+
+	const int iGraphSerial = m_pAudioEngine->graphSerial();
+	if (m_iLatencyUpdate == m_iUpdateSerial
+		&& m_iLatencyGraph == iGraphSerial
+		&& m_iLatencySum == iLatencySum)
+		return false;
+
+	m_iLatencyUpdate = m_iUpdateSerial;
+	m_iLatencyGraph  = iGraphSerial;
+	m_iLatencySum    = iLatencySum;
+
+	// External MIDI output (eg. hardware synths) is to be
+	// aligned to the master (first) audio output bus...
+	qtractorAudioBus *pMasterBus = NULL;
+	for (qtractorBus *pBus = m_pAudioEngine->buses().first();
+			pBus; pBus = pBus->next()) {
+		if (pBus->busMode() & qtractorBus::Output) {
+			pMasterBus = static_cast<qtractorAudioBus *> (pBus);
+			break;
+		}
+	}
+
+	// Plugin chain latencies, as of each track output
+	// and each audio track aux-send (at their insertion points)...
+	QHash<qtractorTrack *, unsigned long> tracks;
+	QHash<qtractorAudioAuxSendPlugin *, unsigned long> sends;
+
+	// Audio bus where each track path gets into: audio track
+	// output bus or MIDI track instrument plugins output bus...
+	QHash<qtractorTrack *, qtractorAudioBus *> targets;
+
+	// Aligned (maximum) latency into each output bus
+	// (bus output plugin chains are left uncompensated)...
+	QHash<qtractorAudioBus *, unsigned long> buses;
+
+	for (pTrack = m_tracks.first(); pTrack; pTrack = pTrack->next()) {
+		if (pTrack->trackType() == qtractorTrack::Midi) {
+			// MIDI track instrument plugins into their audio output bus,
+			// otherwise external MIDI output (no latency of its own)...
+			qtractorPluginList *pPluginList = pTrack->pluginList();
+			qtractorMidiManager *pMidiManager
+				= (pPluginList ? pPluginList->midiManager() : NULL);
+			qtractorAudioBus *pAudioBus
+				= (pMidiManager ? pMidiManager->audioOutputBus() : NULL);
+			if (pAudioBus) {
+				const unsigned long iLatency = pPluginList->latency();
+				tracks.insert(pTrack, iLatency);
+				targets.insert(pTrack, pAudioBus);
+				if (buses.value(pAudioBus, 0) < iLatency)
+					buses.insert(pAudioBus, iLatency);
+			}
+			else
+			if (pMasterBus) {
+				tracks.insert(pTrack, 0);
+				targets.insert(pTrack, pMasterBus);
+			}
+			continue;
+		}
+		if (pTrack->trackType() != qtractorTrack::Audio)
+			continue;
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (pTrack->outputBus());
+		if (pAudioBus == NULL)
+			continue;
+		unsigned long iLatency = 0;
+		qtractorPlugin *pPlugin = pTrack->pluginList()->first();
+		for ( ; pPlugin; pPlugin = pPlugin->next()) {
+			if ((pPlugin->type())->typeHint() == qtractorPluginType::AuxSend) {
+				qtractorAudioAuxSendPlugin *pAuxSendPlugin
+					= static_cast<qtractorAudioAuxSendPlugin *> (pPlugin);
+				qtractorAudioBus *pAuxBus = pAuxSendPlugin->audioBus();
+				if (pAuxBus) {
+					sends.insert(pAuxSendPlugin, iLatency);
+					if (buses.value(pAuxBus, 0) < iLatency)
+						buses.insert(pAuxBus, iLatency);
+				}
+			}
+			else {
+				// Parameter automation follows the signal path,
+				// as late as the plugin chain ahead of it...
+				const qtractorPlugin::Params& params = pPlugin->params();
+				qtractorPlugin::Params::ConstIterator param = params.constBegin();
+				const qtractorPlugin::Params::ConstIterator& param_end
+					= params.constEnd();
+				for ( ; param != param_end; ++param) {
+					qtractorCurve *pCurve = param.value()->subject()->curve();
+					if (pCurve)
+						pCurve->setLatency(iLatency);
+				}
+				if (pPlugin->isActivated())
+					iLatency += pPlugin->latency();
+			}
+		}
+		tracks.insert(pTrack, iLatency);
+		targets.insert(pTrack, pAudioBus);
+		if (buses.value(pAudioBus, 0) < iLatency)
+			buses.insert(pAudioBus, iLatency);
+	}
+
+	// Check whether any compensation delay has changed:
+	// each path gets as late as its own target bus...
+	bool bUpdate = false;
+
+	QHash<qtractorTrack *, unsigned long>::ConstIterator track_iter
+		= tracks.constBegin();
+	const QHash<qtractorTrack *, unsigned long>::ConstIterator& track_end
+		= tracks.constEnd();
+	for ( ; !bUpdate && track_iter != track_end; ++track_iter) {
+		pTrack = track_iter.key();
+		const unsigned long iDelay
+			= buses.value(targets.value(pTrack), 0) - track_iter.value();
+		bUpdate = (pTrack->latencyDelay() != iDelay);
+	}
+
+	QHash<qtractorAudioAuxSendPlugin *, unsigned long>::ConstIterator send_iter
+		= sends.constBegin();
+	const QHash<qtractorAudioAuxSendPlugin *, unsigned long>::ConstIterator& send_end
+		= sends.constEnd();
+	for ( ; !bUpdate && send_iter != send_end; ++send_iter) {
+		qtractorAudioAuxSendPlugin *pAuxSendPlugin = send_iter.key();
+		const unsigned long iDelay
+			= buses.value(pAuxSendPlugin->audioBus(), 0) - send_iter.value();
+		bUpdate = (pAuxSendPlugin->latencyDelay() != iDelay);
+	}
+
+	// Delay-lines (re)allocation must be done while locked...
+	if (bUpdate) {
+		lock();
+		for (track_iter = tracks.constBegin();
+				track_iter != track_end; ++track_iter) {
+			pTrack = track_iter.key();
+			pTrack->setLatencyDelay(
+				buses.value(targets.value(pTrack), 0) - track_iter.value());
+		}
+		for (send_iter = sends.constBegin();
+				send_iter != send_end; ++send_iter) {
+			qtractorAudioAuxSendPlugin *pAuxSendPlugin = send_iter.key();
+			pAuxSendPlugin->setLatencyDelay(
+				buses.value(pAuxSendPlugin->audioBus(), 0) - send_iter.value());
+		}
+		unlock();
+	}
+
+	// Automation follows the compensated signal path,
+	// as track gain and panning are applied post-delay...
+	for (track_iter = tracks.constBegin();
+			track_iter != track_end; ++track_iter) {
+		pTrack = track_iter.key();
+		if (pTrack->trackType() == qtractorTrack::Midi) {
+			// MIDI track plugins get their events that late, and
+			// so their parameter automation, plus the chain ahead...
+			unsigned long iLatency = pTrack->latencyDelay();
+			qtractorPlugin *pPlugin = pTrack->pluginList()->first();
+			for ( ; pPlugin; pPlugin = pPlugin->next()) {
+				const qtractorPlugin::Params& params = pPlugin->params();
+				qtractorPlugin::Params::ConstIterator param = params.constBegin();
+				const qtractorPlugin::Params::ConstIterator& param_end
+					= params.constEnd();
+				for ( ; param != param_end; ++param) {
+					qtractorCurve *pCurve = param.value()->subject()->curve();
+					if (pCurve)
+						pCurve->setLatency(iLatency);
+				}
+				if (pPlugin->isActivated())
+					iLatency += pPlugin->latency();
+			}
+			continue;
+		}
+		qtractorMonitor *pMonitor = pTrack->monitor();
+		if (pMonitor == NULL)
+			continue;
+		const unsigned long iLatency = pTrack->latency();
+		qtractorCurve *pCurve = pMonitor->gainSubject()->curve();
+		if (pCurve)
+			pCurve->setLatency(iLatency);
+		pCurve = pMonitor->panningSubject()->curve();
+		if (pCurve)
+			pCurve->setLatency(iLatency);
+	}
+
+	// Keep track of bus (aligned) latencies...
+	for (qtractorBus *pBus = m_pAudioEngine->buses().first();
+			pBus; pBus = pBus->next()) {
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (pBus);
+		if (pAudioBus == NULL)
+			continue;
+		const unsigned long iLatency = buses.value(pAudioBus, 0);
+		if (pAudioBus->latencyComp() != iLatency) {
+			pAudioBus->setLatencyComp(iLatency);
+			bUpdate = true;
+		}
+	}
+
+	return bUpdate;
+}
+
+
+// Plugin delay compensation (PDC) flush: delay-lines are only
+// cleared on their very next process cycle, in the RT thread.
+void qtractorSession::resetLatency (void)
+{
+	qtractorTrack *pTrack = m_tracks.first();
+	for ( ; pTrack; pTrack = pTrack->next()) {
+		if (pTrack->trackType() != qtractorTrack::Audio)
+			continue;
+		pTrack->resetLatencyDelay();
+		qtractorPluginList *pPluginList = pTrack->pluginList();
+		qtractorPlugin *pPlugin = pPluginList->first();
+		for ( ; pPlugin; pPlugin = pPlugin->next()) {
+			if ((pPlugin->type())->typeHint() == qtractorPluginType::AuxSend
+				&& !pPluginList->isMidi()) {
+				qtractorAudioAuxSendPlugin *pAuxSendPlugin
+					= static_cast<qtractorAudioAuxSendPlugin *> (pPlugin);
+				pAuxSendPlugin->resetLatencyDelay();
+			}
+		}
+	}
+}
+
+
+// Predictive seek prefetch (landing) update (non RT-safe).
+void qtractorSession::updatePrefetch (void)
+{
+	if (!m_pAudioEngine->isActivated()) {
+		m_iPrefetchUpdate = 0;
+		return;
+	}
+
+	const unsigned long iPlayHead = playHead();
+
+	// Nothing changed, as long as the play-head
+	// hasn't crossed any clip start either...
+	const int iGraphSerial = m_pAudioEngine->graphSerial();
+	if (m_iPrefetchUpdate == m_iUpdateSerial
+		&& m_iPrefetchGraph == iGraphSerial
+		&& iPlayHead >= m_iPrefetchHead
+		&& iPlayHead <  m_iPrefetchTail)
+		return;
+
+	m_iPrefetchUpdate = m_iUpdateSerial;
+	m_iPrefetchGraph  = iGraphSerial;
+	m_iPrefetchHead   = 0;
+	m_iPrefetchTail   = ULONG_MAX;
+
+	// Most likely seek targets (in session frames)...
+	QList<unsigned long> targets;
+	if (isLooping())
+		targets.append(loopStart());
+	targets.append(editHead());
+	targets.append(editTail());
+	qtractorTimeScale::Marker *pMarker = timeScale()->markers().first();
+	while (pMarker) {
+		targets.append(pMarker->frame);
+		pMarker = pMarker->next();
+	}
+
+	// Gather (clip-relative) targets for each audio buffer,
+	// as hash-linked clips might share the same one...
+	QHash<qtractorAudioBuffer *, QList<unsigned long> > landings;
+
+	for (qtractorTrack *pTrack = m_tracks.first();
+			pTrack; pTrack = pTrack->next()) {
+		if (pTrack->trackType() != qtractorTrack::Audio)
+			continue;
+		bool bNextClip = false;
+		for (qtractorClip *pClip = pTrack->clips().first();
+				pClip; pClip = pClip->next()) {
+			qtractorAudioClip *pAudioClip
+				= static_cast<qtractorAudioClip *> (pClip);
+			qtractorAudioBuffer *pBuff = pAudioClip->buffer();
+			if (pBuff == NULL)
+				continue;
+			QList<unsigned long>& list = landings[pBuff];
+			const unsigned long iClipStart = pClip->clipStart();
+			const unsigned long iClipEnd = iClipStart + pClip->clipLength();
+			// Play-head window, in between clip starts...
+			if (iClipStart > iPlayHead) {
+				if (m_iPrefetchTail > iClipStart)
+					m_iPrefetchTail = iClipStart;
+			}
+			else if (m_iPrefetchHead < iClipStart)
+				m_iPrefetchHead = iClipStart;
+			// Next upcoming clip start goes first...
+			if (!bNextClip && iClipStart > iPlayHead) {
+				if (!list.contains(0))
+					list.prepend(0);
+				bNextClip = true;
+			}
+			QListIterator<unsigned long> iter(targets);
+			while (iter.hasNext()) {
+				const unsigned long iFrame = iter.next();
+				if (iFrame >= iClipStart && iFrame < iClipEnd) {
+					const unsigned long iOffset = iFrame - iClipStart;
+					if (!list.contains(iOffset))
+						list.append(iOffset);
+				}
+			}
+		}
+	}
+
+	QHash<qtractorAudioBuffer *, QList<unsigned long> >::ConstIterator iter
+		= landings.constBegin();
+	const QHash<qtractorAudioBuffer *, QList<unsigned long> >::ConstIterator&
+		iter_end = landings.constEnd();
+	for ( ; iter != iter_end; ++iter)
+		iter.key()->setLandingTargets(iter.value());
+}
+
+
+// Automation curve node index update (non RT-safe).
+void qtractorSession::updateCurveIndex (void)
+{
+	for (qtractorTrack *pTrack = m_tracks.first();
+			pTrack; pTrack = pTrack->next()) {
+		qtractorCurveList *pCurveList = pTrack->curveList();
+		if (pCurveList)
+			pCurveList->updateIndex();
+	}
+}
+
+
 // Find track of specific curve-list.
 qtractorTrack *qtractorSession::findTrack ( qtractorCurveList *pCurveList ) const
 {
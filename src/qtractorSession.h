@@ -35,6 +35,7 @@ class qtractorClip;
 class qtractorMidiEngine;
 class qtractorAudioEngine;
 class qtractorAudioPeakFactory;
+class qtractorAudioCache;
 class qtractorSessionCursor;
 class qtractorSessionDocument;
 class qtractorMidiManager;
@@ -329,6 +330,9 @@ public:
 	// Audio peak factory accessor.
 	qtractorAudioPeakFactory *audioPeakFactory() const;
 
+	// Shared decoded audio cache accessor.
+	qtractorAudioCache *audioCache() const;
+
 	// MIDI track tagging specifics.
 	unsigned short midiTag() const;
 	void acquireMidiTag(qtractorTrack *pTrack);
@@ -358,6 +362,20 @@ public:
 	// Session special process automation executive.
 	void process_curve(unsigned long iFrame);
 
+	// Plugin delay compensation (PDC) update, if anything changed
+	// (non RT-safe); returns true whenever any compensation has changed.
+	bool updateLatency();
+
+	// Plugin delay compensation (PDC) flush (posted to the RT thread).
+	void resetLatency();
+
+	// Predictive seek prefetch (landing) update, if anything changed
+	// or the play-head crossed some clip start (non RT-safe).
+	void updatePrefetch();
+
+	// Automation curve node index update (non RT-safe).
+	void updateCurveIndex();
+
 	// Document element methods.
 	bool loadElement(qtractorSessionDocument *pDocument, QDomElement *pElement);
 	bool saveElement(qtractorSessionDocument *pDocument, QDomElement *pElement);
@@ -445,6 +463,9 @@ private:
 	// Audio peak factory (singleton) instance.
 	qtractorAudioPeakFactory *m_pAudioPeakFactory;
 
+	// Shared decoded audio cache (singleton) instance.
+	qtractorAudioCache *m_pAudioCache;
+
 	// Track recording counts.
 	unsigned short m_iAudioRecord;
 	unsigned short m_iMidiRecord;
@@ -491,6 +512,21 @@ private:
 	// MIDI plugin manager list.
 	qtractorList<qtractorMidiManager> m_midiManagers;
 
+	// Session contents change serial.
+	unsigned int m_iUpdateSerial;
+
+	// Plugin delay compensation (PDC) last update keys.
+	unsigned int  m_iLatencyUpdate;
+	int           m_iLatencyGraph;
+	unsigned long m_iLatencySum;
+
+	// Predictive seek prefetch last update keys,
+	// incl. the play-head window it still holds for.
+	unsigned int  m_iPrefetchUpdate;
+	int           m_iPrefetchGraph;
+	unsigned long m_iPrefetchHead;
+	unsigned long m_iPrefetchTail;
+
 	// RT-safeness hackish lock-mutex.
 	qtractorAtomic m_locks;
 	qtractorAtomic m_mutex;
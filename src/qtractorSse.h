@@ -0,0 +1,78 @@
+// qtractorSse.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorSse_h
+#define __qtractorSse_h
+
+#if defined(__SSE__)
+
+#include <xmmintrin.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+// SSE/SSE2 detection (EDX feature bits).
+static inline unsigned int sse_cpuid_edx (void)
+{
+#if defined(__GNUC__)
+	unsigned int eax, ebx, ecx, edx;
+#if defined(__x86_64__) || (!defined(PIC) && !defined(__PIC__))
+	__asm__ __volatile__ (
+		"cpuid\n\t" \
+		: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) \
+		: "a" (1) : "cc");
+#else
+	__asm__ __volatile__ (
+		"push %%ebx\n\t" \
+		"cpuid\n\t" \
+		"movl %%ebx,%1\n\t" \
+		"pop %%ebx\n\t" \
+		: "=a" (eax), "=r" (ebx), "=c" (ecx), "=d" (edx) \
+		: "a" (1) : "cc");
+#endif
+	return edx;
+#else
+	return 0;
+#endif
+}
+
+static inline bool sse_enabled (void)
+{
+	return (sse_cpuid_edx() & (1 << 25));
+}
+
+#if defined(__SSE2__)
+
+static inline bool sse2_enabled (void)
+{
+	return (sse_cpuid_edx() & (1 << 26));
+}
+
+#endif	// __SSE2__
+
+#endif	// __SSE__
+
+
+#endif  // __qtractorSse_h
+
+// end of qtractorSse.h
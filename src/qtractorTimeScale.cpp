@@ -22,11 +22,37 @@
 #include "qtractorTimeScale.h"
 #include <QObject>
 
+#include <limits.h>
+
+
+// Atomic pointer (acquire) load helper.
+template <typename T>
+static inline T *atomicPointerLoad ( const QAtomicPointer<T>& ptr )
+{
+#if QT_VERSION >= 0x050000
+	return ptr.loadAcquire();
+#else
+	return ptr;
+#endif
+}
+
 
 //----------------------------------------------------------------------
 // class qtractorTimeScale -- Time scale conversion helper class.
 //
 
+// Destructor.
+qtractorTimeScale::~qtractorTimeScale (void)
+{
+	qDeleteAll(m_retired);
+	m_retired.clear();
+
+	Snapshot *pSnapshot = m_snapshot.fetchAndStoreOrdered(NULL);
+	if (pSnapshot)
+		delete pSnapshot;
+}
+
+
 // Node list cleaner.
 void qtractorTimeScale::reset (void)
 {
@@ -418,6 +444,10 @@ void qtractorTimeScale::updateNode ( qtractorTimeScale::Node *pNode )
 
 	// And update marker/bar positions too...
 	updateMarkers(pNode->prev());
+
+	++m_iRevision;
+
+	updateSnapshot();
 }
 
 
@@ -445,6 +475,10 @@ void qtractorTimeScale::removeNode ( qtractorTimeScale::Node *pNode )
 
 	// Then update marker/bar positions too...
 	updateMarkers(pNodePrev);
+
+	++m_iRevision;
+
+	updateSnapshot();
 }
 
 
@@ -467,6 +501,260 @@ void qtractorTimeScale::updateScale (void)
 
 	// Also update all marker/bar positions too...
 	updateMarkers(m_nodes.first());
+
+	++m_iRevision;
+
+	updateSnapshot();
+}
+
+
+// Tempo-map snapshot publishing (non RT-safe).
+void qtractorTimeScale::updateSnapshot (void)
+{
+	m_mutex.lock();
+
+	// Only worth it when anyone's reading...
+	if (!m_readers.isEmpty()) {
+		Snapshot *pSnapshot
+			= m_snapshot.fetchAndStoreOrdered(new Snapshot(this));
+		if (pSnapshot)
+			m_retired.append(pSnapshot);
+	}
+
+	m_mutex.unlock();
+
+	cleanSnapshots();
+}
+
+
+// Tempo-map snapshot reclamation (non RT-safe):
+// retired snapshots go away when no reader holds them anymore.
+void qtractorTimeScale::cleanSnapshots (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	QMutableListIterator<Snapshot *> iter(m_retired);
+	while (iter.hasNext()) {
+		Snapshot *pSnapshot = iter.next();
+		bool bHazard = false;
+		QListIterator<Reader *> reader_iter(m_readers);
+		while (!bHazard && reader_iter.hasNext())
+			bHazard = (reader_iter.next()->hazard() == pSnapshot);
+		if (!bHazard) {
+			iter.remove();
+			delete pSnapshot;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorTimeScale::Snapshot -- Immutable tempo-map copy.
+//
+
+// Constructor.
+qtractorTimeScale::Snapshot::Snapshot ( const qtractorTimeScale *pTimeScale )
+	: m_iRevision(pTimeScale->revision())
+{
+	qtractorTimeScale *ts = const_cast<qtractorTimeScale *> (pTimeScale);
+
+	m_nodes.reserve(pTimeScale->nodes().count());
+
+	Node *pNode = pTimeScale->nodes().first();
+	while (pNode) {
+		Node node(ts, pNode->frame,
+			pNode->tempo, pNode->beatType,
+			pNode->beatsPerBar, pNode->beatDivisor);
+		node.update();
+		node.bar   = pNode->bar;
+		node.beat  = pNode->beat;
+		node.tick  = pNode->tick;
+		node.pixel = pNode->pixel;
+		m_nodes.append(node);
+		pNode = pNode->next();
+	}
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorTimeScale::Reader -- Per-thread tempo-map reader.
+//
+
+// Constructor (registration; non RT-safe).
+qtractorTimeScale::Reader::Reader ( qtractorTimeScale *pTimeScale )
+	: ts(pTimeScale), m_pSnapshot(NULL), m_iNode(0)
+{
+	ts->m_mutex.lock();
+	ts->m_readers.append(this);
+	ts->m_mutex.unlock();
+
+	// Make sure there's always one to read...
+	if (atomicPointerLoad(ts->m_snapshot) == NULL)
+		ts->updateSnapshot();
+}
+
+
+// Destructor (unregistration; non RT-safe).
+qtractorTimeScale::Reader::~Reader (void)
+{
+	ts->m_mutex.lock();
+	ts->m_readers.removeAll(this);
+	ts->m_mutex.unlock();
+
+	m_hazard.fetchAndStoreOrdered(NULL);
+
+	ts->cleanSnapshots();
+}
+
+
+// Snapshot hazard accessor (reclamation).
+const qtractorTimeScale::Snapshot *qtractorTimeScale::Reader::hazard (void) const
+{
+	return atomicPointerLoad(m_hazard);
+}
+
+
+// Current snapshot (RT-safe): hold it first (hazard),
+// then make sure it's still the current one...
+const qtractorTimeScale::Snapshot *qtractorTimeScale::Reader::snapshot (void)
+{
+	Snapshot *pSnapshot = atomicPointerLoad(ts->m_snapshot);
+	while (pSnapshot != m_pSnapshot) {
+		m_hazard.fetchAndStoreOrdered(pSnapshot);
+		m_pSnapshot = pSnapshot;
+		m_iNode = 0;
+		pSnapshot = atomicPointerLoad(ts->m_snapshot);
+	}
+
+	return m_pSnapshot;
+}
+
+
+// Snapshot node seeker (by frame).
+const qtractorTimeScale::Node *qtractorTimeScale::Reader::seekFrame (
+	unsigned long iFrame )
+{
+	const Snapshot *pSnapshot = snapshot();
+	if (pSnapshot == NULL || pSnapshot->count() < 1)
+		return NULL;
+
+	const unsigned int n = pSnapshot->count();
+	unsigned int i = m_iNode;
+
+	if (iFrame > pSnapshot->node(i)->frame) {
+		// Seek frame forward...
+		while (i + 1 < n && iFrame >= pSnapshot->node(i + 1)->frame)
+			++i;
+	}
+	else
+	if (iFrame < pSnapshot->node(i)->frame) {
+		// Seek frame backward...
+		while (i > 0 && pSnapshot->node(i)->frame > iFrame)
+			--i;
+	}
+
+	m_iNode = i;
+
+	return pSnapshot->node(i);
+}
+
+
+// Snapshot node seeker (by beat).
+const qtractorTimeScale::Node *qtractorTimeScale::Reader::seekBeat (
+	unsigned int iBeat )
+{
+	const Snapshot *pSnapshot = snapshot();
+	if (pSnapshot == NULL || pSnapshot->count() < 1)
+		return NULL;
+
+	const unsigned int n = pSnapshot->count();
+	unsigned int i = m_iNode;
+
+	if (iBeat > pSnapshot->node(i)->beat) {
+		// Seek beat forward...
+		while (i + 1 < n && iBeat >= pSnapshot->node(i + 1)->beat)
+			++i;
+	}
+	else
+	if (iBeat < pSnapshot->node(i)->beat) {
+		// Seek beat backward...
+		while (i > 0 && pSnapshot->node(i)->beat > iBeat)
+			--i;
+	}
+
+	m_iNode = i;
+
+	return pSnapshot->node(i);
+}
+
+
+// Snapshot node seeker (by tick).
+const qtractorTimeScale::Node *qtractorTimeScale::Reader::seekTick (
+	unsigned long iTick )
+{
+	const Snapshot *pSnapshot = snapshot();
+	if (pSnapshot == NULL || pSnapshot->count() < 1)
+		return NULL;
+
+	const unsigned int n = pSnapshot->count();
+	unsigned int i = m_iNode;
+
+	if (iTick > pSnapshot->node(i)->tick) {
+		// Seek tick forward...
+		while (i + 1 < n && iTick >= pSnapshot->node(i + 1)->tick)
+			++i;
+	}
+	else
+	if (iTick < pSnapshot->node(i)->tick) {
+		// Seek tick backward...
+		while (i > 0 && pSnapshot->node(i)->tick > iTick)
+			--i;
+	}
+
+	m_iNode = i;
+
+	return pSnapshot->node(i);
+}
+
+
+// Tick to frame batch conversion: one pass over the current snapshot,
+// as each run of values falling on the same node gets converted at
+// once, with the very same node coefficients (nb. input better be
+// sorted, though any out-of-order value just makes it re-seek).
+void qtractorTimeScale::Reader::framesFromTicks (
+	const unsigned long *pTicks, unsigned long *pFrames, unsigned int iCount )
+{
+	const Snapshot *pSnapshot = snapshot();
+	const unsigned int iNodes = (pSnapshot ? pSnapshot->count() : 0);
+	if (iNodes < 1) {
+		for (unsigned int i = 0; i < iCount; ++i)
+			pFrames[i] = 0;
+		return;
+	}
+
+	unsigned int k = m_iNode;
+	unsigned int i = 0;
+	while (i < iCount) {
+		const unsigned long iTick = pTicks[i];
+		// Seek tick forward or backward...
+		while (k + 1 < iNodes && iTick >= pSnapshot->node(k + 1)->tick)
+			++k;
+		while (k > 0 && pSnapshot->node(k)->tick > iTick)
+			--k;
+		const Node *pNode = pSnapshot->node(k);
+		// Find where this node span ends...
+		const unsigned long iTickEnd
+			= (k + 1 < iNodes ? pSnapshot->node(k + 1)->tick : ULONG_MAX);
+		unsigned int n = i + 1;
+		while (n < iCount
+			&& pTicks[n] >= pNode->tick && pTicks[n] < iTickEnd)
+			++n;
+		// Convert the whole span (tight loop)...
+		for ( ; i < n; ++i)
+			pFrames[i] = pNode->frameFromTick(pTicks[i]);
+	}
+
+	m_iNode = k;
 }
 
 
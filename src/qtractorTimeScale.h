@@ -26,6 +26,9 @@
 
 #include <QStringList>
 #include <QColor>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicPointer>
 
 
 //----------------------------------------------------------------------
@@ -41,11 +44,14 @@ public:
 
 	// Default constructor.
 	qtractorTimeScale() : m_displayFormat(Frames),
-		m_cursor(this), m_markerCursor(this) { clear(); }
+		m_cursor(this), m_markerCursor(this), m_iRevision(0) { clear(); }
 
 	// Copy constructor.
 	qtractorTimeScale(const qtractorTimeScale& ts)
-		: m_cursor(this), m_markerCursor(this) { copy(ts); }
+		: m_cursor(this), m_markerCursor(this), m_iRevision(0) { copy(ts); }
+
+	// Destructor.
+	~qtractorTimeScale();
 
 	// Assignment operator,
 	qtractorTimeScale& operator=(const qtractorTimeScale& ts)
@@ -110,7 +116,7 @@ public:
 	public:
 
 		// Constructor.
-		Node(qtractorTimeScale *pTimeScale,
+		Node(qtractorTimeScale *pTimeScale = 0,
 			unsigned long iFrame = 0,
 			float fTempo = 120.0f,
 			unsigned short iBeatType = 2,
@@ -280,6 +286,96 @@ public:
 	// Internal cursor accessor.
 	Cursor& cursor() { return m_cursor; }
 
+	// Immutable tempo-map snapshot (flat node array copy).
+	class Snapshot
+	{
+	public:
+
+		// Constructor.
+		Snapshot(const qtractorTimeScale *pTimeScale);
+
+		// Accessors.
+		unsigned int revision() const { return m_iRevision; }
+		unsigned int count() const { return m_nodes.count(); }
+
+		const Node *node(unsigned int i) const
+			{ return m_nodes.constData() + i; }
+
+	private:
+
+		// Member variables.
+		unsigned int  m_iRevision;
+		QVector<Node> m_nodes;
+	};
+
+	// Per-thread tempo-map reader (RT-safe cursor): always seeks on
+	// the current published snapshot, which it holds (hazard) while
+	// in use, so that it's never reclaimed under its feet.
+	class Reader
+	{
+	public:
+
+		// Constructor (registration; non RT-safe).
+		Reader(qtractorTimeScale *pTimeScale);
+
+		// Destructor (unregistration; non RT-safe).
+		~Reader();
+
+		// Time scale accessor.
+		qtractorTimeScale *timeScale() const { return ts; }
+
+		// Current snapshot (RT-safe).
+		const Snapshot *snapshot();
+
+		// Seek methods.
+		const Node *seekFrame(unsigned long iFrame);
+		const Node *seekBeat(unsigned int iBeat);
+		const Node *seekTick(unsigned long iTick);
+
+		// Frame/beat general converters.
+		unsigned int beatFromFrame(unsigned long iFrame)
+		{
+			const Node *pNode = seekFrame(iFrame);
+			return (pNode ? pNode->beatFromFrame(iFrame) : 0);
+		}
+
+		unsigned long frameFromBeat(unsigned int iBeat)
+		{
+			const Node *pNode = seekBeat(iBeat);
+			return (pNode ? pNode->frameFromBeat(iBeat) : 0);
+		}
+
+		// Frame/tick general converters.
+		unsigned long tickFromFrame(unsigned long iFrame)
+		{
+			const Node *pNode = seekFrame(iFrame);
+			return (pNode ? pNode->tickFromFrame(iFrame) : 0);
+		}
+
+		unsigned long frameFromTick(unsigned long iTick)
+		{
+			const Node *pNode = seekTick(iTick);
+			return (pNode ? pNode->frameFromTick(iTick) : 0);
+		}
+
+		// Tick to frame batch converter (sorted array, in place allowed).
+		void framesFromTicks(const unsigned long *pTicks,
+			unsigned long *pFrames, unsigned int iCount);
+
+		// Snapshot hazard accessor (reclamation).
+		const Snapshot *hazard() const;
+
+	private:
+
+		// Member variables.
+		qtractorTimeScale *ts;
+
+		QAtomicPointer<Snapshot> m_hazard;
+
+		Snapshot    *m_pSnapshot;
+		unsigned int m_iNode;
+	};
+
 	// Node list specifics.
 	Node *addNode(
 		unsigned long iFrame = 0,
@@ -293,6 +389,9 @@ public:
 	// Complete time-scale update method.
 	void updateScale();
 
+	// Tempo-map revision (bumped on every update).
+	unsigned int revision() const { return m_iRevision; }
+
 	// Frame/pixel convertors.
 	int pixelFromFrame(unsigned long iFrame) const
 		{ return uroundf((m_fPixelRate * iFrame) / m_fFrameRate); }
@@ -561,6 +660,10 @@ protected:
 	float pixelRate() const { return m_fPixelRate; }
 	float frameRate() const { return m_fFrameRate; }
 
+	// Tempo-map snapshot publishing and reclamation (non RT-safe).
+	void updateSnapshot();
+	void cleanSnapshots();
+
 private:
 
 	unsigned short m_iSnapPerBeat;      // Snap per beat (divisor).
@@ -588,6 +691,18 @@ private:
 
 	// Internal node cursor.
 	MarkerCursor m_markerCursor;
+
+	// Tempo-map revision.
+	volatile unsigned int m_iRevision;
+
+	// Tempo-map published snapshot, retired ones
+	// and all the registered readers thereof.
+	QAtomicPointer<Snapshot> m_snapshot;
+
+	QList<Snapshot *> m_retired;
+	QList<Reader *>   m_readers;
+
+	QMutex m_mutex;
 };
 
 #endif	// __qtractorTimeScale_h
@@ -31,6 +31,7 @@
 #include "qtractorAudioEngine.h"
 #include "qtractorAudioMonitor.h"
 #include "qtractorAudioBuffer.h"
+#include "qtractorAudioExport.h"
 #include "qtractorMidiEngine.h"
 #include "qtractorMidiMonitor.h"
 #include "qtractorMidiManager.h"
@@ -326,7 +327,16 @@ qtractorTrack::qtractorTrack ( qtractorSession *pSession, TrackType trackType )
 
 	m_clips.setAutoDelete(true);
 
-	m_pSyncThread = NULL;
+	m_iRenderChannels = 0;
+	m_ppRenderXBuffer = NULL;
+	m_ppBlockBuffer = NULL;
+	m_ppRenderYBuffer = NULL;
+
+	m_ppAudioBuffer = NULL;
+
+	m_pExportStem = NULL;
+
+	m_iMidiLatencyDelay = 0;
 
 	m_pMidiVolumeObserver  = NULL;
 	m_pMidiPanningObserver = NULL;
@@ -420,16 +430,6 @@ void qtractorTrack::clear (void)
 	m_props.solo    = false;
 	m_props.gain    = 1.0f;
 	m_props.panning = 0.0f;
-
-	if (m_pSyncThread) {
-		if (m_pSyncThread->isRunning()) do {
-			m_pSyncThread->setRunState(false);
-		//	m_pSyncThread->terminate();
-			m_pSyncThread->sync();
-		} while (!m_pSyncThread->wait(100));
-		delete m_pSyncThread;
-		m_pSyncThread = NULL;
-	}
 }
 
 
@@ -512,6 +512,13 @@ bool qtractorTrack::open (void)
 				m_props.gain, m_props.panning);
 			m_pPluginList->setChannels(pAudioBus->channels(),
 				qtractorPluginList::AudioTrack);
+			// Block automation buffer pointers...
+			m_iRenderChannels = pAudioBus->channels();
+			m_ppBlockBuffer = new float * [m_iRenderChannels];
+			for (unsigned short i = 0; i < m_iRenderChannels; ++i)
+				m_ppBlockBuffer[i] = NULL;
+			// Private render buffers (parallel rendering only)...
+			updateRenderBuffers();
 		}
 		break;
 	}
@@ -649,6 +656,25 @@ void qtractorTrack::close (void)
 	m_pInputBus  = NULL;
 	m_pOutputBus = NULL;
 
+	// Routing topology has changed...
+	if (m_props.trackType == qtractorTrack::Audio && m_pSession)
+		m_pSession->audioEngine()->resetGraph();
+
+	m_ppAudioBuffer = NULL;
+
+	deleteRenderBuffers();
+
+	if (m_ppBlockBuffer) {
+		delete [] m_ppBlockBuffer;
+		m_ppBlockBuffer = NULL;
+	}
+
+	m_iRenderChannels = 0;
+
+	// Plugin delay compensation must be set anew...
+	m_latencyDelay.setDelay(0, 0);
+	m_iMidiLatencyDelay = 0;
+
 	setClipRecord(NULL);
 }
 
@@ -1318,7 +1344,7 @@ void qtractorTrack::resetProperties (void)
 
 // Track special process cycle executive.
 void qtractorTrack::process ( qtractorClip *pClip,
-	unsigned long iFrameStart, unsigned long iFrameEnd )
+	unsigned long iFrameStart, unsigned long iFrameEnd, bool bRender )
 {
 	// Audio-buffers needs some preparation...
 	const unsigned int nframes = iFrameEnd - iFrameStart;
@@ -1331,7 +1357,16 @@ void qtractorTrack::process ( qtractorClip *pClip,
 		if (pOutputBus) {
 			qtractorAudioBus *pInputBus = (m_pSession->isTrackMonitor(this)
 				? static_cast<qtractorAudioBus *> (m_pInputBus) : NULL);
-			pOutputBus->buffer_prepare(nframes, pInputBus);
+			// Render on our own private buffer (parallel rendering)...
+			bRender = (bRender && m_ppRenderXBuffer);
+			if (bRender) {
+				pOutputBus->buffer_prepare(
+					m_ppRenderXBuffer, m_ppRenderYBuffer, nframes, pInputBus);
+				m_ppAudioBuffer = m_ppRenderYBuffer;
+			} else {
+				pOutputBus->buffer_prepare(nframes, pInputBus);
+				m_ppAudioBuffer = pOutputBus->buffer();
+			}
 		}
 	}
 
@@ -1347,16 +1382,69 @@ void qtractorTrack::process ( qtractorClip *pClip,
 
 	// Audio buffers needs monitoring and commitment...
 	if (pAudioMonitor && pOutputBus) {
+		// Plugins, delay compensation and monitor passthru...
+		process_post(pAudioMonitor, iFrameStart, nframes);
+		// Actually render it (unless deferred)...
+		if (!bRender)
+			pOutputBus->buffer_commit(nframes);
+	}
+}
+
+
+// Audio track post-processing (plugins, delay compensation and monitor).
+void qtractorTrack::process_post ( qtractorAudioMonitor *pAudioMonitor,
+	unsigned long iFrameStart, unsigned int nframes )
+{
+	// Block automation, whether some curve is ramping...
+	const unsigned int iBlockFrames
+		= m_pSession->audioEngine()->blockAutomation();
+	qtractorCurveList *pCurveList = curveList();
+	if (iBlockFrames > 0 && iBlockFrames < nframes && m_ppBlockBuffer
+		&& pCurveList && pCurveList->isProcess()
+		&& pCurveList->isRamping(iFrameStart, iFrameStart + nframes)
+		&& m_pPluginList->isBlockProcess()) {
+		const unsigned short iChannels = m_iRenderChannels;
+		unsigned int iOffset = 0;
+		while (iOffset < nframes) {
+			unsigned int iFrames = nframes - iOffset;
+			if (iFrames > iBlockFrames)
+				iFrames = iBlockFrames;
+			for (unsigned short i = 0; i < iChannels; ++i)
+				m_ppBlockBuffer[i] = m_ppAudioBuffer[i] + iOffset;
+			// Continuous automation, on each sub-block...
+			pCurveList->process_block(iFrameStart + iOffset);
+			pAudioMonitor->update();
+			m_pPluginList->process(m_ppBlockBuffer, iFrames);
+			m_latencyDelay.process(m_ppBlockBuffer, iFrames);
+			pAudioMonitor->process(m_ppBlockBuffer, iFrames);
+			iOffset += iFrames;
+		}
+		// Let observers know of the last sub-block values...
+		pCurveList->process_block_end();
+	} else {
 		// Plugin chain post-processing...
-		m_pPluginList->process(pOutputBus->buffer(), nframes);
+		m_pPluginList->process(m_ppAudioBuffer, nframes);
+		// Plugin delay compensation...
+		m_latencyDelay.process(m_ppAudioBuffer, nframes);
 		// Monitor passthru...
-		pAudioMonitor->process(pOutputBus->buffer(), nframes);
-		// Actually render it...
-		pOutputBus->buffer_commit(nframes);
+		pAudioMonitor->process(m_ppAudioBuffer, nframes);
 	}
 }
 
 
+// Track special process commit executive (parallel rendering only).
+void qtractorTrack::process_commit ( unsigned int nframes )
+{
+	if (m_props.trackType != qtractorTrack::Audio)
+		return;
+
+	qtractorAudioBus *pOutputBus
+		= static_cast<qtractorAudioBus *> (m_pOutputBus);
+	if (pOutputBus && m_pMonitor && m_ppRenderXBuffer)
+		pOutputBus->buffer_commit(m_ppRenderXBuffer, nframes);
+}
+
+
 // Freewheeling process cycle executive (needed for export).
 void qtractorTrack::process_export ( qtractorClip *pClip,
 	unsigned long iFrameStart, unsigned long iFrameEnd )
@@ -1373,8 +1461,10 @@ void qtractorTrack::process_export ( qtractorClip *pClip,
 	if (m_props.trackType == qtractorTrack::Audio) {
 		pAudioMonitor = static_cast<qtractorAudioMonitor *> (m_pMonitor);
 		pOutputBus = static_cast<qtractorAudioBus *> (m_pOutputBus);
-		if (pOutputBus)
+		if (pOutputBus) {
 			pOutputBus->buffer_prepare(nframes);
+			m_ppAudioBuffer = pOutputBus->buffer();
+		}
 	}
 
 	// Playback...
@@ -1389,10 +1479,11 @@ void qtractorTrack::process_export ( qtractorClip *pClip,
 
 	// Audio buffers needs monitoring and commitment...
 	if (pAudioMonitor && pOutputBus) {
-		// Plugin chain post-processing...
-		m_pPluginList->process(pOutputBus->buffer(), nframes);
-		// Monitor passthru...
-		pAudioMonitor->process(pOutputBus->buffer(), nframes);
+		// Plugins, delay compensation and monitor passthru...
+		process_post(pAudioMonitor, iFrameStart, nframes);
+		// Stem export capture...
+		if (m_pExportStem)
+			m_pExportStem->write(m_ppAudioBuffer, nframes);
 		// Actually render it...
 		pOutputBus->buffer_commit(nframes);
 	}
@@ -1578,16 +1669,122 @@ void qtractorTrack::updateClipEditors (void)
 
 
 // Audio buffer ring-cache (playlist) methods.
-qtractorAudioBufferThread *qtractorTrack::syncThread (void)
+qtractorAudioBufferPool *qtractorTrack::syncPool (void)
 {
-	if (m_pSyncThread == NULL) {
-		m_pSyncThread = new qtractorAudioBufferThread();
-		m_pSyncThread->start(QThread::HighPriority);
-	} else {
-		m_pSyncThread->checkSyncSize(m_clips.count());
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return NULL;
+
+	// Common I/O pool is shared among all audio tracks
+	// (request ring grows as buffers get attached)...
+	return pAudioEngine->syncPool();
+}
+
+
+// Audio track current process buffer accessor.
+float **qtractorTrack::audioBuffer (void) const
+{
+	return m_ppAudioBuffer;
+}
+
+
+// Audio track private render buffer predicate.
+bool qtractorTrack::isRenderBuffer (void) const
+{
+	return (m_ppRenderXBuffer != NULL);
+}
+
+
+// Audio track private render buffers (re)allocation (non RT-safe);
+// sized as the current engine buffer, only if there are any render
+// threads around; otherwise the track just gets rendered serially.
+void qtractorTrack::updateRenderBuffers (void)
+{
+	deleteRenderBuffers();
+
+	if (m_props.trackType != qtractorTrack::Audio || m_pSession == NULL)
+		return;
+
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return;
+
+	const unsigned int iBufferSize = pAudioEngine->bufferSize();
+	if (iBufferSize > 0 && pAudioEngine->renderThreads() > 0
+		&& m_iRenderChannels > 0) {
+		m_ppRenderXBuffer = new float * [m_iRenderChannels];
+		m_ppRenderYBuffer = new float * [m_iRenderChannels];
+		for (unsigned short i = 0; i < m_iRenderChannels; ++i) {
+			m_ppRenderXBuffer[i] = new float [iBufferSize];
+			m_ppRenderYBuffer[i] = NULL;
+		}
 	}
 
-	return m_pSyncThread;
+	// Routing topology has changed...
+	pAudioEngine->resetGraph();
+}
+
+
+// Audio track private render buffers disposal (non RT-safe).
+void qtractorTrack::deleteRenderBuffers (void)
+{
+	if (m_ppRenderXBuffer) {
+		for (unsigned short i = 0; i < m_iRenderChannels; ++i)
+			delete [] m_ppRenderXBuffer[i];
+		delete [] m_ppRenderXBuffer;
+		m_ppRenderXBuffer = NULL;
+	}
+
+	if (m_ppRenderYBuffer) {
+		delete [] m_ppRenderYBuffer;
+		m_ppRenderYBuffer = NULL;
+	}
+}
+
+
+// Track plugin delay compensation (non RT-safe).
+void qtractorTrack::setLatencyDelay ( unsigned long iLatencyDelay )
+{
+	// MIDI tracks just get their events that late...
+	if (m_props.trackType == qtractorTrack::Midi) {
+		m_iMidiLatencyDelay = iLatencyDelay;
+		return;
+	}
+
+	unsigned short iChannels = 0;
+	if (m_props.trackType == qtractorTrack::Audio) {
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (m_pOutputBus);
+		if (pAudioBus)
+			iChannels = pAudioBus->channels();
+	}
+
+	m_latencyDelay.setDelay(iChannels, iLatencyDelay);
+}
+
+unsigned long qtractorTrack::latencyDelay (void) const
+{
+	if (m_props.trackType == qtractorTrack::Midi)
+		return m_iMidiLatencyDelay;
+
+	return m_latencyDelay.delay();
+}
+
+
+// Audio track plugin delay compensation flush.
+void qtractorTrack::resetLatencyDelay (void)
+{
+	m_latencyDelay.reset();
+}
+
+
+// Track total compensated latency (in frames).
+unsigned long qtractorTrack::latency (void) const
+{
+	if (m_pPluginList == NULL)
+		return latencyDelay();
+
+	return m_pPluginList->latency() + latencyDelay();
 }
 
 
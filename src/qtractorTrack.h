@@ -25,6 +25,7 @@
 #include "qtractorList.h"
 
 #include "qtractorMidiControl.h"
+#include "qtractorAudioDelay.h"
 
 #include <QColor>
 
@@ -35,15 +36,17 @@ class qtractorDocument;
 class qtractorInstrumentList;
 class qtractorPluginList;
 class qtractorMonitor;
+class qtractorAudioMonitor;
 class qtractorClip;
 class qtractorBus;
 
 class qtractorSubject;
 class qtractorMidiControlObserver;
-class qtractorAudioBufferThread;
+class qtractorAudioBufferPool;
 class qtractorCurveList;
 class qtractorCurveFile;
 class qtractorCurve;
+class qtractorAudioExportStem;
 
 // Special forward declarations.
 class QDomElement;
@@ -215,12 +218,22 @@ public:
 
 	// Track special process cycle executive.
 	void process(qtractorClip *pClip,
-		unsigned long iFrameStart, unsigned long iFrameEnd);
+		unsigned long iFrameStart, unsigned long iFrameEnd,
+		bool bRender = false);
+
+	// Track special process commit executive (parallel rendering only).
+	void process_commit(unsigned int nframes);
 
 	// Track freewheeling process cycle executive (needed for export).
 	void process_export(qtractorClip *pClip,
 		unsigned long iFrameStart, unsigned long iFrameEnd);
 
+	// Audio track stem export capture (needed for stem export).
+	void setExportStem(qtractorAudioExportStem *pExportStem)
+		{ m_pExportStem = pExportStem; }
+	qtractorAudioExportStem *exportStem() const
+		{ return m_pExportStem; }
+
 	// Track special process record executive (audio recording only).
 	void process_record(
 		unsigned long iFrameStart, unsigned long iFrameEnd);
@@ -243,7 +256,28 @@ public:
 	void updateClipEditors();
 
 	// Audio buffer ring-cache (playlist) methods.
-	qtractorAudioBufferThread *syncThread();
+	qtractorAudioBufferPool *syncPool();
+
+	// Audio track current process buffer accessor.
+	float **audioBuffer() const;
+
+	// Audio track private render buffer predicate.
+	bool isRenderBuffer() const;
+
+	// Audio track private render buffers (re)allocation (non RT-safe).
+	void updateRenderBuffers();
+
+	// Track plugin delay compensation (non RT-safe): audio tracks
+	// get an actual delay-line, while MIDI tracks get their events
+	// delivered that late, to plugins and outputs alike.
+	void setLatencyDelay(unsigned long iLatencyDelay);
+	unsigned long latencyDelay() const;
+
+	// Audio track plugin delay compensation flush.
+	void resetLatencyDelay();
+
+	// Track total compensated latency (in frames).
+	unsigned long latency() const;
 
 	// Track state (monitor, record, mute, solo) button setup.
 	qtractorSubject *monitorSubject() const;
@@ -354,6 +388,14 @@ public:
 	void updateTrack();
 	void updateMidiTrack();
 
+	// Audio track post-processing (plugins, delay compensation
+	// and monitor), in sub-blocks while automation is ramping.
+	void process_post(qtractorAudioMonitor *pAudioMonitor,
+		unsigned long iFrameStart, unsigned int nframes);
+
+	// Audio track private render buffers disposal (non RT-safe).
+	void deleteRenderBuffers();
+
 private:
 
 	qtractorSession *m_pSession;    // Session reference.
@@ -382,8 +424,25 @@ private:
 
 	qtractorPluginList *m_pPluginList;	// Plugin chain (audio).
 
-	// Audio buffer ring-cache (playlist).
-	qtractorAudioBufferThread *m_pSyncThread;
+	// Audio track private render buffers (parallel rendering).
+	unsigned short m_iRenderChannels;
+	float        **m_ppRenderXBuffer;
+	float        **m_ppRenderYBuffer;
+
+	// Audio track sub-block buffer (block automation).
+	float        **m_ppBlockBuffer;
+
+	// Audio track current process buffer.
+	float        **m_ppAudioBuffer;
+
+	// Audio track stem export capture.
+	qtractorAudioExportStem *m_pExportStem;
+
+	// Audio track plugin delay compensation.
+	qtractorAudioDelay m_latencyDelay;
+
+	// MIDI track plugin delay compensation (event offset).
+	unsigned long m_iMidiLatencyDelay;
 
 	// MIDI track/channel (volume, panning) observers.
 	class MidiVolumeObserver;
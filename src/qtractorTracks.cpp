@@ -1134,11 +1134,11 @@ struct audioClipBufferItem
 {
 	// Constructor.
 	audioClipBufferItem(qtractorClip *pClip,
-		qtractorAudioBufferThread *pSyncThread,
+		qtractorAudioBufferPool *pSyncPool,
 		unsigned short iChannels)
 		: clip(static_cast<qtractorAudioClip *> (pClip))
 	{
-		buff = new qtractorAudioBuffer(pSyncThread, iChannels);
+		buff = new qtractorAudioBuffer(pSyncPool, iChannels);
 		buff->setOffset(clip->clipOffset());
 		buff->setLength(clip->clipLength());
 		buff->setTimeStretch(clip->timeStretch());
@@ -1264,13 +1264,13 @@ bool qtractorTracks::mergeExportAudioClips ( qtractorClipCommand *pClipCommand )
 		qtractorTrack *pTrack = pClip->track();
 		// Make sure it's a legal selection...
 		if (pTrack && pClip->isClipSelected()) {
-			qtractorAudioBufferThread *pSyncThread = pTrack->syncThread();
+			qtractorAudioBufferPool *pSyncPool = pTrack->syncPool();
 			if (iSelectStart > pClip->clipSelectStart())
 				iSelectStart = pClip->clipSelectStart();
 			if (iSelectEnd < pClip->clipSelectEnd())
 				iSelectEnd = pClip->clipSelectEnd();
 			list.append(new audioClipBufferItem(
-				pClip, pSyncThread, iChannels));
+				pClip, pSyncPool, iChannels));
 		}
 	}
 
@@ -2852,6 +2852,22 @@ bool qtractorTracks::addMidiTracks ( const QStringList& files,
 			continue;
 		// It all depends on the format...
 		const int iTracks = (file.format() == 1 ? file.tracks() : 16);
+		// SMF format 1 tracks are all read in one go (in parallel,
+		// if worth it), each clip taking over its own pre-read one...
+		qtractorMidiSequence **ppSeqs = NULL;
+		if (file.format() == 1 && iTracks > 1) {
+			ppSeqs = new qtractorMidiSequence * [iTracks];
+			for (int iSeq = 0; iSeq < iTracks; ++iSeq) {
+				ppSeqs[iSeq] = new qtractorMidiSequence(
+					QString(), 0, pSession->ticksPerBeat());
+			}
+			if (!file.readTracks(ppSeqs, iTracks)) {
+				for (int iSeq = 0; iSeq < iTracks; ++iSeq)
+					delete ppSeqs[iSeq];
+				delete [] ppSeqs;
+				ppSeqs = NULL;
+			}
+		}
 		for (int iTrackChannel = 0; iTrackChannel < iTracks; ++iTrackChannel) {
 			// Create a new track right away...
 			const QColor& color = qtractorTrack::trackColor(++iTrack);
@@ -2867,10 +2883,16 @@ bool qtractorTracks::addMidiTracks ( const QStringList& files,
 			pMidiClip->setClipStart(iClipStart);
 			if (iTrackChannel == 0 && iImport == 0)
 				pMidiClip->setSessionFlag(true);
+			if (ppSeqs) {
+				pMidiClip->setImportSequence(ppSeqs[iTrackChannel]);
+				ppSeqs[iTrackChannel] = NULL;
+			}
 			// Time to add the new track/clip into session;
 			// actuallly, this is when the given MIDI file and
 			// track-channel gets open and read into the clip!
 			pTrack->addClip(pMidiClip);
+			// Whatever was not taken over...
+			pMidiClip->setImportSequence(NULL);
 			// As far the standards goes,from which we'll strictly follow,
 			// only the first track/channel has some tempo/time signature...
 			if (iTrackChannel == 0) {
@@ -2897,6 +2919,8 @@ bool qtractorTracks::addMidiTracks ( const QStringList& files,
 				delete pTrack;
 			}
 		}
+		if (ppSeqs)
+			delete [] ppSeqs;
 		// Log this successful import operation...
 		if (iUpdate > 0 && pMainForm) {
 			sDescription += tr("MIDI file import \"%1\" on %2 %3.\n")
@@ -945,6 +945,20 @@ void qtractorVstPlugin::process (
 }
 
 
+// Plugin processing latency (in frames), if any.
+unsigned long qtractorVstPlugin::latency (void) const
+{
+	if (!isActivated() || instances() < 1)
+		return 0;
+
+	AEffect *pVstEffect = vst_effect(0);
+	if (pVstEffect == NULL || pVstEffect->initialDelay < 1)
+		return 0;
+
+	return (unsigned long) pVstEffect->initialDelay;
+}
+
+
 // Parameter update method.
 void qtractorVstPlugin::updateParam (
 	qtractorPluginParam *pParam, float fValue, bool /*bUpdate*/ )
@@ -0,0 +1,219 @@
+// qtractor_ramp_bench.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2018, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+// Standalone (no Qt) micro-benchmark of the audio buffer gain-ramped
+// mix-down and clip ramp in/out kernels, over the usual period sizes.
+//
+//   make bench && src/qtractor_ramp_bench [total-frames]
+//
+
+#include "qtractorAudioRamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+
+// Kernel function prototypes (as defined in qtractorAudioRamp.h).
+typedef void (*MixRampFunc)(float *, const float *, unsigned int, float, float);
+typedef void (*GainRampFunc)(float *, unsigned int, float, float);
+
+
+// Kernel variants, as available on this host.
+struct RampKernel
+{
+	const char  *name;
+	MixRampFunc  mix_ramp;
+	GainRampFunc gain_ramp;
+};
+
+
+// Default amount of frames processed per kernel and period size.
+#define QTRACTOR_RAMP_BENCH_FRAMES	(1 << 26)
+
+// Largest period size; buffers are twice that long.
+#define QTRACTOR_RAMP_BENCH_PERIOD	2048
+
+
+// Monotonic time-stamp (nanoseconds).
+static double bench_nsecs (void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return double(ts.tv_sec) * 1e9 + double(ts.tv_nsec);
+}
+
+
+// Pseudo-random signal, in [-1,+1].
+static void bench_fill ( float *pBuffer, unsigned int iFrames )
+{
+	unsigned int iSeed = 0x1234567;
+	for (unsigned int n = 0; n < iFrames; ++n) {
+		iSeed = iSeed * 1103515245 + 12345;
+		pBuffer[n] = float(int(iSeed >> 8) & 0xffff) / 32768.0f - 1.0f;
+	}
+}
+
+
+// Largest difference against the standard kernels, relative to
+// their peak level; the gain ramp steps are not a power of two,
+// lest any SIMD kernel round off just as the scalar one does.
+static float bench_check ( const RampKernel& kernel,
+	const float *pSource, float *pFrames, float *pCheck, unsigned int iFrames )
+{
+	const float fGainIter = 0.3f;
+	const float fGainStep = 0.7f / float(iFrames);
+
+	memset(pFrames, 0, iFrames * sizeof(float));
+	memset(pCheck,  0, iFrames * sizeof(float));
+	(*kernel.mix_ramp)(pFrames, pSource, iFrames, fGainIter, fGainStep);
+	std_mix_ramp(pCheck, pSource, iFrames, fGainIter, fGainStep);
+	(*kernel.gain_ramp)(pFrames, iFrames, fGainIter, fGainStep);
+	std_gain_ramp(pCheck, iFrames, fGainIter, fGainStep);
+
+	float fMaxError = 0.0f;
+	float fMaxLevel = 0.0f;
+	for (unsigned int n = 0; n < iFrames; ++n) {
+		const float fError = ::fabsf(pFrames[n] - pCheck[n]);
+		if (fMaxError < fError)
+			fMaxError = fError;
+		const float fLevel = ::fabsf(pCheck[n]);
+		if (fMaxLevel < fLevel)
+			fMaxLevel = fLevel;
+	}
+
+	return (fMaxLevel > 0.0f ? fMaxError / fMaxLevel : fMaxError);
+}
+
+
+// Main program.
+int main ( int argc, char **argv )
+{
+	unsigned long iTotalFrames = QTRACTOR_RAMP_BENCH_FRAMES;
+	if (argc > 1)
+		iTotalFrames = ::strtoul(argv[1], NULL, 0);
+	if (iTotalFrames < QTRACTOR_RAMP_BENCH_PERIOD)
+		iTotalFrames = QTRACTOR_RAMP_BENCH_PERIOD;
+
+	RampKernel kernels[4];
+	unsigned int iKernels = 0;
+
+	kernels[iKernels].name      = "std";
+	kernels[iKernels].mix_ramp  = std_mix_ramp;
+	kernels[iKernels].gain_ramp = std_gain_ramp;
+	++iKernels;
+#if defined(__SSE__)
+	if (sse_enabled()) {
+		kernels[iKernels].name      = "sse";
+		kernels[iKernels].mix_ramp  = sse_mix_ramp;
+		kernels[iKernels].gain_ramp = sse_gain_ramp;
+		++iKernels;
+	}
+#endif
+#if defined(CONFIG_AVX2_MIX)
+	if (avx2_enabled()) {
+		kernels[iKernels].name      = "avx2";
+		kernels[iKernels].mix_ramp  = avx2_mix_ramp;
+		kernels[iKernels].gain_ramp = avx2_gain_ramp;
+		++iKernels;
+	}
+#endif
+#if defined(__ARM_NEON__)
+	kernels[iKernels].name      = "neon";
+	kernels[iKernels].mix_ramp  = neon_mix_ramp;
+	kernels[iKernels].gain_ramp = neon_gain_ramp;
+	++iKernels;
+#endif
+
+	// Output (mix-down) buffers are aligned, as the engine's are;
+	// the source is deliberately not, as a ring-buffer read may be.
+	const unsigned int iBufferSize = 2 * QTRACTOR_RAMP_BENCH_PERIOD;
+	float *pFrames = NULL;
+	float *pCheck  = NULL;
+	float *pSource = NULL;
+	if (::posix_memalign((void **) &pFrames, 32, iBufferSize * sizeof(float))
+		|| ::posix_memalign((void **) &pCheck, 32, iBufferSize * sizeof(float))
+		|| ::posix_memalign((void **) &pSource, 32, (iBufferSize + 1) * sizeof(float))) {
+		::fprintf(stderr, "qtractor_ramp_bench: out of memory.\n");
+		return 1;
+	}
+
+	const float *pBuffer = pSource + 1;
+	bench_fill(pSource, iBufferSize + 1);
+
+	::printf("%-6s %6s %12s %12s %12s %12s %10s\n", "kernel", "period",
+		"mix ns/prd", "mix Mf/s", "gain ns/prd", "gain Mf/s", "rel error");
+
+	for (unsigned int iFrames = 64;
+			iFrames <= QTRACTOR_RAMP_BENCH_PERIOD; iFrames <<= 1) {
+		const unsigned long iPeriods = iTotalFrames / iFrames;
+		// Ramps just about the whole gain range, back and forth,
+		// so that neither the output nor the gain ever blow up...
+		const float fGainStep = 1.0f / float(iFrames);
+		for (unsigned int k = 0; k < iKernels; ++k) {
+			const RampKernel& kernel = kernels[k];
+			const float fMaxError = bench_check(kernel,
+				pBuffer, pFrames, pCheck, iFrames);
+			memset(pFrames, 0, iBufferSize * sizeof(float));
+			double t0 = bench_nsecs();
+			for (unsigned long i = 0; i < iPeriods; ++i) {
+				if (i & 1)
+					(*kernel.mix_ramp)(pFrames, pBuffer, iFrames, 1.0f, -fGainStep);
+				else
+					(*kernel.mix_ramp)(pFrames, pBuffer, iFrames, 0.0f, +fGainStep);
+			}
+			const double fMixTime = bench_nsecs() - t0;
+			bench_fill(pFrames, iBufferSize);
+			t0 = bench_nsecs();
+			for (unsigned long i = 0; i < iPeriods; ++i) {
+				if (i & 1)
+					(*kernel.gain_ramp)(pFrames, iFrames, 1.0f, 0.0f);
+				else
+					(*kernel.gain_ramp)(pFrames, iFrames, 1.0f, fGainStep * 1e-6f);
+			}
+			const double fGainTime = bench_nsecs() - t0;
+			const double fFrames = double(iPeriods) * double(iFrames);
+			::printf("%-6s %6u %12.1f %12.1f %12.1f %12.1f %10.2g\n",
+				kernel.name, iFrames,
+				fMixTime  / double(iPeriods), 1e3 * fFrames / fMixTime,
+				fGainTime / double(iPeriods), 1e3 * fFrames / fGainTime,
+				double(fMaxError));
+		}
+	}
+
+	// Keep the results alive, as far as the optimizer is concerned...
+	float fSum = 0.0f;
+	for (unsigned int n = 0; n < iBufferSize; ++n)
+		fSum += pFrames[n];
+	if (fSum != fSum)
+		::fprintf(stderr, "qtractor_ramp_bench: not a number.\n");
+
+	::free(pSource);
+	::free(pCheck);
+	::free(pFrames);
+
+	return 0;
+}
+
+
+// end of qtractor_ramp_bench.cpp
@@ -14,15 +14,22 @@ HEADERS += config.h \
 	qtractorAtomic.h \
 	qtractorActionControl.h \
 	qtractorAudioBuffer.h \
+	qtractorAudioCache.h \
 	qtractorAudioClip.h \
 	qtractorAudioConnect.h \
+	qtractorAudioDelay.h \
 	qtractorAudioEngine.h \
+	qtractorAudioExport.h \
 	qtractorAudioFile.h \
+	qtractorAudioGraph.h \
 	qtractorAudioListView.h \
 	qtractorAudioMadFile.h \
 	qtractorAudioMeter.h \
+	qtractorAudioMmapFile.h \
 	qtractorAudioMonitor.h \
 	qtractorAudioPeak.h \
+	qtractorAudioRamp.h \
+	qtractorAudioRender.h \
 	qtractorAudioSndFile.h \
 	qtractorAudioVorbisFile.h \
 	qtractorClip.h \
@@ -76,15 +83,18 @@ HEADERS += config.h \
 	qtractorMidiEventList.h \
 	qtractorMidiFile.h \
 	qtractorMidiFileTempo.h \
+	qtractorMidiJackPort.h \
 	qtractorMidiListView.h \
 	qtractorMidiManager.h \
 	qtractorMidiMeter.h \
 	qtractorMidiMonitor.h \
 	qtractorMidiRpn.h \
 	qtractorMidiSequence.h \
+	qtractorMidiSnapshot.h \
 	qtractorMidiSysex.h \
 	qtractorMidiThumbView.h \
 	qtractorMidiTimer.h \
+	qtractorMidiTools.h \
 	qtractorMixer.h \
 	qtractorMmcEvent.h \
 	qtractorMonitor.h \
@@ -105,6 +115,7 @@ HEADERS += config.h \
 	qtractorSessionCursor.h \
 	qtractorSessionDocument.h \
 	qtractorSpinBox.h \
+	qtractorSse.h \
 	qtractorThumbView.h \
 	qtractorTimeScale.h \
 	qtractorTimeScaleCommand.h \
@@ -146,15 +157,21 @@ SOURCES += \
 	qtractor.cpp \
 	qtractorActionControl.cpp \
 	qtractorAudioBuffer.cpp \
+	qtractorAudioCache.cpp \
 	qtractorAudioClip.cpp \
 	qtractorAudioConnect.cpp \
+	qtractorAudioDelay.cpp \
 	qtractorAudioEngine.cpp \
+	qtractorAudioExport.cpp \
 	qtractorAudioFile.cpp \
+	qtractorAudioGraph.cpp \
 	qtractorAudioListView.cpp \
 	qtractorAudioMadFile.cpp \
 	qtractorAudioMeter.cpp \
+	qtractorAudioMmapFile.cpp \
 	qtractorAudioMonitor.cpp \
 	qtractorAudioPeak.cpp \
+	qtractorAudioRender.cpp \
 	qtractorAudioSndFile.cpp \
 	qtractorAudioVorbisFile.cpp \
 	qtractorClip.cpp \
@@ -200,17 +217,21 @@ SOURCES += \
 	qtractorMidiEditTime.cpp \
 	qtractorMidiEditView.cpp \
 	qtractorMidiEngine.cpp \
+	qtractorMidiEvent.cpp \
 	qtractorMidiEventList.cpp \
 	qtractorMidiFile.cpp \
 	qtractorMidiFileTempo.cpp \
+	qtractorMidiJackPort.cpp \
 	qtractorMidiListView.cpp \
 	qtractorMidiManager.cpp \
 	qtractorMidiMeter.cpp \
 	qtractorMidiMonitor.cpp \
 	qtractorMidiRpn.cpp \
 	qtractorMidiSequence.cpp \
+	qtractorMidiSnapshot.cpp \
 	qtractorMidiThumbView.cpp \
 	qtractorMidiTimer.cpp \
+	qtractorMidiTools.cpp \
 	qtractorMixer.cpp \
 	qtractorMmcEvent.cpp \
 	qtractorNsmClient.cpp \